@@ -23,6 +23,11 @@
 #include "llvm/Support/FileSystem.h" // for F_None
 
 #include "llvm/Support/MemoryBuffer.h"
+#if (LLVM_VERSION_MAJOR >= 4)
+#include "llvm/Support/Error.h"
+#endif
+
+#include "Telemetry.h"
 
 #ifdef MART_GENMU_OBJECTFILE
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
@@ -63,6 +68,27 @@ public:
 #endif
   }
 
+  /// \brief set the buffer to the content of the IR file @param filename
+  bool setToFile(std::string const &filename) {
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+    llvm::OwningPtr<llvm::MemoryBuffer> fileBuf;
+    if (llvm::MemoryBuffer::getFile(filename, fileBuf))
+      return false;
+    mBuf.reset(fileBuf.take());
+#else
+    auto fileBufOrErr = llvm::MemoryBuffer::getFile(filename);
+    if (!fileBufOrErr)
+      return false;
+    mBuf = std::move(fileBufOrErr.get());
+#endif
+    return true;
+  }
+
+  /// \brief the serialized IR (empty if not set)
+  llvm::StringRef getBuffer() const {
+    return (mBuf ? mBuf->getBuffer() : llvm::StringRef());
+  }
+
   ReadWriteIRObj(ReadWriteIRObj const &cp) {
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
     mBuf.reset(llvm::MemoryBuffer::getMemBuffer(
@@ -90,6 +116,21 @@ public:
 #endif
   }
 
+  /// \brief read the IR into the given context (e.g. a thread's own context)
+  inline llvm::Module *readIR(llvm::LLVMContext &context) {
+    llvm::SMDiagnostic SMD;
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+    return (llvm::ParseIR(mBuf.get(), SMD, context));
+#elif (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
+    return (llvm::parseIR(llvm::MemoryBufferRef(mBuf->getBuffer(),
+                                                mBuf->getBufferIdentifier()),
+                          SMD, context)
+                .release());
+#else
+    return (llvm::parseIR(*mBuf, SMD, context).release());
+#endif
+  }
+
   static inline llvm::Module *cloneModuleAndRelease(llvm::Module *M) {
 #if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
     return llvm::CloneModule(*M).release();
@@ -100,8 +141,83 @@ public:
 #endif
   }
 
+  /// \brief clone @param M like cloneModuleAndRelease, except that the
+  /// functions of the lazily read @param M whose bodies are not yet read are
+  /// only declared in the clone. @param VMap maps the values of @param M to
+  /// those of the clone (see cloneRemainingBodies)
+  static inline llvm::Module *
+  cloneMaterializedAndRelease(llvm::Module *M, llvm::ValueToValueMapTy &VMap) {
+#if (LLVM_VERSION_MAJOR >= 4)
+    auto isReadDef = [](llvm::GlobalValue const *GV) {
+      return !GV->isMaterializable();
+    };
+#endif
+#if (LLVM_VERSION_MAJOR >= 8)
+    return llvm::CloneModule(*M, VMap, isReadDef).release();
+#elif (LLVM_VERSION_MAJOR >= 4)
+    return llvm::CloneModule(M, VMap, isReadDef).release();
+#elif (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
+    return llvm::CloneModule(M, VMap);
+#else
+    return llvm::CloneModule(M, VMap).release();
+#endif
+  }
+
+  /// \brief read the remaining function bodies of the lazily read
+  /// @param M and copy them into the functions that were only declared in its
+  /// clone (see cloneMaterializedAndRelease), of @param VMap
+  static bool cloneRemainingBodies(llvm::Module &M,
+                                   llvm::ValueToValueMapTy &VMap) {
+#if (LLVM_VERSION_MAJOR >= 4)
+    std::vector<llvm::Function *> unread;
+    for (auto &Func : M)
+      if (Func.isMaterializable())
+        unread.push_back(&Func);
+    if (!materializeAll(M))
+      return false;
+    for (auto *Func : unread) {
+      auto it = VMap.find(Func);
+      if (it == VMap.end())
+        continue;
+      auto *cloneF = llvm::dyn_cast<llvm::Function>(it->second);
+      if (!cloneF || !cloneF->isDeclaration())
+        continue;
+      auto cloneArg = cloneF->arg_begin();
+      for (auto &arg : Func->args())
+        VMap[&arg] = &*cloneArg++;
+      llvm::SmallVector<llvm::ReturnInst *, 8> returns;
+#if (LLVM_VERSION_MAJOR >= 13)
+      llvm::CloneFunctionInto(cloneF, Func, VMap,
+                              llvm::CloneFunctionChangeType::ClonedModule,
+                              returns);
+#else
+      llvm::CloneFunctionInto(cloneF, Func, VMap, true, returns);
+#endif
+      // The clone made it an external declaration
+      cloneF->setLinkage(Func->getLinkage());
+      if (Func->hasPersonalityFn())
+        cloneF->setPersonalityFn(
+            llvm::MapValue(Func->getPersonalityFn(), VMap));
+      if (auto *comdat = Func->getComdat()) {
+        llvm::Comdat *cloneC =
+            cloneF->getParent()->getOrInsertComdat(comdat->getName());
+        cloneC->setSelectionKind(comdat->getSelectionKind());
+        cloneF->setComdat(cloneC);
+      }
+    }
+#else
+    (void)M;
+    (void)VMap;
+#endif
+    return true;
+  }
+
+  /// \brief read the IR file @param filename into @param module. When
+  /// @param lazy is true, the function bodies are only read when materialized
+  /// (see materialize and materializeAll), LLVM 4 or later
   static bool readIR(const std::string filename,
-                     std::unique_ptr<llvm::Module> &module) {
+                     std::unique_ptr<llvm::Module> &module,
+                     bool lazy = false) {
     llvm::SMDiagnostic SMD;
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
     module.reset(llvm::ParseIRFile(filename, SMD, llvm::getGlobalContext()));
@@ -109,8 +225,14 @@ public:
     module = llvm::parseIRFile(filename, SMD, llvm::getGlobalContext());
 #else
     static llvm::LLVMContext getGlobalContext;
-    module = llvm::parseIRFile(filename, SMD, getGlobalContext);
+#if (LLVM_VERSION_MAJOR >= 4)
+    if (lazy)
+      module = llvm::getLazyIRFileModule(filename, SMD, getGlobalContext);
+    else
 #endif
+      module = llvm::parseIRFile(filename, SMD, getGlobalContext);
+#endif
+    (void)lazy;
 
     if (!module) {
       llvm::errs() << "Failed parsing '" << filename << "' file:\n";
@@ -120,7 +242,52 @@ public:
     return true;
   }
 
+  /// \brief read the body of the function @param func of a lazily read
+  /// module, if not yet done
+  static bool materialize(llvm::Function &func) {
+#if (LLVM_VERSION_MAJOR >= 4)
+    if (func.isMaterializable()) {
+      if (llvm::Error err = func.materialize()) {
+        llvm::errs() << "Mart@Error: failed to read the function '"
+                     << func.getName()
+                     << "': " << llvm::toString(std::move(err)) << "\n";
+        return false;
+      }
+    }
+#else
+    (void)func;
+#endif
+    return true;
+  }
+
+  /// \brief read all the function bodies of a lazily read @param module
+  static bool materializeAll(llvm::Module &module) {
+#if (LLVM_VERSION_MAJOR >= 4)
+    if (llvm::Error err = module.materializeAll()) {
+      llvm::errs() << "Mart@Error: failed to read the module's functions: "
+                   << llvm::toString(std::move(err)) << "\n";
+      return false;
+    }
+#else
+    (void)module;
+#endif
+    return true;
+  }
+
+  /// \brief @return false if some function bodies of the lazily read
+  /// @param module are not yet read
+  static bool isMaterialized(llvm::Module const &module) {
+#if (LLVM_VERSION_MAJOR >= 4)
+    return module.isMaterialized();
+#else
+    (void)module;
+    return true;
+#endif
+  }
+
   static bool writeIR(const llvm::Module *module, const std::string filename) {
+    TelemetrySpan span("writeIR", "write",
+                       "{\"file\":" + Telemetry::quote(filename) + "}");
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
     std::string estr("");
     llvm::raw_fd_ostream Out(filename.c_str(), estr, llvm::sys::fs::F_None);
@@ -0,0 +1,241 @@
+#ifndef Telemetry_h__
+#define Telemetry_h__
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h> //open
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h> //write, getpid
+
+/**
+ * \brief Machine-readable performance telemetry of the Mart tools.
+ * \detail Two optional outputs:
+ *  - a Chrome trace-event file (JSON array format, loadable in
+ *    chrome://tracing or Perfetto) with a complete event per span;
+ *  - a JSON-lines progress stream with the start and end of the phases and
+ *    the progress of the long loops, with an estimated remaining time.
+ * Every event is written with a single write on a file opened in append
+ * mode, so that the forked processes of Mart's batch mode, which inherit the
+ * files, write their events into the same files (with their own pid). The
+ * closing bracket of the trace array is optional in the trace-event format
+ * and is not written. All times are wall clock times.
+ */
+class Telemetry {
+  int traceFd = -1;
+  int progressFd = -1;
+  std::chrono::steady_clock::time_point startTime;
+  std::mutex mtx;
+
+  struct ProgressState {
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point lastEmitted;
+  };
+  std::map<std::string, ProgressState> progressStates;
+
+  // Minimum interval between two progress lines of the same loop
+  static constexpr double progressIntervalSeconds = 0.5;
+
+  Telemetry() : startTime(std::chrono::steady_clock::now()) {}
+
+  static int openAppend(std::string const &filename, bool truncate) {
+    return ::open(filename.c_str(),
+                  O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0),
+                  0644);
+  }
+
+  static void writeLine(int fd, std::string const &line) {
+    if (fd >= 0 && ::write(fd, line.data(), line.size()) < 0)
+      std::perror("Mart@Warning: failed to write telemetry");
+  }
+
+  static unsigned long getThreadNumber() {
+    return std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000;
+  }
+
+public:
+  static Telemetry &get() {
+    static Telemetry instance;
+    return instance;
+  }
+
+  /// \brief JSON string literal of @param str
+  static std::string quote(std::string const &str) {
+    std::string ret("\"");
+    for (char c : str) {
+      switch (c) {
+      case '"':
+        ret += "\\\"";
+        break;
+      case '\\':
+        ret += "\\\\";
+        break;
+      case '\n':
+        ret += "\\n";
+        break;
+      case '\t':
+        ret += "\\t";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+          ret += buf;
+        } else {
+          ret += c;
+        }
+      }
+    }
+    return ret + "\"";
+  }
+
+  /// \brief microseconds since the telemetry was created
+  long long nowMicros() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - startTime)
+        .count();
+  }
+
+  /// \brief write the trace events into @param filename (overwritten)
+  bool openTrace(std::string const &filename) {
+    traceFd = openAppend(filename, true);
+    if (traceFd < 0)
+      return false;
+    writeLine(traceFd, "[\n");
+    return true;
+  }
+
+  /// \brief write the progress stream into @param filename (overwritten)
+  bool openProgress(std::string const &filename) {
+    progressFd = openAppend(filename, true);
+    return progressFd >= 0;
+  }
+
+  void close() {
+    if (traceFd >= 0)
+      ::close(traceFd);
+    if (progressFd >= 0)
+      ::close(progressFd);
+    traceFd = progressFd = -1;
+  }
+
+  bool isEnabled() const { return traceFd >= 0 || progressFd >= 0; }
+
+  /// \brief record a complete event of @param durMicros microseconds,
+  /// started at @param startMicros. @param argsJson is a JSON object (or
+  /// empty) of the event's arguments
+  void addCompleteEvent(std::string const &name, std::string const &category,
+                        long long startMicros, long long durMicros,
+                        std::string const &argsJson = "") {
+    if (traceFd < 0)
+      return;
+    std::string line = "{\"name\":" + quote(name) +
+                       ",\"cat\":" + quote(category) +
+                       ",\"ph\":\"X\",\"ts\":" + std::to_string(startMicros) +
+                       ",\"dur\":" + std::to_string(durMicros) +
+                       ",\"pid\":" + std::to_string(getpid()) +
+                       ",\"tid\":" + std::to_string(getThreadNumber());
+    if (!argsJson.empty())
+      line += ",\"args\":" + argsJson;
+    line += "},\n";
+    writeLine(traceFd, line);
+  }
+
+  /// \brief record the start or end (@param isBegin) of the phase
+  /// @param name in the progress stream
+  void addPhaseEvent(std::string const &name, bool isBegin,
+                     double seconds = 0) {
+    if (progressFd < 0)
+      return;
+    std::string line = "{\"type\":\"" + std::string(isBegin ? "begin" : "end") +
+                       "\",\"phase\":" + quote(name) +
+                       ",\"time\":" + std::to_string(nowMicros() / 1e6) +
+                       ",\"pid\":" + std::to_string(getpid());
+    if (!isBegin)
+      line += ",\"seconds\":" + std::to_string(seconds);
+    line += "}\n";
+    writeLine(progressFd, line);
+  }
+
+  /// \brief report that @param done of the @param total items of the loop
+  /// @param name are processed. The lines are at most every
+  /// progressIntervalSeconds, except for the last item
+  void progress(std::string const &name, unsigned long done,
+                unsigned long total) {
+    if (progressFd < 0)
+      return;
+    auto now = std::chrono::steady_clock::now();
+    double elapsed;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      auto it = progressStates.find(name);
+      if (it == progressStates.end())
+        it = progressStates.emplace(name, ProgressState{now, now}).first;
+      else if (done < total &&
+               std::chrono::duration<double>(now - it->second.lastEmitted)
+                       .count() < progressIntervalSeconds)
+        return;
+      it->second.lastEmitted = now;
+      elapsed = std::chrono::duration<double>(now - it->second.start).count();
+      if (done >= total)
+        progressStates.erase(it);
+    }
+    std::string line = "{\"type\":\"progress\",\"phase\":" + quote(name) +
+                       ",\"time\":" + std::to_string(nowMicros() / 1e6) +
+                       ",\"pid\":" + std::to_string(getpid()) +
+                       ",\"done\":" + std::to_string(done) +
+                       ",\"total\":" + std::to_string(total) +
+                       ",\"elapsed\":" + std::to_string(elapsed);
+    if (done > 0 && done <= total)
+      line += ",\"eta\":" + std::to_string(elapsed * (total - done) / done);
+    line += "}\n";
+    writeLine(progressFd, line);
+  }
+}; // class Telemetry
+
+/**
+ * \brief A span of the trace, from its construction to its end (or
+ * destruction). The spans of category "phase" are also written into the
+ * progress stream.
+ */
+class TelemetrySpan {
+  std::string name;
+  std::string category;
+  std::string argsJson;
+  long long startMicros;
+  bool active;
+
+public:
+  TelemetrySpan(std::string const &spanName, std::string const &spanCategory,
+                std::string const &spanArgsJson = "")
+      : startMicros(0), active(Telemetry::get().isEnabled()) {
+    if (!active)
+      return;
+    name = spanName;
+    category = spanCategory;
+    argsJson = spanArgsJson;
+    startMicros = Telemetry::get().nowMicros();
+    if (category == "phase")
+      Telemetry::get().addPhaseEvent(name, true);
+  }
+  TelemetrySpan(TelemetrySpan const &) = delete;
+  TelemetrySpan &operator=(TelemetrySpan const &) = delete;
+  ~TelemetrySpan() { end(); }
+
+  void end() {
+    if (!active)
+      return;
+    active = false;
+    Telemetry &telemetry = Telemetry::get();
+    long long durMicros = telemetry.nowMicros() - startMicros;
+    telemetry.addCompleteEvent(name, category, startMicros, durMicros,
+                               argsJson);
+    if (category == "phase")
+      telemetry.addPhaseEvent(name, false, durMicros / 1e6);
+  }
+}; // class TelemetrySpan
+
+#endif //~Telemetry_h__
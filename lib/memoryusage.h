@@ -0,0 +1,162 @@
+/**
+ * -==== memoryusage.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class MemoryUsageTracker, which records the peak
+ *            resident memory (RSS) of each phase of a Mart run
+ */
+
+#ifndef __MART_GENMU_memoryusage__
+#define __MART_GENMU_memoryusage__
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/resource.h> //getrusage
+#include <unistd.h>       //sysconf
+#include <vector>
+
+#include "Telemetry.h"
+
+namespace mart {
+
+/**
+ * \brief Peak resident memory of the phases of a run (read, preprocess,
+ * mutate, TCE, ...).
+ * \detail On Linux, the peak RSS of the process (VmHWM) is reset at the start
+ * of each phase (through /proc/self/clear_refs), so that the peak of a phase
+ * is its own. Elsewhere, or when the reset fails, the peak of a phase is the
+ * peak of the process since its start (getrusage), which is still the peak
+ * of the phase when it is the highest so far.
+ * Each phase is also a span of the performance telemetry (-trace-file,
+ * -progress-file), when enabled.
+ */
+class MemoryUsageTracker {
+public:
+  struct PhaseUsage {
+    std::string name;
+    // Peak RSS in KB
+    unsigned long peakKB;
+    // Whether the peak is the phase's own or the process' since its start
+    bool isPhasePeak;
+  };
+
+private:
+  std::vector<PhaseUsage> phases;
+  std::string curPhase;
+  bool curPhaseIsReset = false;
+  std::unique_ptr<TelemetrySpan> curPhaseSpan;
+
+  /// \brief read the value of the field @param key (in KB) of
+  /// /proc/self/status. @return 0 if not available
+  static unsigned long readProcStatusKB(std::string const &key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() &&
+          line[key.size()] == ':') {
+        std::istringstream iss(line.substr(key.size() + 1));
+        unsigned long value = 0;
+        iss >> value;
+        return value;
+      }
+    }
+    return 0;
+  }
+
+public:
+  /// \brief current RSS of the process in KB (0 if not available)
+  static unsigned long getCurrentRSSKB() { return readProcStatusKB("VmRSS"); }
+
+  /// \brief peak RSS of the process in KB, since its start or the last reset
+  static unsigned long getPeakRSSKB() {
+    unsigned long peak = readProcStatusKB("VmHWM");
+    if (peak == 0) {
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage) == 0)
+        peak = usage.ru_maxrss;
+    }
+    return peak;
+  }
+
+  /// \brief peak RSS, in KB, of the largest terminated and waited-for child
+  /// process
+  static unsigned long getChildrenPeakRSSKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_CHILDREN, &usage) == 0)
+      return usage.ru_maxrss;
+    return 0;
+  }
+
+  /// \brief physical memory of the machine in KB (0 if not available)
+  static unsigned long getPhysicalMemoryKB() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0)
+      return 0;
+    return (unsigned long)pages / 1024 * (unsigned long)pageSize;
+  }
+
+  /// \brief reset the peak RSS of the process to its current RSS (Linux)
+  static bool resetPeakRSS() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (!clearRefs.is_open())
+      return false;
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+  }
+
+  /// \brief end the current phase (if any) and start the phase @param name
+  void startPhase(std::string const &name) {
+    endPhase();
+    curPhase = name;
+    curPhaseIsReset = resetPeakRSS();
+    curPhaseSpan.reset(new TelemetrySpan(name, "phase"));
+  }
+
+  /// \brief end the current phase (if any) and record its peak RSS
+  void endPhase() {
+    if (curPhase.empty())
+      return;
+    curPhaseSpan.reset();
+    addPhase(curPhase, getPeakRSSKB(), curPhaseIsReset);
+    curPhase.clear();
+  }
+
+  /// \brief record the peak RSS @param peakKB of a phase measured elsewhere
+  /// (e.g. in a child process)
+  void addPhase(std::string const &name, unsigned long peakKB,
+                bool isPhasePeak = true) {
+    for (auto &phase : phases) {
+      if (phase.name == name) {
+        if (peakKB > phase.peakKB)
+          phase.peakKB = peakKB;
+        phase.isPhasePeak = phase.isPhasePeak && isPhasePeak;
+        return;
+      }
+    }
+    phases.push_back({name, peakKB, isPhasePeak});
+  }
+
+  std::vector<PhaseUsage> const &getPhases() const { return phases; }
+
+  /// \brief the peak RSS of each phase, for the run's info file
+  std::string getStats() const {
+    std::string ret;
+    for (auto &phase : phases)
+      ret += "# Peak memory (RSS) of phase '" + phase.name +
+             "': " + std::to_string(phase.peakKB / 1024) + " MB" +
+             (phase.isPhasePeak ? "" : " (peak since the start)") + "\n";
+    return ret;
+  }
+}; // class MemoryUsageTracker
+
+} // namespace mart
+
+#endif //__MART_GENMU_memoryusage__
@@ -184,6 +184,39 @@ void PredictionModule::predict(std::vector<std::vector<float>> const &X_matrix,
   // randomForestPredict(finalFeatures, in_stream, prediction);
 }
 
+bool PredictionModule::loadModel() {
+  std::fstream in_stream(modelFilename, std::ios_base::in);
+  if (!in_stream.good()) {
+    llvm::errs() << "Mart@Error: failed to open the prediction model file '"
+                 << modelFilename << "'\n";
+    return false;
+  }
+  // get list of feature in the model
+  std::string line;
+  std::getline(in_stream, line);
+  std::istringstream ss(line);
+  loadedFeaturesnames.clear();
+  while (ss.good()) {
+    std::string fstr;
+    ss >> fstr;
+    loadedFeaturesnames.push_back(fstr);
+  }
+  loadedClassifier = std::make_shared<FastBDT::Classifier>(in_stream);
+  return true;
+}
+
+float PredictionModule::predictOne(
+    std::unordered_map<std::string, float> const &features) {
+  assert(loadedClassifier && "predictOne called before loadModel");
+  std::vector<float> event;
+  event.reserve(loadedFeaturesnames.size());
+  for (auto &fname : loadedFeaturesnames) {
+    auto it = features.find(fname);
+    event.push_back(it == features.end() ? 0.0 : it->second);
+  }
+  return loadedClassifier->predict(event);
+}
+
 /// Train model and write model into predictionModelFilename
 /// Each contained vector correspond to a feature
 std::map<unsigned long, double> PredictionModule::train(std::vector<std::vector<float>> const &X_matrix,
@@ -20,11 +20,16 @@
 #ifndef __MART_GENMU_mutantsSelection_MutantSelection__
 #define __MART_GENMU_mutantsSelection_MutantSelection__
 
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace dg {
 class LLVMDependenceGraph;
 }
+namespace FastBDT {
+class Classifier;
+}
 
 #include "../typesops.h" //JsonBox
 #include "../usermaps.h"
@@ -34,6 +39,9 @@ namespace selection {
 
 class PredictionModule {
   std::string modelFilename;
+  // Model loaded by loadModel, and its features names
+  std::shared_ptr<FastBDT::Classifier> loadedClassifier;
+  std::vector<std::string> loadedFeaturesnames;
   void fastBDTPredict(std::vector<std::vector<float>> const &X_matrix,
                       std::fstream &in_stream,
                       std::vector<float> &prediction);
@@ -59,6 +67,13 @@ public:
   /// Train model and write model into predictionModelFilename
   /// Each contained vector correspond to a feature
   std::map<unsigned long, double> train(std::vector<std::vector<float>> const &X_matrix, std::vector<std::string> const &modelFeaturesnames, std::vector<bool> const &isCoupled, std::vector<float> const &weights, unsigned treeNumber = 1000, unsigned treeDepth=3);
+
+  /// Load the model once, for the repeated predictions of predictOne
+  bool loadModel();
+  /// make the prediction of a single mutant whose features values are given
+  /// by name in @param features (the features absent are 0). The model must
+  /// be loaded with loadModel
+  float predictOne(std::unordered_map<std::string, float> const &features);
   
 }; // PredictionModule
 
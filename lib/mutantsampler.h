@@ -0,0 +1,300 @@
+/**
+ * -==== mutantsampler.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class MutantSampler, the deterministic stratified
+ *            sampling of the mutants at generation time
+ */
+
+#ifndef __MART_GENMU_mutantsampler__
+#define __MART_GENMU_mutantsampler__
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "typesops.h"
+
+namespace mart {
+
+/**
+ * \brief Stratified sampling of the mutants, applied to the mutants of each
+ * statement before they get an ID, so that only the sampled mutants are
+ * added into the meta-mutant module.
+ * \detail The mutants are divided into strata by function and mutant type
+ * (and source file when the budget is per file). The budget is either a
+ * percentage of every stratum, or a number of mutants per function, mutant
+ * type or source file that is divided among the strata of that unit in
+ * proportion to their sizes (largest remainder). The sizes of the strata are
+ * obtained with a counting pass, where the mutants are generated but not
+ * added into the module.
+ * Within a stratum, 'q' of its 'n' mutants are selected by systematic
+ * sampling in generation order: the k-th mutant is sampled when
+ * floor(((k+1)*q + o) / n) > floor((k*q + o) / n), where the offset 'o' is
+ * derived from the seed and the stratum. The selection only depends on the
+ * seed and the generated mutants, not on the number of generation threads.
+ */
+class MutantSampler {
+public:
+  enum BudgetUnit { PerFunction, PerMutantType, PerSourceFile };
+
+private:
+  // Denominator of the sampling rate in percentage mode
+  static const unsigned long long rateDenominator = 1000000;
+
+  bool isRateBudget = true;
+  unsigned long long rateNumerator = rateDenominator;
+  unsigned long long countBudget = 0;
+  BudgetUnit budgetUnit = PerFunction;
+  unsigned seed = 0;
+
+  // Set in the counting pass, where the mutants are only counted
+  bool isCountingPass = false;
+
+  struct Stratum {
+    unsigned long long size = 0;
+    unsigned long long quota = 0;
+    // Number of mutants of the stratum seen so far
+    unsigned long long seen = 0;
+  };
+  std::unordered_map<std::string, Stratum> strata;
+
+  unsigned long long numSeen = 0;
+  unsigned long long numSampled = 0;
+
+  /// \brief @return a deterministic pseudo random number from the seed and
+  /// @param key
+  unsigned long long getHash(std::string const &key) const {
+    llvm::MD5 hash;
+    hash.update(std::to_string(seed));
+    hash.update(";");
+    hash.update(key);
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    return std::strtoull(str.str().substr(0, 15).str().c_str(), nullptr, 16);
+  }
+
+  static std::string getStmtSourceFile(MatchStmtIR const &stmtIR) {
+    for (auto *val : stmtIR.getIRList()) {
+      if (auto *inst = llvm::dyn_cast<llvm::Instruction>(val)) {
+        std::string loc = UtilsFunctions::getSrcLoc(inst);
+        if (!loc.empty())
+          return loc.substr(0, loc.find(':'));
+      }
+    }
+    return "";
+  }
+
+  std::string getStratumKey(std::string const &funcName,
+                            std::string const &typeName,
+                            std::string const &srcFile) const {
+    std::string key = funcName + "\n" + typeName;
+    if (budgetUnit == PerSourceFile)
+      key += "\n" + srcFile;
+    return key;
+  }
+
+  std::string getUnitKey(std::string const &stratumKey) const {
+    size_t sep = stratumKey.find('\n');
+    switch (budgetUnit) {
+    case PerFunction:
+      return stratumKey.substr(0, sep);
+    case PerMutantType:
+      return stratumKey.substr(sep + 1, stratumKey.find('\n', sep + 1) -
+                                            (sep + 1));
+    case PerSourceFile:
+      return stratumKey.substr(stratumKey.find('\n', sep + 1) + 1);
+    }
+    return "";
+  }
+
+public:
+  /**
+   * \brief set the sampling budget.
+   * @param budget is either a percentage ('<value>%') or a number of mutants
+   * per @param unit ('function', 'type' or 'file').
+   * @return false if the budget or the unit is invalid.
+   */
+  bool initialize(std::string const &budget, std::string const &unit,
+                  unsigned samplingSeed) {
+    seed = samplingSeed;
+    if (unit == "function") {
+      budgetUnit = PerFunction;
+    } else if (unit == "type") {
+      budgetUnit = PerMutantType;
+    } else if (unit == "file") {
+      budgetUnit = PerSourceFile;
+    } else {
+      llvm::errs() << "Mart@Error: invalid sampling unit '" << unit
+                   << "' (expected 'function', 'type' or 'file')\n";
+      return false;
+    }
+
+    llvm::StringRef budgetRef(budget);
+    budgetRef = budgetRef.trim();
+    if (budgetRef.endswith("%")) {
+      isRateBudget = true;
+      double percent;
+      if (budgetRef.drop_back().trim().getAsDouble(percent) ||
+          percent <= 0.0 || percent > 100.0) {
+        llvm::errs() << "Mart@Error: invalid sampling percentage '" << budget
+                     << "'\n";
+        return false;
+      }
+      rateNumerator = (unsigned long long)(percent / 100.0 * rateDenominator);
+      if (rateNumerator == 0)
+        rateNumerator = 1;
+    } else {
+      isRateBudget = false;
+      if (budgetRef.getAsInteger(10, countBudget) || countBudget == 0) {
+        llvm::errs() << "Mart@Error: invalid sampling budget '" << budget
+                     << "' (expected a percentage or a positive number)\n";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// \brief whether a counting pass is needed to know the strata sizes
+  bool needsCountingPass() const { return !isRateBudget; }
+  void setCountingPass() { isCountingPass = true; }
+
+  /**
+   * \brief compute the quota of each stratum from the strata sizes counted
+   * by @param counter (the sampler of the counting pass)
+   */
+  void computeQuotas(MutantSampler const &counter) {
+    strata.clear();
+    std::map<std::string, std::vector<std::string>> unitsStrata;
+    for (auto &sP : counter.strata) {
+      strata[sP.first].size = sP.second.seen;
+      unitsStrata[getUnitKey(sP.first)].push_back(sP.first);
+    }
+    for (auto &uP : unitsStrata) {
+      std::vector<std::string> &unitStrata = uP.second;
+      // Order by key for determinism
+      std::sort(unitStrata.begin(), unitStrata.end());
+      unsigned long long total = 0;
+      for (auto &key : unitStrata)
+        total += strata[key].size;
+      unsigned long long target = std::min(countBudget, total);
+      unsigned long long allocated = 0;
+      // <remainder, tie breaker, key>
+      std::vector<std::pair<std::pair<unsigned long long, unsigned long long>,
+                            std::string>>
+          remainders;
+      for (auto &key : unitStrata) {
+        Stratum &st = strata[key];
+        st.quota = target * st.size / total;
+        allocated += st.quota;
+        remainders.push_back(std::make_pair(
+            std::make_pair(target * st.size % total, getHash(key)), key));
+      }
+      std::sort(remainders.rbegin(), remainders.rend());
+      for (unsigned i = 0; allocated < target; ++i, ++allocated)
+        ++strata[remainders[i].second].quota;
+    }
+  }
+
+  /**
+   * \brief remove from @param mutants, the mutants (not yet attached to the
+   * module) of the statement @param stmtIR of function @param Func, those
+   * that are not sampled. In the counting pass, all mutants are counted and
+   * removed.
+   */
+  void sampleStmtMutants(llvm::Function const &Func,
+                         MatchStmtIR const &stmtIR, MutantsOfStmt &mutants) {
+    std::string funcName = Func.getName().str();
+    std::string srcFile;
+    if (budgetUnit == PerSourceFile)
+      srcFile = getStmtSourceFile(stmtIR);
+    for (unsigned mind = 0; mind < mutants.getNumMuts();) {
+      std::string key =
+          getStratumKey(funcName, mutants.getTypeName(mind), srcFile);
+      Stratum &st = strata[key];
+      unsigned long long k = st.seen++;
+      ++numSeen;
+      bool sampled = false;
+      if (!isCountingPass) {
+        unsigned long long num, den;
+        if (isRateBudget) {
+          num = rateNumerator;
+          den = rateDenominator;
+        } else {
+          assert(st.size > k && "Stratum larger than in the counting pass");
+          num = st.quota;
+          den = st.size;
+        }
+        if (k < den || isRateBudget) {
+          unsigned long long offset = getHash(key) % den;
+          sampled = ((k + 1) * num + offset) / den > (k * num + offset) / den;
+        }
+      }
+      if (sampled) {
+        ++numSampled;
+        ++mind;
+      } else {
+        mutants.remove(mind);
+      }
+    }
+  }
+
+  /// \brief add the counters of @param other (sampler of a generation
+  /// worker)
+  void addStats(MutantSampler const &other) {
+    numSeen += other.numSeen;
+    numSampled += other.numSampled;
+  }
+
+  unsigned long long getNumSeen() const { return numSeen; }
+  unsigned long long getNumSampled() const { return numSampled; }
+
+  /// \brief identifies the sampling (used in the mutation cache key)
+  std::string getContext() const {
+    std::string ret = "sample:" + std::to_string(seed) + ":" +
+                      std::to_string((int)budgetUnit) + ":";
+    if (isRateBudget)
+      return ret + std::to_string(rateNumerator) + "/" +
+             std::to_string(rateDenominator);
+    // The quotas depend on the whole module
+    std::vector<std::string> keys;
+    for (auto &sP : strata)
+      keys.push_back(sP.first);
+    std::sort(keys.begin(), keys.end());
+    llvm::MD5 hash;
+    for (auto &key : keys) {
+      hash.update(key);
+      hash.update(":" + std::to_string(strata.at(key).quota) + "/" +
+                  std::to_string(strata.at(key).size) + ";");
+    }
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    return ret + std::to_string(countBudget) + ":" + str.str().str();
+  }
+
+  std::string getStats() const {
+    return "# Mutants sampling: " + std::to_string(numSampled) + " of " +
+           std::to_string(numSeen) + " generated mutants sampled\n";
+  }
+}; // class MutantSampler
+
+} // namespace mart
+
+#endif //__MART_GENMU_mutantsampler__
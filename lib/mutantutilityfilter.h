@@ -0,0 +1,327 @@
+/**
+ * -==== mutantutilityfilter.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class MutantUtilityFilter, the filtering of the
+ *            mutants at generation time by their utility predicted by a
+ *            trained model
+ */
+
+#ifndef __MART_GENMU_mutantutilityfilter__
+#define __MART_GENMU_mutantutilityfilter__
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+#include "llvm/Support/CFG.h"
+#else
+#include "llvm/IR/CFG.h"
+#endif
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+
+#include "typesops.h"
+
+namespace mart {
+
+/**
+ * \brief Model predicting the utility of a mutant from its features (e.g.
+ * the models trained with mart-training). Implemented by the tools.
+ */
+class MutantUtilityPredictor {
+public:
+  virtual ~MutantUtilityPredictor() {}
+  /// \brief @return the predicted utility of the mutant whose features
+  /// values are @param features (by feature name, the absent features are 0).
+  /// May be called concurrently by the generation threads
+  virtual float predict(std::unordered_map<std::string, float> const &features) = 0;
+  /// \brief identifies the model (used in the mutation cache key)
+  virtual std::string getModelId() const = 0;
+};
+
+/**
+ * \brief Filtering of the mutants by predicted utility, applied to the
+ * mutants of each statement before they get an ID, so that the mutants with
+ * a low predicted utility are never added into the meta-mutant module.
+ * \detail The features of a mutant are those computed by mart-selection
+ * that need no dependence analysis (mutant type, basic block type, CFG depth,
+ * AST parents, data types and children context); the dependence features are
+ * 0. The mutants predicted below a threshold are dropped, and with a budget
+ * of 'k' mutants, only the 'k' best predicted mutants of the module are kept
+ * (plus those tied with the k-th). The budget needs the predictions of all
+ * the mutants, obtained with a counting pass, where the mutants are
+ * generated but not added into the module.
+ */
+class MutantUtilityFilter {
+  std::shared_ptr<MutantUtilityPredictor> predictor;
+  float threshold = -std::numeric_limits<float>::infinity();
+  unsigned long topK = 0;
+  // Smallest predicted utility kept with the budget, from the counting pass
+  float cutoff = -std::numeric_limits<float>::infinity();
+
+  // Set in the counting pass, where the mutants are only predicted
+  bool isCountingPass = false;
+  std::vector<float> countedScores;
+
+  // Informations on the basic blocks of the function being mutated, by
+  // instruction (taken before the function is modified)
+  struct BBInfo {
+    unsigned cfgDepth = 0;
+    unsigned cfgPredNum = 0;
+    unsigned cfgSuccNum = 0;
+    std::vector<std::string> typenames;
+  };
+  std::vector<BBInfo> funcBBInfos;
+  std::unordered_map<llvm::Instruction const *, unsigned> instToBBInfo;
+
+  unsigned long long numSeen = 0;
+  unsigned long long numKept = 0;
+
+  static std::string getTypeIdStr(llvm::Type const *type) {
+    return std::to_string(type->getTypeID());
+  }
+
+  static bool isIdentifier(llvm::Value const *val) {
+    return llvm::isa<llvm::AllocaInst>(val) ||
+           llvm::isa<llvm::GlobalVariable>(val) ||
+           llvm::isa<llvm::Argument>(val);
+  }
+
+  /// \brief compute the features of the mutant at @param mind of the
+  /// statement @param stmtIR into @param features
+  void computeFeatures(MatchStmtIR const &stmtIR, MutantsOfStmt &mutants,
+                       unsigned mind,
+                       std::unordered_map<std::string, float> &features) {
+    features.clear();
+    std::vector<llvm::Value *> const &stmtIRs = stmtIR.getIRList();
+
+    // Mutant type, as matcher and replacer
+    std::string const &typeName = mutants.getTypeName(mind);
+    auto sepPos = typeName.find('!');
+    features[typeName.substr(0, sepPos) + "-Matcher"] = 1;
+    if (sepPos != std::string::npos)
+      features[typeName.substr(sepPos + 1) + "-Replacer"] = 1;
+
+    features["Complexity"] = mutants.getNumMuts();
+
+    // Basic block of the statement
+    for (auto *val : stmtIRs) {
+      auto *inst = llvm::dyn_cast<llvm::Instruction>(val);
+      auto it = instToBBInfo.find(inst);
+      if (inst == nullptr || it == instToBBInfo.end())
+        continue;
+      BBInfo const &bbInfo = funcBBInfos[it->second];
+      features["CfgDepth"] = bbInfo.cfgDepth;
+      features["CfgPredNum"] = bbInfo.cfgPredNum;
+      features["CfgSuccNum"] = bbInfo.cfgSuccNum;
+      for (auto &bbtname : bbInfo.typenames)
+        features[bbtname] = 1;
+      break;
+    }
+
+    // AST parents, data types and children of the mutated instructions
+    std::unordered_set<llvm::Value const *> mutInsts;
+    for (unsigned pos : mutants.getIRRelevantPos(mind))
+      mutInsts.insert(stmtIRs[pos]);
+    std::unordered_set<std::string> astParentsOpcodeNames;
+    bool hasOperandDataType = false;
+    bool hasReturnDataType = false;
+    unsigned nLiteral = 0, nIdentifier = 0, nOperator = 0;
+    for (unsigned pos : mutants.getIRRelevantPos(mind)) {
+      llvm::Value const *minst = stmtIRs[pos];
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+      for (auto UI = minst->use_begin(), UE = minst->use_end(); UI != UE;
+           ++UI) {
+        const llvm::User *par = *UI;
+#else
+      for (auto *par : minst->users()) {
+#endif
+        if (mutInsts.count(par) != 0)
+          continue;
+        if (auto *astPar = llvm::dyn_cast<llvm::Instruction>(par)) {
+          astParentsOpcodeNames.insert(astPar->getOpcodeName());
+          if (!hasOperandDataType && !hasReturnDataType) {
+            features[getTypeIdStr(astPar->getType()) +
+                     "-Return-DataTypeContext"] = 1;
+            hasReturnDataType = true;
+          }
+        }
+      }
+
+      nLiteral = nIdentifier = nOperator = 0;
+      if (auto *minstU = llvm::dyn_cast<llvm::User>(minst)) {
+        for (unsigned i = 0, ie = minstU->getNumOperands(); i < ie; ++i) {
+          llvm::Value const *child = minstU->getOperand(i);
+          if (mutInsts.count(child) != 0)
+            continue;
+          nLiteral += (unsigned)llvm::isa<llvm::Constant>(child);
+          if (auto *isLoad = llvm::dyn_cast<llvm::LoadInst>(child)) {
+            if (isIdentifier(isLoad->getPointerOperand()))
+              ++nIdentifier;
+          } else if (isIdentifier(child)) {
+            ++nIdentifier;
+          } else if (llvm::isa<llvm::Instruction>(child)) {
+            ++nOperator;
+          }
+          features[getTypeIdStr(child->getType()) +
+                   "-Operand-DataTypeContext"] += 1;
+          hasOperandDataType = true;
+        }
+      }
+    }
+    features["AstNumParents"] = astParentsOpcodeNames.size();
+    for (auto &opname : astParentsOpcodeNames)
+      features[opname + "-ASTp"] = 1;
+    features["HasLiteralChild-ChildContext"] = (nLiteral > 0);
+    features["HasIdentifierChild-ChildContext"] = (nIdentifier > 0);
+    features["HasOperatorChild-ChildContext"] = (nOperator > 0);
+  }
+
+public:
+  /**
+   * \brief set the model @param utilityPredictor. The mutants predicted
+   * below @param minUtility are dropped and, if @param budget is not 0, only
+   * the @param budget best predicted mutants are kept.
+   */
+  void initialize(std::shared_ptr<MutantUtilityPredictor> utilityPredictor,
+                  float minUtility, unsigned long budget) {
+    predictor = utilityPredictor;
+    threshold = minUtility;
+    topK = budget;
+  }
+
+  /// \brief whether a counting pass is needed to know the budget's cutoff
+  bool needsCountingPass() const { return topK > 0; }
+  void setCountingPass() { isCountingPass = true; }
+
+  /// \brief compute the cutoff of the budget from the predictions of the
+  /// counting pass of @param counter
+  void computeCutoff(MutantUtilityFilter const &counter) {
+    std::vector<float> scores(counter.countedScores);
+    if (scores.size() <= topK)
+      return;
+    std::nth_element(scores.begin(), scores.begin() + (topK - 1),
+                     scores.end(), std::greater<float>());
+    cutoff = scores[topK - 1];
+  }
+
+  /**
+   * \brief get the basic blocks informations of the function @param Func,
+   * to call before it is modified by the mutation.
+   */
+  void startFunction(llvm::Function &Func) {
+    funcBBInfos.clear();
+    instToBBInfo.clear();
+    if (Func.isDeclaration())
+      return;
+    std::unordered_map<llvm::BasicBlock const *, unsigned> bbInfoIndex;
+    std::vector<llvm::BasicBlock const *> workQ;
+    llvm::BasicBlock const *entryBB = &Func.getEntryBlock();
+    bbInfoIndex.emplace(entryBB, 0);
+    funcBBInfos.emplace_back();
+    funcBBInfos.back().cfgDepth = 1;
+    workQ.push_back(entryBB);
+    // BFS
+    for (size_t qpos = 0; qpos < workQ.size(); ++qpos) {
+      llvm::BasicBlock const *bb = workQ[qpos];
+      unsigned index = bbInfoIndex.at(bb);
+      unsigned depth = funcBBInfos[index].cfgDepth;
+      unsigned nSuccs = 0, nPreds = 0;
+      for (auto succIt = llvm::succ_begin(bb), succE = llvm::succ_end(bb);
+           succIt != succE; ++succIt, ++nSuccs) {
+        if (bbInfoIndex.emplace(*succIt, funcBBInfos.size()).second) {
+          funcBBInfos.emplace_back();
+          funcBBInfos.back().cfgDepth = depth + 1;
+          workQ.push_back(*succIt);
+        }
+      }
+      for (auto predIt = llvm::pred_begin(bb), predE = llvm::pred_end(bb);
+           predIt != predE; ++predIt)
+        ++nPreds;
+      BBInfo &bbInfo = funcBBInfos[index];
+      bbInfo.cfgPredNum = nPreds;
+      bbInfo.cfgSuccNum = nSuccs;
+      // Type of the basic block from its name, without the count suffix
+      if (bb->getName().size() > 0) {
+        std::string bbTypename =
+            bb->getName().substr(0, bb->getName().rfind('.')).str();
+        auto sepPos = bbTypename.find('.');
+        bbInfo.typenames.push_back(bbTypename.substr(0, sepPos) + "-BBType");
+        if (sepPos != std::string::npos)
+          bbInfo.typenames.push_back(bbTypename.substr(sepPos + 1) +
+                                     "-BBType");
+      }
+      for (auto &inst : *bb)
+        instToBBInfo.emplace(&inst, index);
+    }
+  }
+
+  /**
+   * \brief remove from @param mutants, the mutants (not yet attached to the
+   * module) of the statement @param stmtIR that are predicted below the
+   * threshold or out of the budget. In the counting pass, all mutants are
+   * predicted and removed.
+   */
+  void filterStmtMutants(MatchStmtIR const &stmtIR, MutantsOfStmt &mutants) {
+    unsigned numMuts = mutants.getNumMuts();
+    if (numMuts == 0)
+      return;
+    std::vector<float> scores(numMuts);
+    std::unordered_map<std::string, float> features;
+    for (unsigned mind = 0; mind < numMuts; ++mind) {
+      computeFeatures(stmtIR, mutants, mind, features);
+      scores[mind] = predictor->predict(features);
+    }
+    numSeen += numMuts;
+    for (unsigned mind = numMuts; mind-- > 0;) {
+      bool kept = (scores[mind] >= threshold);
+      if (isCountingPass) {
+        if (kept)
+          countedScores.push_back(scores[mind]);
+        kept = false;
+      } else {
+        kept = kept && (scores[mind] >= cutoff);
+      }
+      if (kept)
+        ++numKept;
+      else
+        mutants.remove(mind);
+    }
+  }
+
+  /// \brief add the counters of @param other (filter of a generation
+  /// worker)
+  void addStats(MutantUtilityFilter const &other) {
+    numSeen += other.numSeen;
+    numKept += other.numKept;
+  }
+
+  /// \brief identifies the filtering (used in the mutation cache key)
+  std::string getContext() const {
+    return "utility:" + predictor->getModelId() + ":" +
+           std::to_string(threshold) + ":" + std::to_string(topK) + ":" +
+           std::to_string(cutoff);
+  }
+
+  std::string getStats() const {
+    return "# Utility prediction: " + std::to_string(numKept) + " of " +
+           std::to_string(numSeen) + " generated mutants kept\n";
+  }
+}; // class MutantUtilityFilter
+
+} // namespace mart
+
+#endif //__MART_GENMU_mutantutilityfilter__
@@ -9,26 +9,41 @@
  * \brief     Implementation of Mutation class
  */
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <queue>
 #include <regex>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "ReadWriteIRObj.h"
 
+#include "memoryusage.h"
 #include "mutation.h"
+#include "mutantsampler.h"
+#include "mutantutilityfilter.h"
+#include "mutationcache.h"
+#include "shardmerger.h"
 #include "operatorsClasses/GenericMuOpBase.h"
 #include "tce.h" //Trivial Compiler Equivalence
+#include "tceverdictcache.h"
 #include "typesops.h"
 #include "usermaps.h"
 
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -45,6 +60,7 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/Linker/Linker.h" //for Linker
 #endif
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Local.h"
@@ -74,6 +90,34 @@
 
 using namespace mart;
 
+namespace {
+/**
+ * \brief Rules of the generation-time trivial equivalence filter. The mutants
+ * pruned by a rule are dropped before they are added into the meta-mutant
+ * module (they get no mutant ID).
+ */
+enum TrivialEquivalenceRule {
+  // Same IRs as the original statement
+  IdenticalToOriginal = 0,
+  // Only the operator of 'x op c' changed, where 'c' is the neutral element
+  // of both operators (e.g. 'x + 0' --> 'x - 0')
+  NeutralOperand,
+  // Operands of a commutative operation swapped (with the swapped predicate
+  // for comparisons)
+  CommutedOperands,
+  // Integer comparison of a value with itself changed into another
+  // comparison that gives the same result (e.g. 'x <= x' --> 'x == x')
+  SameOperandsComparison,
+  // Same IRs as a previous mutant of the same statement
+  DuplicateInStatement,
+  NumTrivialEquivalenceRules
+};
+
+const char *trivialEquivalenceRuleNames[NumTrivialEquivalenceRules] = {
+    "IdenticalToOriginal", "NeutralOperand", "CommutedOperands",
+    "SameOperandsComparison", "DuplicateInStatement"};
+} // namespace
+
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
 static bool oldVersionIsEHPad(llvm::Instruction const *Inst) {
   switch (Inst->getOpcode()) {
@@ -137,8 +181,77 @@ getWMUnsafeInstructions(llvm::BasicBlock *BB,
 
 Mutation::Mutation(llvm::Module &module, std::string mutConfFile,
                    DumpMutFunc_t writeMutsF, std::string scopeJsonFile)
-    : forKLEESEMu(true), funcForKLEESEMu(nullptr),
-      moduleInfo(&module, &usermaps), writeMutantsCallback(writeMutsF) {
+    : forKLEESEMu(true), funcForKLEESEMu(nullptr), numGenerationThreads(1),
+      numTCEThreads(1), mutatedStmtCount(0), isGenerationWorker(false),
+      sharedConfiguration(false), configurationOnly(false),
+      trivialEquivalencePruning(true),
+      unreachablePrunedMutants(0), isDryRun(false), enumerator(nullptr),
+      memoryTracker(nullptr), checkMutantMaterialization(false),
+      numMaterializationChecked(0), numMaterializationDiffering(0),
+      shardIndex(0), shardCount(1), ownUsermaps(new UserMaps),
+      usermaps(*ownUsermaps), moduleInfo(&module, &usermaps),
+      writeMutantsCallback(writeMutsF) {
+  // get mutation config (operators), used by the preprocessing
+  assert(getConfiguration(mutConfFile) &&
+         "@Mutation(): getConfiguration(mutconfFile) Failed!");
+
+  initializeInputModule(module, scopeJsonFile);
+}
+
+/**
+ * \brief Mutation of @param module with the mutation operators configuration
+ * of @param configSource, which is not parsed again, and its UserMaps, which
+ * are not built again (used by the batch mode to mutate several modules with
+ * the same configuration). @param configSource must outlive this object.
+ */
+Mutation::Mutation(llvm::Module &module, Mutation const &configSource,
+                   DumpMutFunc_t writeMutsF, std::string scopeJsonFile)
+    : configuration(configSource.configuration), forKLEESEMu(true),
+      funcForKLEESEMu(nullptr), numGenerationThreads(1), numTCEThreads(1),
+      mutatedStmtCount(0), isGenerationWorker(false), sharedConfiguration(true),
+      configurationOnly(false), trivialEquivalencePruning(true),
+      unreachablePrunedMutants(0),
+      isDryRun(false), enumerator(nullptr),
+      memoryTracker(nullptr), checkMutantMaterialization(false),
+      numMaterializationChecked(0), numMaterializationDiffering(0),
+      shardIndex(0), shardCount(1), mutConfDigest(configSource.mutConfDigest),
+      usermaps(configSource.usermaps), moduleInfo(&module, &usermaps),
+      writeMutantsCallback(writeMutsF) {
+  initializeInputModule(module, scopeJsonFile);
+
+  mutatorsMatchAttempts.assign(configuration.mutators.size(), 0);
+  mutatorsMatchSuccesses.assign(configuration.mutators.size(), 0);
+  trivialPrunedMutants.assign(NumTrivialEquivalenceRules, 0);
+}
+
+/**
+ * \brief Mutation object without module, holding the mutation operators
+ * configuration of @param mutConfFile and its UserMaps, as configuration
+ * source of the Mutation objects of the modules of a batch.
+ */
+Mutation::Mutation(std::string mutConfFile)
+    : forKLEESEMu(true), funcForKLEESEMu(nullptr), currentInputModule(nullptr),
+      currentMetaMutantModule(nullptr), curMutantID(0),
+      numGenerationThreads(1), numTCEThreads(1), mutatedStmtCount(0),
+      isGenerationWorker(false), sharedConfiguration(false),
+      configurationOnly(true), trivialEquivalencePruning(true),
+      unreachablePrunedMutants(0), isDryRun(false), enumerator(nullptr),
+      memoryTracker(nullptr), checkMutantMaterialization(false),
+      numMaterializationChecked(0), numMaterializationDiffering(0),
+      shardIndex(0), shardCount(1), ownUsermaps(new UserMaps),
+      usermaps(*ownUsermaps), moduleInfo(nullptr, &usermaps),
+      writeMutantsCallback(nullptr) {
+  bool parsed = getConfiguration(mutConfFile);
+  assert(parsed && "@Mutation(): getConfiguration(mutconfFile) Failed!");
+  (void)parsed;
+}
+
+void Mutation::initializeInputModule(llvm::Module &module,
+                                     std::string const &scopeJsonFile) {
+  // Get scope info (before anything reads the functions bodies, which may
+  // only be read for the functions in scope)
+  mutationScope.Initialize(module, scopeJsonFile);
+
   // tranform the PHI Node with any non-constant incoming value with reg2mem
   preprocessVariablePhi(module);
 
@@ -147,13 +260,6 @@ Mutation::Mutation(llvm::Module &module, std::string mutConfFile,
   // for now the input is transformed (mutated to become mutant)
   currentMetaMutantModule = currentInputModule;
 
-  // get mutation config (operators)
-  assert(getConfiguration(mutConfFile) &&
-         "@Mutation(): getConfiguration(mutconfFile) Failed!");
-
-  // Get scope info
-  mutationScope.Initialize(module, scopeJsonFile);
-
   // initialize mutantIDSelectorName
   getanothermutantIDSelectorName();
   curMutantID = 0;
@@ -162,9 +268,152 @@ Mutation::Mutation(llvm::Module &module, std::string mutConfFile,
   getanotherPostMutantPointFuncName();
 }
 
+/**
+ * \brief Mutation object used by the parallel generation to mutate the single
+ * function defined in @param funcModule (which lives in the worker's own
+ * LLVMContext). The module was already preprocessed by @param parent, only
+ * its configuration and names are reused.
+ */
+Mutation::Mutation(llvm::Module &funcModule, Mutation const &parent)
+    : configuration(parent.configuration),
+      mutantIDSelectorName(parent.mutantIDSelectorName),
+      mutantIDSelectorName_Func(parent.mutantIDSelectorName_Func),
+      postMutationPointFuncName(parent.postMutationPointFuncName),
+      forKLEESEMu(parent.forKLEESEMu), funcForKLEESEMu(nullptr),
+      currentInputModule(&funcModule), currentMetaMutantModule(&funcModule),
+      curMutantID(0), numGenerationThreads(1), numTCEThreads(1),
+      mutatedStmtCount(0), isGenerationWorker(true), sharedConfiguration(true),
+      configurationOnly(false),
+      trivialEquivalencePruning(parent.trivialEquivalencePruning),
+      unreachableFuncs(parent.unreachableFuncs), unreachablePrunedMutants(0),
+      isDryRun(false), enumerator(nullptr),
+      memoryTracker(nullptr), checkMutantMaterialization(false),
+      numMaterializationChecked(0), numMaterializationDiffering(0),
+      shardIndex(0), shardCount(1),
+      ownUsermaps(new UserMaps), usermaps(*ownUsermaps),
+      moduleInfo(&funcModule, &usermaps),
+      writeMutantsCallback(nullptr) {
+  if (forKLEESEMu)
+    funcForKLEESEMu = funcModule.getFunction(mutantIDSelectorName_Func);
+  if (parent.mutantSampler)
+    mutantSampler.reset(new MutantSampler(*parent.mutantSampler));
+  if (parent.utilityFilter)
+    utilityFilter.reset(new MutantUtilityFilter(*parent.utilityFilter));
+  mutationScope.copySrcLineRanges(parent.mutationScope);
+  for (auto &Func : funcModule) {
+    auto it = parent.mutableBasicBlocks.find(Func.getName().str());
+    if (it != parent.mutableBasicBlocks.end())
+      mutableBasicBlocks.insert(*it);
+  }
+  mutatorsMatchAttempts.assign(configuration.mutators.size(), 0);
+  mutatorsMatchSuccesses.assign(configuration.mutators.size(), 0);
+  trivialPrunedMutants.assign(NumTrivialEquivalenceRules, 0);
+}
+
+/**
+ * \brief Only generate, for each mutator, the replacements that are not
+ * implied by the others (e.g. sufficient set of the relational operators).
+ * Must be called before doMutate.
+ */
+void Mutation::setSufficientSetMode() {
+  configuration.reduceToSufficientSets(usermaps);
+  // The generated mutants differ from those of the full configuration
+  mutConfDigest += ";sufficientSet";
+}
+
+/**
+ * \brief Enable the persistent cache of the mutants of each function, stored
+ * in the directory @param cacheDir. Must be called before doMutate.
+ */
+bool Mutation::setMutationCache(std::string const &cacheDir) {
+#if (LLVM_VERSION_MAJOR <= 3)
+  llvm::errs() << "Mart@Warning: the mutation cache requires LLVM 4 or later, "
+                  "it is disabled.\n";
+  (void)cacheDir;
+  return false;
+#else
+  mutationCache.reset(new MutationCache(cacheDir));
+  if (!mutationCache->initialize()) {
+    mutationCache.reset();
+    return false;
+  }
+  return true;
+#endif
+}
+
+/**
+ * \brief Enable the persistent cache of the TCE verdicts of the mutants,
+ * stored in the directory @param cacheDir. Must be called before doTCE.
+ */
+bool Mutation::setTCEVerdictCache(std::string const &cacheDir) {
+#if (LLVM_VERSION_MAJOR <= 3)
+  llvm::errs() << "Mart@Warning: the TCE verdict cache requires LLVM 4 or "
+                  "later, it is disabled.\n";
+  (void)cacheDir;
+  return false;
+#else
+  tceVerdictCache.reset(new TCEVerdictCache(cacheDir));
+  if (!tceVerdictCache->initialize()) {
+    tceVerdictCache.reset();
+    return false;
+  }
+  return true;
+#endif
+}
+
+/**
+ * \brief Only add the sampled mutants into the meta-mutant module (see
+ * MutantSampler). @param budget is a percentage ('<value>%') or a number of
+ * mutants per @param unit ('function', 'type' or 'file'), @param seed makes
+ * the sampling deterministic. Must be called before doMutate.
+ */
+bool Mutation::setMutantSampling(std::string const &budget,
+                                 std::string const &unit, unsigned seed) {
+  mutantSampler.reset(new MutantSampler());
+  if (!mutantSampler->initialize(budget, unit, seed)) {
+    mutantSampler.reset();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Only add into the meta-mutant module the mutants whose utility
+ * predicted by @param predictor is at least @param minUtility and, if
+ * @param budget is not 0, that are among the @param budget best predicted
+ * (see MutantUtilityFilter). Must be called before doMutate.
+ */
+void Mutation::setUtilityFilter(
+    std::shared_ptr<MutantUtilityPredictor> predictor, float minUtility,
+    unsigned long budget) {
+  utilityFilter.reset(new MutantUtilityFilter());
+  utilityFilter->initialize(predictor, minUtility, budget);
+}
+
+/**
+ * \brief Only mutate the functions of the shard @param index (from 0) of
+ * @param count, to generate the mutants of a module with several processes
+ * whose outputs are merged with mart-merge (see computeShardFunctions). Must
+ * be called before doMutate.
+ */
+bool Mutation::setShard(unsigned index, unsigned count) {
+  if (count == 0 || index >= count) {
+    llvm::errs() << "Mart@Error: invalid shard " << index << " of " << count
+                 << " (the shards are numbered from 0)\n";
+    return false;
+  }
+  shardIndex = index;
+  shardCount = count;
+  return true;
+}
+
 /**
  * \brief PREPROCESSING - Remove PHI Nodes, replacing by reg2mem, for every
- * function in module
+ * function in module.
+ * When source lines to mutate are specified, only the basic blocks having code
+ * in those lines are mutated (see mutateFunction). Only the PHI nodes and the
+ * values that flow from or into those blocks are demoted, the rest of the
+ * function stays in SSA form.
  */
 void Mutation::preprocessVariablePhi(llvm::Module &module) {
   // Replace the PHI node with memory, to avoid error with verify, as it don't
@@ -188,11 +437,32 @@ void Mutation::preprocessVariablePhi(llvm::Module &module) {
         llvm::Type::getInt32Ty(Func.getContext()), "my reg2mem alloca point",
         &*I);
 
+    // The blocks that may get mutants, recorded for mutateFunction since the
+    // demotion below adds instructions that some mutator may match
+    std::unordered_set<llvm::BasicBlock *> mutableBBs;
+    std::vector<bool> &isMutableBB = mutableBasicBlocks[Func.getName().str()];
+    isMutableBB.clear();
+    for (auto &bb : Func) {
+      isMutableBB.push_back(basicBlockMayGetMutants(bb));
+      if (isMutableBB.back())
+        mutableBBs.insert(&bb);
+    }
+
     std::vector<llvm::PHINode *> phiNodes;
-    for (auto &bb : Func)
-      for (auto &instruct : bb)
-        if (auto *phiN = llvm::dyn_cast<llvm::PHINode>(&instruct))
+    for (auto &bb : Func) {
+      for (auto &instruct : bb) {
+        auto *phiN = llvm::dyn_cast<llvm::PHINode>(&instruct);
+        if (!phiN)
+          continue;
+        bool interactsWithMutable = (mutableBBs.count(&bb) > 0);
+        for (unsigned pind = 0, pe = phiN->getNumIncomingValues();
+             pind < pe && !interactsWithMutable; ++pind)
+          interactsWithMutable =
+              (mutableBBs.count(phiN->getIncomingBlock(pind)) > 0);
+        if (interactsWithMutable)
           phiNodes.push_back(phiN);
+      }
+    }
     for (auto it = phiNodes.rbegin(), ie = phiNodes.rend(); it != ie; ++it) {
       auto *phiN = *it;
       bool hasNonConstIncVal = true; /*false;
@@ -280,7 +550,8 @@ void Mutation::preprocessVariablePhi(llvm::Module &module) {
 #endif
           llvm::Instruction *U =
               llvm::dyn_cast<llvm::Instruction>(Usr.getUser());
-          if (U->getParent() != &bb) {
+          if (U->getParent() != &bb &&
+              (mutableBBs.count(&bb) || mutableBBs.count(U->getParent()))) {
             crossBBInsts.push_back(&instruct);
             break;
           }
@@ -298,6 +569,15 @@ void Mutation::preprocessVariablePhi(llvm::Module &module) {
   }
 }
 
+/**
+ * \brief @return true if the basic block @param BB may get mutants: it has
+ * code in the lines to mutate, and an instruction that some mutator may match.
+ */
+bool Mutation::basicBlockMayGetMutants(llvm::BasicBlock &BB) {
+  return mutationScope.basicBlockInMutationScope(BB) &&
+         configuration.mayMutateBasicBlock(BB);
+}
+
 /// DemotePHIToStack - This function takes a virtual register computed by a PHI
 /// node and replaces it with a slot in the stack frame allocated via alloca.
 /// The PHI node is deleted. It returns the pointer to the alloca inserted.
@@ -509,6 +789,10 @@ inline bool Mutation::skipFunc(llvm::Function &Func) {
       !mutationScope.functionInMutationScope(&Func))
     return true;
 
+  if (!otherShardsFuncs.empty() &&
+      otherShardsFuncs.count(Func.getName().str()) > 0)
+    return true;
+
   return false;
 }
 
@@ -520,6 +804,9 @@ bool Mutation::getConfiguration(std::string &mutConfFile) {
   std::vector<enum ExpElemKeys> *correspKeysMatch;
   std::vector<enum ExpElemKeys> *correspKeysMutant;
 
+  // Hash of the effective configuration (used to key the mutation cache)
+  llvm::MD5 confHash;
+
   std::ifstream infile(mutConfFile);
   if (infile) {
     std::string linei;
@@ -541,6 +828,8 @@ bool Mutation::getConfiguration(std::string &mutConfFile) {
         // llvm::errs() << "#"<<linei <<"#\n";
         continue;
       }
+      confHash.update(linei);
+      confHash.update("\n");
 
       std::regex rgx("\\s+\\-\\->\\s+"); // Matcher --> Replacors
       std::sregex_token_iterator iter(linei.begin(), linei.end(), rgx, -1);
@@ -766,9 +1055,114 @@ bool Mutation::getConfiguration(std::string &mutConfFile) {
       llvm::errs() << oops.toString();    //DEBUG
   return false;   //DEBUG*/
 
+  configuration.buildDispatchIndex(usermaps);
+  mutatorsMatchAttempts.assign(configuration.mutators.size(), 0);
+  mutatorsMatchSuccesses.assign(configuration.mutators.size(), 0);
+  trivialPrunedMutants.assign(NumTrivialEquivalenceRules, 0);
+
+  llvm::MD5::MD5Result confHashRes;
+  confHash.final(confHashRes);
+  llvm::SmallString<32> confDigest;
+  llvm::MD5::stringifyResult(confHashRes, confDigest);
+  mutConfDigest = confDigest.str().str();
+
   return true;
 }
 
+/**
+ * \brief Index the mutators by the instruction opcodes that their matcher
+ * requires in a statement (see
+ * GenericMuOpBase::getMinIRInstructionsToBeMatched()), so that each statement
+ * is only offered to the mutators that can match it.
+ */
+void mutationConfig::buildDispatchIndex(UserMaps &usermaps) {
+  anyStmtMutators.clear();
+  mutatorsByOpcode.clear();
+  mutatorsRequiredOpcodes.clear();
+  for (unsigned pos = 0, pe = mutators.size(); pos < pe; ++pos) {
+    std::vector<unsigned> required =
+        usermaps.getMatcherObject(mutators[pos].getMatchOp())
+            ->getMinIRInstructionsToBeMatched();
+    std::sort(required.begin(), required.end());
+    required.erase(std::unique(required.begin(), required.end()),
+                   required.end());
+    if (required.empty())
+      anyStmtMutators.push_back(pos);
+    else
+      mutatorsByOpcode[required.front()].push_back(pos);
+    mutatorsRequiredOpcodes.push_back(required);
+  }
+}
+
+/**
+ * \brief Sufficient-set mode: remove from each mutator the replacors implied
+ * by its other replacors (see GenericMuOpBase::getImpliedReplacors()). The
+ * implied mutants are recorded in the mutants infos of the mutants that imply
+ * them instead of being generated.
+ */
+void mutationConfig::reduceToSufficientSets(UserMaps &usermaps) {
+  std::vector<int> impliedBy;
+  for (auto &mutator : mutators) {
+    usermaps.getMatcherObject(mutator.getMatchOp())
+        ->getImpliedReplacors(mutator, impliedBy);
+    numImpliedReplacors += mutator.removeImpliedReplacors(impliedBy);
+  }
+}
+
+/**
+ * \brief Get in @param candidates the positions (in increasing order, as in
+ * the configuration) of the mutators that can match the statement
+ * @param stmtIR.
+ */
+void mutationConfig::getCandidateMutators(
+    MatchStmtIR const &stmtIR, std::vector<unsigned> &candidates) const {
+  llvm::SmallVector<unsigned, 16> stmtOpcodes;
+  for (auto *val : stmtIR.getIRList())
+    if (auto *inst = llvm::dyn_cast<llvm::Instruction>(val))
+      stmtOpcodes.push_back(inst->getOpcode());
+  std::sort(stmtOpcodes.begin(), stmtOpcodes.end());
+  stmtOpcodes.erase(std::unique(stmtOpcodes.begin(), stmtOpcodes.end()),
+                    stmtOpcodes.end());
+
+  candidates.assign(anyStmtMutators.begin(), anyStmtMutators.end());
+  for (unsigned opcode : stmtOpcodes) {
+    auto it = mutatorsByOpcode.find(opcode);
+    if (it == mutatorsByOpcode.end())
+      continue;
+    for (unsigned pos : it->second) {
+      bool hasAll = true;
+      for (unsigned reqOpcode : mutatorsRequiredOpcodes[pos]) {
+        if (!std::binary_search(stmtOpcodes.begin(), stmtOpcodes.end(),
+                                reqOpcode)) {
+          hasAll = false;
+          break;
+        }
+      }
+      if (hasAll)
+        candidates.push_back(pos);
+    }
+  }
+  // The mutators are applied in the configuration order
+  std::sort(candidates.begin(), candidates.end());
+}
+
+/**
+ * \brief @return false if none of the mutators can match a statement with
+ * code in the basic block @param BB: none may match any statement, and none
+ * requires first an opcode of the instructions of @param BB (see
+ * getCandidateMutators).
+ */
+bool mutationConfig::mayMutateBasicBlock(llvm::BasicBlock const &BB) const {
+  if (!anyStmtMutators.empty())
+    return true;
+  for (auto &Inst : BB)
+    if (mutatorsByOpcode.count(Inst.getOpcode()) > 0)
+      return true;
+  return false;
+}
+
+// The names are the same for every module mutated in the process (e.g. in
+// batch mode), doMutate fails if they are already used in the module.
 void Mutation::getanothermutantIDSelectorName() {
   static unsigned tempglob = 0;
   mutantIDSelectorName.assign("klee_semu_GenMu_Mutant_ID_Selector");
@@ -787,6 +1181,199 @@ void Mutation::getanotherPostMutantPointFuncName() {
   tempglob++;
 }
 
+namespace {
+/**
+ * \brief View of the IRs of a statement (the original or a mutant) where the
+ * values defined in the statement are identified by their position and the
+ * basic blocks of a mutant by their original basic block, so that two
+ * statements are compared IR by IR. Only the statements made of non PHI
+ * instructions, with one mutant basic block per original basic block, are
+ * compared (conservative).
+ */
+class StmtCanonicalView {
+public:
+  // <position + 1, nullptr> for the values of the statement, <0, value>
+  // otherwise
+  typedef std::pair<unsigned, llvm::Value const *> CanonVal;
+
+private:
+  std::vector<llvm::Value *> const *irs = nullptr;
+  llvm::DenseMap<llvm::Value const *, unsigned> posOf;
+  llvm::DenseMap<llvm::Value const *, llvm::Value const *> bbToOrig;
+
+  bool setIRs(std::vector<llvm::Value *> const &irList) {
+    irs = &irList;
+    for (unsigned pos = 0, pe = irList.size(); pos < pe; ++pos) {
+      if (!llvm::isa<llvm::Instruction>(irList[pos]) ||
+          llvm::isa<llvm::PHINode>(irList[pos]))
+        return false;
+      posOf[irList[pos]] = pos;
+    }
+    return true;
+  }
+
+public:
+  /// \brief @return false if the statement cannot be compared
+  bool setToOriginal(MatchStmtIR const &stmtIR) {
+    return setIRs(stmtIR.getIRList());
+  }
+  bool setToMutant(MutantsOfStmt::MutantStmtIR const &mutIR) {
+    if (!setIRs(mutIR.toMatchIRsMutClone))
+      return false;
+    // The mutant basic blocks must contain exactly the IRs of the mutant
+    size_t numInsts = 0;
+    for (auto &obbP : mutIR.origBBToMutBB) {
+      if (obbP.second.size() != 1)
+        return false;
+      bbToOrig[obbP.second.front()] = obbP.first;
+      numInsts += obbP.second.front()->size();
+    }
+    return (numInsts == irs->size());
+  }
+
+  inline unsigned size() const { return irs->size(); }
+  inline llvm::Instruction *getInstAt(unsigned pos) const {
+    return llvm::cast<llvm::Instruction>((*irs)[pos]);
+  }
+
+  CanonVal canon(llvm::Value const *val) const {
+    auto posIt = posOf.find(val);
+    if (posIt != posOf.end())
+      return CanonVal(posIt->second + 1, nullptr);
+    auto bbIt = bbToOrig.find(val);
+    if (bbIt != bbToOrig.end())
+      return CanonVal(0, bbIt->second);
+    return CanonVal(0, val);
+  }
+
+  /// \brief check whether the IR at @param pos is the same as the IR at
+  /// @param otherPos in @param other
+  bool isSameIRAs(unsigned pos, StmtCanonicalView const &other,
+                  unsigned otherPos) const {
+    llvm::Instruction *inst = getInstAt(pos);
+    llvm::Instruction *otherInst = other.getInstAt(otherPos);
+    if (inst->getNumOperands() != otherInst->getNumOperands() ||
+        !inst->isSameOperationAs(otherInst))
+      return false;
+    for (unsigned k = 0, ke = inst->getNumOperands(); k < ke; ++k)
+      if (canon(inst->getOperand(k)) != other.canon(otherInst->getOperand(k)))
+        return false;
+    return true;
+  }
+
+  bool isIdenticalTo(StmtCanonicalView const &other) const {
+    if (size() != other.size())
+      return false;
+    for (unsigned pos = 0, pe = size(); pos < pe; ++pos)
+      if (!isSameIRAs(pos, other, pos))
+        return false;
+    return true;
+  }
+
+  size_t hash() const {
+    llvm::hash_code hc = llvm::hash_value(irs->size());
+    for (auto *ir : *irs) {
+      auto *inst = llvm::cast<llvm::Instruction>(ir);
+      hc = llvm::hash_combine(hc, inst->getOpcode(), inst->getNumOperands());
+      for (unsigned k = 0, ke = inst->getNumOperands(); k < ke; ++k) {
+        CanonVal cv = canon(inst->getOperand(k));
+        hc = llvm::hash_combine(hc, cv.first, cv.second);
+      }
+    }
+    return hc;
+  }
+}; // class StmtCanonicalView
+
+/// \brief @return whether the constant @param cst is the right neutral
+/// element of the integer binary operation @param opcode
+bool isRightNeutralOperand(unsigned opcode, llvm::Value const *cst) {
+  auto *cInt = llvm::dyn_cast<llvm::ConstantInt>(cst);
+  if (!cInt)
+    return false;
+  switch (opcode) {
+  case llvm::Instruction::Add:
+  case llvm::Instruction::Sub:
+  case llvm::Instruction::Or:
+  case llvm::Instruction::Xor:
+  case llvm::Instruction::Shl:
+  case llvm::Instruction::LShr:
+  case llvm::Instruction::AShr:
+    return cInt->isZero();
+  case llvm::Instruction::Mul:
+  case llvm::Instruction::SDiv:
+  case llvm::Instruction::UDiv:
+    return cInt->isOne();
+  default:
+    return false;
+  }
+}
+
+/**
+ * \brief @return the rule by which the mutant @param mutView is trivially
+ * equivalent to the original statement @param origView, or
+ * NumTrivialEquivalenceRules if none applies. The algebraic rules only apply
+ * when a single IR differs.
+ */
+unsigned getTrivialEquivalenceRule(StmtCanonicalView const &origView,
+                                   StmtCanonicalView const &mutView) {
+  if (origView.size() != mutView.size())
+    return NumTrivialEquivalenceRules;
+  int diffPos = -1;
+  for (unsigned pos = 0, pe = origView.size(); pos < pe; ++pos) {
+    if (!origView.isSameIRAs(pos, mutView, pos)) {
+      if (diffPos >= 0)
+        return NumTrivialEquivalenceRules;
+      diffPos = pos;
+    }
+  }
+  if (diffPos < 0)
+    return IdenticalToOriginal;
+
+  llvm::Instruction *origInst = origView.getInstAt(diffPos);
+  llvm::Instruction *mutInst = mutView.getInstAt(diffPos);
+  if (origInst->getType() != mutInst->getType() ||
+      origInst->getNumOperands() != 2 || mutInst->getNumOperands() != 2)
+    return NumTrivialEquivalenceRules;
+  auto origOp0 = origView.canon(origInst->getOperand(0));
+  auto origOp1 = origView.canon(origInst->getOperand(1));
+  auto mutOp0 = mutView.canon(mutInst->getOperand(0));
+  auto mutOp1 = mutView.canon(mutInst->getOperand(1));
+
+  auto *origBinop = llvm::dyn_cast<llvm::BinaryOperator>(origInst);
+  auto *mutBinop = llvm::dyn_cast<llvm::BinaryOperator>(mutInst);
+  if (origBinop && mutBinop) {
+    if (origBinop->getOpcode() == mutBinop->getOpcode()) {
+      if (origBinop->isCommutative() && origOp0 == mutOp1 &&
+          origOp1 == mutOp0 && origBinop->isSameOperationAs(mutBinop))
+        return CommutedOperands;
+    } else if (origInst->getType()->isIntegerTy() && origOp0 == mutOp0 &&
+               origOp1 == mutOp1 &&
+               isRightNeutralOperand(origBinop->getOpcode(),
+                                     origInst->getOperand(1)) &&
+               isRightNeutralOperand(mutBinop->getOpcode(),
+                                     mutInst->getOperand(1))) {
+      return NeutralOperand;
+    }
+    return NumTrivialEquivalenceRules;
+  }
+
+  auto *origCmp = llvm::dyn_cast<llvm::CmpInst>(origInst);
+  auto *mutCmp = llvm::dyn_cast<llvm::CmpInst>(mutInst);
+  if (origCmp && mutCmp && origCmp->getOpcode() == mutCmp->getOpcode()) {
+    if (origOp0 == mutOp1 && origOp1 == mutOp0 &&
+        mutCmp->getPredicate() == origCmp->getSwappedPredicate())
+      return CommutedOperands;
+    // Floating point comparisons of a value with itself depend on NaN
+    if (llvm::isa<llvm::ICmpInst>(origCmp) && origOp0 == origOp1 &&
+        mutOp0 == origOp0 && mutOp1 == origOp0 &&
+        llvm::CmpInst::isTrueWhenEqual(origCmp->getPredicate()) ==
+            llvm::CmpInst::isTrueWhenEqual(mutCmp->getPredicate()))
+      return SameOperandsComparison;
+  }
+  return NumTrivialEquivalenceRules;
+}
+} // namespace
+
 // @Name: Mutation::getMutantsOfStmt
 // This function takes a statement as a list of IR instruction, using the
 // mutation model specified for this class, generate a list of all possible
@@ -801,13 +1388,102 @@ void Mutation::getMutantsOfStmt(MatchStmtIR const &stmtIR,
 
   WholeStmtMutationOnce iswholestmtmutated;
 
-  for (llvmMutationOp &mutator : configuration.mutators) {
+  // Only the mutators that can match the statement
+  std::vector<unsigned> candidateMutators;
+  configuration.getCandidateMutators(stmtIR, candidateMutators);
+
+  // Views of the statement and of its mutants kept so far (by hash), for the
+  // trivial equivalence filter
+  StmtCanonicalView origView;
+  bool origComparable =
+      trivialEquivalencePruning && origView.setToOriginal(stmtIR);
+  std::unordered_multimap<size_t, MutantIDType> keptMutantsByHash;
+
+  // IRs of the deferred mutants (lazy enumeration), only created for the
+  // checks below and deleted with the statement, so that the mutants kept are
+  // those that doMutate would add. Each deferred mutant's IR is at its
+  // position in 'deferredIRs'
+  MutantsOfStmt deferredIRs;
+  std::unordered_map<MutantsOfStmt::DeferredMutant const *, unsigned>
+      deferredIRPos;
+  auto getMutantIR = [&](MutantIDType mind) -> MutantsOfStmt::MutantStmtIR & {
+    if (!ret_mutants.isDeferred(mind))
+      return ret_mutants.getMutantStmtIR(mind);
+    return deferredIRs.getMutantStmtIR(
+        deferredIRPos.at(ret_mutants.results[mind].deferred.get()));
+  };
+
+  for (unsigned mutatorPos : candidateMutators) {
+    llvmMutationOp &mutator = configuration.mutators[mutatorPos];
     // for (auto &mn: mutator.getMutantReplacorsList())    // DBG
     //    llvm::errs() << mn.getMutOpName() << "; ";      // DBG
 
+    MutantIDType prevNumMuts = ret_mutants.getNumMuts();
     usermaps.getMatcherObject(mutator.getMatchOp())
         ->matchAndReplace(stmtIR, mutator, ret_mutants, iswholestmtmutated,
                           moduleInfo);
+    ++mutatorsMatchAttempts[mutatorPos];
+    if (ret_mutants.getNumMuts() > prevNumMuts)
+      ++mutatorsMatchSuccesses[mutatorPos];
+
+    // Create the IRs of the new deferred mutants, and drop those whose
+    // replacement is canceled (no mutant created, as with doMutate)
+    for (MutantIDType mind = prevNumMuts; mind < ret_mutants.getNumMuts();) {
+      if (!ret_mutants.isDeferred(mind)) {
+        ++mind;
+        continue;
+      }
+      auto const &deferred = ret_mutants.results[mind].deferred;
+      unsigned irPos = deferredIRs.getNumMuts();
+      DoReplaceUseful dru;
+      deferred->matcher->replaceMatch(stmtIR, deferred->pos, *deferred->match,
+                                      *deferred->repl, dru, deferredIRs,
+                                      moduleInfo);
+      if (deferredIRs.getNumMuts() == irPos) {
+        ret_mutants.remove(mind);
+      } else {
+        // The location of the created mutant, as with doMutate
+        ret_mutants.results[mind].irRelevantPos =
+            deferredIRs.getIRRelevantPos(irPos);
+        deferredIRPos[deferred.get()] = irPos;
+        ++mind;
+      }
+    }
+
+    // Drop the new mutants that are trivially equivalent to the original
+    // statement or duplicate of a previous mutant of the statement
+    if (trivialEquivalencePruning) {
+      for (MutantIDType mind = prevNumMuts; mind < ret_mutants.getNumMuts();) {
+        StmtCanonicalView mutView;
+        unsigned rule = NumTrivialEquivalenceRules;
+        size_t mutHash = 0;
+        bool comparable = mutView.setToMutant(getMutantIR(mind));
+        if (comparable) {
+          if (origComparable)
+            rule = getTrivialEquivalenceRule(origView, mutView);
+          if (rule == NumTrivialEquivalenceRules) {
+            mutHash = mutView.hash();
+            auto range = keptMutantsByHash.equal_range(mutHash);
+            for (auto it = range.first; it != range.second; ++it) {
+              StmtCanonicalView keptView;
+              keptView.setToMutant(getMutantIR(it->second));
+              if (keptView.isIdenticalTo(mutView)) {
+                rule = DuplicateInStatement;
+                break;
+              }
+            }
+          }
+        }
+        if (rule != NumTrivialEquivalenceRules) {
+          ++trivialPrunedMutants[rule];
+          ret_mutants.remove(mind);
+        } else {
+          if (comparable)
+            keptMutantsByHash.emplace(mutHash, mind);
+          ++mind;
+        }
+      }
+    }
 
     // Check that load and stores type are okay
     for (MutantIDType i = 0, ie = ret_mutants.getNumMuts(); i < ie; i++) {
@@ -845,8 +1521,40 @@ void Mutation::getMutantsOfStmt(MatchStmtIR const &stmtIR,
         }
     }*/
   }
+
+  while (!deferredIRs.isEmpty())
+    deferredIRs.remove(deferredIRs.getNumMuts() - 1);
 } //~Mutation::getMutantsOfStmt
 
+/**
+ * \brief Count, per mutant type, the mutants of the statement @param stmtIR
+ * into @param counts, as getMutantsOfStmt but without creating them (dry
+ * run). The trivial equivalence pruning, which needs the mutants, is not
+ * applied.
+ */
+void Mutation::countMutantsOfStmt(MatchStmtIR const &stmtIR,
+                                  std::map<std::string, unsigned long> &counts,
+                                  ModuleUserInfos const &moduleInfo) {
+  WholeStmtMutationOnce iswholestmtmutated;
+
+  std::vector<unsigned> candidateMutators;
+  configuration.getCandidateMutators(stmtIR, candidateMutators);
+
+  std::map<std::string, unsigned long> mutatorCounts;
+  for (unsigned mutatorPos : candidateMutators) {
+    llvmMutationOp &mutator = configuration.mutators[mutatorPos];
+    mutatorCounts.clear();
+    usermaps.getMatcherObject(mutator.getMatchOp())
+        ->countMatches(stmtIR, mutator, iswholestmtmutated, moduleInfo,
+                       mutatorCounts);
+    ++mutatorsMatchAttempts[mutatorPos];
+    if (!mutatorCounts.empty())
+      ++mutatorsMatchSuccesses[mutatorPos];
+    for (auto &tP : mutatorCounts)
+      counts[tP.first] += tP.second;
+  }
+} //~Mutation::countMutantsOfStmt
+
 llvm::Function *Mutation::createKSFunc(llvm::Module &module, bool bodyOnly,
                                         std::string ks_func_name) {
   llvm::Function *funcForKS = nullptr;
@@ -928,765 +1636,1634 @@ void Mutation::checkFunctionValidity(llvm::Function &Func, const char *errMsg) {
   }
 }
 
-// @Name: doMutate
-// This is the main method of the class Mutation, Call this to mutate a module
-bool Mutation::doMutate() {
-  llvm::Module &module = *currentMetaMutantModule;
+namespace {
 
-  // Instert Mutant ID Selector Global Variable
-  while (module.getNamedGlobal(mutantIDSelectorName)) {
-    llvm::errs() << "The gobal variable '" << mutantIDSelectorName
-                 << "' already present in code!\n";
-    assert(
-        false &&
-        "ERROR: Module already mutated!"); // getanothermutantIDSelectorName();
+/**
+ * \brief Ordered list (source order) of the statements found in the basic blocks
+ * being searched. Statements of different basic blocks are delimited by nullptr
+ * \detail The statements are allocated from a pool owned by the list: they are
+ * recycled after each mutation (clear()) and all released together with the
+ * list, at the end of the mutation of the function.
+ */
+struct SourceStmtsSearchList {
+  std::vector<StatementSearch *> sourceOrderedStmts;
+  llvm::BasicBlock *curBB = nullptr;
+
+  // The deque never moves its elements. The first 'numUsedStmts' are in use
+  std::deque<StatementSearch> stmtsPool;
+  size_t numUsedStmts = 0;
+
+  // Statements removed from the search, erased from 'sourceOrderedStmts' at
+  // doneSearch()
+  llvm::SmallPtrSet<StatementSearch *, 4> removedStmts;
+
+  StatementSearch *createNewElem(llvm::BasicBlock *bb) {
+    if (bb != curBB) {
+      // if (curBB != nullptr)
+      sourceOrderedStmts.push_back(nullptr);
+      curBB = bb;
+    }
+    StatementSearch *ss;
+    if (numUsedStmts < stmtsPool.size()) {
+      ss = &stmtsPool[numUsedStmts];
+      ss->clear();
+    } else {
+      stmtsPool.emplace_back();
+      ss = &stmtsPool.back();
+    }
+    ++numUsedStmts;
+    sourceOrderedStmts.push_back(ss);
+    return sourceOrderedStmts.back();
   }
-  module.getOrInsertGlobal(mutantIDSelectorName,
-                           llvm::Type::getInt32Ty(moduleInfo.getContext()));
-  llvm::GlobalVariable *mutantIDSelectorGlobal =
-      module.getNamedGlobal(mutantIDSelectorName);
-  // mutantIDSelectorGlobal->setLinkage(llvm::GlobalValue::CommonLinkage);
-  // //commonlinkage require 0 as initial value
-#if (LLVM_VERSION_MAJOR >= 10) // && (LLVM_VERSION_MINOR < 5)
-  mutantIDSelectorGlobal->setAlignment(llvm::MaybeAlign(4));
-#else
-  mutantIDSelectorGlobal->setAlignment(4);
-#endif
-  mutantIDSelectorGlobal->setInitializer(llvm::ConstantInt::get(
-      moduleInfo.getContext(), llvm::APInt(32, 0, false)));
-
-  // XXX: Insert definition of the function whose call argument will tell
-  // KS which mutants to fork
-  if (forKLEESEMu) {
-    funcForKLEESEMu = createGlobalMutIDSelector_Func(module);
+  void remove(StatementSearch *ss) {
+    assert(ss && "removing a null statement");
+    bool inserted = removedStmts.insert(ss).second;
+    (void)inserted;
+    assert(inserted && "removing a statement twice");
+  }
+  void appendOrder(llvm::BasicBlock *bb, StatementSearch *ss) {
+    if (bb != curBB) {
+      assert(curBB != nullptr &&
+             "calling append before calling createNewElem");
+      sourceOrderedStmts.push_back(nullptr);
+      curBB = bb;
+    }
+    sourceOrderedStmts.push_back(ss);
+  }
+  void doneSearch() {
+    if (!removedStmts.empty()) {
+      sourceOrderedStmts.erase(
+          std::remove_if(sourceOrderedStmts.begin(), sourceOrderedStmts.end(),
+                         [this](StatementSearch *ss) {
+                           return ss && removedStmts.count(ss);
+                         }),
+          sourceOrderedStmts.end());
+      removedStmts.clear();
+    }
+    sourceOrderedStmts.push_back(nullptr);
+  }
+  void clear() {
+    // all the statements are done, recycle them
+    numUsedStmts = 0;
+    removedStmts.clear();
+    sourceOrderedStmts.clear();
+    curBB = nullptr;
   }
+  std::vector<StatementSearch *> &getSourceOrderedStmts() {
+    return sourceOrderedStmts;
+  }
+};
 
-  // mutate
-  struct SourceStmtsSearchList {
-    std::vector<StatementSearch *> sourceOrderedStmts;
-    llvm::BasicBlock *curBB = nullptr;
-    StatementSearch *createNewElem(llvm::BasicBlock *bb) {
-      if (bb != curBB) {
-        // if (curBB != nullptr)
-        sourceOrderedStmts.push_back(nullptr);
-        curBB = bb;
-      }
-      sourceOrderedStmts.push_back(new StatementSearch);
-      return sourceOrderedStmts.back();
-    }
-    void remove(StatementSearch *ss) {
-      delete ss;
-      bool found = false;
-      for (long i = sourceOrderedStmts.size() - 1; i >= 0; i--)
-        if (sourceOrderedStmts[i] == ss) {
-          sourceOrderedStmts.erase(sourceOrderedStmts.begin() + i);
-          found = true;
-        }
-      assert(found && "removing a statement not inserted");
-    }
-    void appendOrder(llvm::BasicBlock *bb, StatementSearch *ss) {
-      if (bb != curBB) {
-        assert(curBB != nullptr &&
-               "calling append before calling createNewElem");
-        sourceOrderedStmts.push_back(nullptr);
-        curBB = bb;
-      }
-      sourceOrderedStmts.push_back(ss);
-    }
-    void doneSearch() { sourceOrderedStmts.push_back(nullptr); }
-    void clear() {
-      std::unordered_set<StatementSearch *> stmp(sourceOrderedStmts.begin(),
-                                                 sourceOrderedStmts.end());
-      for (auto *ss : stmp)
-        if (ss)
-          delete ss;
-      sourceOrderedStmts.clear();
-      curBB = nullptr;
-    }
-    std::vector<StatementSearch *> &getSourceOrderedStmts() {
-      return sourceOrderedStmts;
-    }
-  } srcStmtsSearchList;
-
-  /**
-   * \brief This class create a proxy BB for each incoming BB of PHI nodes whose
-   * corresponding value is a CONSTANT (independent on value computed on
-   * previous BB)
-   */
-  struct ProxyForPHI {
-    std::unordered_set<llvm::BasicBlock *> proxies;
-    std::unordered_map<llvm::PHINode *,
-                       std::unordered_map<llvm::BasicBlock * /*a Basic Block*/,
-                                          llvm::BasicBlock * /*its Proxy*/>>
-        phiBBProxy;
-    llvm::Function *curFunc = nullptr;
-
-    void clear(llvm::Function *f) {
-      proxies.clear();
-      phiBBProxy.clear();
-      curFunc = f;
-    }
-    bool isProxy(llvm::BasicBlock *bb) { return (proxies.count(bb) > 0); }
-    void getProxiesTerminators(llvm::PHINode *phi,
-                               std::vector<llvm::Instruction *> &terms) {
-      auto itt = phiBBProxy.find(phi);
-      assert(itt != phiBBProxy.end() && "looking for missing phi node");
-      for (auto inerIt : itt->second)
-        terms.push_back(inerIt.second->getTerminator());
-    }
-    void handleBB(llvm::BasicBlock *bb, ModuleUserInfos const &MI) { // see
-      // http://llvm.org/docs/doxygen/html/BasicBlock_8cpp_source.html#l00401
+/**
+ * \brief This class create a proxy BB for each incoming BB of PHI nodes whose
+ * corresponding value is a CONSTANT (independent on value computed on
+ * previous BB)
+ */
+struct ProxyForPHI {
+  std::unordered_set<llvm::BasicBlock *> proxies;
+  std::unordered_map<llvm::PHINode *,
+                     std::unordered_map<llvm::BasicBlock * /*a Basic Block*/,
+                                        llvm::BasicBlock * /*its Proxy*/>>
+      phiBBProxy;
+  llvm::Function *curFunc = nullptr;
+  // Numbering of the proxies of the function, so that their names do not
+  // depend on the other functions (mutated in any order in parallel)
+  unsigned proxyBBNum = 0;
+
+  void clear(llvm::Function *f) {
+    proxies.clear();
+    phiBBProxy.clear();
+    curFunc = f;
+    proxyBBNum = 0;
+  }
+  bool isProxy(llvm::BasicBlock *bb) { return (proxies.count(bb) > 0); }
+  void getProxiesTerminators(llvm::PHINode *phi,
+                             std::vector<llvm::Instruction *> &terms) {
+    auto itt = phiBBProxy.find(phi);
+    assert(itt != phiBBProxy.end() && "looking for missing phi node");
+    for (auto inerIt : itt->second)
+      terms.push_back(inerIt.second->getTerminator());
+  }
+  void handleBB(llvm::BasicBlock *bb, ModuleUserInfos const &MI) { // see
+    // http://llvm.org/docs/doxygen/html/BasicBlock_8cpp_source.html#l00401
 #if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
-      llvm::Instruction *TI = bb->getTerminator();
+    llvm::Instruction *TI = bb->getTerminator();
 #else
-      llvm::TerminatorInst *TI = bb->getTerminator();
-#endif
-      if (!TI)
-        return;
-      for (unsigned i = 0; i < TI->getNumSuccessors(); i++) {
-        llvm::BasicBlock *Succ = TI->getSuccessor(i);
-        for (llvm::BasicBlock::iterator II = Succ->begin(), IE = Succ->end();
-             II != IE; ++II) {
-          llvm::PHINode *PN = llvm::dyn_cast<llvm::PHINode>(II);
-          if (!PN)
-            break;
-          handlePhi(PN, MI);
-        }
+    llvm::TerminatorInst *TI = bb->getTerminator();
+#endif
+    if (!TI)
+      return;
+    for (unsigned i = 0; i < TI->getNumSuccessors(); i++) {
+      llvm::BasicBlock *Succ = TI->getSuccessor(i);
+      for (llvm::BasicBlock::iterator II = Succ->begin(), IE = Succ->end();
+           II != IE; ++II) {
+        llvm::PHINode *PN = llvm::dyn_cast<llvm::PHINode>(II);
+        if (!PN)
+          break;
+        handlePhi(PN, MI);
       }
     }
-    void handlePhi(llvm::PHINode *phi, ModuleUserInfos const &MI) {
-      static unsigned proxyBBNum = 0;
-      llvm::BasicBlock *phiBB = nullptr;
-      std::pair<
-          std::unordered_map<llvm::PHINode *,
-                             std::unordered_map<llvm::BasicBlock *,
-                                                llvm::BasicBlock *>>::iterator,
-          bool>
-          ittmp;
-      unsigned pind = 0;
-      /*for (; pind < phi->getNumIncomingValues(); ++pind)
-      {
-          if (llvm::isa<llvm::Constant>(phi->getIncomingValue(pind)))
-          {
-              ittmp = phiBBProxy.emplace (phi,
-      std::unordered_map<llvm::BasicBlock *, llvm::BasicBlock *>());
-              if (ittmp.second==false)
-                  return;
-              phiBB = phi->getParent();
-              break;
-          }
-      }*/
-      ittmp = phiBBProxy.emplace(
-          phi, std::unordered_map<llvm::BasicBlock *, llvm::BasicBlock *>());
-      if (ittmp.second == false)
-        return;
-      phiBB = phi->getParent();
-
-      for (; pind < phi->getNumIncomingValues(); ++pind) {
-        /*if (! llvm::isa<llvm::Constant>(phi->getIncomingValue(pind)))
-            continue;*/
-
-        /// The incoming value is a constant
-        llvm::BasicBlock *bb = phi->getIncomingBlock(pind);
-        // create proxy
-        llvm::BasicBlock *proxyBlock = llvm::BasicBlock::Create(
-            MI.getContext(),
-            std::string("MART.PHI_N_Proxy") + std::to_string(proxyBBNum++),
-            curFunc, bb->getNextNode());
-        // create unconditional branch to phiBB and
-        // insert at the end of proxyBlock
-        llvm::BranchInst::Create(phiBB, proxyBlock);
-        if ((ittmp.first->second.emplace(bb, proxyBlock)).second == false) {
-          proxyBlock->eraseFromParent();
-        } else {
-          proxies.insert(proxyBlock);
+  }
+  void handlePhi(llvm::PHINode *phi, ModuleUserInfos const &MI) {
+    llvm::BasicBlock *phiBB = nullptr;
+    std::pair<
+        std::unordered_map<llvm::PHINode *,
+                           std::unordered_map<llvm::BasicBlock *,
+                                              llvm::BasicBlock *>>::iterator,
+        bool>
+        ittmp;
+    unsigned pind = 0;
+    /*for (; pind < phi->getNumIncomingValues(); ++pind)
+    {
+        if (llvm::isa<llvm::Constant>(phi->getIncomingValue(pind)))
+        {
+            ittmp = phiBBProxy.emplace (phi,
+    std::unordered_map<llvm::BasicBlock *, llvm::BasicBlock *>());
+            if (ittmp.second==false)
+                return;
+            phiBB = phi->getParent();
+            break;
+        }
+    }*/
+    ittmp = phiBBProxy.emplace(
+        phi, std::unordered_map<llvm::BasicBlock *, llvm::BasicBlock *>());
+    if (ittmp.second == false)
+      return;
+    phiBB = phi->getParent();
+
+    for (; pind < phi->getNumIncomingValues(); ++pind) {
+      /*if (! llvm::isa<llvm::Constant>(phi->getIncomingValue(pind)))
+          continue;*/
+
+      /// The incoming value is a constant
+      llvm::BasicBlock *bb = phi->getIncomingBlock(pind);
+      // create proxy
+      llvm::BasicBlock *proxyBlock = llvm::BasicBlock::Create(
+          MI.getContext(),
+          std::string("MART.PHI_N_Proxy") + std::to_string(proxyBBNum++),
+          curFunc, bb->getNextNode());
+      // create unconditional branch to phiBB and
+      // insert at the end of proxyBlock
+      llvm::BranchInst::Create(phiBB, proxyBlock);
+      if ((ittmp.first->second.emplace(bb, proxyBlock)).second == false) {
+        proxyBlock->eraseFromParent();
+      } else {
+        proxies.insert(proxyBlock);
 
-          phi->setIncomingBlock(pind, proxyBlock);
+        phi->setIncomingBlock(pind, proxyBlock);
 #if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
-          llvm::Instruction *TI = bb->getTerminator();
+        llvm::Instruction *TI = bb->getTerminator();
 #else
-          llvm::TerminatorInst *TI = bb->getTerminator();
+        llvm::TerminatorInst *TI = bb->getTerminator();
 #endif
-          bool found = false; // DEBUG
-          for (unsigned i = 0; i < TI->getNumSuccessors(); i++) {
-            if (phiBB == TI->getSuccessor(i)) {
-              TI->setSuccessor(i, proxyBlock);
-              found = true; // DEBUG
-            }
+        bool found = false; // DEBUG
+        for (unsigned i = 0; i < TI->getNumSuccessors(); i++) {
+          if (phiBB == TI->getSuccessor(i)) {
+            TI->setSuccessor(i, proxyBlock);
+            found = true; // DEBUG
           }
-          assert(found && "bb must have phiBB as a successor"); // DEBUG
         }
+        assert(found && "bb must have phiBB as a successor"); // DEBUG
       }
     }
-  } phiProxy;
-
-  // pos in sourceStmts of the statement spawning multiple BB. The actual
-  // mutation happend only when this is empty at the end of a BB.
-  std::set<StatementSearch *> remainMultiBBLiveStmts;
-  unsigned mod_mutstmtcount = 0;
-
-  // set to null after each stmt search completion
-  StatementSearch *curLiveStmtSearch = nullptr;
+  }
+};
 
-  /******************************************************
-   **** Search for high level statement (source level) **
-   ******************************************************/
-  for (auto &Func : module) {
-
-    // Skip Function with only Declaration (External function -- no definition)
-    if (skipFunc(Func))
+/**
+ * \brief Compute the length of the prefix of the instructions of a single
+ * basic block statement @param stmtIR (in the basic block @param origBB) that
+ * its mutants @param mutants can share with the original statement, instead
+ * of having their own clone of it (copy-on-write).
+ * \detail A mutant's instruction is shared if it is the same operation as the
+ * original's instruction at the same position, on the same operands (or on
+ * shared instructions). The chosen prefix maximizes the number of shared
+ * instructions over the mutants; both the original and each sharing mutant
+ * keep at least one instruction after it.
+ * @param sharing is set to whether each mutant shares the prefix.
+ * @return the length of the shared prefix (0 if nothing is shared).
+ */
+unsigned computeSharedStmtPrefix(MatchStmtIR const &stmtIR,
+                                 llvm::BasicBlock *origBB,
+                                 MutantsOfStmt &mutants,
+                                 std::vector<bool> &sharing) {
+  unsigned nMuts = mutants.getNumMuts();
+  sharing.assign(nMuts, false);
+  if (stmtIR.getNumBB() != 1 || stmtIR.getTotNumIRs() < 2)
+    return 0;
+
+  std::vector<unsigned> mutPrefixLen(nMuts, 0);
+  std::unordered_map<llvm::Value *, llvm::Value *> cloneToOrig;
+  for (unsigned k = 0; k < nMuts; ++k) {
+    auto &mutBlocks = mutants.getMutantStmtIR(k).getMut(origBB);
+    if (mutBlocks.size() != 1)
       continue;
+    cloneToOrig.clear();
+    unsigned len = 0;
+    auto mit = mutBlocks.front()->begin(), mie = mutBlocks.front()->end();
+    for (; len + 1 < stmtIR.getTotNumIRs() && mit != mie; ++len, ++mit) {
+      auto *oInst = llvm::dyn_cast<llvm::Instruction>(stmtIR.getIRAt(len));
+      llvm::Instruction *mInst = &*mit;
+      if (llvm::isa<llvm::PHINode>(oInst) || oInst->isTerminator() ||
+          !mInst->isSameOperationAs(oInst))
+        break;
+      bool sameOprds = true;
+      for (unsigned o = 0, oe = oInst->getNumOperands(); o < oe; ++o) {
+        llvm::Value *mOprd = mInst->getOperand(o);
+        auto cit = cloneToOrig.find(mOprd);
+        if (cit != cloneToOrig.end())
+          mOprd = cit->second;
+        if (mOprd != oInst->getOperand(o)) {
+          sameOprds = false;
+          break;
+        }
+      }
+      if (!sameOprds)
+        break;
+      cloneToOrig[mInst] = oInst;
+    }
+    // The mutant must keep at least one instruction
+    if (len > 0 && mit == mie)
+      --len;
+    mutPrefixLen[k] = len;
+  }
 
-    phiProxy.clear(&Func);
+  // Choose the prefix length that shares the most instructions
+  std::vector<unsigned> sortedLens(mutPrefixLen);
+  std::sort(sortedLens.begin(), sortedLens.end(), std::greater<unsigned>());
+  unsigned prefixLen = 0;
+  unsigned long bestShared = 0;
+  for (unsigned i = 0; i < nMuts && sortedLens[i] > 0; ++i) {
+    if ((unsigned long)sortedLens[i] * (i + 1) > bestShared) {
+      bestShared = (unsigned long)sortedLens[i] * (i + 1);
+      prefixLen = sortedLens[i];
+    }
+  }
+  if (prefixLen == 0)
+    return 0;
+  unsigned numSharing = 0;
+  for (unsigned k = 0; k < nMuts; ++k)
+    if (mutPrefixLen[k] >= prefixLen) {
+      sharing[k] = true;
+      ++numSharing;
+    }
+  // When not all the mutants share the prefix, a second mutant selection
+  // (load and switch) follows the prefix, make sure that it is worth it
+  if (numSharing < nMuts && bestShared <= 2) {
+    sharing.assign(nMuts, false);
+    return 0;
+  }
+  return prefixLen;
+}
 
-    ///\brief This hel recording the IR's LOC: index in the function it belongs
-    unsigned instructionPosInFunc = 0;
+/**
+ * \brief get the mutant selection switch that follows the prefix shared by
+ * the mutants of a statement, when it is the default destination of the
+ * mutant selection switch @param sw (see computeSharedStmtPrefix()).
+ * @return nullptr if there is no such switch.
+ */
+llvm::SwitchInst *getSharedPrefixSwitch(llvm::SwitchInst *sw,
+                                        llvm::GlobalVariable *mutantIDSelGlob) {
+  llvm::BasicBlock *defaultBB = sw->getDefaultDest();
+  if (defaultBB->getSinglePredecessor() != sw->getParent())
+    return nullptr;
+  if (auto *nextSw =
+          llvm::dyn_cast<llvm::SwitchInst>(defaultBB->getTerminator()))
+    if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(nextSw->getCondition()))
+      if (ld->getOperand(0) == mutantIDSelGlob)
+        return nextSw;
+  return nullptr;
+}
 
-    ///\brief In case we have multiBB stmt, this say which is the first BB to
-    /// start mutation from. this is equal to itBBlock below if only sigle BB
-    /// stmts
-    /// Set to null after each actual mutation take place
-    llvm::BasicBlock *mutationStartingAtBB = nullptr;
+/**
+ * \brief Give back to each mutant its own clone of the prefix that it shares
+ * with the original statement, and select all the mutants of the statement
+ * with a single switch, as when the prefix is not shared. This is used by the
+ * instrumentations that compare each mutant with the original block.
+ */
+void unshareStmtsPrefixes(llvm::Module &module,
+                          llvm::GlobalVariable *mutantIDSelGlob) {
+  if (!mutantIDSelGlob)
+    return;
+  std::vector<llvm::SwitchInst *> headSwitches;
+  for (auto &Func : module)
+    for (auto &BB : Func)
+      if (auto *sw =
+              llvm::dyn_cast_or_null<llvm::SwitchInst>(BB.getTerminator()))
+        if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition()))
+          if (ld->getOperand(0) == mutantIDSelGlob &&
+              getSharedPrefixSwitch(sw, mutantIDSelGlob))
+            headSwitches.push_back(sw);
+
+  std::unordered_map<llvm::Value *, llvm::Value *> origToClone;
+  for (auto *sw : headSwitches) {
+    llvm::SwitchInst *prefixSw = getSharedPrefixSwitch(sw, mutantIDSelGlob);
+    llvm::BasicBlock *prefixBB = prefixSw->getParent();
+    llvm::BasicBlock *origRestBB = prefixSw->getDefaultDest();
+    auto *prefixLd = llvm::dyn_cast<llvm::LoadInst>(prefixSw->getCondition());
+
+    for (auto cit = prefixSw->case_begin(), ce = prefixSw->case_end();
+         cit != ce; ++cit) {
+#if (LLVM_VERSION_MAJOR <= 4)
+      llvm::ConstantInt *caseVal = cit.getCaseValue();
+      llvm::BasicBlock *mutBB = cit.getCaseSuccessor();
+#else
+      llvm::ConstantInt *caseVal = (*cit).getCaseValue();
+      llvm::BasicBlock *mutBB = (*cit).getCaseSuccessor();
+#endif
+      origToClone.clear();
+      llvm::Instruction *insertPt = &*(mutBB->begin());
+      for (auto &Inst : *prefixBB) {
+        if (&Inst == prefixLd || &Inst == prefixSw)
+          continue;
+        llvm::Instruction *cloneInst = Inst.clone();
+        cloneInst->insertBefore(insertPt);
+        origToClone[&Inst] = cloneInst;
+      }
+      for (auto &Inst : *mutBB) {
+        for (unsigned o = 0, oe = Inst.getNumOperands(); o < oe; ++o) {
+          auto mapIt = origToClone.find(Inst.getOperand(o));
+          if (mapIt != origToClone.end())
+            Inst.setOperand(o, mapIt->second);
+        }
+      }
+      sw->addCase(caseVal, mutBB);
+    }
 
-    std::unordered_set<llvm::Instruction *> consecutiveSkippedInsts;
+    // Merge the prefix and the rest of the original
+    prefixSw->eraseFromParent();
+    prefixLd->eraseFromParent();
+    origRestBB->replaceAllUsesWith(prefixBB);
+    prefixBB->getInstList().splice(prefixBB->end(),
+                                   origRestBB->getInstList());
+    origRestBB->eraseFromParent();
+  }
+}
 
-    for (auto itBBlock = Func.begin(), F_end = Func.end(); itBBlock != F_end;
-         ++itBBlock) {
-      /// Do not mutate the inserted proxy for PHI nodes
-      if (phiProxy.isProxy(&*itBBlock))
-        continue;
+} // namespace
 
-      /// set the Basic block from which the actual mutation should start
-      if (!mutationStartingAtBB)
-        mutationStartingAtBB = &*itBBlock;
+/**
+ * \brief Search the statements of the function @param Func, generate their
+ * mutants and insert them into the function (switch on the mutant ID selector
+ * global @param mutantIDSelectorGlobal). Mutant IDs continue from
+ * 'curMutantID'.
+ */
+void Mutation::mutateFunction(llvm::Function &Func,
+                              llvm::GlobalVariable *mutantIDSelectorGlobal) {
+  SourceStmtsSearchList srcStmtsSearchList;
+  ProxyForPHI phiProxy;
 
-      // make sure that in case this BB has phi node as successor, proxy BB will
-      // be created and added.
-      phiProxy.handleBB(&*itBBlock, moduleInfo);
+  // pos in sourceStmts of the statement spawning multiple BB. The actual
+  // mutation happend only when this is empty at the end of a BB.
+  std::set<StatementSearch *> remainMultiBBLiveStmts;
 
-      std::queue<llvm::Value *> curUses;
+  // set to null after each stmt search completion
+  StatementSearch *curLiveStmtSearch = nullptr;
 
-      for (auto &Instr : *itBBlock) {
-        // This should always be before anything else in this loop
-        instructionPosInFunc++;
+  /******************************************************
+   **** Search for high level statement (source level) **
+   ******************************************************/
+  phiProxy.clear(&Func);
+  mutatedStmtCount = 0;
+
+  // The blocks that may get mutants, as decided at preprocessing (the blocks
+  // that the mutation splits off are not searched again)
+  std::unordered_set<llvm::BasicBlock *> mutableBBs;
+  auto mutableBBsIt = mutableBasicBlocks.find(Func.getName().str());
+  assert(mutableBBsIt != mutableBasicBlocks.end() &&
+         mutableBBsIt->second.size() == Func.size() &&
+         "the function changed since the preprocessing");
+  unsigned bbPos = 0;
+  for (auto &bb : Func)
+    if (mutableBBsIt->second[bbPos++])
+      mutableBBs.insert(&bb);
+
+  ///\brief This hel recording the IR's LOC: index in the function it belongs
+  unsigned instructionPosInFunc = 0;
+
+  ///\brief In case we have multiBB stmt, this say which is the first BB to
+  /// start mutation from. this is equal to itBBlock below if only sigle BB
+  /// stmts
+  /// Set to null after each actual mutation take place
+  llvm::BasicBlock *mutationStartingAtBB = nullptr;
+
+  std::unordered_set<llvm::Instruction *> consecutiveSkippedInsts;
+
+  bool isUnreachableFunc = (unreachableFuncs.count(Func.getName().str()) > 0);
+
+  // The features of the mutants are taken from the unmodified function
+  if (utilityFilter)
+    utilityFilter->startFunction(Func);
+
+  DryRunFunctionStats *funcDryRunStats = nullptr;
+  if (isDryRun) {
+    funcDryRunStats = &dryRunStats[Func.getName().str()];
+    for (auto &BB : Func)
+      funcDryRunStats->numInstructions += BB.size();
+  }
 
-        // If the instruction was mached as to be skipped (using an instruction)
-        // that was skipped,  skip it (example: 'store' following 'stacksave')
-        if (!consecutiveSkippedInsts.empty()) {
-          if (consecutiveSkippedInsts.count(&Instr)) {
-            consecutiveSkippedInsts.erase(&Instr);
-            continue;
-          } else {
-            llvm::errs() << "Mart@Error: the instruction to delete does not "
-                            "directly follow its precursor! (Atomic..)\n";
-            Instr.print(llvm::errs());
-            assert(false && "consecutiveSkippedInsts not empty");
-          }
+  for (auto itBBlock = Func.begin(), F_end = Func.end(); itBBlock != F_end;
+       ++itBBlock) {
+    /// Do not mutate the inserted proxy for PHI nodes
+    if (phiProxy.isProxy(&*itBBlock))
+      continue;
+
+    /// The blocks that may not get mutants were left in SSA form at
+    /// preprocessing: skip them when no statement spanning multiple blocks
+    /// is pending
+    if (!mutationStartingAtBB && mutableBBs.count(&*itBBlock) == 0) {
+      instructionPosInFunc += itBBlock->size();
+      continue;
+    }
+
+    /// set the Basic block from which the actual mutation should start
+    if (!mutationStartingAtBB)
+      mutationStartingAtBB = &*itBBlock;
+
+    // make sure that in case this BB has phi node as successor, proxy BB will
+    // be created and added.
+    phiProxy.handleBB(&*itBBlock, moduleInfo);
+
+    std::queue<llvm::Value *> curUses;
+
+    for (auto &Instr : *itBBlock) {
+      // This should always be before anything else in this loop
+      instructionPosInFunc++;
+
+      // If the instruction was mached as to be skipped (using an instruction)
+      // that was skipped,  skip it (example: 'store' following 'stacksave')
+      if (!consecutiveSkippedInsts.empty()) {
+        if (consecutiveSkippedInsts.count(&Instr)) {
+          consecutiveSkippedInsts.erase(&Instr);
+          continue;
+        } else {
+          llvm::errs() << "Mart@Error: the instruction to delete does not "
+                          "directly follow its precursor! (Atomic..)\n";
+          Instr.print(llvm::errs());
+          assert(false && "consecutiveSkippedInsts not empty");
         }
+      }
 
 // For Now do not mutate Exeption handling code, TODO later. TODO
 // (http://llvm.org/docs/doxygen/html/Instruction_8h_source.html#l00393)
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
-        if (oldVersionIsEHPad(&Instr))
+      if (oldVersionIsEHPad(&Instr))
 #else
-        if (Instr.isEHPad())
+      if (Instr.isEHPad())
 #endif
-        {
-          llvm::errs()
-              << "(msg) Exception handling not mutated for now. TODO\n";
+      {
+        llvm::errs()
+            << "(msg) Exception handling not mutated for now. TODO\n";
+        continue;
+      }
+
+      // Do not mind Alloca when no size specified, if size specified, remove
+      // anything related to size that was added before
+      if (auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(&Instr)) {
+        if (alloca->isArrayAllocation()) {
+          if (curLiveStmtSearch && curLiveStmtSearch->isVisited(&Instr)) {
+            // do not mutate alloca
+            srcStmtsSearchList.remove(curLiveStmtSearch);
+            curLiveStmtSearch = nullptr;
+          } else {
+            Instr.getParent()->print(llvm::errs());
+            assert(false && "Non atomic ??. Please Report bug (Mart)");
+            // assert (llvm::isa<llvm::ConstantInt>(alloca->getArraySize()) &&
+            // "Non Atomic??");
+          }
+          continue;
+        } else {
           continue;
         }
+      }
 
-        // Do not mind Alloca when no size specified, if size specified, remove
-        // anything related to size that was added before
-        if (auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(&Instr)) {
-          if (alloca->isArrayAllocation()) {
-            if (curLiveStmtSearch && curLiveStmtSearch->isVisited(&Instr)) {
-              // do not mutate alloca
+      // If PHI node and wasn't processed by proxy, add proxies
+      if (auto *phiN = llvm::dyn_cast<llvm::PHINode>(&Instr))
+        phiProxy.handlePhi(phiN, moduleInfo);
+
+      // Skip llvm debugging functions void @llvm.dbg.declare and void
+      // @llvm.dbg.value, and klee special function...
+      if (auto *callinst = llvm::dyn_cast<llvm::CallInst>(&Instr)) {
+        if (auto *intrinsic = llvm::dyn_cast<llvm::IntrinsicInst>(callinst)) {
+          // llvm.dbg.declare  and llvm.dbg.value
+          if (llvm::isa<llvm::DbgInfoIntrinsic>(intrinsic)) {
+            if (curLiveStmtSearch &&
+                curLiveStmtSearch->isVisited(intrinsic)) {
+              assert(false && "The debug statement should not have been in "
+                              "visited (cause no dependency on others "
+                              "stmts...)"); // DBG
               srcStmtsSearchList.remove(curLiveStmtSearch);
               curLiveStmtSearch = nullptr;
-            } else {
-              Instr.getParent()->print(llvm::errs());
-              assert(false && "Non atomic ??. Please Report bug (Mart)");
-              // assert (llvm::isa<llvm::ConstantInt>(alloca->getArraySize()) &&
-              // "Non Atomic??");
             }
             continue;
-          } else {
+          } else if (intrinsic->getIntrinsicID() ==
+                     llvm::Intrinsic::stackrestore) {
+            // XXX For stacksave and restore, skip for now
+            if (curLiveStmtSearch &&
+                curLiveStmtSearch->isVisited(intrinsic)) {
+              srcStmtsSearchList.remove(curLiveStmtSearch);
+              curLiveStmtSearch = nullptr;
+            }
             continue;
-          }
-        }
-
-        // If PHI node and wasn't processed by proxy, add proxies
-        if (auto *phiN = llvm::dyn_cast<llvm::PHINode>(&Instr))
-          phiProxy.handlePhi(phiN, moduleInfo);
-
-        // Skip llvm debugging functions void @llvm.dbg.declare and void
-        // @llvm.dbg.value, and klee special function...
-        if (auto *callinst = llvm::dyn_cast<llvm::CallInst>(&Instr)) {
-          if (auto *intrinsic = llvm::dyn_cast<llvm::IntrinsicInst>(callinst)) {
-            // llvm.dbg.declare  and llvm.dbg.value
-            if (llvm::isa<llvm::DbgInfoIntrinsic>(intrinsic)) {
-              if (curLiveStmtSearch &&
-                  curLiveStmtSearch->isVisited(intrinsic)) {
-                assert(false && "The debug statement should not have been in "
-                                "visited (cause no dependency on others "
-                                "stmts...)"); // DBG
-                srcStmtsSearchList.remove(curLiveStmtSearch);
-                curLiveStmtSearch = nullptr;
-              }
-              continue;
-            } else if (intrinsic->getIntrinsicID() ==
-                       llvm::Intrinsic::stackrestore) {
-              // XXX For stacksave and restore, skip for now
-              if (curLiveStmtSearch &&
-                  curLiveStmtSearch->isVisited(intrinsic)) {
-                srcStmtsSearchList.remove(curLiveStmtSearch);
-                curLiveStmtSearch = nullptr;
-              }
-              continue;
-            } else if (intrinsic->getIntrinsicID() ==
-                       llvm::Intrinsic::stacksave) {
+          } else if (intrinsic->getIntrinsicID() ==
+                     llvm::Intrinsic::stacksave) {
 // XXX For stacksave and restore, skip for now
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-              auto *ss_store =
-                  llvm::dyn_cast<llvm::StoreInst>(*(intrinsic->use_begin()));
+            auto *ss_store =
+                llvm::dyn_cast<llvm::StoreInst>(*(intrinsic->use_begin()));
 #else
-              auto *ss_store =
-                  llvm::dyn_cast<llvm::StoreInst>(*(intrinsic->user_begin()));
+            auto *ss_store =
+                llvm::dyn_cast<llvm::StoreInst>(*(intrinsic->user_begin()));
 #endif
-              // If the Stroe do not directly follow, it will be caught above
-              assert(ss_store && intrinsic->hasOneUse() &&
-                     "unexpected stacksave use pattern");
-              consecutiveSkippedInsts.insert(ss_store);
-              continue;
-            }
-          } else if (llvm::Function *fun = callinst->getCalledFunction()) {
-            // TODO: handle function alias (get called function)
-            if (forKLEESEMu && fun->getName().equals("klee_make_symbolic") &&
-                callinst->getNumArgOperands() == 3 &&
-                fun->getReturnType()->isVoidTy()) {
-              if (curLiveStmtSearch && curLiveStmtSearch->isVisited(&Instr)) {
-                srcStmtsSearchList.remove(
-                    curLiveStmtSearch); // do not mutate klee_make_symbolic
-                curLiveStmtSearch = nullptr;
-              }
-              continue;
-            }
+            // If the Stroe do not directly follow, it will be caught above
+            assert(ss_store && intrinsic->hasOneUse() &&
+                   "unexpected stacksave use pattern");
+            consecutiveSkippedInsts.insert(ss_store);
+            continue;
           }
-        }
-
-        // In case this is not the begining of a stmt search (there are live
-        // stmts)
-        if (curLiveStmtSearch) {
-          if (curLiveStmtSearch->isVisited(&Instr)) // is it visited?
-          {
-            curLiveStmtSearch->checkCountLogic();
-            curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
-                                              instructionPosInFunc - 1);
-            curLiveStmtSearch->countDec();
-
+        } else if (llvm::Function *fun = callinst->getCalledFunction()) {
+          // TODO: handle function alias (get called function)
+          if (forKLEESEMu && fun->getName().equals("klee_make_symbolic") &&
+              callinst->getNumArgOperands() == 3 &&
+              fun->getReturnType()->isVoidTy()) {
+            if (curLiveStmtSearch && curLiveStmtSearch->isVisited(&Instr)) {
+              srcStmtsSearchList.remove(
+                  curLiveStmtSearch); // do not mutate klee_make_symbolic
+              curLiveStmtSearch = nullptr;
+            }
             continue;
           }
         }
+      }
 
-        bool foundd = false;
-        for (auto *remMStmt : remainMultiBBLiveStmts) {
-          if (remMStmt->isVisited(&Instr)) {
-            // Check that Statements are atomic (all IR of stmt1 before any IR
-            // of stmt2, except Alloca - actually all allocas are located at the
-            // beginning of the function)
-            remMStmt->checkAtomicityInBB(&*itBBlock);
+      // In case this is not the begining of a stmt search (there are live
+      // stmts)
+      if (curLiveStmtSearch) {
+        if (curLiveStmtSearch->isVisited(&Instr)) // is it visited?
+        {
+          curLiveStmtSearch->checkCountLogic();
+          curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
+                                            instructionPosInFunc - 1);
+          curLiveStmtSearch->countDec();
 
-            curLiveStmtSearch = StatementSearch::switchFromTo(
-                &*itBBlock, curLiveStmtSearch, remMStmt);
-            srcStmtsSearchList.appendOrder(&*itBBlock, curLiveStmtSearch);
-            remainMultiBBLiveStmts.erase(remMStmt);
-            foundd = true;
+          continue;
+        }
+      }
 
-            // process as for visited Inst, as above
-            curLiveStmtSearch->checkCountLogic();
-            curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
-                                              instructionPosInFunc - 1);
-            curLiveStmtSearch->countDec();
+      bool foundd = false;
+      for (auto *remMStmt : remainMultiBBLiveStmts) {
+        if (remMStmt->isVisited(&Instr)) {
+          // Check that Statements are atomic (all IR of stmt1 before any IR
+          // of stmt2, except Alloca - actually all allocas are located at the
+          // beginning of the function)
+          remMStmt->checkAtomicityInBB(&*itBBlock);
+
+          curLiveStmtSearch = StatementSearch::switchFromTo(
+              &*itBBlock, curLiveStmtSearch, remMStmt);
+          srcStmtsSearchList.appendOrder(&*itBBlock, curLiveStmtSearch);
+          remainMultiBBLiveStmts.erase(remMStmt);
+          foundd = true;
+
+          // process as for visited Inst, as above
+          curLiveStmtSearch->checkCountLogic();
+          curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
+                                            instructionPosInFunc - 1);
+          curLiveStmtSearch->countDec();
 
-            break;
-          }
+          break;
         }
-        if (foundd) {
-          continue;
-        } else {
-          if (curLiveStmtSearch && !curLiveStmtSearch->isCompleted()) {
-            // TODO TODO: Implement the option (1) of Splitting when a
-            // statement,
-            // is non-atomic, at preprocessing (demoting reg to mem
-            // on the atomicity breaking values).
-            // XXX For now, we merge the non atomic statement with its
-            // 'in between' statement (make a bit of harm to whole stmt mutation
-            // like SDL, whle option 1 will make a bit of harm to mutation
-            // involving several IRs).
-            // this is done by creating new stmt search only when on new BB
-            if (curLiveStmtSearch->isOnNewBasicBlock(&*itBBlock)) {
-              remainMultiBBLiveStmts.insert(curLiveStmtSearch);
-              curLiveStmtSearch = StatementSearch::switchFromTo(
-                  &*itBBlock, curLiveStmtSearch,
-                  srcStmtsSearchList.createNewElem(
-                      &*itBBlock)); //(re)initialize
-            }
-          } else {
+      }
+      if (foundd) {
+        continue;
+      } else {
+        if (curLiveStmtSearch && !curLiveStmtSearch->isCompleted()) {
+          // TODO TODO: Implement the option (1) of Splitting when a
+          // statement,
+          // is non-atomic, at preprocessing (demoting reg to mem
+          // on the atomicity breaking values).
+          // XXX For now, we merge the non atomic statement with its
+          // 'in between' statement (make a bit of harm to whole stmt mutation
+          // like SDL, whle option 1 will make a bit of harm to mutation
+          // involving several IRs).
+          // this is done by creating new stmt search only when on new BB
+          if (curLiveStmtSearch->isOnNewBasicBlock(&*itBBlock)) {
+            remainMultiBBLiveStmts.insert(curLiveStmtSearch);
             curLiveStmtSearch = StatementSearch::switchFromTo(
-                &*itBBlock, nullptr,
-                srcStmtsSearchList.createNewElem(&*itBBlock)); //(re)initialize
+                &*itBBlock, curLiveStmtSearch,
+                srcStmtsSearchList.createNewElem(
+                    &*itBBlock)); //(re)initialize
           }
+        } else {
+          curLiveStmtSearch = StatementSearch::switchFromTo(
+              &*itBBlock, nullptr,
+              srcStmtsSearchList.createNewElem(&*itBBlock)); //(re)initialize
         }
+      }
 
-        /* //Commented because the mutating function do no delete stmt with
-        terminator instr (to avoid misformed while), but only delete for return
-        break and continue in this case
-        //make the final unconditional branch part of this statement (to avoid
-        multihop empty branching)
-        if (llvm::isa<llvm::BranchInst>(&Instr))
-        {
-            if (llvm::dyn_cast<llvm::BranchInst>(&Instr)->isUnconditional() &&
-        !visited.empty())
-            {
-                curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
-        instructionPosInFunc - 1);
-                continue;
-            }
-        }*/
+      /* //Commented because the mutating function do no delete stmt with
+      terminator instr (to avoid misformed while), but only delete for return
+      break and continue in this case
+      //make the final unconditional branch part of this statement (to avoid
+      multihop empty branching)
+      if (llvm::isa<llvm::BranchInst>(&Instr))
+      {
+          if (llvm::dyn_cast<llvm::BranchInst>(&Instr)->isUnconditional() &&
+      !visited.empty())
+          {
+              curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
+      instructionPosInFunc - 1);
+              continue;
+          }
+      }*/
 
-        curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
-                                          instructionPosInFunc - 1);
-        if (!curLiveStmtSearch->visit(&Instr)) {
-          // Func.dump();
-          llvm::errs() << "\nInstruction: ";
-          Instr.print(llvm::errs());
-          assert(false && "first time seing an instruction but present in "
-                          "visited. report bug");
-        }
-        curUses.push(&Instr);
-        while (!curUses.empty()) {
-          llvm::Value *popInstr = curUses.front();
-          curUses.pop();
+      curLiveStmtSearch->appendIRToStmt(&*itBBlock, &Instr,
+                                        instructionPosInFunc - 1);
+      if (!curLiveStmtSearch->visit(&Instr)) {
+        // Func.dump();
+        llvm::errs() << "\nInstruction: ";
+        Instr.print(llvm::errs());
+        assert(false && "first time seing an instruction but present in "
+                        "visited. report bug");
+      }
+      curUses.push(&Instr);
+      while (!curUses.empty()) {
+        llvm::Value *popInstr = curUses.front();
+        curUses.pop();
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-          for (llvm::Value::use_iterator ui = popInstr->use_begin(),
-                                         ue = popInstr->use_end();
-               ui != ue; ++ui) {
-            auto &U = ui.getUse();
+        for (llvm::Value::use_iterator ui = popInstr->use_begin(),
+                                       ue = popInstr->use_end();
+             ui != ue; ++ui) {
+          auto &U = ui.getUse();
 #else
-          for (auto &U : popInstr->uses()) {
+        for (auto &U : popInstr->uses()) {
 #endif
-            if (curLiveStmtSearch->visit(U.getUser())) // wasn't visited? insert
-            {
-              curUses.push(U.getUser());
-              curLiveStmtSearch->countInc();
-            }
+          if (curLiveStmtSearch->visit(U.getUser())) // wasn't visited? insert
+          {
+            curUses.push(U.getUser());
+            curLiveStmtSearch->countInc();
           }
-          // consider only operands when more than 1 (popInstr is a user or
-          // operand or Load or Alloca)
-          // if (llvm::dyn_cast<llvm::User>(popInstr)->getNumOperands() > 1)
-          if (!(llvm::isa<llvm::AllocaInst>(popInstr))) {
-            for (unsigned opos = 0;
-                 opos < llvm::dyn_cast<llvm::User>(popInstr)->getNumOperands();
-                 opos++) {
-              auto oprd =
-                  llvm::dyn_cast<llvm::User>(popInstr)->getOperand(opos);
-
-              //@ Check that oprd is not Alloca (done already above 'if')..
-
-              if (!oprd || llvm::isa<llvm::AllocaInst>(oprd))
-                continue;
+        }
+        // consider only operands when more than 1 (popInstr is a user or
+        // operand or Load or Alloca)
+        // if (llvm::dyn_cast<llvm::User>(popInstr)->getNumOperands() > 1)
+        if (!(llvm::isa<llvm::AllocaInst>(popInstr))) {
+          for (unsigned opos = 0;
+               opos < llvm::dyn_cast<llvm::User>(popInstr)->getNumOperands();
+               opos++) {
+            auto oprd =
+                llvm::dyn_cast<llvm::User>(popInstr)->getOperand(opos);
+
+            //@ Check that oprd is not Alloca (done already above 'if')..
+
+            if (!oprd || llvm::isa<llvm::AllocaInst>(oprd))
+              continue;
 
-              if (llvm::dyn_cast<llvm::Instruction>(oprd) &&
-                  curLiveStmtSearch->visit(oprd)) {
-                curUses.push(oprd);
-                curLiveStmtSearch->countInc();
-              }
+            if (llvm::dyn_cast<llvm::Instruction>(oprd) &&
+                curLiveStmtSearch->visit(oprd)) {
+              curUses.push(oprd);
+              curLiveStmtSearch->countInc();
             }
           }
         }
-        // curUses is empty here
-      } // for (auto &Instr: *itBBlock)
+      }
+      // curUses is empty here
+    } // for (auto &Instr: *itBBlock)
 
-      curLiveStmtSearch = nullptr;
+    curLiveStmtSearch = nullptr;
 
-      // Check if we can mutate now or not (seach completed all live stmts)
-      if (!remainMultiBBLiveStmts.empty())
-        continue;
+    // Check if we can mutate now or not (seach completed all live stmts)
+    if (!remainMultiBBLiveStmts.empty())
+      continue;
 
-      /***********************************************************/
-      /// \brief Actual mutation **********************************
-      /***********************************************************/
+    /***********************************************************/
+    /// \brief Actual mutation **********************************
+    /***********************************************************/
 
-      /// \brief mutate all the basic blocks between 'mutationStartingAtBB' and
-      /// '&*itBBlock'
-      srcStmtsSearchList.doneSearch(); // append the last nullptr to order...
+    /// \brief mutate all the basic blocks between 'mutationStartingAtBB' and
+    /// '&*itBBlock'
+    srcStmtsSearchList.doneSearch(); // append the last nullptr to order...
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
-      auto changingBBIt = llvm::Function::iterator(mutationStartingAtBB);
-      auto stopAtBBIt = llvm::Function::iterator(itBBlock);
+    auto changingBBIt = llvm::Function::iterator(mutationStartingAtBB);
+    auto stopAtBBIt = llvm::Function::iterator(itBBlock);
 #else
-      auto changingBBIt = mutationStartingAtBB->getIterator();
-      auto stopAtBBIt = itBBlock->getIterator();
+    auto changingBBIt = mutationStartingAtBB->getIterator();
+    auto stopAtBBIt = itBBlock->getIterator();
 #endif
-      ++stopAtBBIt; // pass the current block
-      llvm::BasicBlock *sstmtCurBB =
-          nullptr; // The loop bellow will be executed at least once
-      auto curSrcStmtIt = srcStmtsSearchList.getSourceOrderedStmts().begin();
+    ++stopAtBBIt; // pass the current block
+    llvm::BasicBlock *sstmtCurBB =
+        nullptr; // The loop bellow will be executed at least once
+    auto curSrcStmtIt = srcStmtsSearchList.getSourceOrderedStmts().begin();
+
+    /// Get all the mutants
+    for (auto *sstmt : srcStmtsSearchList.getSourceOrderedStmts()) {
+      if (sstmt && sstmt->mutantStmt_list.isEmpty()) // not yet mutated
+      {
+        // Skip the statements out of the source lines to mutate
+        if (!mutationScope.stmtInMutationScope(
+                sstmt->matchStmtIR.getIRList()))
+          continue;
 
-      /// Get all the mutants
-      for (auto *sstmt : srcStmtsSearchList.getSourceOrderedStmts()) {
-        if (sstmt && sstmt->mutantStmt_list.isEmpty()) // not yet mutated
-        {
-          // Find all mutants and put into 'mutantStmt_list'
-          getMutantsOfStmt(sstmt->matchStmtIR, sstmt->mutantStmt_list,
-                           moduleInfo);
-
-          // set the mutant IDs
-          for (unsigned mind = 0; mind < sstmt->mutantStmt_list.getNumMuts();
-               mind++) {
-            sstmt->mutantStmt_list.setMutID(mind, ++curMutantID);
-            // for(auto
-            // &xx:sstmt->mutantStmt_list.getMutantStmtIR(mind).origBBToMutBB)
-            //    for(auto *bb: xx.second)
-            //        bb->print(llvm::errs());
+        // Dry run: only count the mutants, without creating them
+        if (isDryRun) {
+          std::map<std::string, unsigned long> counts;
+          countMutantsOfStmt(sstmt->matchStmtIR, counts, moduleInfo);
+          unsigned long numStmtMuts = 0;
+          for (auto &tP : counts)
+            numStmtMuts += tP.second;
+          if (isUnreachableFunc) {
+            unreachablePrunedMutants += numStmtMuts;
+          } else if (numStmtMuts > 0) {
+            ++funcDryRunStats->numMutatedStmts;
+            for (auto &tP : counts)
+              funcDryRunStats->mutantsByType[tP.first] += tP.second;
+            // Each mutant clones the statement
+            funcDryRunStats->numMutantsInsts +=
+                numStmtMuts * sstmt->matchStmtIR.getTotNumIRs();
           }
+          continue;
+        }
+
+        // Find all mutants and put into 'mutantStmt_list'. The enumerator
+        // creates the mutants' IRs on request
+        if (enumerator)
+          sstmt->mutantStmt_list.deferIRs = true;
+        getMutantsOfStmt(sstmt->matchStmtIR, sstmt->mutantStmt_list,
+                         moduleInfo);
+
+        // Drop the mutants of the functions unreachable from the entry
+        // functions
+        if (isUnreachableFunc) {
+          unreachablePrunedMutants += sstmt->mutantStmt_list.getNumMuts();
+          while (sstmt->mutantStmt_list.getNumMuts() > 0)
+            sstmt->mutantStmt_list.remove(
+                sstmt->mutantStmt_list.getNumMuts() - 1);
+        }
+
+        // Only keep the mutants with a high predicted utility
+        if (utilityFilter)
+          utilityFilter->filterStmtMutants(sstmt->matchStmtIR,
+                                           sstmt->mutantStmt_list);
+
+        // Only keep the sampled mutants
+        if (mutantSampler)
+          mutantSampler->sampleStmtMutants(Func, sstmt->matchStmtIR,
+                                           sstmt->mutantStmt_list);
+
+        // Lazy enumeration: the enumerator takes the mutants, which are not
+        // added into the function
+        if (enumerator)
+          enumerator->addStmtMutants(Func, sstmt->matchStmtIR,
+                                     sstmt->mutantStmt_list);
+
+        // set the mutant IDs
+        for (unsigned mind = 0; mind < sstmt->mutantStmt_list.getNumMuts();
+             mind++) {
+          sstmt->mutantStmt_list.setMutID(mind, ++curMutantID);
+          // for(auto
+          // &xx:sstmt->mutantStmt_list.getMutantStmtIR(mind).origBBToMutBB)
+          //    for(auto *bb: xx.second)
+          //        bb->print(llvm::errs());
         }
       }
+    }
 
-      // for each BB place in the muatnts
-      for (; changingBBIt != stopAtBBIt; ++changingBBIt) {
-        /// Do not mutate the inserted proxies for PHI nodes
-        if (phiProxy.isProxy(&*changingBBIt))
-          continue;
+    // for each BB place in the muatnts
+    for (; changingBBIt != stopAtBBIt; ++changingBBIt) {
+      /// Do not mutate the inserted proxies for PHI nodes
+      if (phiProxy.isProxy(&*changingBBIt))
+        continue;
 
-        sstmtCurBB = &*changingBBIt;
+      sstmtCurBB = &*changingBBIt;
 
-        for (++curSrcStmtIt /*the 1st is nullptr*/; *curSrcStmtIt != nullptr;
-             ++curSrcStmtIt) // different BB stmts are delimited by nullptr
-        {
-          unsigned nMuts = (*curSrcStmtIt)->mutantStmt_list.getNumMuts();
-
-          // Mutate only when mutable: at least one mutant (nMuts > 0)
-          if (nMuts > 0) {
-            llvm::Instruction *firstInst, *lastInst;
-            (*curSrcStmtIt)
-                ->matchStmtIR.getFirstAndLastIR(&*changingBBIt, firstInst,
-                                                lastInst);
-
-            /// If the firstInst (intended basic block plit point) isPHI Node,
-            /// instead of splitting, directly add the mutant selection switch
-            /// on the Proxy BB.
-            bool usePhiProxy_NoSplitBB = false;
-            if (llvm::isa<llvm::PHINode>(firstInst))
-              usePhiProxy_NoSplitBB = true;
-
-            llvm::BasicBlock *original = nullptr;
-            std::vector<llvm::Instruction *> linkterminators;
-            std::vector<llvm::SwitchInst *> sstmtMutants;
+      for (++curSrcStmtIt /*the 1st is nullptr*/; *curSrcStmtIt != nullptr;
+           ++curSrcStmtIt) // different BB stmts are delimited by nullptr
+      {
+        unsigned nMuts = (*curSrcStmtIt)->mutantStmt_list.getNumMuts();
+
+        // Mutate only when mutable: at least one mutant (nMuts > 0)
+        if (nMuts > 0) {
+          llvm::Instruction *firstInst, *lastInst;
+          (*curSrcStmtIt)
+              ->matchStmtIR.getFirstAndLastIR(&*changingBBIt, firstInst,
+                                              lastInst);
+
+          /// If the firstInst (intended basic block plit point) isPHI Node,
+          /// instead of splitting, directly add the mutant selection switch
+          /// on the Proxy BB.
+          bool usePhiProxy_NoSplitBB = false;
+          if (llvm::isa<llvm::PHINode>(firstInst))
+            usePhiProxy_NoSplitBB = true;
+
+          /// The mutants that share a prefix of the statement with the
+          /// original are selected after it. When all the mutants share it,
+          /// the statement is simply split after the prefix.
+          std::vector<bool> sharingMuts;
+          unsigned sharedPrefixLen = 0;
+          unsigned numSharingMuts = 0;
+          if (!usePhiProxy_NoSplitBB) {
+            sharedPrefixLen = computeSharedStmtPrefix(
+                (*curSrcStmtIt)->matchStmtIR, &*changingBBIt,
+                (*curSrcStmtIt)->mutantStmt_list, sharingMuts);
+            numSharingMuts =
+                std::count(sharingMuts.begin(), sharingMuts.end(), true);
+            if (numSharingMuts == nMuts)
+              firstInst = llvm::dyn_cast<llvm::Instruction>(
+                  (*curSrcStmtIt)->matchStmtIR.getIRAt(sharedPrefixLen));
+          }
+
+          auto createMutantSelection = [&](llvm::IRBuilder<> &sbuilder,
+                                           llvm::BasicBlock *defaultBB,
+                                           unsigned numCases) {
+            return sbuilder.CreateSwitch(
+#if (LLVM_VERSION_MAJOR >= 10)
+                sbuilder.CreateAlignedLoad(
+                  mutantIDSelectorGlobal->getType()->getPointerElementType(), 
+                  mutantIDSelectorGlobal, 
+                  llvm::MaybeAlign(4)
+                ),
+#else
+                sbuilder.CreateAlignedLoad(mutantIDSelectorGlobal, 4),
+#endif
+                defaultBB, numCases);
+          };
+
+          llvm::BasicBlock *original = nullptr;
+          std::vector<llvm::Instruction *> linkterminators;
+          std::vector<llvm::SwitchInst *> sstmtMutants;
+          llvm::SwitchInst *sharedPrefixMutants = nullptr;
 
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-            llvm::PassManager PM;
-            llvm::RegionInfo *tmp_pass = new llvm::RegionInfo();
-            PM.add(tmp_pass); // tmp_pass must be created with 'new'
-            if (!usePhiProxy_NoSplitBB) {
-              original = llvm::SplitBlock(sstmtCurBB, firstInst, tmp_pass);
+          llvm::PassManager PM;
+          llvm::RegionInfo *tmp_pass = new llvm::RegionInfo();
+          PM.add(tmp_pass); // tmp_pass must be created with 'new'
+          if (!usePhiProxy_NoSplitBB) {
+            original = llvm::SplitBlock(sstmtCurBB, firstInst, tmp_pass);
 #else
-            if (!usePhiProxy_NoSplitBB) {
-              original = llvm::SplitBlock(sstmtCurBB, firstInst);
+          if (!usePhiProxy_NoSplitBB) {
+            original = llvm::SplitBlock(sstmtCurBB, firstInst);
 #endif
-              original->setName(std::string("MART.original_Mut0.Stmt") +
-                                std::to_string(mod_mutstmtcount));
+            original->setName(std::string("MART.original_Mut0.Stmt") +
+                              std::to_string(mutatedStmtCount));
 
-              // this cannot be nullptr because the block just got splitted
-              linkterminators.push_back(sstmtCurBB->getTerminator());
-            } else {
-              // PHI Node is always the first non PHI instruction of its BB
-              original = sstmtCurBB;
+            // this cannot be nullptr because the block just got splitted
+            linkterminators.push_back(sstmtCurBB->getTerminator());
+          } else {
+            // PHI Node is always the first non PHI instruction of its BB
+            original = sstmtCurBB;
 
-              phiProxy.getProxiesTerminators(
-                  llvm::dyn_cast<llvm::PHINode>(firstInst), linkterminators);
+            phiProxy.getProxiesTerminators(
+                llvm::dyn_cast<llvm::PHINode>(firstInst), linkterminators);
+          }
+
+          for (auto *lkt : linkterminators) {
+            llvm::IRBuilder<> sbuilder(lkt);
+
+            // XXX: Insert definition of the function whose call argument will
+            // tell KS which mutants to fork (done elsewhere)
+            if (forKLEESEMu) {
+              std::vector<llvm::Value *> argsv;
+              argsv.push_back(llvm::ConstantInt::get(
+                  moduleInfo.getContext(),
+                  llvm::APInt(
+                      32, (uint64_t)(
+                              (*curSrcStmtIt)->mutantStmt_list.getMutID(0)),
+                      false)));
+              argsv.push_back(llvm::ConstantInt::get(
+                  moduleInfo.getContext(),
+                  llvm::APInt(32, (uint64_t)((*curSrcStmtIt)
+                                                 ->mutantStmt_list.getMutID(
+                                                     nMuts - 1)),
+                              false)));
+              sbuilder.CreateCall(funcForKLEESEMu, argsv);
             }
 
-            for (auto *lkt : linkterminators) {
-              llvm::IRBuilder<> sbuilder(lkt);
+            sstmtMutants.push_back(createMutantSelection(
+                sbuilder, original,
+                (numSharingMuts < nMuts) ? nMuts - numSharingMuts : nMuts));
 
-              // XXX: Insert definition of the function whose call argument will
-              // tell KS which mutants to fork (done elsewhere)
-              if (forKLEESEMu) {
-                std::vector<llvm::Value *> argsv;
-                argsv.push_back(llvm::ConstantInt::get(
-                    moduleInfo.getContext(),
-                    llvm::APInt(
-                        32, (uint64_t)(
-                                (*curSrcStmtIt)->mutantStmt_list.getMutID(0)),
-                        false)));
-                argsv.push_back(llvm::ConstantInt::get(
-                    moduleInfo.getContext(),
-                    llvm::APInt(32, (uint64_t)((*curSrcStmtIt)
-                                                   ->mutantStmt_list.getMutID(
-                                                       nMuts - 1)),
-                                false)));
-                sbuilder.CreateCall(funcForKLEESEMu, argsv);
-              }
+            // Remove old terminator link
+            lkt->eraseFromParent();
+          }
 
-              sstmtMutants.push_back(sbuilder.CreateSwitch(
-#if (LLVM_VERSION_MAJOR >= 10)
-                  sbuilder.CreateAlignedLoad(
-                    mutantIDSelectorGlobal->getType()->getPointerElementType(), 
-                    mutantIDSelectorGlobal, 
-                    llvm::MaybeAlign(4)
-                  ),
+          // Split the rest of the original after the prefix shared by some
+          // of the mutants, selected there
+          if (sharedPrefixLen > 0 && numSharingMuts < nMuts) {
+            llvm::BasicBlock *sharedPrefixBB = original;
+            llvm::Instruction *restFirstInst = llvm::dyn_cast<llvm::Instruction>(
+                (*curSrcStmtIt)->matchStmtIR.getIRAt(sharedPrefixLen));
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+            original = llvm::SplitBlock(sharedPrefixBB, restFirstInst,
+                                        tmp_pass);
 #else
-                  sbuilder.CreateAlignedLoad(mutantIDSelectorGlobal, 4),
+            original = llvm::SplitBlock(sharedPrefixBB, restFirstInst);
 #endif
-                  original, nMuts));
-
-              // Remove old terminator link
-              lkt->eraseFromParent();
-            }
+            original->setName(std::string("MART.original_Mut0.Stmt") +
+                              std::to_string(mutatedStmtCount));
+            sharedPrefixBB->setName(std::string("MART.sharedPrefix_Mut0.Stmt") +
+                                    std::to_string(mutatedStmtCount));
+            llvm::Instruction *prefixTerm = sharedPrefixBB->getTerminator();
+            llvm::IRBuilder<> sbuilder(prefixTerm);
+            sharedPrefixMutants =
+                createMutantSelection(sbuilder, original, numSharingMuts);
+            prefixTerm->eraseFromParent();
+          }
 
-            // Separate Mutants(including original) BB from rest of instr
-            // if we have another stmt after this in this BB
-            if (!llvm::dyn_cast<llvm::Instruction>(lastInst)->isTerminator()) {
+          // Separate Mutants(including original) BB from rest of instr
+          // if we have another stmt after this in this BB
+          if (!llvm::dyn_cast<llvm::Instruction>(lastInst)->isTerminator()) {
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-              llvm::BasicBlock *nextBB =
-                  llvm::SplitBlock(original, lastInst->getNextNode(), tmp_pass);
+            llvm::BasicBlock *nextBB =
+                llvm::SplitBlock(original, lastInst->getNextNode(), tmp_pass);
 #else
-              llvm::BasicBlock *nextBB =
-                  llvm::SplitBlock(original, lastInst->getNextNode());
+            llvm::BasicBlock *nextBB =
+                llvm::SplitBlock(original, lastInst->getNextNode());
 #endif
-              nextBB->setName(std::string("MART.BBafter.Stmt") +
-                              std::to_string(mod_mutstmtcount));
+            nextBB->setName(std::string("MART.BBafter.Stmt") +
+                            std::to_string(mutatedStmtCount));
 
-              sstmtCurBB = nextBB;
-            } else {
-              // llvm::errs() << "Error (Mutation::doMutate): Basic Block '" <<
-              // original->getName() << "' has no terminator!\n";
-              // return false;
-              sstmtCurBB = original;
+            sstmtCurBB = nextBB;
+          } else {
+            // llvm::errs() << "Error (Mutation::doMutate): Basic Block '" <<
+            // original->getName() << "' has no terminator!\n";
+            // return false;
+            sstmtCurBB = original;
+          }
+
+          // XXX: Insert mutant blocks here
+          //@# MUTANTS (see ELSE bellow)
+          for (unsigned ms_ind = 0;
+               ms_ind < (*curSrcStmtIt)->mutantStmt_list.getNumMuts();
+               ms_ind++) {
+            auto &mut_stmt_ir =
+                (*curSrcStmtIt)->mutantStmt_list.getMutantStmtIR(ms_ind);
+            std::string mutIDstr(std::to_string(
+                (*curSrcStmtIt)->mutantStmt_list.getMutID(ms_ind)));
+
+            // Store mutant info
+            mutantsInfos.add(
+                (*curSrcStmtIt)->mutantStmt_list.getMutID(ms_ind),
+                (*curSrcStmtIt)->matchStmtIR.toMatchIRs,
+                (*curSrcStmtIt)->mutantStmt_list.getTypeName(ms_ind),
+                (*curSrcStmtIt)->mutantStmt_list.getIRRelevantPos(ms_ind),
+                &Func, (*curSrcStmtIt)->matchStmtIR.posIRsInOrigFunc,
+                (*curSrcStmtIt)->mutantStmt_list.getImpliedTypeNames(ms_ind));
+
+            // construct Basic Block and insert before original
+            std::vector<llvm::BasicBlock *> &mutBlocks =
+                mut_stmt_ir.getMut(&*changingBBIt);
+
+            // Use the original's shared prefix instead of the mutant's copy
+            if (sharedPrefixLen > 0 && sharingMuts[ms_ind]) {
+              std::vector<llvm::Instruction *> prefixClones;
+              for (auto &mInst : *(mutBlocks.front())) {
+                if (prefixClones.size() == sharedPrefixLen)
+                  break;
+                prefixClones.push_back(&mInst);
+              }
+              for (unsigned i = 0; i < sharedPrefixLen; ++i)
+                prefixClones[i]->replaceAllUsesWith(
+                    (*curSrcStmtIt)->matchStmtIR.getIRAt(i));
+              for (auto *pcInst : prefixClones)
+                pcInst->eraseFromParent();
             }
 
-            // XXX: Insert mutant blocks here
-            //@# MUTANTS (see ELSE bellow)
-            for (unsigned ms_ind = 0;
-                 ms_ind < (*curSrcStmtIt)->mutantStmt_list.getNumMuts();
-                 ms_ind++) {
-              auto &mut_stmt_ir =
-                  (*curSrcStmtIt)->mutantStmt_list.getMutantStmtIR(ms_ind);
-              std::string mutIDstr(std::to_string(
-                  (*curSrcStmtIt)->mutantStmt_list.getMutID(ms_ind)));
-
-              // Store mutant info
-              mutantsInfos.add(
-                  (*curSrcStmtIt)->mutantStmt_list.getMutID(ms_ind),
-                  (*curSrcStmtIt)->matchStmtIR.toMatchIRs,
-                  (*curSrcStmtIt)->mutantStmt_list.getTypeName(ms_ind),
-                  (*curSrcStmtIt)->mutantStmt_list.getIRRelevantPos(ms_ind),
-                  &Func, (*curSrcStmtIt)->matchStmtIR.posIRsInOrigFunc);
-
-              // construct Basic Block and insert before original
-              std::vector<llvm::BasicBlock *> &mutBlocks =
-                  mut_stmt_ir.getMut(&*changingBBIt);
-
-              // Add to mutant selection switch
+            // Add to mutant selection switch
+            llvm::ConstantInt *mutIDConstInt = llvm::ConstantInt::get(
+                moduleInfo.getContext(),
+                llvm::APInt(32, (uint64_t)(*curSrcStmtIt)
+                                    ->mutantStmt_list.getMutID(ms_ind),
+                            false));
+            if (sharedPrefixMutants && sharingMuts[ms_ind])
+              sharedPrefixMutants->addCase(mutIDConstInt, mutBlocks.front());
+            else
               for (auto *swches : sstmtMutants)
-                swches->addCase(
-                    llvm::ConstantInt::get(
-                        moduleInfo.getContext(),
-                        llvm::APInt(32, (uint64_t)(*curSrcStmtIt)
-                                            ->mutantStmt_list.getMutID(ms_ind),
-                                    false)),
-                    mutBlocks.front());
+                swches->addCase(mutIDConstInt, mutBlocks.front());
 
-              for (auto *subBB : mutBlocks) {
-                subBB->setName(std::string("MART.Mutant_preTCEMut") + mutIDstr);
+            for (auto *subBB : mutBlocks) {
+              subBB->setName(std::string("MART.Mutant_preTCEMut") + mutIDstr);
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5) //-----------
-                assert(!subBB->getParent() && "Already has a parent");
+              assert(!subBB->getParent() && "Already has a parent");
 
-                if (original)
-                  Func.getBasicBlockList().insert(
-                      llvm::Function::iterator(original), subBB);
-                else
-                  Func.getBasicBlockList().push_back(subBB);
+              if (original)
+                Func.getBasicBlockList().insert(
+                    llvm::Function::iterator(original), subBB);
+              else
+                Func.getBasicBlockList().push_back(subBB);
 #else  //----------------
-                subBB->insertInto(&Func, original);
+              subBB->insertInto(&Func, original);
 #endif //-----------------
-              }
-
-              // if we have another stmt after this in this BB
-              if (!llvm::dyn_cast<llvm::Instruction>(lastInst)
-                       ->isTerminator()) {
-                // clone original terminator
-                llvm::Instruction *mutTerm = original->getTerminator()->clone();
-
-                // set name
-                if (original->getTerminator()->hasName())
-                  mutTerm->setName(
-                      (original->getTerminator()->getName()).str() + "_Mut" +
-                      mutIDstr);
+            }
 
-                // set as mutant terminator
-                mutBlocks.back()->getInstList().push_back(mutTerm);
-              }
+            // if we have another stmt after this in this BB
+            if (!llvm::dyn_cast<llvm::Instruction>(lastInst)
+                     ->isTerminator()) {
+              // clone original terminator
+              llvm::Instruction *mutTerm = original->getTerminator()->clone();
+
+              // set name
+              if (original->getTerminator()->hasName())
+                mutTerm->setName(
+                    (original->getTerminator()->getName()).str() + "_Mut" +
+                    mutIDstr);
+
+              // set as mutant terminator
+              mutBlocks.back()->getInstList().push_back(mutTerm);
             }
+          }
 
-            /*//delete previous instructions
-            auto rit = sstmt.rbegin();
-            for (; rit!= sstmt.rend(); ++rit)
-            {
-                llvm::dyn_cast<llvm::Instruction>(*rit)->eraseFromParent();
-            }*/
+          /*//delete previous instructions
+          auto rit = sstmt.rbegin();
+          for (; rit!= sstmt.rend(); ++rit)
+          {
+              llvm::dyn_cast<llvm::Instruction>(*rit)->eraseFromParent();
+          }*/
 
-            // Help name the labels for mutants
-            mod_mutstmtcount++;
-          } //~ if(nMuts > 0)
-        }
+          // Help name the labels for mutants
+          mutatedStmtCount++;
+        } //~ if(nMuts > 0)
+      }
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
-        // make 'changeBBIt' point to the last BB before the next
-        // one to explore
-        changingBBIt = llvm::Function::iterator(sstmtCurBB);
+      // make 'changeBBIt' point to the last BB before the next
+      // one to explore
+      changingBBIt = llvm::Function::iterator(sstmtCurBB);
 #else
-        // make 'changeBBIt' foint to the last BB before the next
-        // one to explore
-        changingBBIt = sstmtCurBB->getIterator();
+      // make 'changeBBIt' foint to the last BB before the next
+      // one to explore
+      changingBBIt = sstmtCurBB->getIterator();
 #endif
-      } // Actual mutation for
+    } // Actual mutation for
 
 // Get to the right block
 /*while (&*itBBlock != sstmtCurBB)
 {
-    itBBlock ++;
+  itBBlock ++;
 }*/
 
 // Do not use changingBBIt here because it is advanced
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
-      // make 'changeBBIt' foint to the last BB before the next one to explore
-      itBBlock = llvm::Function::iterator(sstmtCurBB);
+    // make 'changeBBIt' foint to the last BB before the next one to explore
+    itBBlock = llvm::Function::iterator(sstmtCurBB);
+#else
+    // make 'changeBBIt' foint to the last BB before the next one to explore
+    itBBlock = sstmtCurBB->getIterator();
+#endif
+
+    ///\brief Mutation over for the current set of BB, reinitialize
+    ///'mutationStartingAtBB' for the coming ones
+    mutationStartingAtBB = nullptr;
+
+    srcStmtsSearchList.clear();
+
+  } // for each BB in Function
+
+  assert(remainMultiBBLiveStmts.empty() &&
+         "Something wrong with function (missing IRs) or bug!");
+
+  // repairDefinitionUseDomination(Func);  //TODO: when we want to directly
+  // support cross BB use
+
+  // Func.dump();
+
+  Mutation::checkFunctionValidity(
+      Func, "ERROR: Misformed Function After mutation!");
+} //~Mutation::mutateFunction
+
+/**
+ * \brief Parallel and/or cached version of the mutation loop of doMutate.
+ * \detail LLVMContext is not thread safe, thus the functions to mutate are
+ * split into chunks of consecutive functions. Each chunk is extracted into a
+ * module (where the other functions are only declared) that is serialized in
+ * memory, then read and mutated by a worker thread in its own LLVMContext.
+ * The mutated functions are linked back into @param module, chunk by chunk in
+ * the module's function order, and the chunks' mutant IDs are shifted. This
+ * makes the mutant IDs and the mutants infos the same as with the serial
+ * generation.
+ * When the mutation cache is enabled, each chunk has a single function, whose
+ * mutated module is loaded from the cache if the function did not change, or
+ * stored into the cache after being mutated.
+ */
+void Mutation::mutateFunctionsInChunks(
+    llvm::Module &module, llvm::GlobalVariable *mutantIDSelectorGlobal) {
+#if (LLVM_VERSION_MAJOR <= 3)
+  llvm::errs() << "Mart@Warning: parallel mutant generation requires LLVM 4 "
+                  "or later, generating the mutants serially.\n";
+  assert(!mutationCache && "The mutation cache requires LLVM 4 or later");
+  for (auto &Func : module) {
+    if (skipFunc(Func))
+      continue;
+    mutateFunction(Func, mutantIDSelectorGlobal);
+  }
+#else
+  // The chunks' modules use their own declaration of the selector global,
+  // linked back to 'mutantIDSelectorGlobal'
+  (void)mutantIDSelectorGlobal;
+
+  struct GenerationChunk {
+    std::vector<std::string> funcNames;
+    // The chunk's module before mutation, then after mutation
+    ReadWriteIRObj irBuf;
+    // Mutants infos of the chunk, with IDs starting from 1
+    MutantInfoList mutantsInfos;
+    MutantIDType numMutants = 0;
+    // Entry of the chunk's single function in the mutation cache
+    MutationCache::FunctionEntry *cacheEntry = nullptr;
+    // Matching counters of the mutators on the chunk
+    std::vector<unsigned long> matchAttempts;
+    std::vector<unsigned long> matchSuccesses;
+    // Mutants pruned by each trivial equivalence rule on the chunk
+    std::vector<unsigned long> trivialPruned;
+    // Sampler of the chunk's worker, for its counters
+    std::unique_ptr<MutantSampler> sampler;
+    // Utility filter of the chunk's worker, for its counters
+    std::unique_ptr<MutantUtilityFilter> filter;
+    // Mutants dropped in unreachable functions on the chunk
+    unsigned long unreachablePruned = 0;
+    bool isFromCache() const { return cacheEntry && cacheEntry->fromCache; }
+  };
+
+  // Functions to mutate (in the module's order) and their sizes
+  std::vector<std::string> funcsToMutate;
+  std::vector<unsigned> funcsSizes;
+  unsigned long totalSize = 0;
+  for (auto &Func : module) {
+    if (skipFunc(Func))
+      continue;
+    unsigned fsize = 0;
+    for (auto &BB : Func)
+      fsize += BB.size();
+    funcsToMutate.push_back(Func.getName().str());
+    funcsSizes.push_back(fsize);
+    totalSize += fsize;
+  }
+  if (funcsToMutate.empty())
+    return;
+
+  std::vector<std::unique_ptr<GenerationChunk>> chunks;
+  if (mutationCache) {
+    /// \brief One chunk per function, so that each function is cached
+    /// separately. Look the functions up before they are modified below
+    mutationCache->setContext(
+        module, mutConfDigest + ";" + mutantIDSelectorName + ";" +
+                    mutantIDSelectorName_Func + ";" +
+                    postMutationPointFuncName + ";" +
+                    (forKLEESEMu ? "KS" : "noKS") +
+                    (trivialEquivalencePruning ? "" : ";noTrivialPruning") +
+                    (mutantSampler ? ";" + mutantSampler->getContext() : "") +
+                    (utilityFilter ? ";" + utilityFilter->getContext() : "") +
+                    ";" + TCE::getConfigName(Mutation::funcModeOptLevel));
+    mutationCache->setTCEContext(
+        module, TCE::getConfigName(Mutation::funcModeOptLevel),
+        mutantIDSelectorName);
+    for (auto &fname : funcsToMutate) {
+      chunks.emplace_back(new GenerationChunk);
+      GenerationChunk &chunk = *chunks.back();
+      chunk.funcNames.push_back(fname);
+      llvm::Function *Func = module.getFunction(fname);
+      chunk.cacheEntry = &mutationCache->lookup(
+          *Func, chunk.irBuf,
+          mutationScope.getFunctionScopeKey(*Func) +
+              (unreachableFuncs.count(fname) ? ";unreachable" : ""));
+      if (chunk.isFromCache()) {
+        chunk.numMutants = chunk.cacheEntry->numMutants;
+        chunk.mutantsInfos.appendWithIDShift(chunk.cacheEntry->mutantsInfos,
+                                             0);
+      }
+    }
+  } else {
+    /// \brief Split into chunks of consecutive functions of similar sizes.
+    /// Use more chunks than threads for a better load balance
+    unsigned numChunks = std::min<unsigned long>(funcsToMutate.size(),
+                                                 4 * numGenerationThreads);
+    unsigned long chunkTargetSize = totalSize / numChunks + 1;
+    unsigned long curChunkSize = chunkTargetSize;
+    for (unsigned i = 0, ie = funcsToMutate.size(); i < ie; ++i) {
+      if (curChunkSize >= chunkTargetSize) {
+        chunks.emplace_back(new GenerationChunk);
+        curChunkSize = 0;
+      }
+      chunks.back()->funcNames.push_back(funcsToMutate[i]);
+      curChunkSize += funcsSizes[i];
+    }
+  }
+  std::vector<GenerationChunk *> chunksToMutate;
+  for (auto &chunk : chunks)
+    if (!chunk->isFromCache())
+      chunksToMutate.push_back(chunk.get());
+
+  /// \brief Make all the global values external while the functions are
+  /// mutated separately, so that the declarations in the chunks' modules link
+  /// back to them. The unnamed ones, which cannot be linked back by name, get
+  /// a temporary name. The linkages and names are restored at the end.
+  std::vector<std::pair<std::string, llvm::GlobalValue::LinkageTypes>>
+      changedLinkages;
+  std::vector<std::string> tmpNamedGlobals;
+  auto externalize = [&changedLinkages,
+                      &tmpNamedGlobals](llvm::GlobalValue &GV) {
+    if (GV.isDeclaration() || GV.hasExternalLinkage() ||
+        GV.hasAppendingLinkage())
+      return;
+    if (!GV.hasName()) {
+      GV.setName("MART.unnamed_global" +
+                 std::to_string(tmpNamedGlobals.size()));
+      tmpNamedGlobals.push_back(GV.getName().str());
+    }
+    changedLinkages.emplace_back(GV.getName().str(), GV.getLinkage());
+    GV.setLinkage(llvm::GlobalValue::ExternalLinkage);
+  };
+  for (auto &Func : module)
+    externalize(Func);
+  for (auto &GV : module.globals())
+    externalize(GV);
+  for (auto &GA : module.aliases())
+    externalize(GA);
+
+  // Keep the functions order to restore it after linking
+  std::vector<std::string> funcOrder;
+  for (auto &Func : module)
+    funcOrder.push_back(Func.getName().str());
+
+  /// \brief Create the modules of the chunks to mutate
+  for (auto *chunk : chunksToMutate) {
+    std::unordered_set<llvm::GlobalValue const *> chunkFuncs;
+    for (auto &fname : chunk->funcNames)
+      chunkFuncs.insert(module.getFunction(fname));
+    llvm::ValueToValueMapTy VMap;
+#if (LLVM_VERSION_MAJOR >= 8)
+    std::unique_ptr<llvm::Module> chunkMod = llvm::CloneModule(
+#else
+    std::unique_ptr<llvm::Module> chunkMod = llvm::CloneModule(&
+#endif
+        module, VMap, [&chunkFuncs](llvm::GlobalValue const *GV) {
+          return (chunkFuncs.count(GV) > 0);
+        });
+    // The appending globals (llvm.global_ctors...) are now declarations that
+    // cannot be linked back
+    for (auto git = chunkMod->global_begin(), gie = chunkMod->global_end();
+         git != gie;) {
+      llvm::GlobalVariable &GV = *git++;
+      if (GV.isDeclaration() && GV.getName().startswith("llvm.") &&
+          GV.use_empty())
+        GV.eraseFromParent();
+    }
+    // The chunk's functions are linked back into declarations
+    for (auto &fname : chunk->funcNames)
+      chunkMod->getFunction(fname)->setComdat(nullptr);
+    chunk->irBuf.setToModule(chunkMod.get());
+  }
+
+  /// \brief Mutate the chunks in the worker threads
+  std::atomic<unsigned> nextChunk(0);
+  auto mutateChunks = [&]() {
+    for (unsigned c = nextChunk++; c < chunksToMutate.size();
+         c = nextChunk++) {
+      GenerationChunk &chunk = *chunksToMutate[c];
+      // Order matters: the module and the worker must be destroyed before
+      // their context
+      llvm::LLVMContext context;
+      std::unique_ptr<llvm::Module> chunkMod(chunk.irBuf.readIR(context));
+      assert(chunkMod && "Failed to read the chunk module");
+      Mutation worker(*chunkMod, *this);
+      llvm::GlobalVariable *chunkSelGlob =
+          chunkMod->getNamedGlobal(mutantIDSelectorName);
+      for (auto &fname : chunk.funcNames)
+        worker.mutateFunction(*chunkMod->getFunction(fname), chunkSelGlob);
+      chunk.numMutants = worker.curMutantID;
+      chunk.mutantsInfos.appendWithIDShift(worker.mutantsInfos, 0);
+      chunk.matchAttempts = worker.mutatorsMatchAttempts;
+      chunk.matchSuccesses = worker.mutatorsMatchSuccesses;
+      chunk.trivialPruned = worker.trivialPrunedMutants;
+      chunk.sampler = std::move(worker.mutantSampler);
+      chunk.filter = std::move(worker.utilityFilter);
+      chunk.unreachablePruned = worker.unreachablePrunedMutants;
+      chunk.irBuf.setToModule(chunkMod.get());
+    }
+  };
+  std::vector<std::thread> workers;
+  unsigned numWorkers =
+      std::min<unsigned>(numGenerationThreads, chunksToMutate.size());
+  for (unsigned t = 0; t < numWorkers; ++t)
+    workers.emplace_back(mutateChunks);
+  for (auto &th : workers)
+    th.join();
+
+  for (auto *chunk : chunksToMutate) {
+    for (unsigned pos = 0, pe = mutatorsMatchAttempts.size(); pos < pe;
+         ++pos) {
+      mutatorsMatchAttempts[pos] += chunk->matchAttempts[pos];
+      mutatorsMatchSuccesses[pos] += chunk->matchSuccesses[pos];
+    }
+    for (unsigned rule = 0; rule < NumTrivialEquivalenceRules; ++rule)
+      trivialPrunedMutants[rule] += chunk->trivialPruned[rule];
+    if (chunk->sampler)
+      mutantSampler->addStats(*chunk->sampler);
+    if (chunk->filter)
+      utilityFilter->addStats(*chunk->filter);
+    unreachablePrunedMutants += chunk->unreachablePruned;
+  }
+
+  /// \brief Store the newly mutated functions into the cache
+  if (mutationCache) {
+    for (auto *chunk : chunksToMutate) {
+      MutationCache::FunctionEntry &entry = *chunk->cacheEntry;
+      entry.numMutants = chunk->numMutants;
+      entry.mutantsInfos = chunk->mutantsInfos;
+      mutationCache->store(entry, chunk->irBuf);
+    }
+  }
+
+  /// \brief Link back the mutated functions, in order
+  llvm::Linker linker(module);
+  for (auto &chunk : chunks) {
+    MutantIDType idShift = curMutantID;
+    std::unique_ptr<llvm::Module> chunkMod(
+        chunk->irBuf.readIR(module.getContext()));
+    assert(chunkMod && "Failed to read the mutated chunk module");
+
+    // Shift the mutant IDs
+    llvm::GlobalVariable *chunkSelGlob =
+        chunkMod->getNamedGlobal(mutantIDSelectorName);
+    llvm::Function *chunkKSFunc =
+        forKLEESEMu ? chunkMod->getFunction(mutantIDSelectorName_Func)
+                    : nullptr;
+    for (auto &fname : chunk->funcNames)
+      ShardMerger::shiftMutantIDs(*chunkMod->getFunction(fname), idShift,
+                                  chunkSelGlob, chunkKSFunc, nullptr, nullptr,
+                                  "MART.Mutant_preTCEMut");
+
+    // Remove the unused declarations, which may not exist in 'module' when
+    // the chunk comes from the cache
+    std::unordered_set<std::string> chunkFuncNames(chunk->funcNames.begin(),
+                                                   chunk->funcNames.end());
+    std::vector<llvm::GlobalValue *> unusedDecls;
+    for (auto &F : *chunkMod)
+      if (F.isDeclaration() && F.use_empty() &&
+          chunkFuncNames.count(F.getName().str()) == 0)
+        unusedDecls.push_back(&F);
+    for (auto &GV : chunkMod->globals())
+      if (GV.isDeclaration() && GV.use_empty())
+        unusedDecls.push_back(&GV);
+    for (auto *GV : unusedDecls)
+      GV->eraseFromParent();
+
+    // Keep only the module flags among the named metadata, the others
+    // (llvm.dbg.cu, llvm.ident...) are already in 'module'
+    std::vector<llvm::NamedMDNode *> namedMDs;
+    for (auto &NMD : chunkMod->named_metadata())
+      if (NMD.getName() != "llvm.module.flags")
+        namedMDs.push_back(&NMD);
+    for (auto *NMD : namedMDs)
+      chunkMod->eraseNamedMetadata(NMD);
+
+    // Replace the original functions' bodies by the mutated ones
+    std::unordered_map<std::string,
+                       std::pair<llvm::Comdat *, llvm::DICompileUnit *>>
+        funcsComdatAndCU;
+    for (auto &fname : chunk->funcNames) {
+      llvm::Function *Func = module.getFunction(fname);
+      llvm::DISubprogram *SP = Func->getSubprogram();
+      funcsComdatAndCU[fname] = std::make_pair(
+          Func->getComdat(), SP ? SP->getUnit() : nullptr);
+      Func->deleteBody();
+      Func->setComdat(nullptr);
+    }
+    if (linker.linkInModule(std::move(chunkMod))) {
+      assert(false && "Failed to link back the mutated functions");
+    }
+    for (auto &fname : chunk->funcNames) {
+      llvm::Function *Func = module.getFunction(fname);
+      Func->setComdat(funcsComdatAndCU[fname].first);
+      llvm::DISubprogram *SP = Func->getSubprogram();
+      if (SP && funcsComdatAndCU[fname].second)
+        SP->replaceUnit(funcsComdatAndCU[fname].second);
+    }
+
+    if (chunk->cacheEntry)
+      chunk->cacheEntry->firstMutantID = idShift + 1;
+    mutantsInfos.appendWithIDShift(chunk->mutantsInfos, idShift);
+    curMutantID += chunk->numMutants;
+  }
+
+  /// \brief Restore the functions order and the linkages
+  for (auto &fname : funcOrder) {
+    llvm::Function *Func = module.getFunction(fname);
+    module.getFunctionList().splice(module.getFunctionList().end(),
+                                    module.getFunctionList(),
+                                    Func->getIterator());
+  }
+  for (auto &nameLinkage : changedLinkages)
+    module.getNamedValue(nameLinkage.first)->setLinkage(nameLinkage.second);
+  for (auto &tmpName : tmpNamedGlobals)
+    module.getNamedValue(tmpName)->setName("");
+#endif
+} //~Mutation::mutateFunctionsInChunks
+
+/**
+ * \brief Find the defined functions that are not reachable from the entry
+ * functions (reachabilityEntries), and put their names into unreachableFuncs.
+ * \detail The reachable functions are those called or whose address is taken
+ * in a reachable function, or referenced (transitively) from the initializer
+ * of a global variable used in a reachable function. The functions in the
+ * global constructors, destructors and used lists are entries too.
+ * @return false if none of the entry functions is defined in the module.
+ */
+bool Mutation::computeUnreachableFunctions(llvm::Module &module) {
+  std::unordered_set<llvm::Function const *> reachable;
+  std::unordered_set<llvm::Constant const *> visitedConsts;
+  std::vector<llvm::Function const *> workList;
+
+  // Add the functions referenced by the constant @param C
+  std::function<void(llvm::Constant const *)> visitConstant;
+  visitConstant = [&](llvm::Constant const *C) {
+    if (!visitedConsts.insert(C).second)
+      return;
+    if (auto *F = llvm::dyn_cast<llvm::Function>(C)) {
+      if (reachable.insert(F).second)
+        workList.push_back(F);
+    } else if (auto *GV = llvm::dyn_cast<llvm::GlobalVariable>(C)) {
+      if (GV->hasInitializer())
+        visitConstant(GV->getInitializer());
+    } else if (auto *GA = llvm::dyn_cast<llvm::GlobalAlias>(C)) {
+      visitConstant(GA->getAliasee());
+    } else if (!llvm::isa<llvm::GlobalValue>(C)) {
+      for (unsigned i = 0, ie = C->getNumOperands(); i < ie; ++i)
+        if (auto *opC = llvm::dyn_cast<llvm::Constant>(C->getOperand(i)))
+          visitConstant(opC);
+    }
+  };
+
+  unsigned numEntries = 0;
+  for (auto &fname : reachabilityEntries) {
+    llvm::Function *F = module.getFunction(fname);
+    if (F == nullptr || F->isDeclaration()) {
+      llvm::errs() << "Mart@Warning: the entry function '" << fname
+                   << "' is not defined in the module, ignoring it.\n";
+      continue;
+    }
+    ++numEntries;
+    visitConstant(F);
+  }
+  if (numEntries == 0) {
+    llvm::errs() << "Mart@Error: none of the entry functions of the "
+                    "reachability pruning is defined in the module\n";
+    return false;
+  }
+  for (const char *gname : {"llvm.global_ctors", "llvm.global_dtors",
+                            "llvm.used", "llvm.compiler.used"})
+    if (auto *GV = module.getNamedGlobal(gname))
+      visitConstant(GV);
+
+  while (!workList.empty()) {
+    llvm::Function *F = const_cast<llvm::Function *>(workList.back());
+    workList.pop_back();
+    if (!ReadWriteIRObj::materialize(*F))
+      return false;
+    for (auto &BB : *F)
+      for (auto &Inst : BB)
+        for (unsigned i = 0, ie = Inst.getNumOperands(); i < ie; ++i)
+          if (auto *C = llvm::dyn_cast<llvm::Constant>(Inst.getOperand(i)))
+            visitConstant(C);
+  }
+
+  unreachableFuncs.clear();
+  for (auto &Func : module)
+    if (!Func.isDeclaration() && !reachable.count(&Func))
+      unreachableFuncs.insert(Func.getName().str());
+  return true;
+}
+
+/**
+ * \brief Split the functions to mutate, in the module's order, into
+ * shardCount parts of consecutive functions with similar numbers of
+ * instructions. Put the functions of the part shardIndex into shardFuncs and
+ * the others into otherShardsFuncs. A function goes to the part containing
+ * the middle of its instructions, so that all the shards compute the same
+ * split, and the mutant IDs of the merged shards follow the module's order.
+ * @return false if a function fails to be read.
+ */
+bool Mutation::computeShardFunctions(llvm::Module &module) {
+  shardFuncs.clear();
+  otherShardsFuncs.clear();
+  std::vector<std::pair<std::string, unsigned long>> funcsSizes;
+  unsigned long totalSize = 0;
+  for (auto &Func : module) {
+    if (skipFunc(Func))
+      continue;
+    if (!ReadWriteIRObj::materialize(Func))
+      return false;
+    unsigned long fsize = 0;
+    for (auto &BB : Func)
+      fsize += BB.size();
+    funcsSizes.emplace_back(Func.getName().str(), fsize);
+    totalSize += fsize;
+  }
+  unsigned long cumulSize = 0;
+  for (unsigned i = 0, ie = funcsSizes.size(); i < ie; ++i) {
+    unsigned long long shard;
+    if (totalSize == 0)
+      shard = (unsigned long long)i * shardCount / ie;
+    else
+      shard = (unsigned long long)(2 * cumulSize + funcsSizes[i].second) *
+              shardCount / (2 * totalSize);
+    cumulSize += funcsSizes[i].second;
+    if (std::min<unsigned long long>(shard, shardCount - 1) == shardIndex)
+      shardFuncs.push_back(funcsSizes[i].first);
+    else
+      otherShardsFuncs.insert(funcsSizes[i].first);
+  }
+  return true;
+}
+
+/**
+ * \brief generate, with @param counter, the mutants of the functions to
+ * mutate of @param countModule (a copy of the module), where the filters of
+ * @param counter are in counting pass: no mutant is added into the copy.
+ */
+void Mutation::runCountingPass(Mutation &counter, llvm::Module &countModule) {
+  llvm::GlobalVariable *countSelGlob =
+      countModule.getNamedGlobal(mutantIDSelectorName);
+  for (auto &Func : *currentMetaMutantModule) {
+    if (skipFunc(Func))
+      continue;
+    counter.mutateFunction(*countModule.getFunction(Func.getName()),
+                           countSelGlob);
+  }
+}
+
+// @Name: doMutate
+// This is the main method of the class Mutation, Call this to mutate a module
+bool Mutation::doMutate() {
+  llvm::Module &module = *currentMetaMutantModule;
+
+  // Instert Mutant ID Selector Global Variable
+  while (module.getNamedGlobal(mutantIDSelectorName)) {
+    llvm::errs() << "The gobal variable '" << mutantIDSelectorName
+                 << "' already present in code!\n";
+    assert(
+        false &&
+        "ERROR: Module already mutated!"); // getanothermutantIDSelectorName();
+  }
+  module.getOrInsertGlobal(mutantIDSelectorName,
+                           llvm::Type::getInt32Ty(moduleInfo.getContext()));
+  llvm::GlobalVariable *mutantIDSelectorGlobal =
+      module.getNamedGlobal(mutantIDSelectorName);
+  // mutantIDSelectorGlobal->setLinkage(llvm::GlobalValue::CommonLinkage);
+  // //commonlinkage require 0 as initial value
+#if (LLVM_VERSION_MAJOR >= 10) // && (LLVM_VERSION_MINOR < 5)
+  mutantIDSelectorGlobal->setAlignment(llvm::MaybeAlign(4));
 #else
-      // make 'changeBBIt' foint to the last BB before the next one to explore
-      itBBlock = sstmtCurBB->getIterator();
+  mutantIDSelectorGlobal->setAlignment(4);
 #endif
+  mutantIDSelectorGlobal->setInitializer(llvm::ConstantInt::get(
+      moduleInfo.getContext(), llvm::APInt(32, 0, false)));
 
-      ///\brief Mutation over for the current set of BB, reinitialize
-      ///'mutationStartingAtBB' for the coming ones
-      mutationStartingAtBB = nullptr;
-
-      srcStmtsSearchList.clear();
+  // XXX: Insert definition of the function whose call argument will tell
+  // KS which mutants to fork
+  if (forKLEESEMu) {
+    funcForKLEESEMu = createGlobalMutIDSelector_Func(module);
+  }
 
-    } // for each BB in Function
+  if (!reachabilityEntries.empty() && !computeUnreachableFunctions(module))
+    return false;
 
-    assert(remainMultiBBLiveStmts.empty() &&
-           "Something wrong with function (missing IRs) or bug!");
+  if (shardCount > 1 && !computeShardFunctions(module))
+    return false;
 
-    // repairDefinitionUseDomination(Func);  //TODO: when we want to directly
-    // support cross BB use
+  /// \brief A budget in number of mutants needs the predicted utilities of
+  /// all the mutants (utility filter) or the number of mutants of each stratum
+  /// (sampler): generate the mutants of a copy of the module without adding
+  /// them into it, to count them. The copy only needs the functions to mutate,
+  /// which were read with the scope
+  if (utilityFilter && utilityFilter->needsCountingPass()) {
+    llvm::ValueToValueMapTy countVMap;
+    std::unique_ptr<llvm::Module> countModule(
+        ReadWriteIRObj::cloneMaterializedAndRelease(&module, countVMap));
+    Mutation counter(*countModule, *this);
+    counter.utilityFilter->setCountingPass();
+    runCountingPass(counter, *countModule);
+    utilityFilter->computeCutoff(*counter.utilityFilter);
+  }
+  if (mutantSampler && mutantSampler->needsCountingPass()) {
+    llvm::ValueToValueMapTy countVMap;
+    std::unique_ptr<llvm::Module> countModule(
+        ReadWriteIRObj::cloneMaterializedAndRelease(&module, countVMap));
+    Mutation counter(*countModule, *this);
+    counter.mutantSampler->setCountingPass();
+    runCountingPass(counter, *countModule);
+    mutantSampler->computeQuotas(*counter.mutantSampler);
+  }
 
-    // Func.dump();
+  // The dry run counts the mutants in place, without copying the functions
+  if ((numGenerationThreads > 1 || mutationCache) && !isDryRun) {
+    mutateFunctionsInChunks(module, mutantIDSelectorGlobal);
+  } else {
+    for (auto &Func : module) {
+      // Skip Function with only Declaration (External function -- no
+      // definition)
+      if (skipFunc(Func))
+        continue;
 
-    Mutation::checkFunctionValidity(
-        Func, "ERROR: Misformed Function After mutation!");
-  } // for each Function in Module
+      mutateFunction(Func, mutantIDSelectorGlobal);
+    } // for each Function in Module
+  }
 
   //@ Set the Initial Value of mutantIDSelectorGlobal to '<Highest Mutant ID> +
   // 1' (which is equivalent to selecting the original program)
@@ -1857,6 +3434,9 @@ void Mutation::computeWeakMutation(std::unique_ptr<llvm::Module> &cmodule,
   // Strip useless debugging infos
   llvm::StripDebugInfo(*cmodule.get());
 
+  // Weak mutation compares each mutant with the whole original statement
+  unshareStmtsPrefixes(*cmodule, cmodule->getNamedGlobal(mutantIDSelectorName));
+
   llvm::Function *funcWMLog = cmodule->getFunction(wmLogFuncName);
   llvm::Function *funcWMFflush = cmodule->getFunction(wmFFlushFuncName);
   llvm::GlobalVariable *constWMHighestID =
@@ -2196,12 +3776,16 @@ struct DuplicateEquivalentProcessor {
   std::vector<llvm::Module *> mutModules;
   std::vector<llvm::Function *> mutFunctions;
 
-  /// \brief the key of the map is the index (staring from 0) of the function in
-  /// the original's optimized module, or -1 for any function not present in
-  /// original optimized
-  /// \brief the value is a vector of the ids of all the mutants (non dup) in
-  /// duplicateMap for which the function is different than the orig's.
-  std::unordered_map<llvm::Function *, std::vector<MutantIDType>> diffFuncs2Muts;
+  /// \brief the key of the map is the function in the original's optimized
+  /// module, or nullptr for any function not present in original optimized
+  /// \brief the value buckets the ids of all the mutants (non dup) in
+  /// duplicateMap for which the function is different than the orig's, by
+  /// the structural hash of their function (and, in function mode, their
+  /// basic blocks that differ from the original's). A mutant is only diffed
+  /// with the mutants of its bucket, in the order of their ids.
+  std::unordered_map<llvm::Function *,
+                     std::unordered_map<size_t, std::vector<MutantIDType>>>
+      diffFuncs2Muts;
 
   /// \brief map to lookup the module(value) cleaned for each function (key)
   std::unordered_map<llvm::Function *, ReadWriteIRObj> inMemIRModBufByFunc;
@@ -2217,12 +3801,16 @@ struct DuplicateEquivalentProcessor {
 
   std::vector<llvm::SmallVector<llvm::BasicBlock *, 2>> diffBBWithOrig;
 
+  /// \brief verdict of each processed mutant (see update)
+  std::vector<MutantIDType> verdictByMutID;
+
   bool isTCEFunctionMode;
 
   DuplicateEquivalentProcessor(MutantIDType highestMutID, bool is_tce_func_mode)
       : isTCEFunctionMode(is_tce_func_mode) {
     funcMutByMutID.resize(highestMutID + 1, nullptr);
     diffBBWithOrig.resize(highestMutID + 1);
+    verdictByMutID.resize(highestMutID + 1, 0);
   }
 
   /// Populate dup2nondupMap using the dupliate informations from duplicateMap
@@ -2236,8 +3824,11 @@ struct DuplicateEquivalentProcessor {
     }
   }
 
-  void update(MutantIDType mutant_id, llvm::Module *clonedOrig,
-              llvm::Module *clonedM) {
+  /// \brief @return the verdict of the mutant: 0 if it is equivalent, the
+  /// ID of the mutant it duplicates, or @param mutant_id if it is new
+  MutantIDType update(MutantIDType mutant_id, llvm::Module *clonedOrig,
+                      llvm::Module *clonedM) {
+    MutantIDType verdict = mutant_id;
     std::vector<llvm::Function *> mutatedFuncsOfMID;
     if (isTCEFunctionMode) {
       if (tce.functionDiff(
@@ -2254,6 +3845,7 @@ struct DuplicateEquivalentProcessor {
     if (mutatedFuncsOfMID.empty()) // equivalent with orig
     {
       duplicateMap.at(0).push_back(mutant_id);
+      verdict = 0;
 
       // delete its function to free memory space
       if (isTCEFunctionMode) {
@@ -2269,6 +3861,7 @@ struct DuplicateEquivalentProcessor {
              "TODO: extent to mutant cros function");
 
       bool hasEq = false;
+      std::vector<std::vector<MutantIDType> *> bucketOfFuncs;
       for (auto *mF : mutatedFuncsOfMID) {
         llvm::Function *subjFunc;
         if (isTCEFunctionMode)
@@ -2276,7 +3869,15 @@ struct DuplicateEquivalentProcessor {
         else
           subjFunc = clonedM->getFunction(mF->getName());
 
-        for (auto candID : diffFuncs2Muts.at(mF)) {
+        // Only the mutants with the same hash can be duplicates
+        size_t subjHash =
+            TCE::useHashBuckets() ? tce.hashFunction(subjFunc) : 0;
+        if (isTCEFunctionMode)
+          for (auto *diffBB : diffBBWithOrig[mutant_id])
+            subjHash = llvm::hash_combine(subjHash, diffBB);
+        bucketOfFuncs.push_back(&(diffFuncs2Muts.at(mF)[subjHash]));
+
+        for (auto candID : *bucketOfFuncs.back()) {
           llvm::Function *candFunc;
           if (isTCEFunctionMode) {
             // prune useless comparisons
@@ -2306,6 +3907,7 @@ struct DuplicateEquivalentProcessor {
 
             hasEq = true;
             duplicateMap.at(candID).push_back(mutant_id);
+            verdict = candID;
             break;
           } else {
             if (!candFunc)
@@ -2314,6 +3916,7 @@ struct DuplicateEquivalentProcessor {
             if (!tce.functionDiff(candFunc, subjFunc, nullptr)) {
               hasEq = true;
               duplicateMap.at(candID).push_back(mutant_id);
+              verdict = candID;
               break;
             }
           }
@@ -2321,8 +3924,8 @@ struct DuplicateEquivalentProcessor {
       }
       if (!hasEq) {
         duplicateMap[mutant_id]; // insert id into the map
-        for (auto *mF : mutatedFuncsOfMID)
-          diffFuncs2Muts.at(mF).push_back(mutant_id);
+        for (auto *bucket : bucketOfFuncs)
+          bucket->push_back(mutant_id);
       } else {
         // delete its function to free memory space
         if (isTCEFunctionMode) {
@@ -2332,6 +3935,20 @@ struct DuplicateEquivalentProcessor {
         // llvm::errs() << mutant_id << " is duplicate\n"; /////DBG
       }
     }
+    verdictByMutID[mutant_id] = verdict;
+    return verdict;
+  }
+
+  /// \brief record the mutant @param mutant_id, known to be identical to the
+  /// already processed mutant @param identicalID, or equivalent if it is 0,
+  /// without its function. @return its verdict, as update
+  MutantIDType updateAsIdentical(MutantIDType mutant_id,
+                                 MutantIDType identicalID) {
+    MutantIDType verdict =
+        (identicalID == 0 ? 0 : verdictByMutID[identicalID]);
+    duplicateMap.at(verdict).push_back(mutant_id);
+    verdictByMutID[mutant_id] = verdict;
+    return verdict;
   }
 }; //~ struct DuplicateEquivalentProcessor
 
@@ -2354,27 +3971,78 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
   llvm::Module *clonedOrig = nullptr;
 
   /// make the new module that will have no metadata, to hopefully make
-  /// mutantion TCE and write/ comilation faster
+  /// mutantion TCE and write/ comilation faster. The function mode only
+  /// optimizes the mutated functions: the functions of a lazily read module
+  /// that were not read are only declared in it, unless the mutants modules
+  /// are written
+  if ((!isTCEFunctionMode || writeMuts) &&
+      !ReadWriteIRObj::materializeAll(module))
+    assert(false && "Failed to read the functions of the module");
+  llvm::ValueToValueMapTy subjVMap;
   std::unique_ptr<llvm::Module> subjModule(
-      ReadWriteIRObj::cloneModuleAndRelease(&module));
+      ReadWriteIRObj::cloneMaterializedAndRelease(&module, subjVMap));
   llvm::StripDebugInfo(*subjModule);
 
+  /// \brief In function mode, the mutants of different functions can be
+  /// processed in parallel, each function in a worker thread with its own
+  /// LLVMContext, from the buffers of the functions' modules. Not when
+  /// writing the mutants, which needs their functions in this context.
+  bool isParallelTCE = isTCEFunctionMode && numTCEThreads > 1 && !writeMuts;
+
+  ///\brief the original module, optimized, for the parallel TCE workers
+  ReadWriteIRObj origModuleBuf;
+
+  /// \brief The TCE verdict cache is looked up for each mutant after its
+  /// function is cleaned, and before it is optimized (function mode, not
+  /// when writing the mutants, which need their functions). The key of each
+  /// looked up mutant, and, for the cache hits, the mutant it is identical to
+  /// (0 for the original), else noTCECacheHit. These are written by the
+  /// threads of the parallel TCE, each for its own mutants.
+  bool useTCEVerdictCache = tceVerdictCache && isTCEFunctionMode && !writeMuts;
+  const MutantIDType noTCECacheHit = highestMutID + 1;
+  std::vector<std::string> tceCacheKeys;
+  std::vector<MutantIDType> tceCacheHitOf;
+  if (useTCEVerdictCache) {
+    tceCacheKeys.resize(highestMutID + 1);
+    tceCacheHitOf.resize(highestMutID + 1, noTCECacheHit);
+    tceVerdictCache->setContext(
+        *subjModule,
+        TCE::getConfigName(Mutation::funcModeOptLevel), mutantIDSelectorName);
+  }
+
   if (isTCEFunctionMode) {
     dup_eq_processor.mutFunctions.clear();
     dup_eq_processor.mutFunctions.resize(highestMutID + 1, nullptr);
     llvm::errs() << "Cloning...\n"; //////DBG
-    computeModuleBufsByFunc(*subjModule, nullptr,
-                            &dup_eq_processor.clonedModByFunc,
-                            dup_eq_processor.funcMutByMutID);
-
-    clonedOrig = ReadWriteIRObj::cloneModuleAndRelease(
-        dup_eq_processor.clonedModByFunc.at(
-            dup_eq_processor.funcMutByMutID[0]));
-
-    // The original
-    assert(getMutant(*clonedOrig, 0, dup_eq_processor.funcMutByMutID[0],
-                     'A' /*optimizeAllFunctions*/) &&
-           "error: failed to get original");
+    if (isParallelTCE) {
+      computeModuleBufsByFunc(*subjModule,
+                              &dup_eq_processor.inMemIRModBufByFunc, nullptr,
+                              dup_eq_processor.funcMutByMutID);
+
+      // The original
+      llvm::LLVMContext origContext;
+      std::unique_ptr<llvm::Module> origModule(
+          dup_eq_processor.inMemIRModBufByFunc
+              .at(dup_eq_processor.funcMutByMutID[0])
+              .readIR(origContext));
+      assert(getMutant(*origModule, 0, dup_eq_processor.funcMutByMutID[0],
+                       'A' /*optimizeAllFunctions*/) &&
+             "error: failed to get original");
+      origModuleBuf.setToModule(origModule.get());
+    } else {
+      computeModuleBufsByFunc(*subjModule, nullptr,
+                              &dup_eq_processor.clonedModByFunc,
+                              dup_eq_processor.funcMutByMutID);
+
+      clonedOrig = ReadWriteIRObj::cloneModuleAndRelease(
+          dup_eq_processor.clonedModByFunc.at(
+              dup_eq_processor.funcMutByMutID[0]));
+
+      // The original
+      assert(getMutant(*clonedOrig, 0, dup_eq_processor.funcMutByMutID[0],
+                       'A' /*optimizeAllFunctions*/) &&
+             "error: failed to get original");
+    }
   } else {
     dup_eq_processor.mutModules.clear();
     dup_eq_processor.mutModules.resize(highestMutID + 1, nullptr);
@@ -2408,20 +4076,419 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
   dup_eq_processor.duplicateMap[0]; // insert 0 into the map
   // initialize 'dup_eq_processor.diffFuncs2Muts'
   dup_eq_processor.diffFuncs2Muts[nullptr]; // for function not in original
-  for (auto &origFunc : *clonedOrig)
-    dup_eq_processor.diffFuncs2Muts[&origFunc];
+  if (clonedOrig)
+    for (auto &origFunc : *clonedOrig)
+      dup_eq_processor.diffFuncs2Muts[&origFunc];
 
   // The mutants
 
+  /// \brief Materialize the optimized function of each of the mutants
+  /// @param fromID to @param toID, which all mutate the function
+  /// @param subjFunctionName of @param funcModule (its module in
+  /// clonedModByFunc), and pass it, out of the module, to @param onMutant, in
+  /// increasing order of the mutant IDs. The function of the mutants whose
+  /// verdict is reused from the TCE verdict cache is not optimized, and null
+  /// is passed instead (see tceCacheHitOf).
+  auto materializeMutants =
+      [this, useTCEVerdictCache, &tceCacheKeys, &tceCacheHitOf](
+          llvm::Module *funcModule, std::string const &subjFunctionName,
+             MutantIDType fromID, MutantIDType toID, TCE &tce,
+             std::function<void(MutantIDType, llvm::Function *)> const
+                 &onMutant,
+             bool verbose) {
+    llvm::GlobalVariable *mutantIDSelGlobFF =
+        funcModule->getNamedGlobal(mutantIDSelectorName);
+    llvm::Function *mutantIDSelGlob_FuncFF =
+        funcModule->getFunction(mutantIDSelectorName_Func);
+
+    llvm::Function *subjFunc = funcModule->getFunction(subjFunctionName);
+    MutantSwitchCases switchCases;
+    getMutantSwitchCases(*subjFunc, mutantIDSelGlobFF, switchCases);
+
+    /// \brief in order to make optimization and function clone (with debug
+    /// data), the function need to be in a module.
+    /// This string is a name for a temporal function (global value) not yet
+    /// in module, that will be used to temporally
+    /// add the subject function for clone and optimization
+    std::string temporaryFname(mutantIDSelectorName_Func +
+                               std::string("tmp"));
+    unsigned uniq = 0;
+    while (funcModule->getNamedValue(temporaryFname + std::to_string(uniq)))
+      uniq++;
+    temporaryFname += std::to_string(uniq);
+
+    unsigned progressVerbose = 0;
+    unsigned nextProgress = 5;
+    unsigned progressVLandmark = (toID - fromID) * nextProgress / 100;
+
+    // The key of the function in the TCE verdict cache, from its original,
+    // and the first of the mutants having each key
+    std::string tceCacheFuncKey;
+    std::unordered_map<std::string, MutantIDType> tceCacheFirstMutByKey;
+    if (useTCEVerdictCache) {
+      llvm::Function *origFunc = cloneFunctionToMut(
+          *subjFunc, 0, mutantIDSelGlobFF, mutantIDSelGlob_FuncFF,
+          switchCases, temporaryFname);
+      tceCacheFuncKey =
+          tceVerdictCache->computeFunctionKey(subjFunctionName, *origFunc);
+      origFunc->eraseFromParent();
+    }
+
+    /// Clone directly the function of each mutant, with only its own code
+    /// (not the code of the other mutants of the function)
+    for (MutantIDType mutID = fromID; mutID <= toID; ++mutID) {
+      // add to module as temporary name
+      llvm::Function *mutFunc =
+          cloneFunctionToMut(*subjFunc, mutID, mutantIDSelGlobFF,
+                             mutantIDSelGlob_FuncFF, switchCases,
+                             temporaryFname);
+
+      // Compare with the function of the mutant that getMutant cleans out of
+      // the meta function
+      if (checkMutantMaterialization) {
+        llvm::ValueToValueMapTy vmap;
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 9)
+        llvm::Function *cleanedFunc =
+            llvm::CloneFunction(subjFunc, vmap, true /*moduleLevelChanges*/);
+        funcModule->getFunctionList().push_back(cleanedFunc);
+#else
+        llvm::Function *cleanedFunc = llvm::CloneFunction(subjFunc, vmap);
+#endif
+        cleanFunctionToMut(*cleanedFunc, mutID, mutantIDSelGlobFF,
+                           mutantIDSelGlob_FuncFF);
+        ++numMaterializationChecked;
+        if (tce.functionDiff(cleanedFunc, mutFunc, nullptr)) {
+          ++numMaterializationDiffering;
+          llvm::errs() << "Mart@Warning: the function of mutant " << mutID
+                       << " differs from the one cleaned out of the meta "
+                          "function of '"
+                       << subjFunctionName << "'\n";
+        }
+        cleanedFunc->eraseFromParent();
+      }
+
+      // Reuse the verdict of the mutant from the TCE verdict cache: an
+      // equivalent mutant, or a duplicate of a mutant seen before
+      bool isTCECacheHit = false;
+      if (useTCEVerdictCache) {
+        std::string &key = tceCacheKeys[mutID];
+        key = tceVerdictCache->computeMutantKey(tceCacheFuncKey, *mutFunc);
+        TCEVerdictCache::Verdict cachedVerdict;
+        if (tceVerdictCache->lookup(key, cachedVerdict)) {
+          if (cachedVerdict.kind == TCEVerdictCache::Equivalent) {
+            tceCacheHitOf[mutID] = 0;
+            isTCECacheHit = true;
+          } else if (cachedVerdict.kind == TCEVerdictCache::Duplicate) {
+            auto it = tceCacheFirstMutByKey.find(cachedVerdict.duplicateOfKey);
+            if (it != tceCacheFirstMutByKey.end()) {
+              tceCacheHitOf[mutID] = it->second;
+              isTCECacheHit = true;
+            }
+          }
+        }
+        tceVerdictCache->countLookup(isTCECacheHit);
+        tceCacheFirstMutByKey.emplace(key, mutID);
+      }
+
+      if (isTCECacheHit) {
+        mutFunc->eraseFromParent();
+        onMutant(mutID, nullptr);
+      } else {
+        // get final optimized function for mutant
+        tce.optimize(*mutFunc, Mutation::funcModeOptLevel);
+
+        // remove from module and set back original name
+        mutFunc->removeFromParent();
+        mutFunc->setName(subjFunctionName);
+
+        onMutant(mutID, mutFunc);
+      }
+
+      // Progress  -- VERBOSE
+      ++progressVerbose;
+      if (verbose && progressVerbose == progressVLandmark) {
+        llvm::errs() << nextProgress << "% ";
+        nextProgress += 5;
+        progressVLandmark = (toID - fromID) * nextProgress / 100;
+      }
+    }
+  };
+
+  /// \brief TCE of the mutants @param fromID to @param toID, which all mutate
+  /// the same function of @param funcModule (its module in clonedModByFunc),
+  /// against the original functions of @param origModule, with
+  /// @param processor. The verdicts are appended to @param verdicts (when not
+  /// null) in the processing order.
+  auto tceFunctionMutants =
+      [&materializeMutants, &tceCacheHitOf](
+          DuplicateEquivalentProcessor &processor, llvm::Module *funcModule,
+          llvm::Module *origModule, MutantIDType fromID, MutantIDType toID,
+          std::vector<std::pair<MutantIDType, MutantIDType>> *verdicts,
+          bool verbose) {
+    materializeMutants(
+        funcModule, processor.funcMutByMutID[fromID]->getName().str(), fromID,
+        toID, processor.tce,
+        [&](MutantIDType mutID, llvm::Function *mutFunc) {
+          MutantIDType verdict;
+          if (mutFunc) {
+            processor.mutFunctions[mutID] = mutFunc;
+            verdict = processor.update(mutID, origModule, funcModule);
+          } else {
+            verdict = processor.updateAsIdentical(mutID, tceCacheHitOf[mutID]);
+          }
+          if (verdicts)
+            verdicts->emplace_back(mutID, verdict);
+        },
+        verbose);
+  };
+
+  /// \brief Minimum number of mutants of the chunks of a function whose TCE
+  /// is split across the threads (see tceFunctionMutantsInChunks)
+  const MutantIDType tceMinChunkMutants = 64;
+
+  /// \brief TCE of the mutants of a function with too many mutants for a
+  /// single thread, as tceFunctionMutants. The range of mutant IDs is split
+  /// into chunks whose mutants' functions are materialized and optimized in
+  /// parallel, each chunk in its own LLVMContext, from @param funcModuleBuf
+  /// (the buffer of @param funcModule). The functions of the chunks are then
+  /// read into the context of @param funcModule and the duplicates are
+  /// detected in the same order as tceFunctionMutants. @param chunkModules
+  /// gets the modules of the chunks, to destroy after the mutants' functions.
+  auto tceFunctionMutantsInChunks =
+      [&](DuplicateEquivalentProcessor &processor, llvm::Module *funcModule,
+          ReadWriteIRObj &funcModuleBuf, llvm::Module *origModule,
+          MutantIDType fromID, MutantIDType toID,
+          std::vector<std::pair<MutantIDType, MutantIDType>> *verdicts,
+          std::vector<std::unique_ptr<llvm::Module>> &chunkModules) {
+    const std::string subjFunctionName =
+        processor.funcMutByMutID[fromID]->getName().str();
+    struct MutantsChunk {
+      MutantIDType fromID;
+      MutantIDType toID;
+      ReadWriteIRObj irBuf;
+      std::vector<std::string> mutFuncNames;
+    };
+    MutantIDType numMutants = toID - fromID + 1;
+    unsigned numChunks = std::min<MutantIDType>(
+        2 * numTCEThreads,
+        (numMutants + tceMinChunkMutants - 1) / tceMinChunkMutants);
+    std::vector<MutantsChunk> chunks(numChunks);
+    for (unsigned c = 0; c < numChunks; ++c) {
+      chunks[c].fromID = fromID + (unsigned long)numMutants * c / numChunks;
+      chunks[c].toID =
+          fromID + (unsigned long)numMutants * (c + 1) / numChunks - 1;
+    }
+
+    std::atomic<unsigned> nextChunk(0);
+    auto materializeChunks = [&]() {
+      // The thread's optimization pipelines, reused across its chunks
+      TCE tce;
+      for (unsigned c = nextChunk++; c < chunks.size(); c = nextChunk++) {
+        MutantsChunk &chunk = chunks[c];
+        // Order matters: the module must be destroyed before its context
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> chunkMod(funcModuleBuf.readIR(context));
+        assert(chunkMod && "Failed to read the function's module");
+        std::vector<llvm::Function *> mutFuncs;
+        materializeMutants(chunkMod.get(), subjFunctionName, chunk.fromID,
+                           chunk.toID, tce,
+                           [&mutFuncs](MutantIDType, llvm::Function *mutFunc) {
+                             mutFuncs.push_back(mutFunc);
+                           },
+                           false);
+        // Only keep the mutants' functions bodies in the chunk's module
+        for (auto &Func : *chunkMod) {
+          if (!Func.isDeclaration()) {
+            Func.deleteBody();
+#if !((LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5))
+            Func.setComdat(nullptr);
+#endif
+          }
+        }
+        // The mutants reused from the TCE verdict cache have no function
+        for (auto *mutFunc : mutFuncs) {
+          if (mutFunc)
+            chunkMod->getFunctionList().push_back(mutFunc);
+          chunk.mutFuncNames.push_back(mutFunc ? mutFunc->getName().str()
+                                               : std::string());
+        }
+        chunk.irBuf.setToModule(chunkMod.get());
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0, te = std::min<unsigned>(numTCEThreads, numChunks);
+         t < te; ++t)
+      threads.emplace_back(materializeChunks);
+    for (auto &th : threads)
+      th.join();
+
+    for (auto &chunk : chunks) {
+      chunkModules.emplace_back(chunk.irBuf.readIR(funcModule->getContext()));
+      llvm::Module *chunkMod = chunkModules.back().get();
+      assert(chunkMod && "Failed to read the chunk's mutants");
+      assert(chunk.mutFuncNames.size() == chunk.toID - chunk.fromID + 1 &&
+             "Missing mutants in the chunk");
+      MutantIDType mutID = chunk.fromID;
+      for (auto &fname : chunk.mutFuncNames) {
+        MutantIDType verdict;
+        if (fname.empty()) {
+          verdict = processor.updateAsIdentical(mutID, tceCacheHitOf[mutID]);
+        } else {
+          llvm::Function *mutFunc = chunkMod->getFunction(fname);
+          mutFunc->removeFromParent();
+          mutFunc->setName(subjFunctionName);
+          processor.mutFunctions[mutID] = mutFunc;
+          verdict = processor.update(mutID, origModule, funcModule);
+        }
+        if (verdicts)
+          verdicts->emplace_back(mutID, verdict);
+        ++mutID;
+      }
+    }
+  };
+
+  /// \brief The functions whose mutants are processed by the parallel TCE,
+  /// with the verdicts of their mutants in the processing order. The
+  /// functions with more mutants than their share of the threads are split
+  /// (see tceFunctionMutantsInChunks)
+  struct FunctionTCEJob {
+    MutantIDType fromID;
+    MutantIDType toID;
+    bool isSplit;
+    std::vector<std::pair<MutantIDType, MutantIDType>> verdicts;
+  };
+  std::vector<FunctionTCEJob> tceJobs;
+  std::unordered_map<MutantIDType, unsigned> tceJobByFirstID;
+  if (isParallelTCE) {
+    unsigned long numJobsMutants = 0;
+    for (MutantIDType id = 1; id <= highestMutID;) {
+      llvm::Function *subjFunc = dup_eq_processor.funcMutByMutID[id];
+      assert(subjFunc != nullptr &&
+             "//Currently only support a mutant in a single funtion "
+             "(dup_eq_processor.funcMutByMutID[id]). TODO TODO: extent to "
+             "mutant cros function");
+      MutantIDType toID = id;
+      while (toID < highestMutID &&
+             dup_eq_processor.funcMutByMutID[toID + 1] == subjFunc)
+        ++toID;
+      // The functions whose TCE verdicts are reused from the mutation cache
+      // are not processed (see below)
+      MutationCache::FunctionEntry *cacheEntry = nullptr;
+      if (mutationCache)
+        cacheEntry = mutationCache->getEntry(subjFunc->getName().str());
+      if (!(cacheEntry && cacheEntry->fromCache &&
+            !cacheEntry->tceVerdicts.empty())) {
+        tceJobByFirstID[id] = tceJobs.size();
+        tceJobs.push_back(FunctionTCEJob{id, toID, false, {}});
+        numJobsMutants += toID - id + 1;
+      }
+      id = toID + 1;
+    }
+    std::vector<FunctionTCEJob *> splitJobs, otherJobs;
+    for (auto &job : tceJobs) {
+      unsigned long numFuncMutants = job.toID - job.fromID + 1;
+      job.isSplit = (numFuncMutants >= 2 * tceMinChunkMutants &&
+                     numFuncMutants * numTCEThreads > numJobsMutants);
+      (job.isSplit ? splitJobs : otherJobs).push_back(&job);
+    }
+
+    llvm::errs() << "Processing the mutants of " << tceJobs.size()
+                 << " functions in parallel (" << splitJobs.size()
+                 << " split)...\n";
+
+    /// \brief The state of a thread of the parallel TCE: its own context,
+    /// the original module and the TCE data structures
+    struct TCEThreadState {
+      // Order matters: the modules and the processor must be destroyed
+      // before their context
+      llvm::LLVMContext context;
+      std::unique_ptr<llvm::Module> origModule;
+      DuplicateEquivalentProcessor processor;
+      TCEThreadState(ReadWriteIRObj &origModuleBuf,
+                     std::vector<llvm::Function *> const &funcMutByMutID)
+          : origModule(origModuleBuf.readIR(context)),
+            processor(funcMutByMutID.size() - 1, true) {
+        assert(origModule && "Failed to read the original module");
+        processor.funcMutByMutID = funcMutByMutID;
+        processor.mutFunctions.resize(funcMutByMutID.size(), nullptr);
+        processor.duplicateMap[0];
+        for (auto &origFunc : *origModule)
+          processor.diffFuncs2Muts[&origFunc];
+      }
+    };
+
+    std::atomic<unsigned long> numProcessedMuts(0);
+    auto runTCEJob = [&](FunctionTCEJob &job, TCEThreadState &state) {
+      DuplicateEquivalentProcessor &processor = state.processor;
+      llvm::Function *subjFunc = processor.funcMutByMutID[job.fromID];
+      TelemetrySpan funcSpan(
+          "TCE " + subjFunc->getName().str(), "TCE",
+          "{\"function\":" + Telemetry::quote(subjFunc->getName().str()) +
+              ",\"firstMutant\":" + std::to_string(job.fromID) + "}");
+      ReadWriteIRObj &funcModuleBuf =
+          dup_eq_processor.inMemIRModBufByFunc.at(subjFunc);
+      std::unique_ptr<llvm::Module> funcModule(
+          funcModuleBuf.readIR(state.context));
+      assert(funcModule && "Failed to read the function's module");
+      std::vector<std::unique_ptr<llvm::Module>> chunkModules;
+
+      if (job.isSplit)
+        tceFunctionMutantsInChunks(processor, funcModule.get(), funcModuleBuf,
+                                   state.origModule.get(), job.fromID,
+                                   job.toID, &job.verdicts, chunkModules);
+      else
+        tceFunctionMutants(processor, funcModule.get(), state.origModule.get(),
+                           job.fromID, job.toID, &job.verdicts, false);
+
+      // Free the mutants' functions before their modules
+      for (MutantIDType mid = job.fromID; mid <= job.toID; ++mid) {
+        delete processor.mutFunctions[mid];
+        processor.mutFunctions[mid] = nullptr;
+      }
+      processor.diffFuncs2Muts
+          .at(state.origModule->getFunction(subjFunc->getName()))
+          .clear();
+      numProcessedMuts += job.toID - job.fromID + 1;
+      Telemetry::get().progress("TCE", numProcessedMuts, highestMutID);
+    };
+
+    // The split functions are processed one at a time, each with all the
+    // threads
+    if (!splitJobs.empty()) {
+      TCEThreadState state(origModuleBuf, dup_eq_processor.funcMutByMutID);
+      for (auto *job : splitJobs)
+        runTCEJob(*job, state);
+    }
+
+    // The other functions are processed by a pool of threads
+    std::atomic<unsigned> nextJob(0);
+    auto tceWorker = [&]() {
+      TCEThreadState state(origModuleBuf, dup_eq_processor.funcMutByMutID);
+      for (unsigned j = nextJob++; j < otherJobs.size(); j = nextJob++)
+        runTCEJob(*otherJobs[j], state);
+    };
+    std::vector<std::thread> workers;
+    unsigned numWorkers = std::min<unsigned>(numTCEThreads, otherJobs.size());
+    for (unsigned t = 0; t < numWorkers; ++t)
+      workers.emplace_back(tceWorker);
+    for (auto &th : workers)
+      th.join();
+  }
+
   /// \brief since the mutants of the same function have sequential ID, we use
   /// this to trac function change and do some operation only then...
   llvm::Function *curFunc_ForDebug = nullptr; ////DBG
 
   std::vector<bool> visitedEqDupMutants(highestMutID + 1, false);
 
+  // Telemetry span of the TCE of the current function
+  std::unique_ptr<TelemetrySpan> funcTCESpan;
+
   for (MutantIDType id = 1; id <= highestMutID; id++) // id==0 is the original
   {
     llvm::Module *clonedM = nullptr;
+    if (!isParallelTCE)
+      Telemetry::get().progress("TCE", id - 1, highestMutID);
 
     // Currently only support a mutant in a single funtion. TODO TODO: extent to
     // mutant cros function
@@ -2432,6 +4499,14 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
 
     if (curFunc_ForDebug != dup_eq_processor.funcMutByMutID[id]) {
       curFunc_ForDebug = dup_eq_processor.funcMutByMutID[id];
+      funcTCESpan.reset();
+      // The parallel TCE workers record their own spans
+      if (!isParallelTCE)
+        funcTCESpan.reset(new TelemetrySpan(
+            "TCE " + curFunc_ForDebug->getName().str(), "TCE",
+            "{\"function\":" +
+                Telemetry::quote(curFunc_ForDebug->getName().str()) +
+                ",\"firstMutant\":" + std::to_string(id) + "}"));
       llvm::errs() << "\nprocessing Func: " << curFunc_ForDebug->getName()
                    << ", Starting at mutant: " << id << "/" << highestMutID
                    << "\n\t";
@@ -2439,146 +4514,60 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
 
     // Check with original
     if (isTCEFunctionMode) {
-      if (!visitedEqDupMutants[id]) {
-        /// get 'mutFunctions' for all mutants in same function as 'id'. @Note:
-        /// each mutant in only one funtion
-        /// do this by using binary approach (divide an conquer) fo scalability
-        /// (avoid cloning useles code)
-
-        /// \brief get the module for each function (when cleaning all other
-        /// funcs)
-        std::stack<
-            std::tuple<llvm::Function *, MutantIDType /*From*/, MutantIDType /*To*/>>
-            workFStack;
-
-        llvm::ValueToValueMapTy vmap;
+      // Reuse the TCE verdicts of the functions loaded from the mutation
+      // cache (not when writing the mutants, which need their functions)
+      MutationCache::FunctionEntry *cacheEntry = nullptr;
+      if (mutationCache && !writeMuts && !visitedEqDupMutants[id])
+        cacheEntry = mutationCache->getEntry(
+            dup_eq_processor.funcMutByMutID[id]->getName().str());
+      if (cacheEntry && cacheEntry->fromCache &&
+          !cacheEntry->tceVerdicts.empty()) {
+        assert(cacheEntry->firstMutantID == id &&
+               "The cached function's mutants must start here");
+        for (MutantIDType k = 1; k <= cacheEntry->numMutants; ++k) {
+          MutantIDType mid = id + k - 1;
+          MutantIDType verdict = cacheEntry->tceVerdicts[k - 1];
+          if (verdict == 0)
+            dup_eq_processor.duplicateMap.at(0).push_back(mid);
+          else if (verdict == k)
+            dup_eq_processor.duplicateMap[mid];
+          else
+            dup_eq_processor.duplicateMap.at(id + verdict - 1).push_back(mid);
+          visitedEqDupMutants[mid] = true;
+        }
+        llvm::errs() << "(TCE results reused from the mutation cache)";
+        continue;
+      }
 
-        //TODO TODO: Dump previously found function's mutants here to save memory
+      if (!visitedEqDupMutants[id]) {
         MutantIDType maxIDOfFunc = id;
-        while (dup_eq_processor.funcMutByMutID[maxIDOfFunc] ==
-                   dup_eq_processor.funcMutByMutID[id] &&
-               maxIDOfFunc <= highestMutID)
+        while (maxIDOfFunc < highestMutID &&
+               dup_eq_processor.funcMutByMutID[maxIDOfFunc + 1] ==
+                   dup_eq_processor.funcMutByMutID[id])
           maxIDOfFunc++;
-        maxIDOfFunc--;
-
-        clonedM = dup_eq_processor.clonedModByFunc.at(
-            dup_eq_processor.funcMutByMutID[id]);
-        const std::string subjFunctionName =
-            dup_eq_processor.funcMutByMutID[id]->getName().str();
-        llvm::GlobalVariable *mutantIDSelGlobFF =
-            clonedM->getNamedGlobal(mutantIDSelectorName);
-        llvm::Function *mutantIDSelGlob_FuncFF =
-            clonedM->getFunction(mutantIDSelectorName_Func);
-
-        /// \brief in order to make optimization and function clone (with debug
-        /// data), the function need to be in a module.
-        /// This string is a name for a temporal function (global value) not yet
-        /// in module, that will be used to temporally
-        /// add the subject function for clone and optimization
-        std::string temporaryFname(mutantIDSelectorName_Func +
-                                   std::string("tmp"));
-        unsigned uniq = 0;
-        while (clonedM->getNamedValue(temporaryFname + std::to_string(uniq)))
-          uniq++;
-        temporaryFname += std::to_string(uniq);
-
-        unsigned progressVerbose = 0;
-        unsigned nextProgress = 5;
-        unsigned progressVLandmark = (maxIDOfFunc - id) * nextProgress / 100;
-
-        vmap.clear();
-#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 9)
-        llvm::Function *cloneFuncTmp = llvm::CloneFunction(
-                                clonedM->getFunction(subjFunctionName), vmap,
-                                true /*moduleLevelChanges*/);
-#else
-        llvm::Function *cloneFuncTmp = llvm::CloneFunction(
-                                clonedM->getFunction(subjFunctionName), vmap);
-        // Here CloneFunction automatically add to module so remove 
-        // FIXME: Make it better by chnaging code to have it adde here fine
-        cloneFuncTmp->removeFromParent();
-#endif
-        workFStack.emplace(cloneFuncTmp, id, maxIDOfFunc);
-
-        /// \brief Use binary approach(divide and conquer) to quickly obtain the
-        /// module for each function. use DFS here to save memory (once seen
-        /// process and delete duplicate)
-        while (!workFStack.empty()) {
-          auto &queueElem = workFStack.top();
-          MutantIDType min = std::get<1>(queueElem), max = std::get<2>(queueElem);
-          llvm::Function *cloneFuncL = std::get<0>(queueElem);
-          workFStack.pop();
-
-          if (min == max) {
-            // add to module as temporary name
-            cloneFuncL->setName(temporaryFname);
-            clonedM->getFunctionList().push_back(cloneFuncL);
-
-            // get final optimized function for mutant
-            cleanFunctionToMut(*cloneFuncL, min, mutantIDSelGlobFF,
-                               mutantIDSelGlob_FuncFF);
-            dup_eq_processor.tce.optimize(*cloneFuncL,
-                                          Mutation::funcModeOptLevel);
-            dup_eq_processor.mutFunctions[min] = cloneFuncL;
-            visitedEqDupMutants[min] = true; // visit
-
-            // remove from module and set back original name
-            cloneFuncL->removeFromParent();
-            cloneFuncL->setName(subjFunctionName);
-
-            // Process the mutant with TCE
-            dup_eq_processor.update(min, clonedOrig, clonedM);
-
-            // Progress  -- VERBOSE
-            ++progressVerbose;
-            if (progressVerbose == progressVLandmark) {
-              llvm::errs() << nextProgress << "% ";
-              nextProgress += 5;
-              progressVLandmark = (maxIDOfFunc - id) * nextProgress / 100;
-            }
-          } else {
-            MutantIDType mid = min + (max - min) / 2;
-
-            // add to module as temporary name
-            cloneFuncL->setName(temporaryFname);
-            clonedM->getFunctionList().push_back(cloneFuncL);
 
-            // Clone
-            vmap.clear();
-#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 9)
-            llvm::Function *cloneFuncR = llvm::CloneFunction(
-                cloneFuncL, vmap, true /*moduleLevelChanges*/);
-#else
-            llvm::Function *cloneFuncR = llvm::CloneFunction(
-                cloneFuncL, vmap);
-            // Here CloneFunction automatically add to module so remove 
-            // FIXME: Make it better by chnaging code to have it adde here fine
-            cloneFuncR->removeFromParent();
-#endif
-
-            // remove from module and set back original name
-            cloneFuncL->removeFromParent();
-            cloneFuncL->setName(subjFunctionName);
-
-            assert(
-                (min <= mid && mid < max) &&
-                "shlould reach here only if we have at least 2 ids uncleaned");
-
-            // [min, mid]
-            cleanFunctionSWmIDRange(*cloneFuncL, min, mid, mutantIDSelGlobFF,
-                                    mutantIDSelGlob_FuncFF);
-            // left side has been cleaned, now add remaining right side to be
-            // processed next
-            workFStack.emplace(cloneFuncL, mid + 1, max);
-
-            // [mid+1, max]
-            cleanFunctionSWmIDRange(*cloneFuncR, mid + 1, max,
-                                    mutantIDSelGlobFF, mutantIDSelGlob_FuncFF);
-            // right side have been cleaned now add the remaining left side to
-            // be processed next
-            workFStack.emplace(cloneFuncR, min, mid);
+        if (isParallelTCE) {
+          // Record the verdicts of the worker in the same order as the serial
+          // processing, so that the results are identical
+          FunctionTCEJob &job = tceJobs.at(tceJobByFirstID.at(id));
+          assert(job.toID == maxIDOfFunc &&
+                 "Mismatch of the function's mutants");
+          for (auto &mutVerdict : job.verdicts) {
+            if (mutVerdict.second == mutVerdict.first)
+              dup_eq_processor.duplicateMap[mutVerdict.first];
+            else
+              dup_eq_processor.duplicateMap.at(mutVerdict.second)
+                  .push_back(mutVerdict.first);
           }
+          job.verdicts.clear();
+        } else {
+          clonedM = dup_eq_processor.clonedModByFunc.at(
+              dup_eq_processor.funcMutByMutID[id]);
+          tceFunctionMutants(dup_eq_processor, clonedM, clonedOrig, id,
+                             maxIDOfFunc, nullptr, true);
         }
+        for (MutantIDType mid = id; mid <= maxIDOfFunc; ++mid)
+          visitedEqDupMutants[mid] = true; // visit
 
         clonedM = nullptr;
 
@@ -2596,11 +4585,15 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
     {
       clonedM = dup_eq_processor.mutModules[id];
       assert(
-          getMutant(*clonedM, id, dup_eq_processor.funcMutByMutID[id], 'M') &&
+          getMutant(*clonedM, id, dup_eq_processor.funcMutByMutID[id], 'M',
+                    &dup_eq_processor.tce) &&
           "error: failed to get mutant");
       dup_eq_processor.update(id, clonedOrig, clonedM);
     }
   }
+  funcTCESpan.reset();
+  if (!isParallelTCE)
+    Telemetry::get().progress("TCE", highestMutID, highestMutID);
 
   llvm::errs() << "Done processing Funcs!\n"; ////DBG
 
@@ -2623,6 +4616,53 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
   // create the equivalent duplicate 2 non eq/dup map. call this only once
   dup_eq_processor.createEqDup2NonEqDupMap();
 
+  // Store the verdicts of the mutants processed into the TCE verdict cache
+  if (useTCEVerdictCache) {
+    for (MutantIDType mid = 1; mid <= highestMutID; ++mid) {
+      if (tceCacheKeys[mid].empty() || tceCacheHitOf[mid] != noTCECacheHit)
+        continue;
+      // The distinct mutants are not stored
+      if (dup_eq_processor.duplicateMap.count(mid) > 0)
+        continue;
+      TCEVerdictCache::Verdict verdict;
+      MutantIDType nondup = dup_eq_processor.dup2nondupMap.at(mid);
+      if (nondup == 0) {
+        verdict.kind = TCEVerdictCache::Equivalent;
+      } else {
+        verdict.kind = TCEVerdictCache::Duplicate;
+        verdict.duplicateOfKey = tceCacheKeys[nondup];
+        if (verdict.duplicateOfKey.empty())
+          continue;
+      }
+      tceVerdictCache->add(tceCacheKeys[mid], verdict);
+    }
+    tceVerdictCache->flush();
+  }
+
+  // Store the TCE verdicts into the mutation cache. Only in function mode,
+  // where the verdicts of a mutant only depend on its function
+  if (mutationCache && isTCEFunctionMode) {
+    for (auto &entryIt : mutationCache->getEntries()) {
+      MutationCache::FunctionEntry &entry = entryIt.second;
+      if (entry.numMutants == 0 || !entry.tceVerdicts.empty())
+        continue;
+      for (MutantIDType k = 1; k <= entry.numMutants; ++k) {
+        MutantIDType mid = entry.firstMutantID + k - 1;
+        if (dup_eq_processor.duplicateMap.count(mid) > 0) {
+          entry.tceVerdicts.push_back(k);
+        } else {
+          MutantIDType nondup = dup_eq_processor.dup2nondupMap.at(mid);
+          assert((nondup == 0 ||
+                  (nondup >= entry.firstMutantID && nondup < mid)) &&
+                 "Duplicate mutants must be in the same function");
+          entry.tceVerdicts.push_back(
+              nondup == 0 ? 0 : nondup - entry.firstMutantID + 1);
+        }
+      }
+      mutationCache->storeTCEVerdicts(entry);
+    }
+  }
+
   // re-assign the ids of mutants
   dup_eq_processor.duplicateMap.erase(0); // Remove original
   MutantIDType newmutIDs = 1;
@@ -2689,22 +4729,21 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
           if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition())) {
             if (ld->getOperand(0) ==
                 module.getNamedGlobal(mutantIDSelectorName)) {
-              uint64_t fromMID = highestMutID;
-              uint64_t toMID = 0;
+              // The mutants of a statement may be split between two switches
+              // (see computeSharedStmtPrefix), go through the actual cases in
+              // increasing order
+              std::vector<uint64_t> caseMIDs;
               for (llvm::SwitchInst::CaseIt i = sw->case_begin(),
                                             e = sw->case_end();
                    i != e; ++i) {
 #if (LLVM_VERSION_MAJOR <= 4)
-                uint64_t curcase = i.getCaseValue()->getZExtValue();
+                caseMIDs.push_back(i.getCaseValue()->getZExtValue());
 #else
-                uint64_t curcase = (*i).getCaseValue()->getZExtValue();
+                caseMIDs.push_back((*i).getCaseValue()->getZExtValue());
 #endif
-                if (curcase > toMID)
-                  toMID = curcase;
-                if (curcase < fromMID)
-                  fromMID = curcase;
               }
-              for (unsigned i = fromMID; i <= toMID; i++) {
+              std::sort(caseMIDs.begin(), caseMIDs.end());
+              for (uint64_t i : caseMIDs) {
                 llvm::SwitchInst::CaseIt cit =
                     sw->findCaseValue(llvm::ConstantInt::get(
                         moduleInfo.getContext(),
@@ -2761,6 +4800,11 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
   /// XXX After writing the, do not use dup_eq_processor.mutModules of
   /// dup_eq_processor.mutFunctions, snce they are modified by the write mutants
   /// callback
+  /// The whole meta-module is needed from here
+  if (!ReadWriteIRObj::materializeAll(module))
+    assert(false && "Failed to read the functions of the module");
+  if (memoryTracker)
+    memoryTracker->startPhase("WM/COV");
   if (writeMuts || modWMLog || modCovLog) {
     std::unique_ptr<llvm::Module> wmModule(nullptr);
     std::unique_ptr<llvm::Module> covModule(nullptr);
@@ -2789,6 +4833,9 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
       computeMutantCoverage(covModule, modCovLog);
     }
 
+    if (memoryTracker)
+      memoryTracker->startPhase("write");
+
     // XXX After writing the, do not use dup_eq_processor.mutModules of
     // dup_eq_processor.mutFunctions
     if (writeMuts) {
@@ -2833,6 +4880,8 @@ void Mutation::doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<l
 
   optMetaMu.reset(ReadWriteIRObj::cloneModuleAndRelease(&module));
   dup_eq_processor.tce.optimize(*(optMetaMu.get()), modModeOptLevel);
+  // Reduce the execution overhead of the demotion done at preprocessing
+  dup_eq_processor.tce.promoteMemoryToRegisters(*(optMetaMu.get()));
 
   // XXX create the final version of the meta-mutant file
   if (forKLEESEMu) {
@@ -2929,18 +4978,32 @@ void Mutation::applyPostMutationPointForKSOnMetaModule(llvm::Module &module) {
           if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition())) {
             if (ld->getOperand(0) == mutantIDSelGlob) {
               //XXX is mutation point, now process
-              if (sw->getNumCases() == 0)
+              // The switch following a prefix shared by mutants is processed
+              // together with the switch before the prefix
+              if (auto *predBB = sw->getParent()->getSinglePredecessor())
+                if (auto *predSw = llvm::dyn_cast<llvm::SwitchInst>(
+                        predBB->getTerminator()))
+                  if (getSharedPrefixSwitch(predSw, mutantIDSelGlob) == sw)
+                    continue;
+              std::vector<llvm::SwitchInst *> stmtSwitches({sw});
+              unsigned numCases = sw->getNumCases();
+              while (auto *nextSw = getSharedPrefixSwitch(stmtSwitches.back(),
+                                                          mutantIDSelGlob)) {
+                stmtSwitches.push_back(nextSw);
+                numCases += nextSw->getNumCases();
+              }
+              if (numCases == 0)
                 continue;
 
               pointBB2mutantIDVect.clear();
               
               // Original
 #if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
-              llvm::Instruction* origBBterm_i = sw->getDefaultDest()->getTerminator();
+              llvm::Instruction* origBBterm_i = stmtSwitches.back()->getDefaultDest()->getTerminator();
 #else
               llvm::TerminatorInst* origBBterm_i = 
                             llvm::dyn_cast<llvm::TerminatorInst>(
-                                        sw->getDefaultDest()->getTerminator());
+                                        stmtSwitches.back()->getDefaultDest()->getTerminator());
 #endif
               assert (origBBterm_i && "malformed original BB");
               for (unsigned sid = 0; sid < origBBterm_i->getNumSuccessors(); ++sid) {
@@ -2949,27 +5012,29 @@ void Mutation::applyPostMutationPointForKSOnMetaModule(llvm::Module &module) {
               }
               
               // Mutants
-              for (auto csit = sw->case_begin(), cse = sw->case_end();
-                   csit != cse; ++csit) {
+              for (auto *stmtSw : stmtSwitches) {
+                for (auto csit = stmtSw->case_begin(), cse = stmtSw->case_end();
+                     csit != cse; ++csit) {
 #if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
-                llvm::Instruction* mutBBterm_i = 
-                                          csit->getCaseSuccessor()->getTerminator();
-                uint64_t curcaseuint = csit->getCaseValue()->getZExtValue();
+                  llvm::Instruction* mutBBterm_i = 
+                                            csit->getCaseSuccessor()->getTerminator();
+                  uint64_t curcaseuint = csit->getCaseValue()->getZExtValue();
 #elif (LLVM_VERSION_MAJOR <= 4)
-                llvm::TerminatorInst* mutBBterm_i = 
-                            llvm::dyn_cast<llvm::TerminatorInst>(
-                                        csit.getCaseSuccessor()->getTerminator());
-                uint64_t curcaseuint = csit.getCaseValue()->getZExtValue();
+                  llvm::TerminatorInst* mutBBterm_i = 
+                              llvm::dyn_cast<llvm::TerminatorInst>(
+                                          csit.getCaseSuccessor()->getTerminator());
+                  uint64_t curcaseuint = csit.getCaseValue()->getZExtValue();
 #else
-                llvm::TerminatorInst* mutBBterm_i = 
-                            llvm::dyn_cast<llvm::TerminatorInst>(
-                                        (*csit).getCaseSuccessor()->getTerminator());
-                uint64_t curcaseuint = (*csit).getCaseValue()->getZExtValue();
+                  llvm::TerminatorInst* mutBBterm_i = 
+                              llvm::dyn_cast<llvm::TerminatorInst>(
+                                          (*csit).getCaseSuccessor()->getTerminator());
+                  uint64_t curcaseuint = (*csit).getCaseValue()->getZExtValue();
 #endif
-                assert (mutBBterm_i && "malformed mutant BB");
-                for (unsigned sid = 0; sid < mutBBterm_i->getNumSuccessors(); ++sid) {
-                  llvm::BasicBlock * pointBB = mutBBterm_i->getSuccessor(sid);
-                  pointBB2mutantIDVect[pointBB].push_back(curcaseuint);
+                  assert (mutBBterm_i && "malformed mutant BB");
+                  for (unsigned sid = 0; sid < mutBBterm_i->getNumSuccessors(); ++sid) {
+                    llvm::BasicBlock * pointBB = mutBBterm_i->getSuccessor(sid);
+                    pointBB2mutantIDVect[pointBB].push_back(curcaseuint);
+                  }
                 }
               }
 
@@ -3015,84 +5080,153 @@ void Mutation::applyPostMutationPointForKSOnMetaModule(llvm::Module &module) {
   }
 }
 
-/**
- * \brief Clean switch of mutant for the muatnt ids in range from to
- */
-void Mutation::cleanFunctionSWmIDRange(llvm::Function &Func,
-                                       MutantIDType mIDFrom, MutantIDType mIDTo,
-                                       llvm::GlobalVariable *mutantIDSelGlob,
-                                       llvm::Function *mutantIDSelGlob_Func) {
-  if (Func.isDeclaration())
-    return;
-  std::vector<llvm::BasicBlock *> toBeRemovedBB;
-  std::vector<llvm::ConstantInt *> tmpCaseVals;
+/// \brief the mutant selector switch terminating @param BB, if any
+static llvm::SwitchInst *
+getMutantSelectorSwitch(llvm::BasicBlock *BB,
+                        llvm::GlobalVariable *mutantIDSelGlob) {
+  if (auto *sw = llvm::dyn_cast_or_null<llvm::SwitchInst>(BB->getTerminator()))
+    if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition()))
+      if (ld->getOperand(0) == mutantIDSelGlob)
+        return sw;
+  return nullptr;
+}
+
+void Mutation::getMutantSwitchCases(llvm::Function &Func,
+                                    llvm::GlobalVariable *mutantIDSelGlob,
+                                    MutantSwitchCases &switchCases) {
+  switchCases.casesOfMutant.clear();
+  switchCases.positionOfBB.clear();
   for (auto &BB : Func) {
-    toBeRemovedBB.clear();
-    for (llvm::BasicBlock::iterator Iit = BB.begin(), Iie = BB.end();
-         Iit != Iie;) {
-      // we increment here so that 'eraseFromParent' bellow do not cause crash
-      llvm::Instruction &Inst = *Iit++;
-      if (auto *callI = llvm::dyn_cast<llvm::CallInst>(&Inst)) {
-        if (forKLEESEMu && callI->getCalledFunction() == mutantIDSelGlob_Func) {
-          // remove all calls to the heler function for KLEE integration
-          callI->eraseFromParent();
-        }
-      }
-      if (auto *sw = llvm::dyn_cast<llvm::SwitchInst>(&Inst)) {
-        if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition())) {
-          if (ld->getOperand(0) == mutantIDSelGlob) {
-            tmpCaseVals.clear();
-            for (auto csit = sw->case_begin(), cse = sw->case_end();
-                 csit != cse; ++csit) {
-#if (LLVM_VERSION_MAJOR <= 4)
-              llvm::ConstantInt *curcase = csit.getCaseValue();
-#else
-              llvm::ConstantInt *curcase = (*csit).getCaseValue();
-#endif
-              uint64_t curcaseuint = curcase->getZExtValue();
-              if (curcaseuint > mIDTo || curcaseuint < mIDFrom)
-                continue;
-              tmpCaseVals.push_back(curcase);
-            }
-            // in case all mutant at this swich should be removed
-            if (tmpCaseVals.size() == sw->getNumCases()) {
-              // Make all PHI nodes that referred to BB now refer to Pred as
-              // their
-              // source...
+    switchCases.positionOfBB.emplace(&BB, switchCases.positionOfBB.size());
+    auto *sw = getMutantSelectorSwitch(&BB, mutantIDSelGlob);
+    if (sw == nullptr)
+      continue;
+    for (auto csit = sw->case_begin(), cse = sw->case_end(); csit != cse;
+         ++csit) {
 #if (LLVM_VERSION_MAJOR <= 4)
-              llvm::BasicBlock *citSucc = sw->case_default().getCaseSuccessor();
+      switchCases.casesOfMutant[csit.getCaseValue()->getZExtValue()]
+          .emplace_back(sw, csit.getCaseSuccessor());
 #else
-              llvm::BasicBlock *citSucc = (*(sw->case_default())).getCaseSuccessor();
+      switchCases.casesOfMutant[(*csit).getCaseValue()->getZExtValue()]
+          .emplace_back(sw, (*csit).getCaseSuccessor());
 #endif
-              llvm::BasicBlock *swBB = sw->getParent();
-              citSucc->replaceAllUsesWith(swBB);
-              // Move all definitions in the successor to the predecessor...
-              sw->eraseFromParent();
-              ld->eraseFromParent();
+    }
+  }
+}
 
-              swBB->getInstList().splice(swBB->end(), citSucc->getInstList());
-              toBeRemovedBB.push_back(citSucc);
-            } else {
-              for (auto csv : tmpCaseVals) {
-                llvm::SwitchInst::CaseIt csit = sw->findCaseValue(csv);
-#if (LLVM_VERSION_MAJOR <= 4)
-                toBeRemovedBB.push_back(csit.getCaseSuccessor());
-#else
-                toBeRemovedBB.push_back((*csit).getCaseSuccessor());
-#endif
-                sw->removeCase(csit);
-              }
-            }
-          }
-        }
-      }
+/**
+ * \brief Create, in the module of @param Func (a function of the meta-module),
+ * the function @param cloneName of the mutant @param mutantID. The result is
+ * the same as cleanFunctionToMut on a clone of Func, but only the basic blocks
+ * of the mutant are cloned: those reached from the entry block through the
+ * case of the mutant (or the default) of the mutant selector switches, which
+ * are not cloned. The cost is thus the size of the mutant's function, not the
+ * size of Func, with the code of all its mutants. @param switchCases is the
+ * index of Func's switches (see getMutantSwitchCases).
+ */
+llvm::Function *Mutation::cloneFunctionToMut(
+    llvm::Function &Func, MutantIDType mutantID,
+    llvm::GlobalVariable *mutantIDSelGlob, llvm::Function *mutantIDSelGlob_Func,
+    MutantSwitchCases const &switchCases, std::string const &cloneName) {
+  assert(!Func.isDeclaration() && "cloning a declaration to a mutant");
+
+  // The successor of the selector switches that have a case for the mutant
+  std::unordered_map<llvm::Instruction *, llvm::BasicBlock *> mutantCaseOf;
+  auto casesIt = switchCases.casesOfMutant.find(mutantID);
+  if (casesIt != switchCases.casesOfMutant.end())
+    mutantCaseOf.insert(casesIt->second.begin(), casesIt->second.end());
+
+  // The blocks of the mutant, and the successor kept for each selector switch
+  std::unordered_set<llvm::BasicBlock *> mutantBBSet;
+  std::vector<llvm::BasicBlock *> mutantBBs(1, &Func.getEntryBlock());
+  std::unordered_map<llvm::BasicBlock *, llvm::BasicBlock *> keptSuccOfSwBB;
+  mutantBBSet.insert(&Func.getEntryBlock());
+  for (unsigned pos = 0; pos < mutantBBs.size(); ++pos) {
+    llvm::BasicBlock *BB = mutantBBs[pos];
+    if (auto *sw = getMutantSelectorSwitch(BB, mutantIDSelGlob)) {
+      auto it = mutantCaseOf.find(sw);
+      llvm::BasicBlock *succ =
+          (it != mutantCaseOf.end()) ? it->second : sw->getDefaultDest();
+      keptSuccOfSwBB[BB] = succ;
+      if (mutantBBSet.insert(succ).second)
+        mutantBBs.push_back(succ);
+    } else {
+      auto *term = BB->getTerminator();
+      for (unsigned i = 0, e = term->getNumSuccessors(); i < e; ++i)
+        if (mutantBBSet.insert(term->getSuccessor(i)).second)
+          mutantBBs.push_back(term->getSuccessor(i));
     }
-    for (auto *bbrm : toBeRemovedBB)
-      bbrm->eraseFromParent();
   }
-  // Check validity
-  // Mutation::checkFunctionValidity(Func, "ERROR: Misformed Function after
-  // cleanFunctionSWmIDRange!");
+  // Keep the order of the blocks in Func
+  std::sort(mutantBBs.begin(), mutantBBs.end(),
+            [&switchCases](llvm::BasicBlock *a, llvm::BasicBlock *b) {
+              return switchCases.positionOfBB.at(a) <
+                     switchCases.positionOfBB.at(b);
+            });
+
+  llvm::Function *mutFunc = llvm::Function::Create(
+      Func.getFunctionType(), Func.getLinkage(), cloneName, Func.getParent());
+  mutFunc->copyAttributesFrom(&Func);
+  llvm::ValueToValueMapTy vmap;
+  llvm::Function::arg_iterator destI = mutFunc->arg_begin();
+  for (auto argIt = Func.arg_begin(), argE = Func.arg_end(); argIt != argE;
+       ++argIt, ++destI) {
+    destI->setName(argIt->getName());
+    vmap[&*argIt] = &*destI;
+  }
+
+  // Clone the blocks. The selector switches (and their load) are replaced by
+  // a branch to the kept successor, merged below like cleanFunctionToMut
+  std::vector<llvm::BranchInst *> keptSuccBranches;
+  for (auto *BB : mutantBBs) {
+    llvm::BasicBlock *clonedBB =
+        llvm::BasicBlock::Create(Func.getContext(), BB->getName(), mutFunc);
+    vmap[BB] = clonedBB;
+    auto keptSuccIt = keptSuccOfSwBB.find(BB);
+    llvm::Instruction *swLoad = nullptr;
+    if (keptSuccIt != keptSuccOfSwBB.end())
+      swLoad = llvm::cast<llvm::Instruction>(
+          llvm::cast<llvm::SwitchInst>(BB->getTerminator())->getCondition());
+    for (auto &Inst : *BB) {
+      if (swLoad && (&Inst == swLoad || &Inst == BB->getTerminator()))
+        continue;
+      if (auto *callI = llvm::dyn_cast<llvm::CallInst>(&Inst))
+        if (forKLEESEMu && callI->getCalledFunction() == mutantIDSelGlob_Func)
+          continue;
+      llvm::Instruction *clonedInst = Inst.clone();
+      if (Inst.hasName())
+        clonedInst->setName(Inst.getName());
+      clonedBB->getInstList().push_back(clonedInst);
+      vmap[&Inst] = clonedInst;
+      // Only the incoming blocks of the mutant remain
+      if (auto *phi = llvm::dyn_cast<llvm::PHINode>(clonedInst))
+        for (unsigned i = phi->getNumIncomingValues(); i > 0; --i)
+          if (mutantBBSet.count(phi->getIncomingBlock(i - 1)) == 0)
+            phi->removeIncomingValue(i - 1, false /*DeletePHIIfEmpty*/);
+    }
+    if (swLoad)
+      keptSuccBranches.push_back(
+          llvm::BranchInst::Create(keptSuccIt->second, clonedBB));
+  }
+  for (auto &BB : *mutFunc)
+    for (auto &Inst : BB)
+      llvm::RemapInstruction(&Inst, vmap, llvm::RF_NoModuleLevelChanges);
+
+  for (auto *br : keptSuccBranches) {
+    llvm::BasicBlock *swBB = br->getParent();
+    llvm::BasicBlock *citSucc = br->getSuccessor(0);
+    // Make all PHI nodes that referred to BB now refer to Pred as their
+    // source...
+    citSucc->replaceAllUsesWith(swBB);
+    // Move all definitions in the successor to the predecessor...
+    br->eraseFromParent();
+    swBB->getInstList().splice(swBB->end(), citSucc->getInstList());
+    citSucc->eraseFromParent();
+  }
+
+  Mutation::checkFunctionValidity(
+      *mutFunc, "ERROR: Misformed Function after cloneFunctionToMut!");
+  return mutFunc;
 }
 
 void Mutation::cleanFunctionToMut(llvm::Function &Func, MutantIDType mutantID,
@@ -3119,7 +5253,7 @@ void Mutation::cleanFunctionToMut(llvm::Function &Func, MutantIDType mutantID,
           if (ld->getOperand(0) == mutantIDSelGlob) {
             llvm::SwitchInst::CaseIt cit =
                 sw->findCaseValue(llvm::ConstantInt::get(
-                    moduleInfo.getContext(),
+                    Func.getContext(),
                     llvm::APInt(32, (uint64_t)(mutantID), false)));
             llvm::BasicBlock *citSucc = nullptr;
             llvm::BasicBlock *swBB = sw->getParent();
@@ -3165,6 +5299,9 @@ void Mutation::cleanFunctionToMut(llvm::Function &Func, MutantIDType mutantID,
             sw->eraseFromParent();
             ld->eraseFromParent();
 
+            // Continue with the moved instructions, which may contain the
+            // switch following a shared prefix (see computeSharedStmtPrefix)
+            Iit = citSucc->begin();
             swBB->getInstList().splice(swBB->end(), citSucc->getInstList());
             toBeRemovedBB.push_back(citSucc);
 
@@ -3320,7 +5457,8 @@ void Mutation::computeModuleBufsByFunc(
 }
 
 bool Mutation::getMutant(llvm::Module &module, unsigned mutantID,
-                         llvm::Function *mutFunc, char optimizeModFuncNone) {
+                         llvm::Function *mutFunc, char optimizeModFuncNone,
+                         TCE *reusedTCE) {
   unsigned highestMutID = getHighestMutantID(&module);
   if (mutantID > highestMutID)
     return false;
@@ -3329,7 +5467,8 @@ bool Mutation::getMutant(llvm::Module &module, unsigned mutantID,
       module.getNamedGlobal(mutantIDSelectorName);
   llvm::Function *mutantIDSelGlob_Func =
       module.getFunction(mutantIDSelectorName_Func);
-  TCE tce;
+  TCE localTCE;
+  TCE &tce = reusedTCE ? *reusedTCE : localTCE;
 
   if (optimizeModFuncNone == 'F')
     assert(mutFunc && "optimize function but function is NULL");
@@ -3370,6 +5509,7 @@ bool Mutation::getMutant(llvm::Module &module, unsigned mutantID,
         moduleInfo.getContext(), llvm::APInt(32, (uint64_t)mutantID, false)));
     mutantIDSelGlob->setConstant(true);
     tce.optimize(module, Mutation::modModeOptLevel);
+    tce.promoteMemoryToRegisters(module);
   } else if (optimizeModFuncNone == 'A') // optimize all the functions
   {
     for (auto &ffunc : module)
@@ -3405,6 +5545,12 @@ void Mutation::dumpMutantInfos(std::string filename, std::string eqdup_filename)
   mutantsInfos.printToJsonFile(filename, eqdup_filename);
 }
 
+// The mutants infos only, before TCE (there is no equivalent or duplicate
+// mutant yet)
+void Mutation::dumpMutantInfos(std::string filename) {
+  mutantsInfos.printToJsonFile(filename);
+}
+
 std::string Mutation::getMutationStats() {
   std::string retstr;
   retstr += "\n# Number of Mutants:   PreTCE: " +
@@ -3412,14 +5558,405 @@ std::string Mutation::getMutationStats() {
             std::to_string(postTCENumMuts) + ", ";
   retstr += "Equivalent: " + std::to_string(numEquivalentMuts) +
             ", Duplicates: " + std::to_string(numDuplicateMuts) + "\n\n";
+  if (configuration.numImpliedReplacors > 0)
+    retstr += "# Sufficient-set mode: " +
+              std::to_string(configuration.numImpliedReplacors) +
+              " replacements removed from the configuration, " +
+              std::to_string(mutantsInfos.getImpliedMutantsNumber()) +
+              " implied mutants not generated\n\n";
+  if (trivialEquivalencePruning) {
+    retstr += "# Trivially equivalent mutants pruned at generation:";
+    for (unsigned rule = 0; rule < NumTrivialEquivalenceRules; ++rule)
+      retstr += std::string(rule > 0 ? ", " : " ") +
+                trivialEquivalenceRuleNames[rule] + ": " +
+                std::to_string(trivialPrunedMutants[rule]);
+    retstr += "\n\n";
+  }
+  if (!reachabilityEntries.empty())
+    retstr += "# Unreachable functions: " +
+              std::to_string(unreachableFuncs.size()) + ", their " +
+              std::to_string(unreachablePrunedMutants) +
+              " mutants pruned at generation\n\n";
+  if (utilityFilter)
+    retstr += utilityFilter->getStats() + "\n";
+  if (mutantSampler)
+    retstr += mutantSampler->getStats() + "\n";
+  if (mutationCache)
+    retstr += mutationCache->getStats() + "\n";
+  if (tceVerdictCache)
+    retstr += tceVerdictCache->getStats() + "\n";
+  if (shardCount > 1)
+    retstr += "# Shard " + std::to_string(shardIndex) + " of " +
+              std::to_string(shardCount) + ": " +
+              std::to_string(shardFuncs.size()) + " functions mutated\n\n";
   return retstr;
 }
 
+/**
+ * \brief Write into the JSON file @param filename the infos needed by
+ * mart-merge to merge the output of this shard with the other shards: the
+ * shard, its functions, its numbers of mutants, and the names of the mutant
+ * ID selector and log functions. @param outputName is the name (without
+ * suffix) of the output modules of the shard.
+ */
+void Mutation::dumpShardInfos(std::string filename,
+                              std::string const &outputName) {
+  JsonBox::Object outJ;
+  outJ["ShardIndex"] = JsonBox::Value((int)shardIndex);
+  outJ["ShardCount"] = JsonBox::Value((int)shardCount);
+  outJ["OutputName"] = JsonBox::Value(outputName);
+  JsonBox::Array funcsJ;
+  for (auto &fname : shardFuncs)
+    funcsJ.push_back(JsonBox::Value(fname));
+  outJ["Functions"] = funcsJ;
+  outJ["PreTCEMutants"] = JsonBox::Value((int)preTCENumMuts);
+  outJ["PostTCEMutants"] = JsonBox::Value((int)postTCENumMuts);
+  outJ["EquivalentDuplicateMutants"] =
+      JsonBox::Value((int)(numEquivalentMuts + numDuplicateMuts));
+  outJ["MutantIDSelector"] = JsonBox::Value(mutantIDSelectorName);
+  outJ["MutantIDSelectorFunc"] = JsonBox::Value(mutantIDSelectorName_Func);
+  outJ["PostMutationPointFunc"] = JsonBox::Value(postMutationPointFuncName);
+  outJ["WMLogFunc"] = JsonBox::Value(std::string(wmLogFuncName));
+  outJ["HighestMutantIDGlobal"] =
+      JsonBox::Value(std::string(wmHighestMutantIDConst));
+  JsonBox::Value vout(outJ);
+  vout.writeToFile(filename, true, false);
+}
+
+/**
+ * \brief Write into the JSON file @param filename, for each mutator of the
+ * configuration (in order), the number of statements that were offered to it
+ * and the number of those for which it created mutants.
+ */
+void Mutation::dumpMutatorsMatchStats(std::string filename) {
+  JsonBox::Array outJ;
+  for (unsigned pos = 0, pe = configuration.mutators.size(); pos < pe; ++pos) {
+    llvmMutationOp const &mutator = configuration.mutators[pos];
+    JsonBox::Object mutatorJ;
+    mutatorJ["MatchOp"] = JsonBox::Value((int)mutator.getMatchOp());
+    JsonBox::Array namesJ;
+    for (auto &repl : mutator.getMutantReplacorsList())
+      namesJ.push_back(JsonBox::Value(repl.getMutOpName()));
+    mutatorJ["Mutants"] = namesJ;
+    mutatorJ["Attempts"] = JsonBox::Value((int)mutatorsMatchAttempts[pos]);
+    mutatorJ["Successes"] = JsonBox::Value((int)mutatorsMatchSuccesses[pos]);
+    outJ.push_back(mutatorJ);
+  }
+  JsonBox::Value vout(outJ);
+  vout.writeToFile(filename, true, false);
+}
+
+/**
+ * \brief Write the estimate of a dry run (see setDryRun) into the JSON file
+ * @param filename: the number of mutants per function and mutant type, the
+ * estimated size of the meta-mutant module and the estimated TCE cost.
+ * \detail The meta-mutant module gets, for each mutated statement, a switch
+ * on the mutant ID (and the call to the mutant selector function for KLEE)
+ * and, for each mutant, its statement and a branch to the merge point. Its
+ * bitcode size is estimated from the bytes per instruction of the input
+ * module. TCE optimizes the function of each mutant and compares it with the
+ * original and with the other mutants of the same function (at most n*(n-1)/2
+ * comparisons for n mutants).
+ */
+bool Mutation::dumpDryRunEstimate(std::string filename) {
+  assert(isDryRun && "dumpDryRunEstimate called without a dry run");
+  // The counts are written as doubles (JSON numbers), since they may not fit
+  // in an int
+  JsonBox::Object outJ;
+  JsonBox::Object funcsJ;
+  std::map<std::string, unsigned long> mutantsByType;
+  unsigned long numMutants = 0;
+  unsigned long numMetaInsts = 0;
+  unsigned long numTCEOptimizedInsts = 0;
+  unsigned long numTCEComparisons = 0;
+  for (auto &fP : dryRunStats) {
+    DryRunFunctionStats const &fstats = fP.second;
+    unsigned long funcMutants = 0;
+    JsonBox::Object typesJ;
+    for (auto &tP : fstats.mutantsByType) {
+      typesJ[tP.first] = JsonBox::Value((double)tP.second);
+      mutantsByType[tP.first] += tP.second;
+      funcMutants += tP.second;
+    }
+    JsonBox::Object funcJ;
+    funcJ["Instructions"] = JsonBox::Value((double)fstats.numInstructions);
+    funcJ["MutatedStmts"] = JsonBox::Value((double)fstats.numMutatedStmts);
+    funcJ["Mutants"] = JsonBox::Value((double)funcMutants);
+    funcJ["MutantsByType"] = typesJ;
+    funcsJ[fP.first] = funcJ;
+
+    numMutants += funcMutants;
+    numMetaInsts += fstats.numMutantsInsts + funcMutants +
+                    fstats.numMutatedStmts * (forKLEESEMu ? 2 : 1);
+    numTCEOptimizedInsts += (funcMutants + 1) * fstats.numInstructions;
+    numTCEComparisons += funcMutants * (funcMutants + 1) / 2;
+  }
+
+  JsonBox::Object metaJ;
+  metaJ["AddedInstructions"] = JsonBox::Value((double)numMetaInsts);
+
+  // The size of the whole module is only known when all of its functions
+  // were read (not with a lazily read module)
+  llvm::Module &module = *currentMetaMutantModule;
+  double bytesPerInst = 0;
+  if (ReadWriteIRObj::isMaterialized(module)) {
+    unsigned long numModuleInsts = 0;
+    for (auto &Func : module)
+      for (auto &BB : Func)
+        numModuleInsts += BB.size();
+    numMetaInsts += numModuleInsts;
+    ReadWriteIRObj moduleBuf;
+    moduleBuf.setToModule(&module);
+    bytesPerInst =
+        (double)moduleBuf.getBuffer().size() / std::max(1UL, numModuleInsts);
+    metaJ["Instructions"] = JsonBox::Value((double)numMetaInsts);
+    metaJ["BitcodeBytes"] =
+        JsonBox::Value((double)(unsigned long)(bytesPerInst * numMetaInsts));
+  }
+
+  JsonBox::Object typesJ;
+  for (auto &tP : mutantsByType)
+    typesJ[tP.first] = JsonBox::Value((double)tP.second);
+  outJ["Mutants"] = JsonBox::Value((double)numMutants);
+  outJ["MutantsByType"] = typesJ;
+  outJ["Functions"] = funcsJ;
+  outJ["MetaModule"] = metaJ;
+  JsonBox::Object tceJ;
+  tceJ["OptimizedInstructions"] = JsonBox::Value((double)numTCEOptimizedInsts);
+  tceJ["MaxComparisons"] = JsonBox::Value((double)numTCEComparisons);
+  outJ["TCE"] = tceJ;
+
+  JsonBox::Value vout(outJ);
+  vout.writeToFile(filename, true, false);
+
+  llvm::outs() << "Mart@DryRun: " << numMutants << " mutants in "
+               << dryRunStats.size() << " functions, ";
+  if (bytesPerInst > 0)
+    llvm::outs() << "meta-mutant module of ~" << numMetaInsts
+                 << " instructions ("
+                 << (unsigned long)(bytesPerInst * numMetaInsts / 1024)
+                 << " KB of bitcode), ";
+  else
+    llvm::outs() << "~" << numMetaInsts
+                 << " instructions added into the meta-mutant module, ";
+  llvm::outs() << "TCE cost of ~" << numTCEOptimizedInsts
+               << " optimized instructions. Estimate written into '"
+               << filename << "'\n";
+  return true;
+}
+
+/**
+ * \brief estimate the memory (in KB) used by doTCE in function mode or in
+ * module mode (@param isTCEFunctionMode), to call after doMutate.
+ * \detail Module mode keeps a copy of the module for every mutant. Function
+ * mode keeps a copy of the module for every mutated function and a copy of
+ * the mutated function for every mutant. The copies are counted in
+ * instructions of the original code (without the mutants' code).
+ */
+unsigned long Mutation::estimateTCEMemoryKB(bool isTCEFunctionMode) {
+  llvm::Module &module = *currentMetaMutantModule;
+  llvm::GlobalVariable *mutantIDSelGlob =
+      module.getNamedGlobal(mutantIDSelectorName);
+  assert(mutantIDSelGlob && "estimating the TCE memory before mutation");
+
+  unsigned long numMutants = getHighestMutantID(&module);
+  unsigned long numModuleInsts = 0;
+  unsigned long numMutatedFuncs = 0;
+  // Sum, over the mutants, of the size of their function
+  unsigned long numMutantsFuncInsts = 0;
+  for (auto &Func : module) {
+    unsigned long numFuncInsts = 0;
+    // A mutant may have cases in several switches (PHI proxies, shared
+    // prefix), it is counted once
+    std::unordered_set<uint64_t> funcMutantIDs;
+    for (auto &BB : Func) {
+      if (!BB.getName().startswith("MART.Mutant_preTCEMut"))
+        numFuncInsts += BB.size();
+      if (auto *sw =
+              llvm::dyn_cast_or_null<llvm::SwitchInst>(BB.getTerminator()))
+        if (auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition()))
+          if (ld->getOperand(0) == mutantIDSelGlob)
+            for (auto cit = sw->case_begin(), ce = sw->case_end(); cit != ce;
+                 ++cit)
+#if (LLVM_VERSION_MAJOR <= 4)
+              funcMutantIDs.insert(cit.getCaseValue()->getZExtValue());
+#else
+              funcMutantIDs.insert((*cit).getCaseValue()->getZExtValue());
+#endif
+    }
+    numModuleInsts += numFuncInsts;
+    if (!funcMutantIDs.empty()) {
+      ++numMutatedFuncs;
+      numMutantsFuncInsts += funcMutantIDs.size() * numFuncInsts;
+    }
+  }
+
+  double numInsts;
+  // Each thread of the parallel TCE holds its own copies of the module and
+  // of the original
+  if (isTCEFunctionMode)
+    numInsts = (double)(numMutatedFuncs + 2 * std::max(1U, numTCEThreads)) *
+                   numModuleInsts +
+               (double)numMutantsFuncInsts;
+  else
+    numInsts = (double)(numMutants + 2) * numModuleInsts;
+  return (unsigned long)(numInsts * tceBytesPerInstruction / 1024);
+}
+
+MutantEnumerator::MutantEnumerator(Mutation &mutation)
+    : mutation(mutation), initialized(false), nextStmtPos(0),
+      nextMutantID(1) {}
+
+MutantEnumerator::~MutantEnumerator() {
+  releaseFunction();
+  if (mutation.enumerator == this)
+    mutation.enumerator = nullptr;
+}
+
+bool MutantEnumerator::initialize() {
+  assert(!initialized && "MutantEnumerator initialized twice");
+  if (mutation.enumerator) {
+    llvm::errs() << "Mart@Error: the mutants of the module are already being "
+                    "enumerated\n";
+    return false;
+  }
+  if (mutation.isDryRun || mutation.numGenerationThreads > 1 ||
+      mutation.mutationCache) {
+    llvm::errs() << "Mart@Error: the lazy mutant enumeration does not "
+                    "support the dry run, the parallel generation and the "
+                    "mutation cache\n";
+    return false;
+  }
+  if (mutation.mutantSampler && mutation.mutantSampler->needsCountingPass()) {
+    llvm::errs() << "Mart@Error: the lazy mutant enumeration does not "
+                    "support a budget of mutants (which needs all the "
+                    "mutants of the module)\n";
+    return false;
+  }
+  if (mutation.utilityFilter) {
+    llvm::errs() << "Mart@Error: the lazy mutant enumeration does not "
+                    "support the utility filter (which needs the mutants' "
+                    "IRs)\n";
+    return false;
+  }
+
+  llvm::Module &module = *mutation.currentMetaMutantModule;
+  if (!mutation.reachabilityEntries.empty() &&
+      !mutation.computeUnreachableFunctions(module))
+    return false;
+  if (mutation.shardCount > 1 && !mutation.computeShardFunctions(module))
+    return false;
+
+  mutation.enumerator = this;
+  nextFuncIt = module.begin();
+  initialized = true;
+  return true;
+}
+
+llvm::Function *MutantEnumerator::nextFunction() {
+  assert(initialized && "MutantEnumerator used before initialization");
+  releaseFunction();
+  llvm::Module &module = *mutation.currentMetaMutantModule;
+  while (nextFuncIt != module.end()) {
+    llvm::Function &Func = *nextFuncIt;
+    ++nextFuncIt;
+    if (mutation.skipFunc(Func))
+      continue;
+    if (!ReadWriteIRObj::materialize(Func))
+      assert(false && "Failed to read a function of the module");
+
+    // No mutant is added into the function, thus no selector is needed
+    mutation.mutateFunction(Func, nullptr);
+    if (!funcStmts.empty())
+      return &Func;
+  }
+  return nullptr;
+}
+
+MutantEnumerator::StmtMutants const *MutantEnumerator::nextStatement() {
+  if (nextStmtPos >= funcStmts.size() && !nextFunction())
+    return nullptr;
+  return &funcStmts[nextStmtPos++];
+}
+
+void MutantEnumerator::addStmtMutants(llvm::Function &Func,
+                                      MatchStmtIR const &stmtIR,
+                                      MutantsOfStmt &stmtMutants) {
+  if (stmtMutants.isEmpty())
+    return;
+  funcStmts.emplace_back();
+  StmtMutants &stmt = funcStmts.back();
+  stmt.func = &Func;
+  stmt.stmtIR = stmtIR;
+  stmt.moduleInfo = &mutation.moduleInfo;
+  stmt.firstMutantID = nextMutantID;
+  nextMutantID += stmtMutants.getNumMuts();
+  // The mutants' basic blocks are now owned by the enumerator
+  stmt.mutants.swap(stmtMutants.results);
+}
+
+void MutantEnumerator::releaseFunction() {
+  for (auto &stmt : funcStmts)
+    for (auto &mutant : stmt.mutants)
+      mutant.mutantStmtIR.deleteContainedMutant();
+  funcStmts.clear();
+  nextStmtPos = 0;
+}
+
+MutantInfoList::MutantInfo
+MutantEnumerator::StmtMutants::getMutantInfo(unsigned index) const {
+  return MutantInfoList::MutantInfo(
+      getMutantID(index), stmtIR.getIRList(), mutants[index].typeName,
+      mutants[index].irRelevantPos, func, stmtIR.posIRsInOrigFunc,
+      *(mutants[index].impliedTypeNames));
+}
+
+std::string MutantEnumerator::StmtMutants::getMutantIR(unsigned index) const {
+  // Create the IR of a deferred mutant, only for the printing
+  MutantsOfStmt created;
+  auto const *mutantStmtIR = &mutants[index].mutantStmtIR;
+  if (auto const &deferred = mutants[index].deferred) {
+    DoReplaceUseful dru;
+    deferred->matcher->replaceMatch(stmtIR, deferred->pos, *deferred->match,
+                                    *deferred->repl, dru, created,
+                                    *moduleInfo);
+    if (created.isEmpty())
+      return "";
+    mutantStmtIR = &created.getMutantStmtIR(0);
+  }
+  auto const &origBBToMutBB = mutantStmtIR->origBBToMutBB;
+  std::string ret;
+  llvm::raw_string_ostream ross(ret);
+  // In the order of the original statement's basic blocks
+  std::set<llvm::BasicBlock *> seenBBs;
+  for (auto *val : stmtIR.getIRList()) {
+    auto *origInst = llvm::dyn_cast<llvm::Instruction>(val);
+    if (!origInst || !seenBBs.insert(origInst->getParent()).second)
+      continue;
+    auto *origBB = origInst->getParent();
+    auto it = origBBToMutBB.find(origBB);
+    if (it == origBBToMutBB.end())
+      continue;
+    for (auto *bb : it->second)
+      bb->print(ross);
+  }
+  ross.flush();
+  if (!created.isEmpty())
+    created.remove(0);
+  return ret;
+}
+
 Mutation::~Mutation() {
+  // The generation workers share the parent's configuration
+  if (isGenerationWorker)
+    return;
+
   // mutantsInfos.printToStdout();
 
-  llvm::errs() << getMutationStats();
+  if (!configurationOnly)
+    llvm::errs() << getMutationStats();
 
   // Clear the constant map to avoid double free
-  llvmMutationOp::destroyPosConstValueMap();
+  if (!sharedConfiguration)
+    llvmMutationOp::destroyPosConstValueMap();
 }
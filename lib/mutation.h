@@ -13,7 +13,11 @@
 #ifndef __MART_GENMU_mutation__
 #define __MART_GENMU_mutation__
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <llvm/IR/Module.h>
@@ -24,8 +28,34 @@
 
 namespace mart {
 
+class MemoryUsageTracker;
+class MutantEnumerator;
+class MutationCache;
+class MutantSampler;
+class MutantUtilityFilter;
+class TCE;
+class TCEVerdictCache;
+class MutantUtilityPredictor;
+
 struct mutationConfig {
   std::vector<llvmMutationOp> mutators;
+
+  // Dispatch index of the mutators (positions in 'mutators'): the mutators
+  // that may match any statement, and the others by the first instruction
+  // opcode that they require (see buildDispatchIndex)
+  std::vector<unsigned> anyStmtMutators;
+  std::unordered_map<unsigned /*opcode*/, std::vector<unsigned>>
+      mutatorsByOpcode;
+  std::vector<std::vector<unsigned>> mutatorsRequiredOpcodes;
+
+  // Number of replacors removed by the sufficient-set mode
+  unsigned numImpliedReplacors = 0;
+
+  void buildDispatchIndex(UserMaps &usermaps);
+  void reduceToSufficientSets(UserMaps &usermaps);
+  void getCandidateMutators(MatchStmtIR const &stmtIR,
+                            std::vector<unsigned> &candidates) const;
+  bool mayMutateBasicBlock(llvm::BasicBlock const &BB) const;
 }; // struct mutationConfig
 
 class Mutation {
@@ -55,7 +85,111 @@ class Mutation {
   unsigned numDuplicateMuts;
   unsigned numEquivalentMuts;
 
-  UserMaps usermaps;
+  // Number of threads used to generate the mutants (1 means serial)
+  unsigned numGenerationThreads;
+
+  // Number of threads of the function-mode TCE, each processing the mutants
+  // of a function at a time in its own LLVMContext (1 means serial)
+  unsigned numTCEThreads;
+
+  // Number of mutated statements of the function being mutated, used to name
+  // the split basic blocks. It restarts for each function, so that the names
+  // do not depend on the other functions (mutated in any order in parallel or
+  // by other shards)
+  unsigned mutatedStmtCount;
+
+  // Set for the Mutation objects used internally to mutate a single function
+  // (in its own LLVMContext) during parallel generation
+  bool isGenerationWorker;
+
+  // Set when the configuration is copied from another Mutation object (the
+  // generation workers and the modules of a batch), which owns its constants
+  bool sharedConfiguration;
+
+  // Set for a Mutation object without module, which only holds a parsed
+  // configuration for other Mutation objects (the modules of a batch)
+  bool configurationOnly;
+
+  // Number of statements offered to each mutator of the configuration, and
+  // number of those for which the mutator created mutants
+  std::vector<unsigned long> mutatorsMatchAttempts;
+  std::vector<unsigned long> mutatorsMatchSuccesses;
+
+  // Whether the mutants trivially equivalent to the original statement (or
+  // duplicate of another mutant of the statement) are dropped at generation,
+  // and the number of mutants dropped by each rule
+  bool trivialEquivalencePruning;
+  std::vector<unsigned long> trivialPrunedMutants;
+
+  // Entry functions of the reachability pruning (empty if disabled), names
+  // of the defined functions not reachable from them, whose mutants are
+  // dropped at generation, and the number of mutants dropped
+  std::vector<std::string> reachabilityEntries;
+  std::unordered_set<std::string> unreachableFuncs;
+  unsigned long unreachablePrunedMutants;
+
+  // Whether each basic block of each function (in the function's order at
+  // preprocessing) may get mutants. Only the PHI nodes around those blocks
+  // are demoted (see preprocessVariablePhi), and only those blocks are
+  // searched for statements (see mutateFunction)
+  std::unordered_map<std::string, std::vector<bool>> mutableBasicBlocks;
+
+  // Dry run (see setDryRun): the mutants of each function are counted, per
+  // mutant type, and dropped instead of being added into the module
+  struct DryRunFunctionStats {
+    unsigned long numInstructions = 0;
+    unsigned long numMutatedStmts = 0;
+    // Number of instructions of the mutants' statements
+    unsigned long numMutantsInsts = 0;
+    std::map<std::string, unsigned long> mutantsByType;
+  };
+  bool isDryRun;
+  std::map<std::string, DryRunFunctionStats> dryRunStats;
+
+  // Lazy enumeration of the mutants (see MutantEnumerator): the mutants of
+  // each statement are handed to the enumerator instead of being added into
+  // the module (null when not enumerating)
+  MutantEnumerator *enumerator;
+
+  // Records the peak memory of the phases of doTCE (null if not tracked)
+  MemoryUsageTracker *memoryTracker;
+
+  // Check of the function-mode TCE (see setMutantMaterializationCheck):
+  // numbers of mutants whose function built by cloneFunctionToMut was
+  // compared with the one cleaned out of the meta function, and of those
+  // that differ
+  bool checkMutantMaterialization;
+  std::atomic<unsigned long> numMaterializationChecked;
+  std::atomic<unsigned long> numMaterializationDiffering;
+
+  // Sharded generation (see setShard): index of the shard and number of
+  // shards, the functions of the shard (in the module's order) and those of
+  // the other shards, which are not mutated
+  unsigned shardIndex;
+  unsigned shardCount;
+  std::vector<std::string> shardFuncs;
+  std::unordered_set<std::string> otherShardsFuncs;
+
+  // Hash of the effective mutation operators configuration
+  std::string mutConfDigest;
+
+  // Persistent cache of the mutants of each function (null if disabled)
+  std::unique_ptr<MutationCache> mutationCache;
+
+  // Persistent cache of the TCE verdicts of the mutants (null if disabled)
+  std::unique_ptr<TCEVerdictCache> tceVerdictCache;
+
+  // Sampling of the mutants at generation time (null if disabled)
+  std::unique_ptr<MutantSampler> mutantSampler;
+
+  // Filtering of the mutants by predicted utility at generation time (null
+  // if disabled)
+  std::unique_ptr<MutantUtilityFilter> utilityFilter;
+
+  // The UserMaps of this object, unless it uses those of the configuration
+  // source (batch mode), which are built once
+  std::unique_ptr<UserMaps> ownUsermaps;
+  UserMaps &usermaps;
 
   ModuleUserInfos moduleInfo;
 
@@ -79,6 +213,10 @@ class Mutation {
   static const unsigned funcModeOptLevel = 1;
   static const unsigned modModeOptLevel = 0;
 
+  // Rough size in memory of an instruction (with its uses and share of the
+  // basic blocks and functions), used to estimate the memory of TCE
+  static const unsigned tceBytesPerInstruction = 160;
+
 public:
   typedef bool (*DumpMutFunc_t)(
       Mutation *mutEng, std::map<unsigned, std::vector<unsigned>> *,
@@ -86,34 +224,85 @@ public:
       std::vector<llvm::Function *> const *mutFunctions);
   Mutation(llvm::Module &module, std::string mutConfFile,
            DumpMutFunc_t writeMutsF, std::string scopeJsonFile = "");
+  Mutation(llvm::Module &module, Mutation const &configSource,
+           DumpMutFunc_t writeMutsF, std::string scopeJsonFile = "");
+  Mutation(std::string mutConfFile);
   ~Mutation();
   bool doMutate(); // Transforms module
   void doTCE(std::unique_ptr<llvm::Module> &optMetaMu, std::unique_ptr<llvm::Module> &modWMLog, 
             std::unique_ptr<llvm::Module> &modCovLog, bool writeMuts = false,
             bool isTCEFunctionMode = false); // Transforms module
+  void setGenerationThreads(unsigned nThreads) {
+    numGenerationThreads = (nThreads == 0 ? 1 : nThreads);
+  }
+  void setTCEThreads(unsigned nThreads) {
+    numTCEThreads = (nThreads == 0 ? 1 : nThreads);
+  }
+  bool setMutationCache(std::string const &cacheDir);
+  bool setTCEVerdictCache(std::string const &cacheDir);
+  bool setMutantSampling(std::string const &budget, std::string const &unit,
+                         unsigned seed);
+  void setSufficientSetMode();
+  void setUtilityFilter(std::shared_ptr<MutantUtilityPredictor> predictor,
+                        float minUtility, unsigned long budget);
+  void setTrivialEquivalencePruning(bool enable) {
+    trivialEquivalencePruning = enable;
+  }
+  void setDryRun() { isDryRun = true; }
+  void setMutantMaterializationCheck() { checkMutantMaterialization = true; }
+  std::pair<unsigned long, unsigned long>
+  getMutantMaterializationCheckStats() const {
+    return std::make_pair(numMaterializationChecked.load(),
+                          numMaterializationDiffering.load());
+  }
+  bool dumpDryRunEstimate(std::string filename);
+  void setMemoryTracker(MemoryUsageTracker *tracker) {
+    memoryTracker = tracker;
+  }
+  unsigned long estimateTCEMemoryKB(bool isTCEFunctionMode);
+  void setReachabilityEntries(std::vector<std::string> const &entries) {
+    reachabilityEntries = entries;
+  }
+  bool setShard(unsigned index, unsigned count);
+  void dumpShardInfos(std::string filename, std::string const &outputName);
   void setModFuncToFunction(llvm::Module *Mod, llvm::Function *srcF,
                             llvm::Function *targetF = nullptr);
   unsigned getHighestMutantID(llvm::Module const *module = nullptr);
 
   void loadMutantInfos(std::string filename);
   void dumpMutantInfos(std::string filename, std::string eqdup_filename);
+  void dumpMutantInfos(std::string filename);
   // llvm::Module & getMetaMutantModule() {return currentMetaMutantModule;}
   std::string getMutationStats();
+  void dumpMutatorsMatchStats(std::string filename);
 
   // Utilities
   void linkMetamoduleWithMutantSelection(
                         std::unique_ptr<llvm::Module> &optMetaMu,
                         std::unique_ptr<llvm::Module> &mutantSelectorMod);
+  /// @param tce, if not null, is used for the optimization, so that its
+  /// pipelines are reused across the calls
   bool getMutant(llvm::Module &module, unsigned mutanatID,
                  llvm::Function *mutFunc = nullptr,
-                 char optimizeModFuncNone = 'M' /* 'M', 'F', 'A', '0' */);
+                 char optimizeModFuncNone = 'M' /* 'M', 'F', 'A', '0' */,
+                 TCE *tce = nullptr);
 
 private:
+  friend class MutantEnumerator;
+  Mutation(llvm::Module &funcModule, Mutation const &parent);
+  void initializeInputModule(llvm::Module &module,
+                             std::string const &scopeJsonFile);
   bool getConfiguration(std::string &mutconfFile);
+  bool computeUnreachableFunctions(llvm::Module &module);
+  bool computeShardFunctions(llvm::Module &module);
+  void runCountingPass(Mutation &counter, llvm::Module &countModule);
   void getanothermutantIDSelectorName();
   void getanotherPostMutantPointFuncName();
   void getMutantsOfStmt(MatchStmtIR const &stmtIR, MutantsOfStmt &ret_mutants,
                         ModuleUserInfos const &moduleInfos);
+  void countMutantsOfStmt(MatchStmtIR const &stmtIR,
+                          std::map<std::string, unsigned long> &counts,
+                          ModuleUserInfos const &moduleInfos);
   llvm::Function *createKSFunc(llvm::Module &module, bool bodyOnly,
                                         std::string ks_func_name);
   llvm::Function *createGlobalMutIDSelector_Func(llvm::Module &module,
@@ -136,18 +325,39 @@ private:
       std::unique_ptr<llvm::Module> &modWMLog);
 
   void preprocessVariablePhi(llvm::Module &module);
+  bool basicBlockMayGetMutants(llvm::BasicBlock &BB);
   llvm::AllocaInst *MYDemotePHIToStack(llvm::PHINode *P,
                                        llvm::Instruction *AllocaPoint);
   llvm::AllocaInst *MyDemoteRegToStack(llvm::Instruction &I, bool VolatileLoads,
                                        llvm::Instruction *AllocaPoint);
   inline bool skipFunc(llvm::Function &Func);
+  void mutateFunction(llvm::Function &Func,
+                      llvm::GlobalVariable *mutantIDSelectorGlobal);
+  void mutateFunctionsInChunks(llvm::Module &module,
+                               llvm::GlobalVariable *mutantIDSelectorGlobal);
 
   void applyPostMutationPointForKSOnMetaModule(llvm::Module &module);
 
-  void cleanFunctionSWmIDRange(llvm::Function &Func, MutantIDType mIDFrom,
-                               MutantIDType mIDTo,
-                               llvm::GlobalVariable *mutantIDSelGlob,
-                               llvm::Function *mutantIDSelGlob_Func);
+  /// \brief index of the mutant selector switches of a function of the
+  /// meta-module, for cloneFunctionToMut (see getMutantSwitchCases)
+  struct MutantSwitchCases {
+    // The switches having a case for each mutant ID, with the case successor
+    std::unordered_map<
+        MutantIDType,
+        std::vector<std::pair<llvm::Instruction *, llvm::BasicBlock *>>>
+        casesOfMutant;
+    // The position of each basic block in the function
+    std::unordered_map<llvm::BasicBlock *, unsigned> positionOfBB;
+  };
+  void getMutantSwitchCases(llvm::Function &Func,
+                            llvm::GlobalVariable *mutantIDSelGlob,
+                            MutantSwitchCases &switchCases);
+  llvm::Function *cloneFunctionToMut(llvm::Function &Func,
+                                     MutantIDType mutantID,
+                                     llvm::GlobalVariable *mutantIDSelGlob,
+                                     llvm::Function *mutantIDSelGlob_Func,
+                                     MutantSwitchCases const &switchCases,
+                                     std::string const &cloneName);
   void cleanFunctionToMut(llvm::Function &Func, MutantIDType mutantID,
                           llvm::GlobalVariable *mutantIDSelGlob,
                           llvm::Function *mutantIDSelGlob_Func,
@@ -165,6 +375,88 @@ private:
                                            const char *errMsg = "");
 }; // class Mutation
 
+/**
+ * \brief Lazy enumeration of the mutants of the module of a Mutation object,
+ * statement by statement, without building the meta-mutant module.
+ * \detail The functions to mutate are matched one at a time, when all the
+ * statements of the previous one were consumed, so that only the mutants of
+ * one function are in memory. The mutants get the IDs and the infos that
+ * doMutate would give them: the IR of each mutant is created to check it
+ * (see getMutantsOfStmt), deleted with its statement, and created again on
+ * request. No mutant is added into the module, but its functions are
+ * changed as for doMutate: their PHI nodes around the blocks that may get
+ * mutants are demoted into memory (when the Mutation object is constructed)
+ * and proxy blocks are inserted on the edges into the PHI nodes left.
+ * doMutate must not be called on the Mutation object used for enumeration.
+ */
+class MutantEnumerator {
+public:
+  /**
+   * \brief The mutants of a statement, valid until the enumeration moves to
+   * the next function. The mutants' IRs are the detached basic blocks that
+   * replace the statement, which reference the values of the function. Most
+   * mutants only keep their match, and their IR is created on request.
+   */
+  class StmtMutants {
+    friend class MutantEnumerator;
+    llvm::Function *func;
+    MatchStmtIR stmtIR;
+    std::vector<MutantsOfStmt::RawMutantStmt> mutants;
+    MutantIDType firstMutantID;
+    ModuleUserInfos const *moduleInfo;
+
+  public:
+    llvm::Function &getFunction() const { return *func; }
+    std::vector<llvm::Value *> const &getOriginalIRs() const {
+      return stmtIR.getIRList();
+    }
+    unsigned getNumMutants() const { return mutants.size(); }
+    MutantIDType getMutantID(unsigned index) const {
+      return firstMutantID + index;
+    }
+    std::string const &getTypeName(unsigned index) const {
+      return mutants[index].typeName;
+    }
+    /// \brief the location of a mutant, as written in the mutants infos
+    MutantInfoList::MutantInfo getMutantInfo(unsigned index) const;
+    /// \brief the replacement IR of a mutant, created and printed on
+    /// request
+    std::string getMutantIR(unsigned index) const;
+  }; // class StmtMutants
+
+  MutantEnumerator(Mutation &mutation);
+  ~MutantEnumerator();
+
+  /// \brief check the configuration of the Mutation object, to call before
+  /// the enumeration
+  bool initialize();
+
+  /// \brief match the next function having mutants, whose statements are
+  /// then returned by nextStatement. @return nullptr when all the functions
+  /// to mutate were enumerated
+  llvm::Function *nextFunction();
+
+  /// \brief @return the mutants of the next mutated statement, or nullptr
+  /// when all the functions to mutate were enumerated
+  StmtMutants const *nextStatement();
+
+private:
+  friend class Mutation;
+  Mutation &mutation;
+  llvm::Module::iterator nextFuncIt;
+  bool initialized;
+
+  // Statements of the current function, and position of the next one
+  std::vector<StmtMutants> funcStmts;
+  unsigned nextStmtPos;
+
+  MutantIDType nextMutantID;
+
+  void addStmtMutants(llvm::Function &Func, MatchStmtIR const &stmtIR,
+                      MutantsOfStmt &stmtMutants);
+  void releaseFunction();
+}; // class MutantEnumerator
+
 } // namespace mart
 
 #endif //__MART_GENMU_mutation__
@@ -0,0 +1,342 @@
+/**
+ * -==== mutationcache.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class MutationCache, the persistent on-disk cache of
+ *            the mutants of each function, used for incremental re-mutation
+ */
+
+#ifndef __MART_GENMU_mutationcache__
+#define __MART_GENMU_mutationcache__
+
+#include <cctype>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ReadWriteIRObj.h"
+#include "typesops.h"
+
+namespace mart {
+
+/**
+ * \brief Cache of the mutants generated for each function, stored in a
+ * directory and reused across runs of Mart.
+ * \detail An entry is keyed by the hash of the function's preprocessed IR
+ * (with its source locations) and of the generation context (the effective
+ * mutation operators configuration, the data layout, the named struct types,
+ * the names of the mutant selection global and functions). An entry contains
+ * the module of the mutated function, where the mutant IDs start from 1
+ * (<key>.bc), and the mutants infos and the TCE verdicts of its mutants
+ * (<key>.json). Files are written into a temporary file and then renamed, so
+ * that concurrent runs never read a partially written entry.
+ * The TCE verdicts also depend on the TCE configuration and on the globals
+ * and functions declarations of the module (e.g. the attributes of the
+ * callees), but the mutants do not. So, the verdicts are stored with the
+ * digest of this TCE context (see setTCEContext) and only loaded for the
+ * same one, while the mutants are still reused when it changes.
+ */
+class MutationCache {
+public:
+  struct FunctionEntry {
+    std::string funcName;
+    std::string key;
+    // Whether the mutants of the function were loaded from the cache
+    bool fromCache = false;
+    // ID of the first mutant of the function in the meta-mutant module
+    MutantIDType firstMutantID = 0;
+    MutantIDType numMutants = 0;
+    // Mutants infos, with IDs starting from 1
+    MutantInfoList mutantsInfos;
+    // TCE verdict of mutant 'i' (IDs starting from 1) at position 'i-1': 0
+    // for equivalent, 'j' < 'i' for duplicate of mutant 'j', 'i' otherwise.
+    // Empty when not yet computed (function mode TCE only).
+    std::vector<MutantIDType> tceVerdicts;
+  };
+
+private:
+  // Increase this when the generated mutants or the format change
+  static const unsigned cacheFormatVersion = 5;
+
+  std::string cacheDir;
+  std::string contextDigest;
+  std::string tceContextDigest;
+
+  std::map<std::string, FunctionEntry> entriesByFunc;
+
+  unsigned numHits = 0;
+  unsigned numMisses = 0;
+
+  std::string getPath(std::string const &key, const char *ext) const {
+    return cacheDir + "/" + key + ext;
+  }
+
+  static bool writeFileAtomically(std::string const &path,
+                                  llvm::StringRef data) {
+    int fd;
+    llvm::SmallString<128> tmpPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath))
+      return false;
+    {
+      llvm::raw_fd_ostream os(fd, true /*shouldClose*/);
+      os << data;
+      os.flush();
+      if (os.has_error()) {
+        os.clear_error();
+        llvm::sys::fs::remove(tmpPath.str());
+        return false;
+      }
+    }
+    if (llvm::sys::fs::rename(tmpPath.str(), path)) {
+      llvm::sys::fs::remove(tmpPath.str());
+      return false;
+    }
+    return true;
+  }
+
+  bool writeEntryJson(FunctionEntry const &entry) const {
+    JsonBox::Object outJ;
+    outJ["Key"] = JsonBox::Value(entry.key);
+    outJ["FuncName"] = JsonBox::Value(entry.funcName);
+    outJ["NumMutants"] = JsonBox::Value((int)entry.numMutants);
+    JsonBox::Object infosJ;
+    entry.mutantsInfos.getJson(infosJ);
+    outJ["MutantsInfos"] = infosJ;
+    if (!entry.tceVerdicts.empty()) {
+      JsonBox::Array verdictsJ;
+      for (auto v : entry.tceVerdicts)
+        verdictsJ.push_back(JsonBox::Value((int)v));
+      outJ["TCEVerdicts"] = verdictsJ;
+      outJ["TCEContext"] = JsonBox::Value(tceContextDigest);
+    }
+    std::ostringstream oss;
+    JsonBox::Value(outJ).writeToStream(oss, false, false);
+    return writeFileAtomically(getPath(entry.key, ".json"), oss.str());
+  }
+
+public:
+  MutationCache(std::string const &dir) : cacheDir(dir) {}
+
+  static std::string getDigest(llvm::MD5 &hash) {
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    return str.str().str();
+  }
+
+  /// \brief Replace the metadata and attribute group numbers, which depend on
+  /// the whole module, in the printed IR of a function
+  static std::string normalizeSlotNumbers(std::string const &printedIR) {
+    std::string ret;
+    ret.reserve(printedIR.size());
+    for (size_t i = 0, ie = printedIR.size(); i < ie; ++i) {
+      ret.push_back(printedIR[i]);
+      if ((printedIR[i] == '!' || printedIR[i] == '#') && i + 1 < ie &&
+          std::isdigit(printedIR[i + 1])) {
+        ret.push_back('N');
+        while (i + 1 < ie && std::isdigit(printedIR[i + 1]))
+          ++i;
+      }
+    }
+    return ret;
+  }
+
+  /// \brief Create the cache directory if it does not exist
+  bool initialize() {
+    if (llvm::sys::fs::create_directories(cacheDir)) {
+      llvm::errs() << "Mart@Error: failed to create the mutation cache "
+                      "directory '"
+                   << cacheDir << "'\n";
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief set the part of the key that is common to all functions.
+  /// @param genConfig identifies the mutation configuration
+  void setContext(llvm::Module const &module, std::string const &genConfig) {
+    llvm::MD5 hash;
+    hash.update(std::to_string(cacheFormatVersion));
+    hash.update(genConfig);
+    hash.update(module.getDataLayoutStr());
+    hash.update(module.getTargetTriple());
+    for (auto *sType : module.getIdentifiedStructTypes()) {
+      std::string typeStr;
+      llvm::raw_string_ostream ross(typeStr);
+      sType->print(ross);
+      ross << " = ";
+      if (sType->isOpaque())
+        ross << "opaque";
+      else
+        for (auto *elemT : sType->elements())
+          elemT->print(ross << ",");
+      ross << "\n";
+      hash.update(ross.str());
+    }
+    contextDigest = getDigest(hash);
+  }
+
+  /// \brief Digest of the globals (except @param ignoredGlobal), aliases and
+  /// functions declarations (with their attributes) of @param module, on
+  /// which the optimization of its functions may depend
+  static std::string getDeclarationsDigest(llvm::Module const &module,
+                                           std::string const &ignoredGlobal) {
+    std::string declsStr;
+    llvm::raw_string_ostream ross(declsStr);
+    for (auto &gv : module.globals())
+      if (gv.getName() != ignoredGlobal)
+        gv.print(ross << "\n");
+    for (auto &ga : module.aliases())
+      ga.print(ross << "\n");
+    for (auto &func : module) {
+      ross << "\n" << func.getName() << ":";
+      func.getFunctionType()->print(ross);
+      for (unsigned i = 0, e = func.arg_size(); i <= e; ++i)
+        ross << ";" << func.getAttributes().getAsString(i);
+      ross << ";" << func.getAttributes().getAsString(~0U);
+    }
+    ross.flush();
+    llvm::MD5 hash;
+    hash.update(normalizeSlotNumbers(declsStr));
+    return getDigest(hash);
+  }
+
+  /// \brief set the TCE context of the verdicts: @param tceConfig identifies
+  /// the TCE optimization (see TCE::getConfigName), and the declarations of
+  /// @param module are hashed, except the global @param ignoredGlobal (the
+  /// mutant ID selector). To call before the lookups
+  void setTCEContext(llvm::Module const &module, std::string const &tceConfig,
+                     std::string const &ignoredGlobal) {
+    llvm::MD5 hash;
+    hash.update(tceConfig);
+    hash.update(getDeclarationsDigest(module, ignoredGlobal));
+    tceContextDigest = getDigest(hash);
+  }
+
+  /// \brief @param scopeKey identifies the part of the function in the
+  /// mutation scope, when only some of its source lines are mutated
+  std::string computeFunctionKey(llvm::Function &Func,
+                                 std::string const &scopeKey = "") const {
+    std::string funcIR;
+    llvm::raw_string_ostream ross(funcIR);
+    Func.print(ross);
+    ross.flush();
+
+    llvm::MD5 hash;
+    hash.update(contextDigest);
+    hash.update(Func.getAttributes().getAsString(~0U));
+    hash.update(normalizeSlotNumbers(funcIR));
+    hash.update(scopeKey);
+    // The metadata numbers are normalized, add the source locations
+    for (auto &BB : Func) {
+      for (auto &Inst : BB) {
+        hash.update(UtilsFunctions::getSrcLoc(&Inst));
+        hash.update(";");
+      }
+    }
+    return getDigest(hash);
+  }
+
+  /**
+   * \brief create the entry of the function @param Func, to call before it
+   * is mutated, and try to load its mutants from the cache into @param irBuf
+   * and the entry. @param scopeKey is the mutation scope key of the function
+   * (see computeFunctionKey).
+   * @return the entry, whose field 'fromCache' tells whether it was loaded.
+   */
+  FunctionEntry &lookup(llvm::Function &Func, ReadWriteIRObj &irBuf,
+                        std::string const &scopeKey = "") {
+    std::string funcName = Func.getName().str();
+    assert(entriesByFunc.count(funcName) == 0 &&
+           "Function looked up twice in the mutation cache");
+    FunctionEntry &entry = entriesByFunc[funcName];
+    entry.funcName = funcName;
+    entry.key = computeFunctionKey(Func, scopeKey);
+
+    auto jsonBufOrErr =
+        llvm::MemoryBuffer::getFile(getPath(entry.key, ".json"));
+    if (jsonBufOrErr && irBuf.setToFile(getPath(entry.key, ".bc"))) {
+      JsonBox::Value value_in;
+      value_in.loadFromString(jsonBufOrErr.get()->getBuffer().str());
+      if (value_in.isObject()) {
+        JsonBox::Object object_in = value_in.getObject();
+        if (object_in["Key"].isString() &&
+            object_in["Key"].getString() == entry.key &&
+            object_in["NumMutants"].isInteger() &&
+            object_in["MutantsInfos"].isObject()) {
+          entry.numMutants = object_in["NumMutants"].getInteger();
+          entry.mutantsInfos.loadFromJson(object_in["MutantsInfos"].getObject());
+          if (object_in["TCEVerdicts"].isArray() &&
+              object_in["TCEContext"].isString() &&
+              object_in["TCEContext"].getString() == tceContextDigest) {
+            for (auto &v : object_in["TCEVerdicts"].getArray())
+              entry.tceVerdicts.push_back(v.getInteger());
+            if (entry.tceVerdicts.size() != entry.numMutants)
+              entry.tceVerdicts.clear();
+          }
+          entry.fromCache =
+              (entry.mutantsInfos.getMutantsNumber() == entry.numMutants);
+        }
+      }
+    }
+    if (entry.fromCache) {
+      ++numHits;
+    } else {
+      ++numMisses;
+      entry.mutantsInfos = MutantInfoList();
+      entry.tceVerdicts.clear();
+    }
+    return entry;
+  }
+
+  /// \brief store the mutants of a function just mutated, @param irBuf is the
+  /// serialized module of the mutated function
+  void store(FunctionEntry &entry, ReadWriteIRObj const &irBuf) {
+    if (!writeFileAtomically(getPath(entry.key, ".bc"), irBuf.getBuffer()) ||
+        !writeEntryJson(entry))
+      llvm::errs() << "Mart@Warning: failed to write the mutation cache entry "
+                      "of function '"
+                   << entry.funcName << "'\n";
+  }
+
+  /// \brief store the TCE verdicts newly computed for an entry
+  void storeTCEVerdicts(FunctionEntry &entry) {
+    assert(entry.tceVerdicts.size() == entry.numMutants &&
+           "Incomplete TCE verdicts");
+    if (!writeEntryJson(entry))
+      llvm::errs() << "Mart@Warning: failed to write the TCE verdicts of "
+                      "function '"
+                   << entry.funcName << "' into the mutation cache\n";
+  }
+
+  FunctionEntry *getEntry(std::string const &funcName) {
+    auto it = entriesByFunc.find(funcName);
+    return (it == entriesByFunc.end() ? nullptr : &(it->second));
+  }
+
+  std::map<std::string, FunctionEntry> &getEntries() { return entriesByFunc; }
+
+  std::string getStats() const {
+    return "# Mutation cache: " + std::to_string(numHits) + " of " +
+           std::to_string(numHits + numMisses) +
+           " functions reused from '" + cacheDir + "'\n";
+  }
+}; // class MutationCache
+
+} // namespace mart
+
+#endif //__MART_GENMU_mutationcache__
@@ -46,6 +46,9 @@ private:
   struct MatchUseful *additionalMU; // When there are many matches at a pos,
                                     // linklist then using this
   struct MatchUseful *curLast;
+  // Nodes of the list released by 'clearAll()', reused by 'getNew()' instead
+  // of allocating new ones
+  struct MatchUseful *spareMU;
 
   /// \brief This vector is the list of pairs representing the IR used to make
   /// high level operands
@@ -61,10 +64,8 @@ private:
   unsigned posReturnIntoIR;
   unsigned retIntoOprdIndex; // For constant replacement
 
-public:
-  MatchUseful() : additionalMU(nullptr) { clearAll(); }
-  ~MatchUseful() { clearAll(); }
-  void clearAll() {
+  /// \brief reset the data fields (keep the vectors' storage for reuse)
+  void clearData() {
     highLevelOprdsSources.clear();
     relevantIRPos.clear();
     // highLevelReturningIR = nullptr;
@@ -72,12 +73,58 @@ public:
     // returnIntoIR = nullptr;
     posReturnIntoIR = -1;
     retIntoOprdIndex = -1;
+    curLast = nullptr;
+  }
+
+  /// \brief keep the nodes of the list starting at @param first as spare
+  void releaseNodes(struct MatchUseful *first) {
+    struct MatchUseful *tail = first;
+    while (tail->additionalMU)
+      tail = tail->additionalMU;
+    tail->additionalMU = spareMU;
+    spareMU = first;
+  }
+
+  /// \brief get a node for the list, from the spare ones if any
+  struct MatchUseful *allocNode() {
+    if (!spareMU)
+      return new MatchUseful();
+    struct MatchUseful *node = spareMU;
+    spareMU = node->additionalMU;
+    node->additionalMU = nullptr;
+    node->clearData();
+    return node;
+  }
+
+public:
+  MatchUseful() : additionalMU(nullptr), spareMU(nullptr) { clearAll(); }
+  ~MatchUseful() {
+    clearAll();
+    while (spareMU) {
+      struct MatchUseful *node = spareMU;
+      spareMU = node->additionalMU;
+      node->additionalMU = nullptr;
+      delete node;
+    }
+  }
+  void clearAll() {
+    clearData();
     if (additionalMU) {
-      // additionalMU->clearAll(); //done in the destructor
-      delete additionalMU;
+      releaseNodes(additionalMU);
       additionalMU = nullptr;
     }
-    curLast = nullptr;
+  }
+
+  /// \brief set this to a single match with the data of @param node (to
+  /// keep a match of a list that is cleared)
+  void setToDataOf(MatchUseful const &node) {
+    clearAll();
+    highLevelOprdsSources = node.highLevelOprdsSources;
+    relevantIRPos = node.relevantIRPos;
+    posReturningIR = node.posReturningIR;
+    posReturnIntoIR = node.posReturnIntoIR;
+    retIntoOprdIndex = node.retIntoOprdIndex;
+    curLast = this;
   }
 
   /// \brief expand
@@ -86,7 +133,10 @@ public:
       curLast = this;
       return curLast;
     } else {
-      curLast->additionalMU = new MatchUseful();
+      // this replaces the node following 'curLast', if any
+      if (curLast->additionalMU)
+        releaseNodes(curLast->additionalMU);
+      curLast->additionalMU = allocNode();
       return curLast->additionalMU;
     }
   }
@@ -341,21 +391,10 @@ public:
           } else {
             for (MatchUseful const *ptr_mu = mu.first(); ptr_mu != mu.end();
                  ptr_mu = ptr_mu->next()) {
-              prepareCloneIRs(toMatch, pos, *ptr_mu, repl, dru, MI);
-              try {
-                dru.getOrigRelevantIRPos();
-              } catch (std::exception &e) {
-                llvm::errs() << "didn't set 'OrigRelevantIRPos': " << e.what();
-              }
-              doReplacement(toMatch, resultMuts, repl, dru.toMatchMutant,
-                            dru.posOfIRtoRemove, dru.getHLOprdOrNull(0),
-                            dru.getHLOprdOrNull(1), dru.getHLReturningIRPos(),
-                            dru.getOrigRelevantIRPos(), MI,
-                            dru.getHLReturnIntoIRPos(),
-                            dru.getHLReturnIntoOprdIndex());
-
-              // make sure to clear 'dru' for the next replcement
-              dru.clearAll();
+              if (resultMuts.deferIRs)
+                deferReplaceMatch(pos, *ptr_mu, repl, resultMuts);
+              else
+                replaceMatch(toMatch, pos, *ptr_mu, repl, dru, resultMuts, MI);
             }
           }
         }
@@ -366,6 +405,74 @@ public:
     }
   }
 
+  /**  A virtual member.
+   * \brief Create the mutant of the statement @param toMatch for the match
+   * @param mu (returned by matchIRs at @param pos) and the replacor
+   * @param repl, and append it to @param resultMuts. Used by matchAndReplace,
+   * and to create on request the mutants whose IR was deferred (see
+   * MutantsOfStmt::deferIRs). Reimplement this when the mutant is not created
+   * with doReplacement.
+   * @param dru is cleared after use, for the next replacement.
+   */
+  virtual void replaceMatch(MatchStmtIR const &toMatch, unsigned pos,
+                            MatchUseful const &mu,
+                            llvmMutationOp::MutantReplacors const &repl,
+                            DoReplaceUseful &dru, MutantsOfStmt &resultMuts,
+                            ModuleUserInfos const &MI) {
+    prepareCloneIRs(toMatch, pos, mu, repl, dru, MI);
+    try {
+      dru.getOrigRelevantIRPos();
+    } catch (std::exception &e) {
+      llvm::errs() << "didn't set 'OrigRelevantIRPos': " << e.what();
+    }
+    doReplacement(toMatch, resultMuts, repl, dru.toMatchMutant,
+                  dru.posOfIRtoRemove, dru.getHLOprdOrNull(0),
+                  dru.getHLOprdOrNull(1), dru.getHLReturningIRPos(),
+                  dru.getOrigRelevantIRPos(), MI, dru.getHLReturnIntoIRPos(),
+                  dru.getHLReturnIntoOprdIndex());
+
+    // make sure to clear 'dru' for the next replcement
+    dru.clearAll();
+  }
+
+  /**  A virtual member.
+   * \brief Count, per mutant type, the mutants that matchAndReplace would
+   * create, without cloning the statement (dry run). Reimplement this with
+   * matchAndReplace when it does not use matchIRs.
+   * \detail The count is an upper bound: the few replacements that
+   * doReplacement cancels (a constant replaced by the same value) are
+   * counted.
+   * @param counts is where the number of mutants of each type is added.
+   * The other parameters are those of matchAndReplace.
+   */
+  virtual void countMatches(MatchStmtIR const &toMatch,
+                            llvmMutationOp const &mutationOp,
+                            WholeStmtMutationOnce &iswholestmtmutated,
+                            ModuleUserInfos const &MI,
+                            std::map<std::string, unsigned long> &counts) {
+    MatchUseful mu;
+    int pos = -1;
+    for (auto *val : toMatch.getIRList()) {
+      (void)val;
+      pos++;
+      if (matchIRs(toMatch, mutationOp, pos, mu, MI)) {
+        for (auto &repl : mutationOp.getMutantReplacorsList()) {
+          if (checkWholeStmtAndCount(toMatch, repl, iswholestmtmutated, MI,
+                                     counts)) {
+            ; // Do nothing, already counted
+          } else {
+            for (MatchUseful const *ptr_mu = mu.first(); ptr_mu != mu.end();
+                 ptr_mu = ptr_mu->next())
+              ++counts[repl.getMutOpName()];
+          }
+        }
+
+        // make sure to clear both 'mu' for the next match
+        mu.clearAll();
+      }
+    }
+  }
+
   /**
    * \brief Thismethod is useful to help filter before hand the operation that
    * can never be matched in a stmt. overload this in the operator classes.
@@ -380,6 +487,20 @@ public:
     return std::vector<unsigned>();
   }
 
+  /**
+   * \brief This method is used by the sufficient-set mode to only generate the
+   * non redundant mutants of an operator. overload this in the operator
+   * classes whose replacements can be subsumed by others.
+   * @return in @param impliedBy, for each replacor of @param mutationOp, the
+   * index of the replacor that implies it (any input for which the mutant of
+   * the latter differs from the original, at the mutated expression, makes
+   * the mutant of the former differ too), or -1 if it is not implied.
+   */
+  virtual void getImpliedReplacors(llvmMutationOp const &mutationOp,
+                                   std::vector<int> &impliedBy) {
+    impliedBy.assign(mutationOp.getNumReplacor(), -1);
+  }
+
 protected:
   /**
    * \brief Tels whether the llvm type is a sequential type
@@ -768,6 +889,78 @@ protected:
     return true;
   }
 
+  /**
+   * \brief Same as checkWholeStmtAndMutate, but the whole statement mutant is
+   * only counted into @param counts (see countMatches)
+   */
+  inline bool checkWholeStmtAndCount(
+      MatchStmtIR const &toMatch, llvmMutationOp::MutantReplacors const &repl,
+      WholeStmtMutationOnce &iswholestmtmutated, ModuleUserInfos const &MI,
+      std::map<std::string, unsigned long> &counts) {
+    if (isDeletion(repl.getExpElemKey())) {
+      if (iswholestmtmutated.isDeleted())
+        return true;
+      if (!toMatch.wholeStmtHasTerminators()) {
+        ++counts[repl.getMutOpName()];
+      } else {
+        enum ExpElemKeys termDelCode = getTerminatorDeleterCode();
+        llvmMutationOp tmpMutationOp;
+        tmpMutationOp.setMatchOp(termDelCode, std::vector<std::string>());
+        tmpMutationOp.addReplacor(getGenericDeleterCode(),
+                                  std::vector<unsigned>(),
+                                  repl.getMutOpName());
+        MI.getUserMaps()
+            ->getMatcherObject(termDelCode)
+            ->countMatches(toMatch, tmpMutationOp, iswholestmtmutated, MI,
+                           counts);
+      }
+      iswholestmtmutated.setDeleted();
+    } else if (isTrapInsertion(repl.getExpElemKey())) {
+      if (iswholestmtmutated.isTrapped())
+        return true;
+      ++counts[repl.getMutOpName()];
+      iswholestmtmutated.setTrapped();
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief Append to @param resultMuts the mutant of the match @param mu at
+   * @param pos with the replacor @param repl, without creating its IR (see
+   * replaceMatch). The mutant's location is the match's relevant IRs.
+   */
+  void deferReplaceMatch(unsigned pos, MatchUseful const &mu,
+                         llvmMutationOp::MutantReplacors const &repl,
+                         MutantsOfStmt &resultMuts) {
+    std::shared_ptr<MutantsOfStmt::DeferredMutant> deferred(
+        new MutantsOfStmt::DeferredMutant());
+    deferred->matcher = this;
+    deferred->pos = pos;
+    deferred->match.reset(new MatchUseful());
+    deferred->match->setToDataOf(mu);
+    deferred->repl = &repl;
+    resultMuts.addDeferred(std::move(deferred), mu.getRelevantIRPos());
+  }
+
+  /**
+   * \brief countMatches of the operators whose matchAndReplace does not use
+   * matchIRs: the mutants it creates are counted and deleted
+   */
+  void countByMatchAndReplace(MatchStmtIR const &toMatch,
+                              llvmMutationOp const &mutationOp,
+                              WholeStmtMutationOnce &iswholestmtmutated,
+                              ModuleUserInfos const &MI,
+                              std::map<std::string, unsigned long> &counts) {
+    MutantsOfStmt mutants;
+    matchAndReplace(toMatch, mutationOp, mutants, iswholestmtmutated, MI);
+    while (mutants.getNumMuts() > 0) {
+      ++counts[mutants.getTypeName(mutants.getNumMuts() - 1)];
+      mutants.remove(mutants.getNumMuts() - 1);
+    }
+  }
+
   /**
    * \brief Check whether two values of the same type are constant and of same
    *values
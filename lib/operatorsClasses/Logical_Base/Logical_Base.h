@@ -28,6 +28,13 @@ namespace mart {
 
 class Logical_Base : public GenericMuOpBase {
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the conditional branch
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Br});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     llvm::errs() << "Unsuported yet: 'matchIRs' mathod of Logical should not "
@@ -59,6 +66,16 @@ public:
     (void)MI;
   }
 
+  /// matchAndReplace does not use matchIRs
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    countByMatchAndReplace(toMatch, mutationOp, iswholestmtmutated, MI,
+                           counts);
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
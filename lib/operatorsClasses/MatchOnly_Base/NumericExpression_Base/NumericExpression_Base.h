@@ -89,6 +89,20 @@ public:
     DRU.setHLReturningIRPos(MU.getHLReturningIRPos());
   }
 
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    // Count for constant, as matchAndReplace
+    MI.getUserMaps()
+        ->getMatcherObject(getCorrespConstMatcherOp())
+        ->countMatches(toMatch, mutationOp, iswholestmtmutated, MI, counts);
+
+    MatchOnly_Base::countMatches(toMatch, mutationOp, iswholestmtmutated, MI,
+                                 counts);
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
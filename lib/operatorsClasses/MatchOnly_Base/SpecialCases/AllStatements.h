@@ -43,6 +43,20 @@ public:
     (void)MI;
   }
 
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    for (unsigned i = 0; i < mutationOp.getNumReplacor(); ++i) {
+      bool isWholeStmt = checkWholeStmtAndCount(
+          toMatch, mutationOp.getReplacor(i), iswholestmtmutated, MI, counts);
+      assert(isWholeStmt && "only Delete Stmt and Trap affect whole statement "
+                            "and match anything");
+      (void)isWholeStmt;
+    }
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
@@ -102,6 +102,13 @@ private:
   }
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the call
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Call});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     llvm::errs() << "Unsuported yet: 'matchIRs' mathod of FunctionCall should "
@@ -132,6 +139,16 @@ public:
     (void)MI;
   }
 
+  /// matchAndReplace does not use matchIRs
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    countByMatchAndReplace(toMatch, mutationOp, iswholestmtmutated, MI,
+                           counts);
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
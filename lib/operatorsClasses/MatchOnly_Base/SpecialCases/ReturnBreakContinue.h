@@ -19,6 +19,13 @@
 namespace mart {
 
 class ReturnBreakContinue : public MatchOnly_Base {
+  // Function of the previously matched statement and, when that function
+  // returns a struct through its 'sret' parameter, the not yet mutated use of
+  // that parameter. Kept per object (not static) so that each Mutation (and
+  // its UserMaps) has its own state.
+  llvm::Function *prevFunc = nullptr;
+  const llvm::Value *structRetUse = nullptr;
+
 public:
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
@@ -50,13 +57,21 @@ public:
     (void)MI;
   }
 
+  /// matchAndReplace does not use matchIRs
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    countByMatchAndReplace(toMatch, mutationOp, iswholestmtmutated, MI,
+                           counts);
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
                        WholeStmtMutationOnce &iswholestmtmutated,
                        ModuleUserInfos const &MI) {
-    static llvm::Function *prevFunc = nullptr;
-    static const llvm::Value *structRetUse = nullptr;
     // Here toMatch should have only one elem for 'br' and for ret, the last
     // elem should be 'ret'
     llvm::Instruction *retbr =
@@ -111,6 +111,13 @@ private:
   }
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the switch
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Switch});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     llvm::errs() << "Unsuported yet: 'matchIRs' mathod of SwitchCases should "
@@ -141,6 +148,16 @@ public:
     (void)MI;
   }
 
+  /// matchAndReplace does not use matchIRs
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    countByMatchAndReplace(toMatch, mutationOp, iswholestmtmutated, MI,
+                           counts);
+  }
+
   void matchAndReplace(MatchStmtIR const &toMatch,
                        llvmMutationOp const &mutationOp,
                        MutantsOfStmt &resultMuts,
@@ -15,6 +15,8 @@
  * class.
  */
 
+#include <cstdlib>
+
 #include "../GenericMuOpBase.h"
 
 namespace mart {
@@ -44,6 +46,70 @@ protected:
   inline virtual llvm::CmpInst::Predicate getNeqPred() = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the comparison instruction
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    if (getMyPredicate() >= llvm::CmpInst::FIRST_ICMP_PREDICATE &&
+        getMyPredicate() <= llvm::CmpInst::LAST_ICMP_PREDICATE)
+      return std::vector<unsigned>({llvm::Instruction::ICmp});
+    return std::vector<unsigned>({llvm::Instruction::FCmp});
+  }
+
+  /**
+   * \brief Implements from GenericMuOpBase: a relational replacor is implied
+   * when the inputs for which another replacor differs from the original are
+   * a subset of those for which it differs. Each predicate is represented by
+   * its truth table over the orderings of its operands (less, equal, greater,
+   * and unordered for floating point). For example, with every relational
+   * replacor and the constants (true and false), '<' only keeps '<=', '!='
+   * and 'false'.
+   */
+  void getImpliedReplacors(llvmMutationOp const &mutationOp,
+                           std::vector<int> &impliedBy) {
+    unsigned numRepl = mutationOp.getNumReplacor();
+    impliedBy.assign(numRepl, -1);
+
+    llvm::CmpInst::Predicate myPred = getMyPredicate();
+    // The unordered case only exists for floating point
+    unsigned casesMask = (llvm::CmpInst::isFPPredicate(myPred) ? 0xF : 0x7);
+    int myTable = getPredTruthTable(myPred);
+
+    // Cases for which each replacor differs from the original (-1 if unknown)
+    std::vector<int> diffCases(numRepl, -1);
+    for (unsigned r = 0; r < numRepl; ++r) {
+      int table = getReplacorTruthTable(mutationOp.getReplacor(r), myPred);
+      if (table >= 0)
+        diffCases[r] = (table ^ myTable) & casesMask;
+    }
+
+    // The sufficient replacors differ from the original on a minimal set of
+    // cases (the first one is kept among those with the same cases)
+    std::vector<bool> isSufficient(numRepl, false);
+    for (unsigned r = 0; r < numRepl; ++r) {
+      if (diffCases[r] <= 0)
+        continue;
+      isSufficient[r] = true;
+      for (unsigned o = 0; o < numRepl && isSufficient[r]; ++o) {
+        if (o == r || diffCases[o] <= 0 || (diffCases[o] & ~diffCases[r]))
+          continue;
+        if (diffCases[o] != diffCases[r] || o < r)
+          isSufficient[r] = false;
+      }
+    }
+    for (unsigned r = 0; r < numRepl; ++r) {
+      if (diffCases[r] <= 0 || isSufficient[r])
+        continue;
+      for (unsigned o = 0; o < numRepl; ++o) {
+        if (isSufficient[o] && !(diffCases[o] & ~diffCases[r])) {
+          impliedBy[r] = o;
+          break;
+        }
+      }
+      assert(impliedBy[r] >= 0 && "Non sufficient replacor must be implied");
+    }
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     // Suppress build warnings
@@ -138,101 +204,159 @@ public:
     }
   }
 
-  void matchAndReplace(MatchStmtIR const &toMatch,
-                       llvmMutationOp const &mutationOp,
-                       MutantsOfStmt &resultMuts,
-                       WholeStmtMutationOnce &iswholestmtmutated,
-                       ModuleUserInfos const &MI) {
-    MatchUseful mu;
-    DoReplaceUseful dru;
-    int pos = -1;
-    for (auto *val : toMatch.getIRList()) {
-      (void)val;
-      pos++;
-      if (matchIRs(toMatch, mutationOp, pos, mu, MI)) {
-        for (auto &repl : mutationOp.getMutantReplacorsList()) {
-          if (checkWholeStmtAndMutate(toMatch, repl, resultMuts,
-                                      iswholestmtmutated, MI)) {
-            // Do nothing, already mutated
-          } else {
-            for (MatchUseful const *ptr_mu = mu.first(); ptr_mu != mu.end();
-                                                  ptr_mu = ptr_mu->next()) {
-              prepareCloneIRs(toMatch, pos, *ptr_mu, repl, dru, MI);
-              try {
-                dru.getOrigRelevantIRPos();
-              } catch (std::exception &e) {
-                llvm::errs() << "didn't set 'OrigRelevantIRPos': " << e.what();
-              }
-
-              // the replacer is also reational: already mutated into toMatchMutant
-              if (!dru.hasValidHLReturnIntoIRPos()) 
-                resultMuts.add(/*toMatch, */ dru.toMatchMutant, repl,
-                               dru.getOrigRelevantIRPos());
-              else
-                doReplacement(toMatch, resultMuts, repl, dru.toMatchMutant,
-                              dru.posOfIRtoRemove, dru.getHLOprdOrNull(0),
-                              dru.getHLOprdOrNull(1), dru.getHLReturningIRPos(),
-                              dru.getOrigRelevantIRPos(), MI,
-                              dru.getHLReturnIntoIRPos(),
-                              dru.getHLReturnIntoOprdIndex());
-
-              // make sure to clear 'dru' for the next replcement
-              dru.clearAll();
-            }
-          }
-        }
-
-        // make sure to clear both 'mu' for the next match
-        mu.clearAll();
-      }
+  void replaceMatch(MatchStmtIR const &toMatch, unsigned pos,
+                    MatchUseful const &mu,
+                    llvmMutationOp::MutantReplacors const &repl,
+                    DoReplaceUseful &dru, MutantsOfStmt &resultMuts,
+                    ModuleUserInfos const &MI) {
+    prepareCloneIRs(toMatch, pos, mu, repl, dru, MI);
+    try {
+      dru.getOrigRelevantIRPos();
+    } catch (std::exception &e) {
+      llvm::errs() << "didn't set 'OrigRelevantIRPos': " << e.what();
     }
+
+    // the replacer is also reational: already mutated into toMatchMutant
+    if (!dru.hasValidHLReturnIntoIRPos()) 
+      resultMuts.add(/*toMatch, */ dru.toMatchMutant, repl,
+                     dru.getOrigRelevantIRPos());
+    else
+      doReplacement(toMatch, resultMuts, repl, dru.toMatchMutant,
+                    dru.posOfIRtoRemove, dru.getHLOprdOrNull(0),
+                    dru.getHLOprdOrNull(1), dru.getHLReturningIRPos(),
+                    dru.getOrigRelevantIRPos(), MI,
+                    dru.getHLReturnIntoIRPos(),
+                    dru.getHLReturnIntoOprdIndex());
+
+    // make sure to clear 'dru' for the next replcement
+    dru.clearAll();
   }
 
 protected:
   static std::map<enum ExpElemKeys, llvm::CmpInst::Predicate> *getPredRelMap() {
-    static std::map<enum ExpElemKeys, llvm::CmpInst::Predicate> mrel_IRrel_Map;
-    if (mrel_IRrel_Map.empty()) {
-      typedef std::pair<enum ExpElemKeys, llvm::CmpInst::Predicate> RelPairType;
-      mrel_IRrel_Map.insert(
-          RelPairType(mFCMP_FALSE, llvm::CmpInst::FCMP_FALSE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_OEQ, llvm::CmpInst::FCMP_OEQ));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_OGT, llvm::CmpInst::FCMP_OGT));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_OGE, llvm::CmpInst::FCMP_OGE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_OLT, llvm::CmpInst::FCMP_OLT));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_OLE, llvm::CmpInst::FCMP_OLE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_ONE, llvm::CmpInst::FCMP_ONE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_ORD, llvm::CmpInst::FCMP_ORD));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_UNO, llvm::CmpInst::FCMP_UNO));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_UEQ, llvm::CmpInst::FCMP_UEQ));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_UGT, llvm::CmpInst::FCMP_UGT));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_UGE, llvm::CmpInst::FCMP_UGE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_ULT, llvm::CmpInst::FCMP_ULT));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_ULE, llvm::CmpInst::FCMP_ULE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_UNE, llvm::CmpInst::FCMP_UNE));
-      mrel_IRrel_Map.insert(RelPairType(mFCMP_TRUE, llvm::CmpInst::FCMP_TRUE));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_EQ, llvm::CmpInst::ICMP_EQ));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_NE, llvm::CmpInst::ICMP_NE));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_UGT, llvm::CmpInst::ICMP_UGT));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_UGE, llvm::CmpInst::ICMP_UGE));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_ULT, llvm::CmpInst::ICMP_ULT));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_ULE, llvm::CmpInst::ICMP_ULE));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_SGT, llvm::CmpInst::ICMP_SGT));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_SGE, llvm::CmpInst::ICMP_SGE));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_SLT, llvm::CmpInst::ICMP_SLT));
-      mrel_IRrel_Map.insert(RelPairType(mICMP_SLE, llvm::CmpInst::ICMP_SLE));
-
-      mrel_IRrel_Map.insert(RelPairType(mP_EQ, llvm::CmpInst::ICMP_EQ));
-      mrel_IRrel_Map.insert(RelPairType(mP_NE, llvm::CmpInst::ICMP_NE));
-      mrel_IRrel_Map.insert(RelPairType(mP_GT, llvm::CmpInst::ICMP_UGT));
-      mrel_IRrel_Map.insert(RelPairType(mP_GE, llvm::CmpInst::ICMP_UGE));
-      mrel_IRrel_Map.insert(RelPairType(mP_LT, llvm::CmpInst::ICMP_ULT));
-      mrel_IRrel_Map.insert(RelPairType(mP_LE, llvm::CmpInst::ICMP_ULE));
-
-      assert(mrel_IRrel_Map.size() == 32 &&
-             "Error Inserting some element into mrel_IRrel_Map");
+    // Function-local static initialization is thread safe (C++11), the map
+    // may be requested concurrently by the parallel mutant generation workers
+    static std::map<enum ExpElemKeys, llvm::CmpInst::Predicate> mrel_IRrel_Map(
+        createPredRelMap());
+    return &mrel_IRrel_Map;
+  }
+
+private:
+  /**
+   * \brief @return the truth table of the predicate @param pred over the
+   * cases 'equal' (bit 0), 'greater' (bit 1), 'less' (bit 2) and 'unordered'
+   * (bit 3), which is the encoding of the floating point predicates.
+   */
+  static int getPredTruthTable(llvm::CmpInst::Predicate pred) {
+    if (llvm::CmpInst::isFPPredicate(pred))
+      return pred - llvm::CmpInst::FCMP_FALSE;
+    switch (pred) {
+    case llvm::CmpInst::ICMP_EQ:
+      return llvm::CmpInst::FCMP_OEQ;
+    case llvm::CmpInst::ICMP_NE:
+      return llvm::CmpInst::FCMP_ONE;
+    case llvm::CmpInst::ICMP_UGT:
+    case llvm::CmpInst::ICMP_SGT:
+      return llvm::CmpInst::FCMP_OGT;
+    case llvm::CmpInst::ICMP_UGE:
+    case llvm::CmpInst::ICMP_SGE:
+      return llvm::CmpInst::FCMP_OGE;
+    case llvm::CmpInst::ICMP_ULT:
+    case llvm::CmpInst::ICMP_SLT:
+      return llvm::CmpInst::FCMP_OLT;
+    case llvm::CmpInst::ICMP_ULE:
+    case llvm::CmpInst::ICMP_SLE:
+      return llvm::CmpInst::FCMP_OLE;
+    default:
+      assert(false && "Invalid predicate");
+      return -1;
     }
+  }
 
-    return &mrel_IRrel_Map;
+  /**
+   * \brief @return the truth table (@see getPredTruthTable) of the mutant of
+   * @param repl on the original predicate @param myPred operands, or -1 if
+   * it cannot be represented
+   */
+  static int getReplacorTruthTable(llvmMutationOp::MutantReplacors const &repl,
+                                   llvm::CmpInst::Predicate myPred) {
+    std::vector<unsigned> const &oprds = repl.getOprdIndexList();
+    auto map_it = getPredRelMap()->find(repl.getExpElemKey());
+    if (map_it != getPredRelMap()->end()) {
+      llvm::CmpInst::Predicate pred = map_it->second;
+      if (llvm::CmpInst::isFPPredicate(pred) !=
+          llvm::CmpInst::isFPPredicate(myPred))
+        return -1;
+      // Signed and unsigned orderings cannot be compared
+      if (llvm::CmpInst::isIntPredicate(pred) &&
+          !llvm::ICmpInst::isEquality(pred) &&
+          !llvm::ICmpInst::isEquality(myPred) &&
+          llvm::CmpInst::isSigned(pred) != llvm::CmpInst::isSigned(myPred))
+        return -1;
+      if (oprds.size() != 2)
+        return -1;
+      int table = getPredTruthTable(pred);
+      if (oprds[0] == 0 && oprds[1] == 1)
+        return table;
+      // Swapped operands: swap 'greater' and 'less'
+      if (oprds[0] == 1 && oprds[1] == 0)
+        return (table & 0x9) | ((table & 0x2) << 1) | ((table & 0x4) >> 1);
+      return -1;
+    }
+    // The constant replacing the expression is compared to zero (see
+    // prepareCloneIRs)
+    if (repl.getExpElemKey() == mCONST_VALUE_OF && oprds.size() == 1 &&
+        llvmMutationOp::isSpecifiedConstIndex(oprds[0]))
+      return (std::strtod(llvmMutationOp::getConstValueStr(oprds[0]).c_str(),
+                          nullptr) == 0.0
+                  ? 0x0
+                  : 0xF);
+    return -1;
+  }
+
+  static std::map<enum ExpElemKeys, llvm::CmpInst::Predicate>
+  createPredRelMap() {
+    std::map<enum ExpElemKeys, llvm::CmpInst::Predicate> mrel_IRrel_Map;
+    typedef std::pair<enum ExpElemKeys, llvm::CmpInst::Predicate> RelPairType;
+    mrel_IRrel_Map.insert(
+        RelPairType(mFCMP_FALSE, llvm::CmpInst::FCMP_FALSE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_OEQ, llvm::CmpInst::FCMP_OEQ));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_OGT, llvm::CmpInst::FCMP_OGT));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_OGE, llvm::CmpInst::FCMP_OGE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_OLT, llvm::CmpInst::FCMP_OLT));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_OLE, llvm::CmpInst::FCMP_OLE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_ONE, llvm::CmpInst::FCMP_ONE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_ORD, llvm::CmpInst::FCMP_ORD));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_UNO, llvm::CmpInst::FCMP_UNO));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_UEQ, llvm::CmpInst::FCMP_UEQ));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_UGT, llvm::CmpInst::FCMP_UGT));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_UGE, llvm::CmpInst::FCMP_UGE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_ULT, llvm::CmpInst::FCMP_ULT));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_ULE, llvm::CmpInst::FCMP_ULE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_UNE, llvm::CmpInst::FCMP_UNE));
+    mrel_IRrel_Map.insert(RelPairType(mFCMP_TRUE, llvm::CmpInst::FCMP_TRUE));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_EQ, llvm::CmpInst::ICMP_EQ));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_NE, llvm::CmpInst::ICMP_NE));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_UGT, llvm::CmpInst::ICMP_UGT));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_UGE, llvm::CmpInst::ICMP_UGE));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_ULT, llvm::CmpInst::ICMP_ULT));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_ULE, llvm::CmpInst::ICMP_ULE));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_SGT, llvm::CmpInst::ICMP_SGT));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_SGE, llvm::CmpInst::ICMP_SGE));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_SLT, llvm::CmpInst::ICMP_SLT));
+    mrel_IRrel_Map.insert(RelPairType(mICMP_SLE, llvm::CmpInst::ICMP_SLE));
+
+    mrel_IRrel_Map.insert(RelPairType(mP_EQ, llvm::CmpInst::ICMP_EQ));
+    mrel_IRrel_Map.insert(RelPairType(mP_NE, llvm::CmpInst::ICMP_NE));
+    mrel_IRrel_Map.insert(RelPairType(mP_GT, llvm::CmpInst::ICMP_UGT));
+    mrel_IRrel_Map.insert(RelPairType(mP_GE, llvm::CmpInst::ICMP_UGE));
+    mrel_IRrel_Map.insert(RelPairType(mP_LT, llvm::CmpInst::ICMP_ULT));
+    mrel_IRrel_Map.insert(RelPairType(mP_LE, llvm::CmpInst::ICMP_ULE));
+
+    assert(mrel_IRrel_Map.size() == 32 &&
+           "Error Inserting some element into mrel_IRrel_Map");
+
+    return mrel_IRrel_Map;
   }
 }; // class NumericAndPointerRelational_Base
 
@@ -29,6 +29,56 @@ protected:
   inline virtual unsigned getMyInstructionIROpCode() = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the binary operator instruction
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({getMyInstructionIROpCode()});
+  }
+
+  /**
+   * \brief Implements from GenericMuOpBase: for integer addition and
+   * subtraction, keeping an operand is implied by the opposite operation
+   * that keeps that operand on the left. 'a + b' and 'a - b' differ when
+   * '2*b != 0' (modular), which implies 'b != 0', for which 'a' differs from
+   * them. The same holds for 'a + b' --> 'b' with 'b - a'.
+   */
+  void getImpliedReplacors(llvmMutationOp const &mutationOp,
+                           std::vector<int> &impliedBy) {
+    unsigned numRepl = mutationOp.getNumReplacor();
+    impliedBy.assign(numRepl, -1);
+
+    enum ExpElemKeys oppositeOp;
+    if (getMyInstructionIROpCode() == llvm::Instruction::Add)
+      oppositeOp = mSUB;
+    else if (getMyInstructionIROpCode() == llvm::Instruction::Sub)
+      oppositeOp = mADD;
+    else
+      return;
+
+    for (unsigned r = 0; r < numRepl; ++r) {
+      auto const &repl = mutationOp.getReplacor(r);
+      if (repl.getExpElemKey() != mKEEP_ONE_OPRD ||
+          repl.getOprdIndexList().size() != 1)
+        continue;
+      unsigned kept = repl.getOprdIndexList()[0];
+      // The right operand of a subtraction cannot be kept this way
+      if (kept > 1 || (kept == 1 && getMyInstructionIROpCode() ==
+                                        llvm::Instruction::Sub))
+        continue;
+      for (unsigned o = 0; o < numRepl; ++o) {
+        auto const &other = mutationOp.getReplacor(o);
+        if (other.getExpElemKey() == oppositeOp &&
+            other.getOprdIndexList().size() == 2 &&
+            other.getOprdIndexList()[0] == kept &&
+            other.getOprdIndexList()[1] == 1 - kept) {
+          impliedBy[r] = o;
+          break;
+        }
+      }
+    }
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     // Suppress build warnings
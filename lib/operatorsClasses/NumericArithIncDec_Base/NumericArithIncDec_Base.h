@@ -44,6 +44,13 @@ protected:
   inline virtual bool isLeft_notRight() = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the store of the modified value
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Store});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     // Suppress build warnings
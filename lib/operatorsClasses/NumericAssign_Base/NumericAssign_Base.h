@@ -29,6 +29,13 @@ protected:
   inline virtual bool valTypeMatched(llvm::Type *type) = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the assignment
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Store});
+  }
+
   virtual bool matchIRs(MatchStmtIR const &toMatch,
                         llvmMutationOp const &mutationOp, unsigned pos,
                         MatchUseful &MU, ModuleUserInfos const &MI) {
@@ -47,6 +47,13 @@ protected:
   }
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the xor with -1
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Xor});
+  }
+
   llvm::Value *createReplacement(llvm::Value *oprd1_addrOprd,
                                  llvm::Value *oprd2_intValOprd,
                                  std::vector<llvm::Value *> &replacement,
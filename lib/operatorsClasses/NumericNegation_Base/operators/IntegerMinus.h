@@ -36,6 +36,13 @@ protected:
   }
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the subtraction from 0
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Sub});
+  }
+
   llvm::Value *createReplacement(llvm::Value *oprd1_addrOprd,
                                  llvm::Value *oprd2_intValOprd,
                                  std::vector<llvm::Value *> &replacement,
@@ -32,6 +32,13 @@ protected:
   inline virtual bool checkIntPartExp(llvm::Instruction *tmpI) = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the pointer indexing
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::GetElementPtr});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     // Suppress build warnings
@@ -37,6 +37,13 @@ protected:
   inline virtual bool isLeft_notRight() = 0;
 
 public:
+  /**
+   * \brief Implements from GenericMuOpBase: the store of the modified pointer
+   */
+  std::vector<unsigned> getMinIRInstructionsToBeMatched() {
+    return std::vector<unsigned>({llvm::Instruction::Store});
+  }
+
   bool matchIRs(MatchStmtIR const &toMatch, llvmMutationOp const &mutationOp,
                 unsigned pos, MatchUseful &MU, ModuleUserInfos const &MI) {
     // Suppress build warnings
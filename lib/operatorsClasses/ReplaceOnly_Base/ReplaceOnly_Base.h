@@ -59,6 +59,16 @@ class ReplaceOnly_Base : public GenericMuOpBase {
     (void)MI;
   }
 
+  /// matchAndReplace does not use matchIRs
+  void countMatches(MatchStmtIR const &toMatch,
+                    llvmMutationOp const &mutationOp,
+                    WholeStmtMutationOnce &iswholestmtmutated,
+                    ModuleUserInfos const &MI,
+                    std::map<std::string, unsigned long> &counts) {
+    countByMatchAndReplace(toMatch, mutationOp, iswholestmtmutated, MI,
+                           counts);
+  }
+
   /**
    * \bref Inplements virtual from @see GenericMuOpBase
    */
@@ -0,0 +1,340 @@
+/**
+ * -==== shardmerger.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class ShardMerger, used to link back together the
+ *            modules (meta-mutant, weak mutation, coverage) generated by the
+ *            shards of a sharded mutant generation
+ */
+
+#ifndef __MART_GENMU_shardmerger__
+#define __MART_GENMU_shardmerger__
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#if (LLVM_VERSION_MAJOR >= 4)
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/Linker/Linker.h"
+#endif
+
+#include "typesops.h"
+
+namespace mart {
+
+/**
+ * \brief Merge of the modules of the shards of a sharded generation, where
+ * each shard mutated a distinct set of functions of the same module and
+ * numbered its mutants from 1.
+ * \detail The merged module starts as the module of the first shard. The
+ * module of each following shard has the mutant IDs of its functions shifted
+ * by the number of mutants of the previous shards, then its functions
+ * replace the unmutated ones of the merged module. The other definitions of
+ * the shard's module that are in the original module, or that the merged
+ * module already defines with an external linkage (mutant ID selector, log
+ * functions...), become declarations linked to those of the merged module.
+ */
+class ShardMerger {
+public:
+  /// \brief Names of the mutant ID selector global and of the functions
+  /// whose arguments are mutant IDs (the same for all the shards)
+  struct MutantIDNames {
+    std::string selectorGlobal;
+    std::string selectorFunc;
+    std::string postMutationPointFunc;
+    std::string wmLogFunc;
+    std::string highestMutantIDGlobal;
+  };
+
+private:
+  llvm::Module &mergedModule;
+  MutantIDNames names;
+  // Prefix of the names of the mutants' basic blocks
+  std::string caseBBPrefix;
+  // Names of the global values defined in the original module
+  std::unordered_set<std::string> originalNames;
+
+public:
+  /**
+   * \brief shift by @param idShift the mutant IDs in the function @param
+   * Func: the cases of the switches on @param selectorGlobal, whose basic
+   * blocks are renamed '<@param caseBBPrefix><ID>', and the arguments of the
+   * calls to @param selectorFunc, @param postMutationPointFunc and
+   * @param wmLogFunc (each may be null). The ID 0 (original program) is kept.
+   */
+  static void shiftMutantIDs(llvm::Function &Func, MutantIDType idShift,
+                             llvm::GlobalVariable const *selectorGlobal,
+                             llvm::Function const *selectorFunc,
+                             llvm::Function *postMutationPointFunc,
+                             llvm::Function const *wmLogFunc,
+                             std::string const &caseBBPrefix) {
+    if (idShift == 0)
+      return;
+    auto shifted = [idShift](llvm::Value *val) -> llvm::Constant * {
+      auto *cst = llvm::cast<llvm::ConstantInt>(val);
+      return llvm::ConstantInt::get(cst->getType(),
+                                    cst->getZExtValue() + idShift);
+    };
+    std::vector<llvm::CallInst *> postPointCalls;
+    for (auto &BB : Func) {
+      for (auto &Inst : BB) {
+        if (auto *callI = llvm::dyn_cast<llvm::CallInst>(&Inst)) {
+          llvm::Function *callee = callI->getCalledFunction();
+          if (callee == nullptr)
+            continue;
+          if (callee == selectorFunc) {
+            for (unsigned a = 0; a < 2; ++a)
+              callI->setArgOperand(a, shifted(callI->getArgOperand(a)));
+          } else if (callee == wmLogFunc) {
+            callI->setArgOperand(0, shifted(callI->getArgOperand(0)));
+          } else if (callee == postMutationPointFunc) {
+            postPointCalls.push_back(callI);
+          }
+        } else if (auto *sw = llvm::dyn_cast<llvm::SwitchInst>(&Inst)) {
+          auto *ld = llvm::dyn_cast<llvm::LoadInst>(sw->getCondition());
+          if (!ld || ld->getOperand(0) != selectorGlobal)
+            continue;
+          for (llvm::SwitchInst::CaseIt cit = sw->case_begin(),
+                                        ce = sw->case_end();
+               cit != ce; ++cit) {
+#if (LLVM_VERSION_MAJOR <= 4)
+            uint64_t new_mid = idShift + cit.getCaseValue()->getZExtValue();
+            cit.setValue(llvm::cast<llvm::ConstantInt>(
+                shifted(cit.getCaseValue())));
+            cit.getCaseSuccessor()->setName(caseBBPrefix +
+                                            std::to_string(new_mid));
+#else
+            uint64_t new_mid =
+                idShift + (*cit).getCaseValue()->getZExtValue();
+            (*cit).setValue(llvm::cast<llvm::ConstantInt>(
+                shifted((*cit).getCaseValue())));
+            (*cit).getCaseSuccessor()->setName(caseBBPrefix +
+                                               std::to_string(new_mid));
+#endif
+          }
+        }
+      }
+    }
+    // The range of a post mutation point call may start with the original
+    // program, which is not shifted: split the call
+    for (auto *callI : postPointCalls) {
+      auto *fromC = llvm::cast<llvm::ConstantInt>(callI->getArgOperand(0));
+      auto *toC = llvm::cast<llvm::ConstantInt>(callI->getArgOperand(1));
+      if (!fromC->isZero()) {
+        callI->setArgOperand(0, shifted(fromC));
+        callI->setArgOperand(1, shifted(toC));
+      } else if (!toC->isZero()) {
+        llvm::Value *args[] = {
+            llvm::ConstantInt::get(fromC->getType(), 1 + idShift),
+            shifted(toC)};
+        llvm::CallInst::Create(postMutationPointFunc, args, "",
+                               callI->getNextNode());
+        callI->setArgOperand(1, fromC);
+      }
+    }
+  }
+
+  /**
+   * \brief @param firstShardModule is the module of the first shard, into
+   * which the others are merged. @param originalModule is the module before
+   * mutation (only the names of its global values are used).
+   */
+  ShardMerger(llvm::Module &firstShardModule,
+              llvm::Module const &originalModule,
+              MutantIDNames const &mutantIDNames,
+              std::string const &mutantsBBPrefix)
+      : mergedModule(firstShardModule), names(mutantIDNames),
+        caseBBPrefix(mutantsBBPrefix) {
+    for (auto &F : originalModule)
+      if (!F.isDeclaration())
+        originalNames.insert(F.getName().str());
+    for (auto &GV : originalModule.globals())
+      if (!GV.isDeclaration() && GV.hasName())
+        originalNames.insert(GV.getName().str());
+    for (auto &GA : originalModule.aliases())
+      originalNames.insert(GA.getName().str());
+  }
+
+  /**
+   * \brief merge the module @param shardModule of a shard, whose mutated
+   * functions are @param shardFuncs, after shifting its mutant IDs by
+   * @param idShift. @return false on failure.
+   */
+  bool mergeShard(std::unique_ptr<llvm::Module> shardModule,
+                  std::vector<std::string> const &shardFuncs,
+                  MutantIDType idShift) {
+#if (LLVM_VERSION_MAJOR <= 3)
+    llvm::errs() << "Mart@Error: merging the shards requires LLVM 4 or "
+                    "later\n";
+    return false;
+#else
+    llvm::Module &shardMod = *shardModule;
+    std::unordered_set<std::string> shardFuncNames(shardFuncs.begin(),
+                                                   shardFuncs.end());
+
+    /// \brief Shift the mutant IDs of the shard's functions
+    llvm::GlobalVariable *selGlob =
+        shardMod.getNamedGlobal(names.selectorGlobal);
+    llvm::Function *selFunc = shardMod.getFunction(names.selectorFunc);
+    llvm::Function *postPointFunc =
+        shardMod.getFunction(names.postMutationPointFunc);
+    llvm::Function *wmLogFunc = shardMod.getFunction(names.wmLogFunc);
+    for (auto &fname : shardFuncs) {
+      llvm::Function *F = shardMod.getFunction(fname);
+      llvm::Function *mergedF = mergedModule.getFunction(fname);
+      if (!F || F->isDeclaration() || !mergedF) {
+        llvm::errs() << "Mart@Error: the function '" << fname
+                     << "' of the shard is not defined in its module\n";
+        return false;
+      }
+      shiftMutantIDs(*F, idShift, selGlob, selFunc, postPointFunc, wmLogFunc,
+                     caseBBPrefix);
+    }
+
+    /// \brief Keep, in the shard's module, only the shard's functions and the
+    /// definitions that are not in the merged module (e.g. the local
+    /// constants created by the mutants). The appending globals
+    /// (llvm.global_ctors...) are already in the merged module
+    auto inMergedModule = [&](llvm::GlobalValue const &GV) {
+      if (!GV.hasName())
+        return false;
+      llvm::GlobalValue *mergedGV = mergedModule.getNamedValue(GV.getName());
+      if (!mergedGV || mergedGV->isDeclaration())
+        return false;
+      return (originalNames.count(GV.getName().str()) > 0 ||
+              (!GV.hasLocalLinkage() && !mergedGV->hasLocalLinkage()));
+    };
+    std::vector<llvm::GlobalVariable *> appendingGlobals;
+    for (auto &GV : shardMod.globals())
+      if (GV.hasAppendingLinkage())
+        appendingGlobals.push_back(&GV);
+    for (auto *GV : appendingGlobals)
+      GV->eraseFromParent();
+    std::vector<llvm::GlobalAlias *> mergedAliases;
+    for (auto &GA : shardMod.aliases())
+      if (inMergedModule(GA))
+        mergedAliases.push_back(&GA);
+    for (auto *GA : mergedAliases) {
+      GA->replaceAllUsesWith(GA->getAliasee());
+      GA->eraseFromParent();
+    }
+    for (auto &F : shardMod) {
+      if (F.isDeclaration())
+        continue;
+      if (shardFuncNames.count(F.getName().str())) {
+        F.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        F.setComdat(nullptr);
+      } else if (inMergedModule(F)) {
+        F.deleteBody();
+        F.setComdat(nullptr);
+      }
+    }
+    for (auto &GV : shardMod.globals()) {
+      if (!GV.isDeclaration() && inMergedModule(GV)) {
+        GV.setInitializer(nullptr);
+        GV.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        GV.setComdat(nullptr);
+      }
+    }
+
+    // Remove the unused declarations
+    std::vector<llvm::GlobalValue *> unusedDecls;
+    for (auto &F : shardMod)
+      if (F.isDeclaration() && F.use_empty())
+        unusedDecls.push_back(&F);
+    for (auto &GV : shardMod.globals())
+      if (GV.isDeclaration() && GV.use_empty())
+        unusedDecls.push_back(&GV);
+    for (auto *GV : unusedDecls)
+      GV->eraseFromParent();
+
+    // Keep only the module flags among the named metadata, the others
+    // (llvm.dbg.cu, llvm.ident...) are already in the merged module
+    std::vector<llvm::NamedMDNode *> namedMDs;
+    for (auto &NMD : shardMod.named_metadata())
+      if (NMD.getName() != "llvm.module.flags")
+        namedMDs.push_back(&NMD);
+    for (auto *NMD : namedMDs)
+      shardMod.eraseNamedMetadata(NMD);
+
+    /// \brief Make the original global values of the merged module external
+    /// while linking, so that the declarations of the shard's module link to
+    /// them. The linkages are restored after linking
+    std::vector<std::pair<std::string, llvm::GlobalValue::LinkageTypes>>
+        changedLinkages;
+    auto externalize = [&](llvm::GlobalValue &GV) {
+      if (GV.isDeclaration() || !GV.hasName() || !GV.hasLocalLinkage() ||
+          originalNames.count(GV.getName().str()) == 0)
+        return;
+      changedLinkages.emplace_back(GV.getName().str(), GV.getLinkage());
+      GV.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    };
+    for (auto &F : mergedModule)
+      externalize(F);
+    for (auto &GV : mergedModule.globals())
+      externalize(GV);
+    for (auto &GA : mergedModule.aliases())
+      externalize(GA);
+
+    // Replace the unmutated functions by the shard's ones
+    std::unordered_map<std::string,
+                       std::pair<llvm::Comdat *, llvm::DICompileUnit *>>
+        funcsComdatAndCU;
+    for (auto &fname : shardFuncs) {
+      llvm::Function *Func = mergedModule.getFunction(fname);
+      llvm::DISubprogram *SP = Func->getSubprogram();
+      funcsComdatAndCU[fname] =
+          std::make_pair(Func->getComdat(), SP ? SP->getUnit() : nullptr);
+      Func->deleteBody();
+      Func->setComdat(nullptr);
+    }
+    if (llvm::Linker::linkModules(mergedModule, std::move(shardModule))) {
+      llvm::errs() << "Mart@Error: failed to link the module of a shard\n";
+      return false;
+    }
+    for (auto &fname : shardFuncs) {
+      llvm::Function *Func = mergedModule.getFunction(fname);
+      Func->setComdat(funcsComdatAndCU[fname].first);
+      llvm::DISubprogram *SP = Func->getSubprogram();
+      if (SP && funcsComdatAndCU[fname].second)
+        SP->replaceUnit(funcsComdatAndCU[fname].second);
+    }
+    for (auto &nameLinkage : changedLinkages)
+      mergedModule.getNamedValue(nameLinkage.first)
+          ->setLinkage(nameLinkage.second);
+    return true;
+#endif
+  }
+
+  /// \brief set the mutant ID selecting the original program, and the
+  /// highest mutant ID of the weak mutation and coverage modules, after all
+  /// the shards were merged, to match @param highestMutantID
+  void setHighestMutantID(MutantIDType highestMutantID) {
+    if (auto *selGlob = mergedModule.getNamedGlobal(names.selectorGlobal))
+      if (selGlob->hasInitializer())
+        selGlob->setInitializer(llvm::ConstantInt::get(
+            selGlob->getInitializer()->getType(), (uint64_t)1 + highestMutantID));
+    if (auto *highestGlob =
+            mergedModule.getNamedGlobal(names.highestMutantIDGlobal))
+      if (highestGlob->hasInitializer())
+        highestGlob->setInitializer(llvm::ConstantInt::get(
+            highestGlob->getInitializer()->getType(), (uint64_t)highestMutantID));
+  }
+}; // class ShardMerger
+
+} // namespace mart
+
+#endif //__MART_GENMU_shardmerger__
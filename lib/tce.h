@@ -12,11 +12,22 @@
 #ifndef __MART_GENMU_tce__
 #define __MART_GENMU_tce__
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
@@ -27,35 +38,86 @@
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 //#include "llvm/Transforms/IPO/InlinerPass.h"
 #include "llvm/Transforms/IPO.h"
+// llvm::createPromoteMemoryToRegisterPass
+#if (LLVM_VERSION_MAJOR >= 7)
+#include "llvm/Transforms/Utils.h"
+#else
+#include "llvm/Transforms/Scalar.h"
+#endif
+
+#if (LLVM_VERSION_MAJOR >= 12)
+#include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Transforms/Scalar/EarlyCSE.h"
+#include "llvm/Transforms/Scalar/LowerExpectIntrinsic.h"
+#include "llvm/Transforms/Scalar/SROA.h"
+#include "llvm/Transforms/Scalar/SimplifyCFG.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#endif
 
 #include "llvm-diff/DifferenceEngineEntry.h"
 
 namespace mart {
 
+/**
+ * \brief Optimizer and code diff of the TCE.
+ * \detail The optimization pipelines are built once per optimization level
+ * and reused for all the modules and functions optimized with the same TCE
+ * object (the legacy function pipeline is bound to a module, and rebuilt when
+ * the module changes). With LLVM 12 or later, the functions are optimized
+ * with the new pass manager, whose analysis managers are kept and only
+ * cleared of the analyses of the optimized function.
+ * A TCE object must only be used by one thread at a time.
+ */
 class TCE {
 public:
-  void optimize(llvm::Module &module, unsigned optLevel = 0 /* 0,1,2,3 */) {
-#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-    llvm::PassManager mpm;
-#else
-    llvm::legacy::PassManager mpm;
-#endif
-    llvm::PassManagerBuilder pmbuilder;
-    // mpm.add(llvm::createStripSymbolsPass(true));
-    // mpm.add(llvm::createGlobalOptimizerPass());
+  /// \brief pass manager of the functions' optimization
+  enum PassManagerKind {
+    LegacyPM,
+    NewPM,
+    // New pass manager, checking its output against the legacy's
+    CheckPM
+  };
 
-    pmbuilder.OptLevel = optLevel;
-    pmbuilder.SizeLevel = 2;
-    // pmbuilder.Inliner = llvm::createFunctionInliningPass(3, 2); //This is for
-    // module pass
-#if (LLVM_VERSION_MAJOR < 8) // && (LLVM_VERSION_MINOR < 5)
-    pmbuilder.DisableUnitAtATime = false;
+  /// \brief set the pass manager of the functions' optimization of all the
+  /// TCE objects (the new pass manager is only available from LLVM 12)
+  static bool setPassManager(PassManagerKind kind) {
+#if (LLVM_VERSION_MAJOR < 12)
+    if (kind != LegacyPM)
+      return false;
 #endif
-    pmbuilder.DisableUnrollLoops = false;
-    pmbuilder.LoopVectorize = true;
-    pmbuilder.SLPVectorize = true;
-    pmbuilder.populateModulePassManager(mpm);
-    mpm.run(module);
+    passManagerKind() = kind;
+    return true;
+  }
+
+  static PassManagerKind getPassManager() { return passManagerKind(); }
+
+  /// \brief identifies the functions' optimization at @param optLevel with
+  /// the current pass manager, in the keys of the cached TCE verdicts
+  static std::string getConfigName(unsigned optLevel) {
+    static const char *pmNames[] = {"legacyPM", "newPM", "checkPM"};
+    return "opt" + std::to_string(optLevel) + ";" + pmNames[passManagerKind()];
+  }
+
+  /// \brief @return the numbers of functions optimized with the check of the
+  /// new pass manager (CheckPM), and of those for which its output differs
+  /// from the legacy's
+  static std::pair<unsigned long, unsigned long> getPassManagerCheckStats() {
+    return std::make_pair(numPMChecked().load(), numPMDiffering().load());
+  }
+
+  void optimize(llvm::Module &module, unsigned optLevel = 0 /* 0,1,2,3 */) {
+    auto &mpm = modulePipelines[optLevel];
+    if (!mpm) {
+      mpm.reset(new ModulePassManagerT());
+      llvm::PassManagerBuilder pmbuilder;
+      configure(pmbuilder, optLevel);
+      pmbuilder.populateModulePassManager(*mpm);
+    }
+    mpm->run(module);
     /*for (auto &Func: module)
     {
         mpm.run(Func);
@@ -63,28 +125,35 @@ public:
   }
 
   void optimize(llvm::Function &func, unsigned optLevel = 0 /* 0,1,2,3 */) {
-#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
-    llvm::FunctionPassManager fpm(func.getParent());
-#else
-    llvm::legacy::FunctionPassManager fpm(func.getParent());
+#if (LLVM_VERSION_MAJOR >= 12)
+    if (passManagerKind() == NewPM) {
+      optimizeNewPM(func, optLevel);
+      return;
+    }
+    if (passManagerKind() == CheckPM) {
+      checkNewPM(func, optLevel);
+      return;
+    }
 #endif
-    llvm::PassManagerBuilder pmbuilder;
-    // fpm.add(llvm::createStripSymbolsPass(true));
-    // fpm.add(llvm::createGlobalOptimizerPass());
+    optimizeLegacyPM(func, optLevel);
+  }
 
-    pmbuilder.OptLevel = optLevel;
-    pmbuilder.SizeLevel = 2;
-    // pmbuilder.Inliner = llvm::createFunctionInliningPass(3, 2); //This is for
-    // module pass
-#if (LLVM_VERSION_MAJOR < 8) // && (LLVM_VERSION_MINOR < 5)
-    pmbuilder.DisableUnitAtATime = false;
+  /**
+   * \brief promote back into SSA registers the stack slots of the functions
+   * of @param module (mem2reg), in particular those of the values demoted at
+   * preprocessing. The optimization at level 0 does not do it.
+   */
+  void promoteMemoryToRegisters(llvm::Module &module) {
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+    llvm::FunctionPassManager fpm(&module);
+#else
+    llvm::legacy::FunctionPassManager fpm(&module);
 #endif
-    pmbuilder.DisableUnrollLoops = false;
-    pmbuilder.LoopVectorize = true;
-    pmbuilder.SLPVectorize = true;
-    pmbuilder.populateFunctionPassManager(fpm);
+    fpm.add(llvm::createPromoteMemoryToRegisterPass());
     fpm.doInitialization();
-    fpm.run(func);
+    for (auto &func : module)
+      if (!func.isDeclaration())
+        fpm.run(func);
     fpm.doFinalization();
   }
 
@@ -115,6 +184,49 @@ public:
     return Consumer.hadDifferences();
   }
 
+  /// \brief set whether the duplicate candidates of the mutants are bucketed
+  /// by their structural hash (see hashFunction). Without the buckets, each
+  /// mutant is diffed with all the candidates, which must give the same
+  /// verdicts
+  static void setHashBuckets(bool enabled) { hashBucketsEnabled() = enabled; }
+
+  static bool useHashBuckets() { return hashBucketsEnabled(); }
+
+  /**
+   * \brief Structural hash of @param func, used to only diff the functions
+   * whose hashes are equal. The hash only covers what functionDiff compares
+   * (opcodes, predicates, operands, constants, names of the globals and the
+   * control flow from the entry block), in the order of the successors, so
+   * that the functions found identical by functionDiff have the same hash,
+   * whatever their value names and the numbering of their basic blocks.
+   */
+  size_t hashFunction(llvm::Function *func) {
+    if (!func)
+      return 0;
+    // The difference engine finds all the declarations identical
+    if (func->isDeclaration())
+      return 1;
+
+    llvm::hash_code hash = llvm::hash_value(func->arg_size());
+    llvm::SmallPtrSet<llvm::BasicBlock *, 32> visited;
+    llvm::SmallVector<llvm::BasicBlock *, 32> toVisit;
+    toVisit.push_back(&func->getEntryBlock());
+    while (!toVisit.empty()) {
+      llvm::BasicBlock *bb = toVisit.pop_back_val();
+      if (visited.count(bb))
+        continue;
+      visited.insert(bb);
+      for (auto &inst : *bb)
+        hash = llvm::hash_combine(hash, hashInstruction(inst));
+      // Successors followed by the difference engine, last to visit first
+      llvm::SmallVector<llvm::BasicBlock *, 8> succs;
+      getComparedSuccessors(bb->getTerminator(), succs);
+      for (auto it = succs.rbegin(), ie = succs.rend(); it != ie; ++it)
+        toVisit.push_back(*it);
+    }
+    return hash;
+  }
+
   /**
    * \brief Modifies 'diffFuncs2Muts' and 'mutatedFuncsOfMID'
    */
@@ -136,6 +248,266 @@ public:
       assert(false &&
              "TODO: case the mutation remove or add a function to module");
   }
+
+private:
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+  typedef llvm::PassManager ModulePassManagerT;
+  typedef llvm::FunctionPassManager FunctionPassManagerT;
+#else
+  typedef llvm::legacy::PassManager ModulePassManagerT;
+  typedef llvm::legacy::FunctionPassManager FunctionPassManagerT;
+#endif
+
+  /// \brief legacy function pipeline, bound to the module @param module
+  struct LegacyFunctionPipeline {
+    llvm::Module *module = nullptr;
+    std::unique_ptr<FunctionPassManagerT> fpm;
+  };
+
+  std::map<unsigned, std::unique_ptr<ModulePassManagerT>> modulePipelines;
+  std::map<unsigned, LegacyFunctionPipeline> legacyFunctionPipelines;
+
+  static PassManagerKind &passManagerKind() {
+#if (LLVM_VERSION_MAJOR >= 12)
+    static PassManagerKind kind = NewPM;
+#else
+    static PassManagerKind kind = LegacyPM;
+#endif
+    return kind;
+  }
+  static bool &hashBucketsEnabled() {
+    static bool enabled = true;
+    return enabled;
+  }
+  static std::atomic<unsigned long> &numPMChecked() {
+    static std::atomic<unsigned long> num(0);
+    return num;
+  }
+  static std::atomic<unsigned long> &numPMDiffering() {
+    static std::atomic<unsigned long> num(0);
+    return num;
+  }
+
+  static void configure(llvm::PassManagerBuilder &pmbuilder,
+                        unsigned optLevel) {
+    // pmbuilder.Inliner = llvm::createFunctionInliningPass(3, 2); //This is for
+    // module pass
+    pmbuilder.OptLevel = optLevel;
+    pmbuilder.SizeLevel = 2;
+#if (LLVM_VERSION_MAJOR < 8) // && (LLVM_VERSION_MINOR < 5)
+    pmbuilder.DisableUnitAtATime = false;
+#endif
+    pmbuilder.DisableUnrollLoops = false;
+    pmbuilder.LoopVectorize = true;
+    pmbuilder.SLPVectorize = true;
+  }
+
+  void optimizeLegacyPM(llvm::Function &func, unsigned optLevel) {
+    LegacyFunctionPipeline &pipeline = legacyFunctionPipelines[optLevel];
+    if (!pipeline.fpm || pipeline.module != func.getParent()) {
+      pipeline.module = func.getParent();
+      pipeline.fpm.reset(new FunctionPassManagerT(pipeline.module));
+      llvm::PassManagerBuilder pmbuilder;
+      configure(pmbuilder, optLevel);
+      pmbuilder.populateFunctionPassManager(*pipeline.fpm);
+    }
+    pipeline.fpm->doInitialization();
+    pipeline.fpm->run(func);
+    pipeline.fpm->doFinalization();
+  }
+
+#if (LLVM_VERSION_MAJOR >= 12)
+  /// \brief analysis managers of the new pass manager, registered with each
+  /// other once
+  struct NewPMAnalyses {
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+    llvm::PassBuilder passBuilder;
+    // The same passes as the legacy populateFunctionPassManager at level > 0
+    llvm::FunctionPassManager fpm;
+
+    NewPMAnalyses() {
+      // The legacy pipeline has no TargetLibraryInfo pass, thus gets the
+      // default one (for an unknown target), while the PassBuilder's is for
+      // the module's target. Registered first, the default one is kept
+      fam.registerPass([] {
+        return llvm::TargetLibraryAnalysis(llvm::TargetLibraryInfoImpl());
+      });
+      passBuilder.registerModuleAnalyses(mam);
+      passBuilder.registerCGSCCAnalyses(cgam);
+      passBuilder.registerFunctionAnalyses(fam);
+      passBuilder.registerLoopAnalyses(lam);
+      passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+      fpm.addPass(llvm::LowerExpectIntrinsicPass());
+      fpm.addPass(llvm::SimplifyCFGPass());
+#if (LLVM_VERSION_MAJOR >= 14)
+      fpm.addPass(llvm::SROAPass());
+#else
+      fpm.addPass(llvm::SROA());
+#endif
+      fpm.addPass(llvm::EarlyCSEPass());
+    }
+  };
+  std::unique_ptr<NewPMAnalyses> newPMAnalyses;
+
+  void optimizeNewPM(llvm::Function &func, unsigned optLevel) {
+    // The legacy function pipeline is empty at level 0
+    if (optLevel == 0)
+      return;
+    if (!newPMAnalyses)
+      newPMAnalyses.reset(new NewPMAnalyses());
+    newPMAnalyses->fpm.run(func, newPMAnalyses->fam);
+    // The function may be freed after, and another allocated at its address
+    newPMAnalyses->fam.clear(func, func.getName());
+  }
+
+  /// \brief optimize @param func with the new pass manager, and a clone of
+  /// it with the legacy one, and count the differences of their outputs
+  void checkNewPM(llvm::Function &func, unsigned optLevel) {
+    llvm::ValueToValueMapTy vmap;
+    llvm::Function *legacyFunc = llvm::CloneFunction(&func, vmap);
+    optimizeLegacyPM(*legacyFunc, optLevel);
+    optimizeNewPM(func, optLevel);
+    ++numPMChecked();
+    if (functionDiff(legacyFunc, &func, nullptr)) {
+      ++numPMDiffering();
+      llvm::errs() << "Mart@Warning: the new pass manager's optimization of "
+                      "function '"
+                   << func.getName() << "' differs from the legacy one's\n";
+    }
+    legacyFunc->eraseFromParent();
+  }
+#endif
+
+  /// \brief hash of a call site, of which only the called value and the
+  /// arguments are compared
+  template <typename CallT> llvm::hash_code hashCallSite(CallT *call) {
+#if (LLVM_VERSION_MAJOR >= 8)
+    llvm::hash_code hash = hashOperand(call->getCalledOperand());
+    unsigned numArgs = call->arg_size();
+#else
+    llvm::hash_code hash = hashOperand(call->getCalledValue());
+    unsigned numArgs = call->getNumArgOperands();
+#endif
+    hash = llvm::hash_combine(hash, numArgs);
+    for (unsigned i = 0; i < numArgs; ++i)
+      hash = llvm::hash_combine(hash, hashOperand(call->getArgOperand(i)));
+    return hash;
+  }
+
+  llvm::hash_code hashInstruction(llvm::Instruction &inst) {
+    llvm::hash_code hash = llvm::hash_value(inst.getOpcode());
+    if (auto *cmp = llvm::dyn_cast<llvm::CmpInst>(&inst)) {
+      hash = llvm::hash_combine(hash, (unsigned)cmp->getPredicate());
+    } else if (auto *call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+      return llvm::hash_combine(hash, hashCallSite(call));
+    } else if (llvm::isa<llvm::PHINode>(&inst)) {
+      // The incoming values of the PHI nodes are not compared
+      return hash;
+    } else if (auto *invoke = llvm::dyn_cast<llvm::InvokeInst>(&inst)) {
+      return llvm::hash_combine(hash, hashCallSite(invoke));
+    } else if (auto *br = llvm::dyn_cast<llvm::BranchInst>(&inst)) {
+      if (!br->isConditional())
+        return hash;
+      return llvm::hash_combine(hash, hashOperand(br->getCondition()));
+    } else if (auto *ibr = llvm::dyn_cast<llvm::IndirectBrInst>(&inst)) {
+      return llvm::hash_combine(hash, ibr->getNumDestinations(),
+                                hashOperand(ibr->getAddress()));
+    } else if (auto *sw = llvm::dyn_cast<llvm::SwitchInst>(&inst)) {
+      // The cases are matched by value, whatever their order
+      size_t casesHash = 0;
+#if (LLVM_VERSION_MAJOR < 5)
+      for (llvm::SwitchInst::CaseIt it = sw->case_begin(),
+                                    ie = sw->case_end();
+           it != ie; ++it)
+#else
+      for (auto it : sw->cases())
+#endif
+        casesHash += llvm::hash_value(it.getCaseValue()->getValue());
+      return llvm::hash_combine(hash, hashOperand(sw->getCondition()),
+                                sw->getNumCases(), casesHash);
+    } else if (llvm::isa<llvm::UnreachableInst>(&inst)) {
+      return hash;
+    }
+    hash = llvm::hash_combine(hash, inst.getNumOperands());
+    for (unsigned i = 0, e = inst.getNumOperands(); i < e; ++i)
+      hash = llvm::hash_combine(hash, hashOperand(inst.getOperand(i)));
+    return hash;
+  }
+
+  /// \brief hash of an operand. The local values are matched by the
+  /// difference engine by their position, so only their kind is hashed
+  llvm::hash_code hashOperand(llvm::Value *val) {
+    llvm::hash_code hash = llvm::hash_value(val->getValueID());
+    if (auto *gv = llvm::dyn_cast<llvm::GlobalValue>(val)) {
+      // Local variables with unique initializer are compared by initializer
+      if (auto *gvar = llvm::dyn_cast<llvm::GlobalVariable>(gv))
+        if (gvar->hasLocalLinkage() && gvar->hasUniqueInitializer())
+          return hash;
+      return llvm::hash_combine(hash, gv->getName());
+    }
+    if (auto *ce = llvm::dyn_cast<llvm::ConstantExpr>(val)) {
+      hash = llvm::hash_combine(hash, ce->getOpcode(), ce->getNumOperands());
+      if (ce->isCompare())
+        hash = llvm::hash_combine(hash, ce->getPredicate());
+      for (unsigned i = 0, e = ce->getNumOperands(); i < e; ++i)
+        hash = llvm::hash_combine(hash, hashOperand(ce->getOperand(i)));
+      return hash;
+    }
+    if (auto *cv = llvm::dyn_cast<llvm::ConstantVector>(val)) {
+      hash = llvm::hash_combine(hash, cv->getNumOperands());
+      for (unsigned i = 0, e = cv->getNumOperands(); i < e; ++i)
+        hash = llvm::hash_combine(hash, hashOperand(cv->getOperand(i)));
+      return hash;
+    }
+    // The other constants are only equal to themselves
+    if (auto *ci = llvm::dyn_cast<llvm::ConstantInt>(val))
+      return llvm::hash_combine(hash, ci->getValue());
+    if (auto *cfp = llvm::dyn_cast<llvm::ConstantFP>(val))
+      return llvm::hash_combine(hash,
+                                cfp->getValueAPF().bitcastToAPInt());
+    if (auto *arg = llvm::dyn_cast<llvm::Argument>(val))
+      return llvm::hash_combine(hash, arg->getArgNo());
+    if (auto *inst = llvm::dyn_cast<llvm::Instruction>(val))
+      return llvm::hash_combine(hash, inst->getOpcode());
+    return hash;
+  }
+
+  /// \brief the successors of @param term that the difference engine pairs
+  /// with those of the other function (the cases of a switch by value)
+  void
+  getComparedSuccessors(llvm::Instruction *term,
+                        llvm::SmallVectorImpl<llvm::BasicBlock *> &succs) {
+    if (auto *br = llvm::dyn_cast<llvm::BranchInst>(term)) {
+      for (unsigned i = 0, e = br->getNumSuccessors(); i < e; ++i)
+        succs.push_back(br->getSuccessor(i));
+    } else if (auto *invoke = llvm::dyn_cast<llvm::InvokeInst>(term)) {
+      succs.push_back(invoke->getNormalDest());
+      succs.push_back(invoke->getUnwindDest());
+    } else if (auto *sw = llvm::dyn_cast<llvm::SwitchInst>(term)) {
+      succs.push_back(sw->getDefaultDest());
+      std::vector<std::pair<llvm::ConstantInt *, llvm::BasicBlock *>> cases;
+#if (LLVM_VERSION_MAJOR < 5)
+      for (llvm::SwitchInst::CaseIt it = sw->case_begin(),
+                                    ie = sw->case_end();
+           it != ie; ++it)
+#else
+      for (auto it : sw->cases())
+#endif
+        cases.push_back(std::make_pair(it.getCaseValue(),
+                                       it.getCaseSuccessor()));
+      std::sort(cases.begin(), cases.end(),
+                [](std::pair<llvm::ConstantInt *, llvm::BasicBlock *> const &a,
+                   std::pair<llvm::ConstantInt *, llvm::BasicBlock *> const &b) {
+                  return a.first->getValue().ult(b.first->getValue());
+                });
+      for (auto &c : cases)
+        succs.push_back(c.second);
+    }
+    // The successors of the other terminators are not compared
+  }
 }; // class TCE
 
 } // namespace mart
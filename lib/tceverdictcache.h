@@ -0,0 +1,310 @@
+/**
+ * -==== tceverdictcache.h
+ *
+ *                MART Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Define the class TCEVerdictCache, the persistent on-disk cache of
+ *            the TCE verdicts of the mutants, reused across runs of Mart
+ */
+
+#ifndef __MART_GENMU_tceverdictcache__
+#define __MART_GENMU_tceverdictcache__
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>    //open
+#include <string>
+#include <sys/file.h> //flock
+#include <unistd.h>   //read, write, close
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "mutationcache.h"
+
+namespace mart {
+
+/**
+ * \brief Cache of the function-mode TCE verdicts of the mutants, stored in a
+ * directory and shared by the runs of Mart.
+ * \detail A mutant is keyed by the hash of the TCE configuration (LLVM
+ * version, optimization level and pass manager), of the original module's
+ * globals and functions declarations, of its original function and of its
+ * function before optimization (both without their local value names). The
+ * verdict of a mutant is equivalent or duplicate (with the key of the mutant
+ * it duplicates). The distinct mutants are not stored: their functions are
+ * optimized again, to be compared with the other mutants.
+ * The verdicts are in a single log file, whose lines '<key> E' and '<key> D
+ * <key of the duplicated mutant>' are only appended, under an
+ * exclusive lock (flock), while the file is read under a shared lock. So,
+ * concurrent runs on the same machine can share the cache. The lines of a
+ * killed run that are incomplete are ignored.
+ */
+class TCEVerdictCache {
+public:
+  enum VerdictKind { Equivalent, Duplicate };
+  struct Verdict {
+    VerdictKind kind;
+    std::string duplicateOfKey;
+  };
+
+private:
+  // Increase this when the TCE verdicts or the format change
+  static const unsigned cacheFormatVersion = 3;
+
+  std::string cacheDir;
+  std::string contextDigest;
+
+  std::unordered_map<std::string, Verdict> verdicts;
+  std::string newRecords;
+
+  std::atomic<unsigned long> numLookups;
+  std::atomic<unsigned long> numHits;
+
+  std::string getLogPath() const { return cacheDir + "/tce-verdicts.log"; }
+
+  static bool isKey(std::string const &str) {
+    if (str.size() != 32)
+      return false;
+    for (char c : str)
+      if (!std::isxdigit(c))
+        return false;
+    return true;
+  }
+
+  void parseRecords(std::string const &data) {
+    size_t pos = 0;
+    for (size_t eol = data.find('\n'); eol != std::string::npos;
+         pos = eol + 1, eol = data.find('\n', pos)) {
+      std::string line = data.substr(pos, eol - pos);
+      std::string key = line.substr(0, 32);
+      if (line.size() < 34 || !isKey(key) || line[32] != ' ')
+        continue;
+      Verdict verdict;
+      if (line.size() == 34 && line[33] == 'E') {
+        verdict.kind = Equivalent;
+      } else if (line.size() == 67 && line[33] == 'D' && line[34] == ' ' &&
+                 isKey(line.substr(35))) {
+        verdict.kind = Duplicate;
+        verdict.duplicateOfKey = line.substr(35);
+      } else {
+        continue;
+      }
+      verdicts[key] = verdict;
+    }
+  }
+
+  /// \brief the printed IR of @param Func without its local value names
+  /// (they contain the mutant and statement IDs). The names are removed for
+  /// the printing, then restored
+  static std::string printWithoutLocalNames(llvm::Function &Func) {
+    std::vector<std::pair<llvm::Value *, std::string>> names;
+    auto removeName = [&names](llvm::Value &val) {
+      if (val.hasName()) {
+        names.emplace_back(&val, val.getName().str());
+        val.setName("");
+      }
+    };
+    for (auto &arg : Func.args())
+      removeName(arg);
+    for (auto &BB : Func) {
+      removeName(BB);
+      for (auto &Inst : BB)
+        removeName(Inst);
+    }
+    std::string funcIR;
+    llvm::raw_string_ostream ross(funcIR);
+    Func.print(ross);
+    // The attribute groups of the call sites are normalized, add them
+    for (auto &BB : Func) {
+      for (auto &Inst : BB) {
+        llvm::Instruction *inst = &Inst;
+        if (auto *call = llvm::dyn_cast<llvm::CallInst>(inst)) {
+          for (unsigned i = 0, e = call->getNumOperands(); i <= e; ++i)
+            ross << call->getAttributes().getAsString(i) << ";";
+          ross << call->getAttributes().getAsString(~0U) << "\n";
+        } else if (auto *invoke = llvm::dyn_cast<llvm::InvokeInst>(inst)) {
+          for (unsigned i = 0, e = invoke->getNumOperands(); i <= e; ++i)
+            ross << invoke->getAttributes().getAsString(i) << ";";
+          ross << invoke->getAttributes().getAsString(~0U) << "\n";
+        }
+      }
+    }
+    ross.flush();
+    for (auto &name : names)
+      name.first->setName(name.second);
+    return MutationCache::normalizeSlotNumbers(funcIR);
+  }
+
+public:
+  TCEVerdictCache(std::string const &dir)
+      : cacheDir(dir), numLookups(0), numHits(0) {}
+
+  /// \brief Create the cache directory if it does not exist and load the
+  /// verdicts
+  bool initialize() {
+    if (llvm::sys::fs::create_directories(cacheDir)) {
+      llvm::errs() << "Mart@Error: failed to create the TCE verdict cache "
+                      "directory '"
+                   << cacheDir << "'\n";
+      return false;
+    }
+    int fd = ::open(getLogPath().c_str(), O_RDONLY);
+    if (fd < 0)
+      return true; // Empty cache
+    std::string data;
+    if (::flock(fd, LOCK_SH) == 0) {
+      char buf[65536];
+      ssize_t n;
+      while ((n = ::read(fd, buf, sizeof(buf))) > 0 ||
+             (n < 0 && errno == EINTR))
+        if (n > 0)
+          data.append(buf, n);
+      ::flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+    parseRecords(data);
+    return true;
+  }
+
+  /// \brief set the part of the keys that is common to all the mutants:
+  /// @param tceConfig identifies the TCE optimization, and @param origModule
+  /// is the original module, whose globals and functions declarations may
+  /// affect the optimization of a function. The global @param ignoredGlobal
+  /// (the mutant ID selector, whose initializer is the number of mutants) is
+  /// not hashed
+  void setContext(llvm::Module const &origModule,
+                  std::string const &tceConfig,
+                  std::string const &ignoredGlobal) {
+    llvm::MD5 hash;
+    hash.update(std::to_string(cacheFormatVersion));
+    hash.update(LLVM_VERSION_STRING);
+    hash.update(tceConfig);
+    hash.update(origModule.getDataLayoutStr());
+    hash.update(origModule.getTargetTriple());
+    std::string typesStr;
+    llvm::raw_string_ostream ross(typesStr);
+    for (auto *sType : origModule.getIdentifiedStructTypes())
+      sType->print(ross << "\n");
+    ross.flush();
+    hash.update(MutationCache::normalizeSlotNumbers(typesStr));
+    hash.update(
+        MutationCache::getDeclarationsDigest(origModule, ignoredGlobal));
+    contextDigest = MutationCache::getDigest(hash);
+  }
+
+  /// \brief key of the mutated function @param funcName, whose original
+  /// (before optimization) is @param origFunc. Its local names are removed
+  std::string computeFunctionKey(std::string const &funcName,
+                                 llvm::Function &origFunc) const {
+    llvm::MD5 hash;
+    hash.update(contextDigest);
+    hash.update(funcName);
+    hash.update(printWithoutLocalNames(origFunc));
+    return MutationCache::getDigest(hash);
+  }
+
+  /// \brief key of the mutant whose function, before optimization, is
+  /// @param mutFunc (its local names are removed), in the function whose key
+  /// is @param functionKey
+  std::string computeMutantKey(std::string const &functionKey,
+                               llvm::Function &mutFunc) const {
+    llvm::MD5 hash;
+    hash.update(functionKey);
+    hash.update(printWithoutLocalNames(mutFunc));
+    return MutationCache::getDigest(hash);
+  }
+
+  /// \brief look up the verdict of the mutant @param key. Can be called by
+  /// concurrent threads, but not concurrently with add
+  bool lookup(std::string const &key, Verdict &verdict) const {
+    auto it = verdicts.find(key);
+    if (it == verdicts.end())
+      return false;
+    verdict = it->second;
+    return true;
+  }
+
+  /// \brief count a looked up mutant, and whether its verdict was reused
+  void countLookup(bool isHit) {
+    ++numLookups;
+    if (isHit)
+      ++numHits;
+  }
+
+  /// \brief add the verdict of a mutant, to write with flush
+  void add(std::string const &key, Verdict const &verdict) {
+    auto it = verdicts.find(key);
+    if (it != verdicts.end() && it->second.kind == verdict.kind &&
+        it->second.duplicateOfKey == verdict.duplicateOfKey)
+      return;
+    verdicts[key] = verdict;
+    newRecords += key;
+    if (verdict.kind == Equivalent)
+      newRecords += " E\n";
+    else
+      newRecords += " D " + verdict.duplicateOfKey + "\n";
+  }
+
+  /// \brief append the verdicts added since the last flush to the cache
+  bool flush() {
+    if (newRecords.empty())
+      return true;
+    int fd = ::open(getLogPath().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0 || ::flock(fd, LOCK_EX) != 0) {
+      if (fd >= 0)
+        ::close(fd);
+      llvm::errs() << "Mart@Warning: failed to write into the TCE verdict "
+                      "cache '"
+                   << getLogPath() << "'\n";
+      return false;
+    }
+    bool failed = false;
+    for (size_t done = 0; done < newRecords.size();) {
+      ssize_t n = ::write(fd, newRecords.data() + done,
+                          newRecords.size() - done);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0) {
+        failed = true;
+        break;
+      }
+      done += n;
+    }
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+    if (failed) {
+      llvm::errs() << "Mart@Warning: failed to write into the TCE verdict "
+                      "cache '"
+                   << getLogPath() << "'\n";
+      return false;
+    }
+    newRecords.clear();
+    return true;
+  }
+
+  std::string getStats() const {
+    unsigned long lookups = numLookups, hits = numHits;
+    return "# TCE verdict cache: " + std::to_string(hits) + " of " +
+           std::to_string(lookups) + " mutants reused from '" + cacheDir +
+           "' (hit rate " +
+           std::to_string(lookups == 0 ? 0 : 100 * hits / lookups) + "%)\n";
+  }
+}; // class TCEVerdictCache
+
+} // namespace mart
+
+#endif //__MART_GENMU_tceverdictcache__
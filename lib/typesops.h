@@ -12,6 +12,10 @@
 #ifndef __MART_GENMU_typesops__
 #define __MART_GENMU_typesops__
 
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <unordered_map>
@@ -37,6 +41,7 @@
 #include "llvm/IR/DebugInfoMetadata.h" //DIScope
 #endif
 
+#include "ReadWriteIRObj.h"
 #include "usermaps.h"
 
 // https://github.com/anhero/JsonBox
@@ -132,7 +137,11 @@ public:
 
   inline void setModule(llvm::Module *module) {
     curModule = module;
-    if (DL) {
+    if (curModule == nullptr) {
+      // No module (configuration only)
+      delete DL;
+      DL = nullptr;
+    } else if (DL) {
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
       // here 'module->getDataLayout()' returns a string
       DL->init(module->getDataLayout());
@@ -170,6 +179,11 @@ public:
     enum ExpElemKeys expElemKey;
     std::vector<unsigned> oprdIndexes;
     std::string mutOpName;
+    // Sufficient-set mode: names of the replacors implied by this one, that
+    // are not generated
+    std::vector<std::string> impliedMutOpNames;
+
+    friend class llvmMutationOp;
 
   public:
     MutantReplacors(enum ExpElemKeys e, std::vector<unsigned> o, std::string mn)
@@ -182,6 +196,9 @@ public:
     } // second
     inline const std::string &getMutOpName() const { return mutOpName; }
     inline const std::string *getMutOpNamePtr() const { return &mutOpName; }
+    inline const std::vector<std::string> &getImpliedMutOpNames() const {
+      return impliedMutOpNames;
+    }
   };
 
 private:
@@ -219,6 +236,37 @@ public:
     return mutantReplacorsList.at(ind);
   }
   inline unsigned getNumReplacor() const { return mutantReplacorsList.size(); }
+
+  /**
+   * \brief Remove the replacors implied by others (sufficient-set mode).
+   * @param impliedBy gives, for each replacor, the index of the (not implied)
+   * replacor that implies it, or -1. The names of the removed replacors are
+   * recorded in the replacor that implies them.
+   * @return the number of removed replacors.
+   */
+  unsigned removeImpliedReplacors(std::vector<int> const &impliedBy) {
+    assert(impliedBy.size() == mutantReplacorsList.size() &&
+           "Invalid implied replacors list");
+    std::vector<MutantReplacors> kept;
+    std::vector<int> keptIndex(impliedBy.size(), -1);
+    for (unsigned i = 0, ie = impliedBy.size(); i < ie; ++i) {
+      if (impliedBy[i] < 0) {
+        keptIndex[i] = kept.size();
+        kept.push_back(mutantReplacorsList[i]);
+      }
+    }
+    for (unsigned i = 0, ie = impliedBy.size(); i < ie; ++i) {
+      if (impliedBy[i] >= 0) {
+        assert(keptIndex[impliedBy[i]] >= 0 &&
+               "A replacor is implied by an implied replacor");
+        kept[keptIndex[impliedBy[i]]].impliedMutOpNames.push_back(
+            mutantReplacorsList[i].getMutOpName());
+      }
+    }
+    unsigned numRemoved = mutantReplacorsList.size() - kept.size();
+    mutantReplacorsList.swap(kept);
+    return numRemoved;
+  }
   inline enum ExpElemKeys getMatchOp() const { return matchOp; }
   inline enum codeParts getCPType(unsigned pos) const {
     return oprdCPType.at(pos);
@@ -330,6 +378,96 @@ private:
   std::unordered_set<llvm::Function *> funcsToMutate;
   bool initialized;
 
+  // Sorted and disjoint ranges of source lines [first, second] to mutate, per
+  // source file. Empty when the whole functions are mutated
+  std::unordered_map<std::string, std::vector<std::pair<unsigned, unsigned>>>
+      srcLineRanges;
+
+  /// \brief get the source file and line from the src loc @param srcLoc
+  /// @return false if there is no location
+  bool parseSrcLoc(std::string const &srcLoc, std::string &srcFile,
+                   unsigned &line) {
+    std::size_t found = srcLoc.find(":");
+    if (srcLoc.empty() || found == std::string::npos || found == 0)
+      return false;
+    if (matchOnlySrcFilePathBasename)
+      srcFile.assign(getBasename(srcLoc.substr(0, found)));
+    else
+      srcFile.assign(srcLoc.substr(0, found));
+    line = std::strtoul(srcLoc.c_str() + found + 1, nullptr, 10);
+    return true;
+  }
+
+  /// \brief get the source file of function @param Func from its debug info
+  /// subprogram, or else from its first located instruction. Empty if the
+  /// function has no debug info
+  std::string getFunctionSrcFile(llvm::Function &Func) {
+    std::string srcFile;
+#if (LLVM_VERSION_MAJOR >= 4)
+    if (auto *subprogram = Func.getSubprogram())
+      srcFile = subprogram->getFilename().str();
+#endif
+    if (!srcFile.empty())
+      return matchOnlySrcFilePathBasename ? getBasename(srcFile) : srcFile;
+    unsigned line;
+    for (auto &BB : Func)
+      for (auto &Inst : BB)
+        if (parseSrcLoc(UtilsFunctions::getSrcLoc(&Inst), srcFile, line))
+          return srcFile;
+    return "";
+  }
+
+  bool lineInMutationScope(std::string const &srcFile, unsigned line) const {
+    auto it = srcLineRanges.find(srcFile);
+    if (it == srcLineRanges.end())
+      return false;
+    auto &ranges = it->second;
+    auto rIt = std::upper_bound(
+        ranges.begin(), ranges.end(),
+        std::make_pair(line, std::numeric_limits<unsigned>::max()));
+    return (rIt != ranges.begin() && (--rIt)->second >= line);
+  }
+
+  /// \brief Read the "Source-Lines" object of the scope JSON: source file
+  /// name mapped to an array of lines and [first, last] line ranges
+  void loadSrcLineRanges(JsonBox::Object const &linesObj) {
+    for (auto &fileP : linesObj) {
+      assert(fileP.second.isArray() &&
+             "The lines of a source file in Source-Lines must be a JSON array "
+             "of line numbers and [first, last] ranges");
+      std::string srcFile = matchOnlySrcFilePathBasename
+                                ? getBasename(fileP.first)
+                                : fileP.first;
+      auto &ranges = srcLineRanges[srcFile];
+      for (auto &val : fileP.second.getArray()) {
+        if (val.isInteger()) {
+          assert(val.getInteger() > 0 && "Invalid line number in Source-Lines");
+          ranges.emplace_back(val.getInteger(), val.getInteger());
+        } else {
+          assert(val.isArray() && val.getArray().size() == 2 &&
+                 val.getArray()[0].isInteger() &&
+                 val.getArray()[1].isInteger() &&
+                 "A range of lines in Source-Lines must be [first, last]");
+          int first = val.getArray()[0].getInteger();
+          int last = val.getArray()[1].getInteger();
+          assert(first > 0 && first <= last &&
+                 "Invalid range of lines in Source-Lines");
+          ranges.emplace_back(first, last);
+        }
+      }
+      // Sort and merge the overlapping or adjacent ranges
+      std::sort(ranges.begin(), ranges.end());
+      unsigned last = 0;
+      for (auto &r : ranges) {
+        if (last > 0 && r.first <= ranges[last - 1].second + 1)
+          ranges[last - 1].second = std::max(ranges[last - 1].second, r.second);
+        else
+          ranges[last++] = r;
+      }
+      ranges.resize(last);
+    }
+  }
+
 public:
   MutationScope() : initialized(false) {}
 
@@ -414,6 +552,13 @@ public:
         }
       }
 
+      if (!inScope["Source-Lines"].isNull()) {
+        assert(inScope["Source-Lines"].isObject() &&
+               "The Source-Lines to mutate, if present, must be a JSON object "
+               "mapping source file names to arrays of lines");
+        loadSrcLineRanges(inScope["Source-Lines"].getObject());
+      }
+
       /*if (! inScope[""].isNull())
       {
 
@@ -426,37 +571,21 @@ public:
         if (Func.isDeclaration())
           continue;
 
+        // The functions not selected are not read (lazily read module)
+        if (!specFuncs.empty() && specFuncs.count(Func.getName().str()) == 0)
+          continue;
+        if (!ReadWriteIRObj::materialize(Func))
+          assert(false && "Failed to read a function of the module");
+
         bool canMutThisFunc = true;
         if (!specSrcFiles.empty()) {
-          std::string srcOfF;
-          for (auto &BB : Func) {
-            for (auto &Inst : BB) {
-              /// Get Src level LOC
-              std::string tmpSrc = UtilsFunctions::getSrcLoc(&Inst);
-              if (!tmpSrc.empty()) {
-                srcOfF.assign(tmpSrc);
-                assert(srcOfF.length() > 0 && "LOC in source is empty string");
-                break;
-              }
-            }
-            if (srcOfF.length() > 0) {
-              hasDbgIfSrc = true;
-              std::size_t found = srcOfF.find(":");
-              assert(found != std::string::npos && found > 0 &&
-                     "Problem with the src loc info, didn't find the ':'.");
-
-              std::string tmp;
-              if (matchOnlySrcFilePathBasename)
-                tmp.assign(getBasename(srcOfF.substr(0, found)));
-              else
-                tmp.assign(srcOfF.substr(0, found));
-
-              if (specSrcFiles.count(tmp) == 0) {
-                canMutThisFunc = false;
-              } else {
-                seenSrcs.insert(tmp);
-              }
-              break;
+          std::string srcOfF = getFunctionSrcFile(Func);
+          if (srcOfF.length() > 0) {
+            hasDbgIfSrc = true;
+            if (specSrcFiles.count(srcOfF) == 0) {
+              canMutThisFunc = false;
+            } else {
+              seenSrcs.insert(srcOfF);
             }
           }
         }
@@ -489,7 +618,9 @@ public:
           }
         }
       }
-      if (seenSrcs.size() != specSrcFiles.size()) {
+      // Only the sources of the selected functions are seen when some
+      // functions are selected
+      if (specFuncs.empty() && seenSrcs.size() != specSrcFiles.size()) {
         llvm::errs() << "Specified Srcs: ";
         for (auto &s : specSrcFiles)
           llvm::errs() << " " << s;
@@ -500,8 +631,87 @@ public:
         assert(seenSrcs.size() == specSrcFiles.size() &&
                "Some specified sources file are not found in the module.");
       }
+
+      // Only keep the functions having some code in the lines to mutate
+      if (!srcLineRanges.empty()) {
+        for (auto fIt = funcsToMutate.begin(); fIt != funcsToMutate.end();) {
+          if (getFunctionScopeKey(**fIt).empty())
+            fIt = funcsToMutate.erase(fIt);
+          else
+            ++fIt;
+        }
+      }
     }
-    mutateAllFuncs = funcsToMutate.empty();
+    mutateAllFuncs = funcsToMutate.empty() && srcLineRanges.empty();
+  }
+
+  /**
+   * \brief Use the source lines to mutate of @param other, for the mutation
+   * object of a generation worker (whose scope is not initialized)
+   */
+  void copySrcLineRanges(MutationScope const &other) {
+    srcLineRanges = other.srcLineRanges;
+  }
+
+  /**
+   * \brief This method return true if the statement whose IRs are
+   * @param stmtIRs is in the scope: always when no source lines are
+   * specified, otherwise when one of its instructions is located in the lines
+   * to mutate.
+   */
+  bool stmtInMutationScope(std::vector<llvm::Value *> const &stmtIRs) {
+    if (srcLineRanges.empty())
+      return true;
+    std::string srcFile;
+    unsigned line;
+    for (auto *val : stmtIRs) {
+      if (auto *inst = llvm::dyn_cast<llvm::Instruction>(val)) {
+        if (parseSrcLoc(UtilsFunctions::getSrcLoc(inst), srcFile, line) &&
+            lineInMutationScope(srcFile, line))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief This method return true if the basic block @param BB may contain
+   * statements in the scope: always when no source lines are specified,
+   * otherwise when one of its instructions is located in the lines to mutate.
+   */
+  bool basicBlockInMutationScope(llvm::BasicBlock &BB) {
+    if (srcLineRanges.empty())
+      return true;
+    std::string srcFile;
+    unsigned line;
+    for (auto &Inst : BB)
+      if (parseSrcLoc(UtilsFunctions::getSrcLoc(&Inst), srcFile, line) &&
+          lineInMutationScope(srcFile, line))
+        return true;
+    return false;
+  }
+
+  /**
+   * \brief get the source lines of function @param Func that are in the
+   * lines to mutate (used in the mutation cache key), as a string.
+   * The string is empty when no source lines are specified or when none of
+   * the function's code is in the lines to mutate.
+   */
+  std::string getFunctionScopeKey(llvm::Function &Func) {
+    if (srcLineRanges.empty())
+      return "";
+    std::set<std::pair<std::string, unsigned>> inScopeLines;
+    std::string srcFile;
+    unsigned line;
+    for (auto &BB : Func)
+      for (auto &Inst : BB)
+        if (parseSrcLoc(UtilsFunctions::getSrcLoc(&Inst), srcFile, line) &&
+            lineInMutationScope(srcFile, line))
+          inScopeLines.emplace(srcFile, line);
+    std::string ret;
+    for (auto &fl : inScopeLines)
+      ret += fl.first + ":" + std::to_string(fl.second) + ";";
+    return ret;
   }
 
   /**
@@ -675,6 +885,8 @@ public:
  * mutation op, these are not yet attached to the module. Once attached, update
  * @see MutantList
  */
+struct MatchUseful;
+
 struct MutantsOfStmt {
   /// This struct represent the toMatchMutant (Irs BB for the mutants and the
   /// corresponding BB in original)
@@ -823,6 +1035,7 @@ struct MutantsOfStmt {
                             ModuleUserInfos const &MI) {
       assert(empty() &&
              "already have some data, first clear it before cloning into");
+      toMatchIRsMutClone.reserve(toMatch.toMatchIRs.size());
       llvm::SmallDenseMap<llvm::Value *, llvm::Value *> pointerMap;
       for (llvm::Value *I : toMatch.toMatchIRs) {
         // clone instruction
@@ -985,9 +1198,21 @@ struct MutantsOfStmt {
     }
   }; // struct MutantStmtIR
 
+  /// \brief The match of a mutant whose IR is only created on request, with
+  /// the replaceMatch of its matcher (lazy mutant enumeration)
+  struct DeferredMutant {
+    GenericMuOpBase *matcher;
+    unsigned pos;
+    std::shared_ptr<MatchUseful> match;
+    llvmMutationOp::MutantReplacors const *repl;
+  };
+
   struct RawMutantStmt {
     MutantStmtIR mutantStmtIR;
 
+    // Set, with an empty mutantStmtIR, when the IR is created on request
+    std::shared_ptr<DeferredMutant> deferred;
+
     // Mutant type
     std::string typeName;
 
@@ -1000,19 +1225,26 @@ struct MutantsOfStmt {
     // Mutant id
     unsigned id;
 
+    // Types of the mutants implied by this one (sufficient-set mode), owned
+    // by the mutation configuration
+    std::vector<std::string> const *impliedTypeNames;
+
     RawMutantStmt(MutantStmtIR const &toMatchMutant,
                   llvmMutationOp::MutantReplacors const &repl,
-                  std::vector<unsigned> const &relevantPos) {
-      mutantStmtIR = toMatchMutant;
-      typeName = repl.getMutOpName();
-      irRelevantPos = relevantPos;
-      id = 0; // initialize to invalid mutant id value. will be modified during
-              // merging mutant into Module
-    }
+                  std::vector<unsigned> const &relevantPos)
+        : mutantStmtIR(toMatchMutant), typeName(repl.getMutOpName()),
+          irRelevantPos(relevantPos),
+          id(0), // initialize to invalid mutant id value. will be modified
+                 // during merging mutant into Module
+          impliedTypeNames(&repl.getImpliedMutOpNames()) {}
   }; // struct RawMutantStmt
 
   std::vector<RawMutantStmt> results;
 
+  // Whether the matchers that support it record the matches instead of
+  // creating the mutants' IRs (see addDeferred)
+  bool deferIRs = false;
+
   /**
    * \brief This method add a new mutant statement.
    * \detail It computes the corresponding Weak mutation using difference
@@ -1030,8 +1262,23 @@ struct MutantsOfStmt {
     results.emplace_back(toMatchMutant, repl, relevantPos);
   }
 
+  /// \brief add a mutant whose IR is created on request from @param deferred
+  /// (see deferIRs)
+  inline void addDeferred(std::shared_ptr<DeferredMutant> deferred,
+                          std::vector<unsigned> const &relevantPos) {
+    results.emplace_back(MutantStmtIR(), *deferred->repl, relevantPos);
+    results.back().deferred = std::move(deferred);
+  }
+
   inline void clear() { results.clear(); }
 
+  /// \brief remove the mutant at @param index (not yet attached to the
+  /// module) and delete its IRs
+  inline void remove(unsigned index) {
+    results[index].mutantStmtIR.deleteContainedMutant();
+    results.erase(results.begin() + index);
+  }
+
   inline unsigned getNumMuts() { return results.size(); }
 
   inline MutantStmtIR &getMutantStmtIR(unsigned index) {
@@ -1043,6 +1290,9 @@ struct MutantsOfStmt {
   inline const std::vector<unsigned> &getIRRelevantPos(unsigned index) {
     return results[index].irRelevantPos;
   }
+  inline const std::vector<std::string> &getImpliedTypeNames(unsigned index) {
+    return *(results[index].impliedTypeNames);
+  }
   inline void setMutID(unsigned index, unsigned id) {
     assert(results[index].id == 0 && "setting ID twice");
     results[index].id = id;
@@ -1052,6 +1302,9 @@ struct MutantsOfStmt {
     return results[index].id;
   }
   inline bool isEmpty() { return (getNumMuts() == 0); }
+  inline bool isDeferred(unsigned index) {
+    return (results[index].deferred != nullptr);
+  }
 }; //~struct MutantsOfStmt
 
 /**
@@ -1123,6 +1376,7 @@ struct StatementSearch {
   StatementSearch() { clear(); }
   void clear() {
     matchStmtIR.clear();
+    mutantStmt_list.clear();
     visited.clear();
     stmtIRcount = 0;
     atomicityInBB = lastBB = nullptr;
@@ -1179,15 +1433,24 @@ struct MutantInfoList {
     std::vector<unsigned> irLeveLocInFunc;
     std::string srcLevelLoc;
 
+    // Types of the mutants, at the same location, implied by this mutant and
+    // not generated (sufficient-set mode)
+    std::vector<std::string> impliedTypeNames;
+
     MutantInfo(MutantIDType mutant_id, std::string const &type,
                std::string const &funcName, std::vector<unsigned> const &irPos,
-               std::string const &srcLoc)
+               std::string const &srcLoc,
+               std::vector<std::string> const &implied =
+                   std::vector<std::string>())
         : id(mutant_id), typeName(type), locFuncName(funcName),
-          irLeveLocInFunc(irPos), srcLevelLoc(srcLoc) {}
+          irLeveLocInFunc(irPos), srcLevelLoc(srcLoc),
+          impliedTypeNames(implied) {}
 
     MutantInfo(MutantIDType mid, std::vector<llvm::Value *> const &toMatch,
                std::string const &mName, std::vector<unsigned> const &relpos,
-               llvm::Function *curFunc, std::vector<unsigned> const &absPos) {
+               llvm::Function *curFunc, std::vector<unsigned> const &absPos,
+               std::vector<std::string> const &implied)
+        : impliedTypeNames(implied) {
       id = mid;
       typeName = mName;
       locFuncName = curFunc->getName().str();
@@ -1232,7 +1495,7 @@ struct MutantInfoList {
     // ID of the mutant which mutant is dupliacte. if 0, it means it is equivalent mutant.
     MutantIDType duplicateOfID;
 
-    EquivalentDuplicateMutantInfo(MutantInfo const &mi, MutantIDType newid, MutantIDType dupOfId): MutantInfo(newid, mi.typeName, mi.locFuncName, mi.irLeveLocInFunc, mi.srcLevelLoc), duplicateOfID(dupOfId) {}
+    EquivalentDuplicateMutantInfo(MutantInfo const &mi, MutantIDType newid, MutantIDType dupOfId): MutantInfo(newid, mi.typeName, mi.locFuncName, mi.irLeveLocInFunc, mi.srcLevelLoc, mi.impliedTypeNames), duplicateOfID(dupOfId) {}
   };
 
 private:
@@ -1252,13 +1515,14 @@ private:
   void internalAdd(MutantIDType mutant_id, std::string const &type,
                    std::string const &funcName,
                    std::vector<unsigned> const &irPos,
-                   std::string const &srcLoc) {
+                   std::string const &srcLoc,
+                   std::vector<std::string> const &implied) {
     if (wasAdded(mutant_id)) {
       llvm::errs() << "Error: Mutant with ID " << mutant_id
                    << "internally added several time (reading from JSON)\n";
       assert(false);
     }
-    mutants.emplace_back(mutant_id, type, funcName, irPos, srcLoc);
+    mutants.emplace_back(mutant_id, type, funcName, irPos, srcLoc, implied);
     containedMutsIDs.insert(mutant_id);
   }
 
@@ -1315,18 +1579,49 @@ public:
    * @param curFunc is the function containing @param toMatch
    * @param toMatchIRPosInFunc is the list of positions of each IR in toMatch in
    * the function @param curFunc
+   * @param implied is the list of the types of the mutants implied by this
+   * one (sufficient-set mode)
    */
   void add(MutantIDType mid, std::vector<llvm::Value *> const &toMatch,
            std::string const &mName, std::vector<unsigned> const &relpos,
            llvm::Function *curFunc,
-           std::vector<unsigned> const &toMatchIRPosInFunc) {
+           std::vector<unsigned> const &toMatchIRPosInFunc,
+           std::vector<std::string> const &implied) {
     if (wasAdded(mid))
       return;
     mutants.emplace_back(mid, toMatch, mName, relpos, curFunc,
-                         toMatchIRPosInFunc);
+                         toMatchIRPosInFunc, implied);
     containedMutsIDs.insert(mid);
   }
 
+  /**
+   * \brief add the info @param info of a mutant computed elsewhere (e.g. by
+   * the lazy mutant enumeration)
+   */
+  void add(MutantInfo const &info) {
+    internalAdd(info.id, info.typeName, info.locFuncName, info.irLeveLocInFunc,
+                info.srcLevelLoc, info.impliedTypeNames);
+  }
+
+  /**
+   * \brief Append the mutants infos of @param other, which were computed
+   * separately (IDs starting from 1), shifting their IDs by @param idShift.
+   */
+  void appendWithIDShift(MutantInfoList const &other, MutantIDType idShift) {
+    for (auto &info : other.mutants) {
+      MutantIDType mid = info.id + idShift;
+      if (wasAdded(mid)) {
+        llvm::errs() << "Error: Mutant with ID " << mid
+                     << " already added (appendWithIDShift)\n";
+        assert(false);
+      }
+      mutants.emplace_back(mid, info.typeName, info.locFuncName,
+                           info.irLeveLocInFunc, info.srcLevelLoc,
+                           info.impliedTypeNames);
+      containedMutsIDs.insert(mid);
+    }
+  }
+
   /**
    *  \brief remove the TCE's equivalent and duplicate mutants
    */
@@ -1381,6 +1676,17 @@ public:
     return mutants[mutant_id - 1].srcLevelLoc;
   }
 
+  /// \brief the number of mutants implied by the recorded mutants (including
+  /// the equivalent and duplicate ones), that were not generated
+  MutantIDType getImpliedMutantsNumber() const {
+    MutantIDType num = 0;
+    for (auto &info : mutants)
+      num += info.impliedTypeNames.size();
+    for (auto &eqdupinfo : equivalent_duplicate_mutants)
+      num += eqdupinfo.impliedTypeNames.size();
+    return num;
+  }
+
   void printToStdout() const {
     llvm::errs() << "\n~~~~~~~~~ MUTANTS INFOS ~~~~~~~~~\n\nID, Name, SRC "
                     "Location, Function Name\n-------------------\n";
@@ -1393,6 +1699,13 @@ public:
     // outJSON.writeToStream(std::cout, true, true);
   }
 
+  void printToJsonFile(std::string filename) const {
+    JsonBox::Object outJSON;
+    getJson(outJSON);
+    JsonBox::Value vout(outJSON);
+    vout.writeToFile(filename, true, false);
+  }
+
   void printToJsonFile(std::string filename, std::string eqdupfilename) const {
     JsonBox::Object outJSON;
     getJson(outJSON);
@@ -1419,6 +1732,12 @@ public:
         tmparr.push_back(JsonBox::Value((int)pos));
       outJ[mid]["IRPosInFunc"] = tmparr;
       outJ[mid]["SrcLoc"] = JsonBox::Value(info.srcLevelLoc);
+      if (!info.impliedTypeNames.empty()) {
+        JsonBox::Array impliedarr;
+        for (auto &implied : info.impliedTypeNames)
+          impliedarr.push_back(JsonBox::Value(implied));
+        outJ[mid]["Implies"] = impliedarr;
+      }
     }
   }
 
@@ -1436,6 +1755,12 @@ public:
         tmparr.push_back(JsonBox::Value((int)pos));
       outJ[mid]["IRPosInFunc"] = tmparr;
       outJ[mid]["SrcLoc"] = JsonBox::Value(eqdupinfo.srcLevelLoc);
+      if (!eqdupinfo.impliedTypeNames.empty()) {
+        JsonBox::Array impliedarr;
+        for (auto &implied : eqdupinfo.impliedTypeNames)
+          impliedarr.push_back(JsonBox::Value(implied));
+        outJ[mid]["Implies"] = impliedarr;
+      }
 
       outJ[mid]["EquivalenDuplicateOf"] = JsonBox::Value(std::to_string(eqdupinfo.duplicateOfID));
     }
@@ -1446,7 +1771,17 @@ public:
     value_in.loadFromFile(filename);
     assert(value_in.isObject() &&
            "The JSON file data of mutants info must be a JSON object");
-    JsonBox::Object object_in = value_in.getObject();
+    loadFromJson(value_in.getObject());
+    if (fix_missing_srclocs)
+      fixMissingSrcLocs();
+  }
+
+  /**
+   * \brief Load the mutants infos from the JSON object @param in_object,
+   * formated as produced by getJson().
+   */
+  void loadFromJson(JsonBox::Object const &in_object) {
+    JsonBox::Object object_in = in_object;
     MutantIDType num_of_mutants = object_in.size();
     for (MutantIDType mutant_id = 1; mutant_id <= num_of_mutants; ++mutant_id) {
       std::string mutant_id_string(std::to_string(mutant_id));
@@ -1486,10 +1821,20 @@ public:
              "Source Level Loc must be string in JSON");
       std::string srcLoc = srcloc_val.getString();
 
-      internalAdd(mutant_id, type, funcName, irPos, srcLoc);
+      // Optional, present in sufficient-set mode
+      std::vector<std::string> implied;
+      if (mutant_info.count("Implies") > 0) {
+        assert(mutant_info["Implies"].isArray() &&
+               "Implied mutants must be array in JSON");
+        for (JsonBox::Value implied_val : mutant_info["Implies"].getArray()) {
+          assert(implied_val.isString() &&
+                 "Implied mutant Type must be string in JSON");
+          implied.push_back(implied_val.getString());
+        }
+      }
+
+      internalAdd(mutant_id, type, funcName, irPos, srcLoc, implied);
     }
-    if (fix_missing_srclocs)
-      fixMissingSrcLocs();
   }
 }; // struct MutantInfoList
 
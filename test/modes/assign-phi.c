@@ -0,0 +1,10 @@
+int a, b, c, d, m;
+
+/* Only the assignment of 'm' is mutated (assign.conf): the PHI node of the
+ * '&&' flows into the one of the '?:', but its block has no assignment and
+ * keeps it */
+int assign_phi (void)
+{
+    m = a ? (b && c) : d;
+    return m;
+}
@@ -0,0 +1,48 @@
+int g = 3;
+
+static int clamp (int v, int lo, int hi)
+{
+    if (v < lo)
+        return lo;
+    if (v > hi)
+        return hi;
+    return v;
+}
+
+int sum (int *a, int n)
+{
+    int s = 0;
+    for (int i = 0; i < n; i++)
+        s += a[i] * g;
+    return s;
+}
+
+int poly (int x, int y)
+{
+    int r = x * x - 2 * y;
+    r = r + (x / (y | 1)) % 7;
+    if (r > x && y <= 5)
+        r -= x << 2;
+    else
+        r = (r ^ y) & 0xff;
+    return r >= 0 ? r : -r;
+}
+
+int max3 (int x, int y, int z)
+{
+    int m = x > y ? x : y;
+    return m >= z ? m : z;
+}
+
+/* Not called: unreachable from main */
+int unused (int x, int y)
+{
+    return x * 2 + (y > x);
+}
+
+int main ()
+{
+    int a[4] = {1, -2, 3, 4};
+    g = poly (a[0], a[3]);
+    return clamp (sum (a, 4), 0, max3 (a[0], a[1], a[2]) * 10);
+}
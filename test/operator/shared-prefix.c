@@ -0,0 +1,9 @@
+struct S { int f[4]; };
+
+int main ()
+{
+    struct S s[3];
+    int i = 1, j = 2, r;
+    r = s[i].f[j] + s[j].f[i] * 3;
+    return r;
+}
@@ -14,6 +14,7 @@ error_exit()
 testSrcs="${TEST_SRCS:-}"
 example_only="${EXAMPLE_ONLY:-OFF}"
 test_feat_extract="${TEST_FEATURE_EXTRACTION:-OFF}"
+test_modes="${TEST_MODES:-ON}"
 
 [ $# -eq 1 ] || error_exit "Expected 1 argument(build dir), $# passed"
 
@@ -28,6 +29,7 @@ rm -rf "test" || error_exit "Failed to remove existint 'test' dir"
 mkdir -p "test/tmpRunDir" || error_exit "Making 'tmpRunDir'"
 
 cp -r $TOPDIR/operator "test" || error_exit "Failed to copy $TOPDIR/operator into 'test'"
+cp -r $TOPDIR/modes "test" || error_exit "Failed to copy $TOPDIR/modes into 'test'"
 
 #enter
 cd test/tmpRunDir
@@ -81,6 +83,22 @@ do
     $LLVM_DIS -o $filep-out/$filep.preTCE.MetaMu.ll $filep-out/$filep.preTCE.MetaMu.bc || error_exit "llvm-dis failed on $filep-out/$filep.preTCE.MetaMu.bc"
     test -f $filep-out/$filep.WM.bc && { $LLVM_DIS -o $filep-out/$filep.WM.ll $filep-out/$filep.WM.bc || error_exit "llvm-dis failed on $filep-out/wm-$filep.bc" ; }
 
+    # The mutants sharing the leading instructions of a statement are selected by a second switch, check that
+    # the written mutants are still valid and differ from the original
+    if [ "$filep" = "shared-prefix" ]; then
+        grep -q "MART.sharedPrefix_Mut0" $filep-out/$filep.preTCE.MetaMu.ll || error_exit "no shared prefix in $filep-out/$filep.preTCE.MetaMu.ll"
+        $LLVM_DIS -o $filep-out/$filep.orig.ll $filep-out/mutants.out/0/$filep.bc || error_exit "llvm-dis failed on the original of $filep"
+        nWritten=0
+        for mdir in $filep-out/mutants.out/*
+        do
+            [ "$(basename $mdir)" = "0" ] && continue
+            $LLVM_DIS -o $mdir/$filep.ll $mdir/$filep.bc || error_exit "llvm-dis failed on $mdir/$filep.bc"
+            cmp -s $mdir/$filep.bc $filep-out/mutants.out/0/$filep.bc && error_exit "mutant $mdir is identical to the original"
+            nWritten=$(($nWritten + 1))
+        done
+        [ $nWritten -gt 0 ] || error_exit "no mutant written for $filep"
+    fi
+
     # test feature extraction is enabled
     if [ "$test_feat_extract" = "ON" ]; then
         echo " >> $filep mutant features extraction ..."
@@ -90,6 +108,254 @@ do
     echo "==========================="; echo
 done  
 
+# Regression cases of the generation modes, on test/modes/modes.c
+if [ "$example_only" = "OFF" -a "$test_modes" != "OFF" ]; then
+    echo "# Running the generation modes ..."
+    MART=$buildDir/../tools/mart
+    modesbc=$(pwd)/modes.bc
+    $CLANGC -O0 -g -c -emit-llvm -o $modesbc ../modes/modes.c || error_exit "Failed to compile ../modes/modes.c"
+
+    # Mutate modes.bc into the output directory $1, with the options that follow
+    mart_modes()
+    {
+        local outdir=$1
+        shift
+        echo "> modes $*"
+        rm -rf $outdir
+        ( $MART -no-compilation "$@" $modesbc 2>&1 ) > $outdir.log || { printf "\n---\n"; cat $outdir.log; echo "---"; error_exit "mutation of modes.bc failed with the options: $*"; }
+        # The output directory is named after the run (e.g. mart-out-shard0of2-0)
+        mv mart-out-* $outdir || error_exit "Failed to store the output $outdir"
+    }
+
+    # Check that the output directories $1 and $2 have the same meta-mutant module and mutants infos
+    same_outputs()
+    {
+        local d
+        for d in $1 $2
+        do
+            $LLVM_DIS -o - $d/modes.MetaMu.bc | sed '/^; ModuleID/d' > $d/modes.MetaMu.ll || error_exit "llvm-dis failed on $d/modes.MetaMu.bc"
+        done
+        cmp -s $1/modes.MetaMu.ll $2/modes.MetaMu.ll || error_exit "the meta-mutant modules of $1 and $2 differ"
+        cmp -s $1/mutantsInfos.json $2/mutantsInfos.json || error_exit "the mutants infos of $1 and $2 differ"
+        cmp -s $1/equidup-mutantsInfos.json $2/equidup-mutantsInfos.json || error_exit "the TCE verdicts of $1 and $2 differ"
+    }
+
+    # Number of mutants of the output directory $1, before and after the TCE
+    num_pretce_mutants()
+    {
+        grep -o "PreTCE: [0-9]*" $1/info | cut -d' ' -f2
+    }
+    num_posttce_mutants()
+    {
+        grep -o "PostTCE: [0-9]*" $1/info | cut -d' ' -f2
+    }
+
+    mart_modes modes-serial
+
+    # PHI nodes left in blocks that may not get mutants: only the assignment of assign-phi.c is mutated, although
+    # the demotion of the PHI node of its block adds an assignment into the blocks that flow into it
+    $CLANGC -O0 -g -c -emit-llvm -o assign-phi.bc ../modes/assign-phi.c || error_exit "Failed to compile ../modes/assign-phi.c"
+    rm -rf mart-out-* modes-assign-phi
+    ( $MART -no-compilation -mutant-config ../modes/assign.conf assign-phi.bc 2>&1 ) > modes-assign-phi.log || { cat modes-assign-phi.log; error_exit "mutation of assign-phi.bc failed"; }
+    mv mart-out-* modes-assign-phi || error_exit "Failed to store the output modes-assign-phi"
+    assignLine=$(grep -n "^    m = " ../modes/assign-phi.c | cut -d':' -f1)
+    [ $(num_pretce_mutants modes-assign-phi) -eq 1 ] || error_exit "$(num_pretce_mutants modes-assign-phi) mutants in assign-phi.c, instead of 1"
+    grep -q "assign-phi\.c:$assignLine:" modes-assign-phi/mutantsInfos.json || error_exit "the assignment of assign-phi.c is not mutated"
+
+    # Dry run (-dry-run): the estimate has all its keys, and counts the mutant of assign-phi.c, by its type
+    rm -f modes-dry-run.json
+    ( $MART -mutant-config ../modes/assign.conf -dry-run $(pwd)/modes-dry-run.json assign-phi.bc 2>&1 ) > modes-dry-run.log || { cat modes-dry-run.log; error_exit "dry run of assign-phi.bc failed"; }
+    for key in Mutants MutantsByType Functions assign_phi Instructions MutatedStmts MetaModule AddedInstructions BitcodeBytes TCE OptimizedInstructions MaxComparisons
+    do
+        grep -q "\"$key\" *:" modes-dry-run.json || error_exit "no key '$key' in modes-dry-run.json"
+    done
+    mutType=$(grep -o '"Type" *: *"[^"]*"' modes-assign-phi/mutantsInfos.json | cut -d'"' -f4)
+    # The mutants of the function and of the module
+    [ $(grep -c '"Mutants" *: *1,\?$' modes-dry-run.json) -eq 2 ] || error_exit "the dry run did not count 1 mutant in assign-phi.c"
+    [ $(grep -c "\"$mutType\" *: *1,\?\$" modes-dry-run.json) -eq 2 ] || error_exit "the dry run did not count 1 mutant of type '$mutType' in assign-phi.c"
+
+    # Parallel generation (-gen-threads): the output of the serial generation
+    mart_modes modes-gen-threads -gen-threads 3
+    same_outputs modes-serial modes-gen-threads
+
+    # Mutation cache (-mutation-cache): the second run reuses all the functions, with the same output
+    rm -rf modes-mutation-cache.dir
+    mart_modes modes-mutation-cache1 -mutation-cache modes-mutation-cache.dir
+    mart_modes modes-mutation-cache2 -mutation-cache modes-mutation-cache.dir
+    grep -q "^# Mutation cache: \([1-9][0-9]*\) of \1 functions" modes-mutation-cache2/info || error_exit "the second run missed the mutation cache"
+    same_outputs modes-mutation-cache1 modes-mutation-cache2
+
+    # Lazy mutant enumeration (-enumerate-mutants): the IDs and infos of the mutants of the generation, before the TCE
+    mart_modes modes-pretce -print-preTCE-Meta
+    ( $MART -enumerate-mutants $(pwd)/modes-enumerated.json $modesbc 2>&1 ) > modes-enumerated.log || { cat modes-enumerated.log; error_exit "enumeration of the mutants of modes.bc failed"; }
+    [ $(grep -c '"Type"' modes-enumerated.json) -eq $(num_pretce_mutants modes-serial) ] || error_exit "$(grep -c '"Type"' modes-enumerated.json) mutants enumerated, instead of $(num_pretce_mutants modes-serial)"
+    cmp -s modes-pretce/preTCE-mutantsInfos.json modes-enumerated.json || error_exit "the enumerated mutants differ from modes-pretce/preTCE-mutantsInfos.json"
+
+    # Matching statistics (-dump-matching-stats): the mutators indexed by opcode give the same mutants, and no
+    # mutator mutates more statements than it was offered
+    mart_modes modes-matching-stats -dump-matching-stats
+    same_outputs modes-serial modes-matching-stats
+    awk '/"Attempts"/ {gsub(/[^0-9]/, ""); a = $0 + 0}
+         /"Successes"/ {gsub(/[^0-9]/, ""); if ($0 + 0 > a) bad = 1; if ($0 + 0 > 0) mutated = 1}
+         END {exit (bad || !mutated)}' modes-matching-stats/mutatorsMatchStats.json \
+        || error_exit "invalid matching statistics in modes-matching-stats/mutatorsMatchStats.json"
+
+    # Pooled statements and matches: the mutants of a function do not depend on the functions mutated before it
+    nAloneMutants=0
+    for func in clamp sum poly max3 unused main
+    do
+        echo "{\"Functions\": [\"$func\"]}" > modes-scope-$func.json
+        mart_modes modes-alone-$func -mutant-scope modes-scope-$func.json
+        nAloneMutants=$(($nAloneMutants + $(num_pretce_mutants modes-alone-$func)))
+    done
+    [ $nAloneMutants -eq $(num_pretce_mutants modes-serial) ] || error_exit "the functions mutated alone have $nAloneMutants mutants, instead of $(num_pretce_mutants modes-serial)"
+
+    # Lazily read module (with a mutation scope): the output of the module read at once, for both kinds of scope
+    echo '{"Functions": ["poly", "main"]}' > modes-scope-funcs.json
+    echo '{"Source-Files": ["modes.c"]}' > modes-scope-files.json
+    for scope in funcs files
+    do
+        mart_modes modes-lazy-$scope -mutant-scope modes-scope-$scope.json
+        mart_modes modes-eager-$scope -mutant-scope modes-scope-$scope.json -no-lazy-read
+        same_outputs modes-lazy-$scope modes-eager-$scope
+    done
+
+    # Trivially equivalent mutants pruned at generation: fewer mutants, but the same number after the TCE
+    mart_modes modes-no-trivial-pruning -no-trivial-pruning
+    grep -q "^# Trivially equivalent mutants pruned at generation:" modes-serial/info || error_exit "no trivial pruning statistics in modes-serial/info"
+    [ $(num_pretce_mutants modes-serial) -lt $(num_pretce_mutants modes-no-trivial-pruning) ] || error_exit "no trivially equivalent mutant pruned"
+    [ $(num_posttce_mutants modes-serial) -eq $(num_posttce_mutants modes-no-trivial-pruning) ] || error_exit "the trivial pruning changed the mutants left by the TCE"
+
+    # Sufficient-set mode (-sufficient-set): fewer mutants, the implied ones are listed in the mutants infos
+    mart_modes modes-sufficient-set -sufficient-set
+    [ $(num_pretce_mutants modes-sufficient-set) -lt $(num_pretce_mutants modes-serial) ] || error_exit "the sufficient set did not reduce the mutants"
+    grep -q "implied mutants not generated" modes-sufficient-set/info || error_exit "no implied mutants in modes-sufficient-set/info"
+    grep -q '"Implies"' modes-sufficient-set/mutantsInfos.json || error_exit "no implied mutants in modes-sufficient-set/mutantsInfos.json"
+
+    # Mutants sampling (-sample): the same sample for the same seed
+    mart_modes modes-sample1 -sample 30% -sample-seed 7
+    mart_modes modes-sample2 -sample 30% -sample-seed 7
+    [ $(num_pretce_mutants modes-sample1) -lt $(num_pretce_mutants modes-serial) ] || error_exit "the sampling did not reduce the mutants"
+    same_outputs modes-sample1 modes-sample2
+
+    # Source lines in the mutation scope (Source-Lines): only the statements of the lines of 'poly' get mutants
+    polyFirst=$(grep -n "^int poly" ../modes/modes.c | cut -d':' -f1)
+    polyLast=$(awk -v first=$polyFirst 'NR > first && /^}/ {print NR; exit}' ../modes/modes.c)
+    echo "{\"Source-Lines\": {\"modes.c\": [[$polyFirst, $polyLast]]}}" > modes-scope-lines.json
+    mart_modes modes-lines -mutant-scope modes-scope-lines.json
+    [ $(num_pretce_mutants modes-lines) -gt 0 ] || error_exit "no mutant in the lines of poly"
+    [ $(num_pretce_mutants modes-lines) -lt $(num_pretce_mutants modes-serial) ] || error_exit "the source lines did not restrict the mutants"
+    for line in $(grep -o 'modes\.c:[0-9]*' modes-lines/mutantsInfos.json | cut -d':' -f2)
+    do
+        [ $line -ge $polyFirst -a $line -le $polyLast ] || error_exit "mutant at line $line, out of the lines $polyFirst-$polyLast of poly"
+    done
+
+    # Reachability pruning (-entry-functions): only the mutants of 'unused', not called from main, are dropped
+    mart_modes modes-entry -entry-functions main
+    grep -q "^# Unreachable functions: 1, their [1-9][0-9]* mutants pruned" modes-entry/info || error_exit "'unused' not pruned in modes-entry/info"
+    [ $(num_pretce_mutants modes-entry) -eq $(($(num_pretce_mutants modes-serial) - $(num_pretce_mutants modes-alone-unused))) ] || error_exit "the reachability pruning dropped other mutants than those of 'unused'"
+
+    # Utility-based filtering (-utility-model), when Mart is built with the mutant selection (and its models)
+    utilityModel=$buildDir/../tools/useful/trained-models/default-trained.model
+    if [ -f $utilityModel ]; then
+        mart_modes modes-utility -utility-model $utilityModel -utility-budget 20
+        utilityStats=$(grep -o "^# Utility prediction: [0-9]* of [0-9]*" modes-utility/info) || error_exit "no utility prediction statistics in modes-utility/info"
+        nKept=$(echo $utilityStats | cut -d' ' -f4)
+        nPredicted=$(echo $utilityStats | cut -d' ' -f6)
+        # The budget keeps the mutants tied with the last one
+        [ $nKept -ge 20 -a $nKept -lt $nPredicted ] || error_exit "the utility budget of 20 kept $nKept of $nPredicted mutants"
+        [ $(num_pretce_mutants modes-utility) -le $nKept ] || error_exit "more mutants than kept by the utility budget"
+        mart_modes modes-utility2 -utility-model $utilityModel -utility-budget 20
+        same_outputs modes-utility modes-utility2
+    else
+        echo "> skipping -utility-model: no model $utilityModel (Mart built without the mutant selection)"
+    fi
+
+    # Sharded generation (-shard): the merge of the shards gives the output of a single run with function-mode TCE
+    MART_MERGE=$buildDir/../tools/mart-merge
+    mart_modes modes-func -tce-mode function
+    mart_modes modes-shard0 -tce-mode function -shard 0/2
+    mart_modes modes-shard1 -tce-mode function -shard 1/2
+    rm -rf modes-merged
+    ( $MART_MERGE -o modes-merged modes-shard0 modes-shard1 2>&1 ) > modes-merged.log || { cat modes-merged.log; error_exit "mart-merge failed"; }
+    same_outputs modes-func modes-merged
+    n0=$(num_posttce_mutants modes-shard0)
+    n1=$(num_posttce_mutants modes-shard1)
+    grep -q "^## Shard 0 (modes-shard0): mutants 1\.\.$n0\$" modes-merged/info || error_exit "wrong range of shard 0 in modes-merged/info"
+    grep -q "^## Shard 1 (modes-shard1): mutants $((n0 + 1))\.\.$((n0 + n1))\$" modes-merged/info || error_exit "wrong range of shard 1 in modes-merged/info"
+
+    # Telemetry (-trace-file, -progress-file): the spans of the TCE, and an end for the begin of each phase
+    rm -f modes-trace.json modes-progress.jsonl
+    mart_modes modes-telemetry -tce-mode function -trace-file $(pwd)/modes-trace.json -progress-file $(pwd)/modes-progress.jsonl
+    grep -q '"cat":"TCE"' modes-trace.json || error_exit "no TCE span in modes-trace.json"
+    for phase in read mutate TCE write
+    do
+        grep -q "\"type\":\"begin\",\"phase\":\"$phase\"" modes-progress.jsonl || error_exit "no begin of the phase $phase in modes-progress.jsonl"
+        grep -q "\"type\":\"end\",\"phase\":\"$phase\"" modes-progress.jsonl || error_exit "no end of the phase $phase in modes-progress.jsonl"
+    done
+    [ $(grep -c '"type":"begin"' modes-progress.jsonl) -eq $(grep -c '"type":"end"' modes-progress.jsonl) ] || error_exit "unfinished phases in modes-progress.jsonl"
+    grep -q '"type":"progress","phase":"TCE"' modes-progress.jsonl || error_exit "no TCE progress in modes-progress.jsonl"
+
+    # Parallel TCE of the functions (-tce-threads): the verdicts of the serial TCE
+    mart_modes modes-tce-threads -tce-mode function -tce-threads 2
+    same_outputs modes-func modes-tce-threads
+
+    # TCE of a function split across the threads: the verdicts of the serial TCE
+    mart_modes modes-tce-split -tce-mode function -tce-threads 8
+    grep -q "([1-9][0-9]* split)" modes-tce-split.log || error_exit "no function TCE split across the threads in modes-tce-split.log"
+    same_outputs modes-func modes-tce-split
+
+    # Duplicate candidates bucketed by a structural hash: the verdicts of the diffs with all the candidates
+    mart_modes modes-func-no-buckets -tce-mode function -tce-no-hash-buckets
+    same_outputs modes-func modes-func-no-buckets
+    mart_modes modes-module -tce-mode module
+    mart_modes modes-module-no-buckets -tce-mode module -tce-no-hash-buckets
+    same_outputs modes-module modes-module-no-buckets
+
+    # TCE mode: function mode by default, and module mode with -tce-mode auto for a module as small as modes.c
+    same_outputs modes-serial modes-func
+    mart_modes modes-auto -tce-mode auto
+    grep -q "TCE in module mode" modes-auto.log || error_exit "-tce-mode auto did not select module mode in modes-auto.log"
+    same_outputs modes-module modes-auto
+
+    # New pass manager of the TCE (from LLVM 12): the functions optimized by the legacy one, and the same verdicts
+    llvmMajor=$($MART -version 2>&1 | grep -o "LLVM version [0-9]*" | grep -o "[0-9]*$")
+    if [ "${llvmMajor:-0}" -ge 12 ]; then
+        mart_modes modes-pm-check -tce-pass-manager check
+        grep -q "differs from the legacy one's for 0 of the [1-9][0-9]* optimized functions" modes-pm-check/info || error_exit "the pass managers' optimizations differ in modes-pm-check/info"
+        same_outputs modes-func modes-pm-check
+        mart_modes modes-pm-legacy -tce-pass-manager legacy
+        same_outputs modes-func modes-pm-legacy
+    else
+        echo "> skipping -tce-pass-manager: no new pass manager in the TCE with LLVM $llvmMajor"
+    fi
+
+    # TCE verdict cache (-tce-cache): the second run reuses the verdicts, with the same output
+    rm -rf modes-tce-cache.dir
+    mart_modes modes-tce-cache1 -tce-cache modes-tce-cache.dir
+    mart_modes modes-tce-cache2 -tce-cache modes-tce-cache.dir
+    grep -q "^# TCE verdict cache: [1-9][0-9]* of " modes-tce-cache2/info || error_exit "the second run missed the TCE verdict cache"
+    same_outputs modes-func modes-tce-cache1
+    same_outputs modes-tce-cache1 modes-tce-cache2
+
+    # Functions of the mutants built directly from the meta-mutant function in the TCE: those cleaned out of it
+    mart_modes modes-check-materialization -tce-mode function -tce-check-materialization
+    grep -q "differs from the one cleaned out of the meta-mutant function for 0 of the [1-9][0-9]* checked mutants" modes-check-materialization/info || error_exit "the functions of the mutants differ in modes-check-materialization/info"
+    same_outputs modes-func modes-check-materialization
+
+    # Batch mode (-batch): the output of a single run for each mutated module, and a failure for a missing one
+    rm -rf mart-out-* modes-batch modes-batch-missing
+    echo "[{\"Input\": \"$modesbc\", \"OutputDir\": \"modes-batch\"}, {\"Input\": \"$(pwd)/missing.bc\", \"OutputDir\": \"modes-batch-missing\"}]" > modes-batch.json
+    echo "> batch modes-batch.json"
+    ( $MART -no-compilation -batch modes-batch.json -batch-jobs 2 -batch-report $(pwd)/modes-batch-report.json 2>&1 ) > modes-batch.log && { cat modes-batch.log; error_exit "the batch with a missing module succeeded"; }
+    grep -q "^Mart@Progress: batch: 1 of 2 modules mutated" modes-batch.log || { cat modes-batch.log; error_exit "wrong number of mutated modules in modes-batch.log"; }
+    grep -q '"FailedModules" *: *1' modes-batch-report.json || error_exit "the missing module is not reported failed in modes-batch-report.json"
+    [ ! -d modes-batch-missing ] || error_exit "output directory created for the missing module"
+    same_outputs modes-serial modes-batch
+
+    echo "==========================="; echo
+fi
+
 if [ $run_example_on -eq 1 ]; then
     echo "# Running example ..."
     cp -r $TOPDIR/../example . || error_exit "Failed to copy folder $TOPDIR/../example into $(pwd)"
@@ -0,0 +1,570 @@
+/**
+ * -==== Mart-Merge.cpp
+ *
+ *                Mart Multi-Language LLVM Mutation Framework
+ *
+ * This file is distributed under the University of Illinois Open Source
+ * License. See LICENSE.TXT for details.
+ *
+ * \brief     Main source file of the tool merging the output directories of
+ * the shards of a sharded mutant generation (mart -shard <i>/<N>) into a
+ * single output directory.
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>  //mkdir, stat, chmod
+#include <sys/types.h> //mkdir, stat
+#include <vector>
+
+#include "../lib/mutation.h"
+#include "../lib/shardmerger.h"
+#include "../lib/tce.h"
+#include "../lib/typesops.h"
+#include "ReadWriteIRObj.h"
+
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "llvm/Support/CommandLine.h" //llvm::cl
+
+using namespace mart;
+
+#define TOOLNAME "Mart-Merge"
+#include "tools_commondefs.h"
+
+static std::string outputDir("mart-out-");
+static const std::string mutantsFolder("mutants.out");
+static const std::string generalInfo("info");
+static const std::string readmefile("README.md");
+static const std::string fdupesJsonFileName("fdupes_duplicates.json");
+
+#if (LLVM_VERSION_MAJOR >= 4)
+/**
+ * \brief Output directory of a shard and its shard infos (written by mart
+ * -shard, see Mutation::dumpShardInfos)
+ */
+struct ShardOutput {
+  std::string dir;
+  unsigned index = 0;
+  unsigned count = 0;
+  std::string outputName;
+  std::vector<std::string> funcs;
+  MutantIDType preTCEMutants = 0;
+  MutantIDType postTCEMutants = 0;
+  MutantIDType eqDupMutants = 0;
+  ShardMerger::MutantIDNames names;
+};
+
+static bool loadShardOutput(std::string const &dir, ShardOutput &shard) {
+  std::string filename = dir + "/" + shardInfosFileName;
+  if (!llvm::sys::fs::exists(filename)) {
+    llvm::errs() << "Mart@Error: '" << dir
+                 << "' is not the output of a shard (no "
+                 << shardInfosFileName << ")\n";
+    return false;
+  }
+  JsonBox::Value value_in;
+  value_in.loadFromFile(filename);
+  if (!value_in.isObject()) {
+    llvm::errs() << "Mart@Error: invalid shard infos file '" << filename
+                 << "'\n";
+    return false;
+  }
+  JsonBox::Object obj = value_in.getObject();
+  for (const char *key : {"ShardIndex", "ShardCount", "PreTCEMutants",
+                          "PostTCEMutants", "EquivalentDuplicateMutants"})
+    if (!obj[key].isInteger()) {
+      llvm::errs() << "Mart@Error: missing '" << key << "' in '" << filename
+                   << "'\n";
+      return false;
+    }
+  for (const char *key :
+       {"OutputName", "MutantIDSelector", "MutantIDSelectorFunc",
+        "PostMutationPointFunc", "WMLogFunc", "HighestMutantIDGlobal"})
+    if (!obj[key].isString()) {
+      llvm::errs() << "Mart@Error: missing '" << key << "' in '" << filename
+                   << "'\n";
+      return false;
+    }
+  if (!obj["Functions"].isArray()) {
+    llvm::errs() << "Mart@Error: missing 'Functions' in '" << filename
+                 << "'\n";
+    return false;
+  }
+  shard.dir = dir;
+  shard.index = obj["ShardIndex"].getInteger();
+  shard.count = obj["ShardCount"].getInteger();
+  shard.outputName = obj["OutputName"].getString();
+  for (auto &fval : obj["Functions"].getArray())
+    shard.funcs.push_back(fval.getString());
+  shard.preTCEMutants = obj["PreTCEMutants"].getInteger();
+  shard.postTCEMutants = obj["PostTCEMutants"].getInteger();
+  shard.eqDupMutants = obj["EquivalentDuplicateMutants"].getInteger();
+  shard.names.selectorGlobal = obj["MutantIDSelector"].getString();
+  shard.names.selectorFunc = obj["MutantIDSelectorFunc"].getString();
+  shard.names.postMutationPointFunc = obj["PostMutationPointFunc"].getString();
+  shard.names.wmLogFunc = obj["WMLogFunc"].getString();
+  shard.names.highestMutantIDGlobal = obj["HighestMutantIDGlobal"].getString();
+  return true;
+}
+
+/// \brief copy the file @param from into @param to, as a hard link when
+/// possible, keeping its permissions (the mutants' executables)
+static bool copyFile(std::string const &from, std::string const &to) {
+  if (!llvm::sys::fs::create_hard_link(from, to))
+    return true;
+  struct stat st;
+  if (llvm::sys::fs::copy_file(from, to) || stat(from.c_str(), &st) != 0 ||
+      chmod(to.c_str(), st.st_mode) != 0) {
+    llvm::errs() << "Mart@Error: failed to copy '" << from << "' into '" << to
+                 << "'\n";
+    return false;
+  }
+  return true;
+}
+
+static bool copyDirectory(std::string const &from, std::string const &to) {
+  if (mkdir(to.c_str(), 0777) != 0) {
+    llvm::errs() << "Mart@Error: failed to create the directory '" << to
+                 << "'\n";
+    return false;
+  }
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(from, ec), ie; it != ie && !ec;
+       it.increment(ec)) {
+    std::string name = llvm::sys::path::filename(it->path()).str();
+    bool ok = llvm::sys::fs::is_directory(it->path())
+                  ? copyDirectory(it->path(), to + "/" + name)
+                  : copyFile(it->path(), to + "/" + name);
+    if (!ok)
+      return false;
+  }
+  if (ec) {
+    llvm::errs() << "Mart@Error: failed to read the directory '" << from
+                 << "'\n";
+    return false;
+  }
+  return true;
+}
+
+/// \brief @return whether the file @param name exists in the output of all
+/// the shards (warn if it only exists in some of them)
+static bool inAllShards(std::vector<ShardOutput> const &shards,
+                        std::string const &name) {
+  unsigned found = 0;
+  for (auto &shard : shards)
+    found += llvm::sys::fs::exists(shard.dir + "/" + name) ? 1 : 0;
+  if (found > 0 && found < shards.size())
+    llvm::errs() << "Mart@Warning: '" << name << "' is only in some of the "
+                 << "shards, it is not merged\n";
+  return (found == shards.size());
+}
+
+/**
+ * \brief merge the modules '<name><@param suffix>' of the shards into
+ * @param merged. @param preTCE tells whether they have the pre-TCE mutant
+ * IDs. @param merged stays null if the modules were not written.
+ */
+static bool mergeShardModules(std::vector<ShardOutput> const &shards,
+                              llvm::Module const &originalModule,
+                              const char *suffix, bool preTCE,
+                              std::unique_ptr<llvm::Module> &merged) {
+  std::string name = shards[0].outputName + suffix;
+  if (!inAllShards(shards, name))
+    return true;
+  llvm::outs() << "Mart@Progress: merging '" << name << "'...\n";
+  TelemetrySpan mergeSpan("merge " + name, "phase");
+  if (!ReadWriteIRObj::readIR(shards[0].dir + "/" + name, merged))
+    return false;
+  ShardMerger merger(*merged, originalModule, shards[0].names,
+                     preTCE ? "MART.Mutant_preTCEMut" : "MART.Mutant_Mut");
+  MutantIDType idShift =
+      preTCE ? shards[0].preTCEMutants : shards[0].postTCEMutants;
+  for (unsigned s = 1; s < shards.size(); ++s) {
+    std::unique_ptr<llvm::Module> shardModule;
+    if (!ReadWriteIRObj::readIR(shards[s].dir + "/" + name, shardModule) ||
+        !merger.mergeShard(std::move(shardModule), shards[s].funcs,
+                           idShift)) {
+      llvm::errs() << "Mart@Error: failed to merge '" << name
+                   << "' of the shard '" << shards[s].dir << "'\n";
+      return false;
+    }
+    idShift += (preTCE ? shards[s].preTCEMutants : shards[s].postTCEMutants);
+  }
+  merger.setHighestMutantID(idShift);
+  if (llvm::verifyModule(*merged, &llvm::errs())) {
+    llvm::errs() << "Mart@Error: the merged '" << name << "' is invalid\n";
+    return false;
+  }
+  return ReadWriteIRObj::writeIR(merged.get(), outputDir + "/" + name);
+}
+
+/**
+ * \brief write the optimized meta-mutant module, obtained as by Mart from the
+ * merged meta-mutant module @param metaModule: the post mutation point calls
+ * (for KLEE-SEMu) are removed, the module is optimized and linked with the
+ * mutant selector module @param selectorModuleFile. The optimized modules of
+ * the shards cannot be merged since functions of different shards may have
+ * been inlined into each other.
+ */
+static bool writeOptimizedMetaModule(llvm::Module *metaModule,
+                                     ShardMerger::MutantIDNames const &names,
+                                     std::string const &selectorModuleFile,
+                                     std::string const &filename) {
+  std::unique_ptr<llvm::Module> optMod(
+      ReadWriteIRObj::cloneModuleAndRelease(metaModule));
+  if (auto *postPointFunc = optMod->getFunction(names.postMutationPointFunc)) {
+    std::vector<llvm::CallInst *> calls;
+    for (auto *user : postPointFunc->users())
+      if (auto *callI = llvm::dyn_cast<llvm::CallInst>(user))
+        calls.push_back(callI);
+    for (auto *callI : calls)
+      callI->eraseFromParent();
+    if (postPointFunc->use_empty())
+      postPointFunc->eraseFromParent();
+  }
+  // Same optimization level as Mart's for the optimized meta-mutant
+  TCE tce;
+  tce.optimize(*optMod);
+  tce.promoteMemoryToRegisters(*optMod);
+  std::unique_ptr<llvm::Module> selectorModule;
+  if (!ReadWriteIRObj::readIR(selectorModuleFile, selectorModule))
+    return false;
+  if (llvm::Linker::linkModules(*optMod, std::move(selectorModule))) {
+    llvm::errs() << "Mart@Error: failed to link the optimized meta-mutant "
+                    "module with the mutant selector module\n";
+    return false;
+  }
+  return ReadWriteIRObj::writeIR(optMod.get(), filename);
+}
+
+/**
+ * \brief merge the mutants infos of the shards. The equivalent and duplicate
+ * mutants get the IDs following the last mutant, as in Mart's output.
+ */
+static void mergeMutantsInfos(std::vector<ShardOutput> const &shards) {
+  if (!inAllShards(shards, mutantsInfosFileName) ||
+      !inAllShards(shards, equivalentduplicate_mutantsInfosFileName))
+    return;
+  JsonBox::Object infosJ, eqdupJ;
+  MutantIDType idShift = 0, eqDupID = 0;
+  for (auto &shard : shards)
+    eqDupID += shard.postTCEMutants;
+  for (auto &shard : shards) {
+    JsonBox::Value value_in;
+    value_in.loadFromFile(shard.dir + "/" + mutantsInfosFileName);
+    for (auto &mP : value_in.getObject())
+      infosJ[std::to_string(std::stoul(mP.first) + idShift)] = mP.second;
+
+    // Keep the order of the equivalent and duplicate mutants
+    value_in.loadFromFile(shard.dir + "/" +
+                          equivalentduplicate_mutantsInfosFileName);
+    std::map<MutantIDType, JsonBox::Object> shardEqDup;
+    for (auto &mP : value_in.getObject())
+      shardEqDup[std::stoul(mP.first)] = mP.second.getObject();
+    for (auto &eP : shardEqDup) {
+      JsonBox::Object &info = eP.second;
+      std::string dupOf = info["EquivalenDuplicateOf"].getString();
+      if (dupOf != "0")
+        info["EquivalenDuplicateOf"] =
+            JsonBox::Value(std::to_string(std::stoul(dupOf) + idShift));
+      eqdupJ[std::to_string(++eqDupID)] = info;
+    }
+    idShift += shard.postTCEMutants;
+  }
+  JsonBox::Value(infosJ).writeToFile(outputDir + "/" + mutantsInfosFileName,
+                                     true, false);
+  JsonBox::Value(eqdupJ).writeToFile(
+      outputDir + "/" + equivalentduplicate_mutantsInfosFileName, true, false);
+}
+
+/// \brief sum the matching statistics of the mutators over the shards
+static void mergeMutatorsMatchStats(std::vector<ShardOutput> const &shards) {
+  if (!inAllShards(shards, mutatorsMatchStatsFileName))
+    return;
+  JsonBox::Array mergedJ;
+  for (auto &shard : shards) {
+    JsonBox::Value value_in;
+    value_in.loadFromFile(shard.dir + "/" + mutatorsMatchStatsFileName);
+    JsonBox::Array const &statsJ = value_in.getArray();
+    if (mergedJ.empty()) {
+      mergedJ = statsJ;
+      continue;
+    }
+    if (statsJ.size() != mergedJ.size()) {
+      llvm::errs() << "Mart@Warning: the shards have different mutation "
+                      "configurations, the matching statistics are not "
+                      "merged\n";
+      return;
+    }
+    for (unsigned pos = 0; pos < statsJ.size(); ++pos) {
+      JsonBox::Object mutatorJ = mergedJ[pos].getObject();
+      JsonBox::Object shardMutatorJ = statsJ[pos].getObject();
+      for (const char *key : {"Attempts", "Successes"})
+        mutatorJ[key] = JsonBox::Value(mutatorJ[key].getInteger() +
+                                       shardMutatorJ[key].getInteger());
+      mergedJ[pos] = mutatorJ;
+    }
+  }
+  JsonBox::Value(mergedJ).writeToFile(
+      outputDir + "/" + mutatorsMatchStatsFileName, true, false);
+}
+
+/**
+ * \brief copy the mutants' directories of the shards, renamed with the merged
+ * mutant IDs, and merge the on-disk TCE duplicates (fdupes) of the shards.
+ */
+static bool mergeMutantsFolders(std::vector<ShardOutput> const &shards) {
+  if (!inAllShards(shards, mutantsFolder))
+    return true;
+  llvm::outs() << "Mart@Progress: copying the mutants...\n";
+  TelemetrySpan copySpan("copy mutants", "phase");
+  if (mkdir((outputDir + "/" + mutantsFolder).c_str(), 0777) != 0) {
+    llvm::errs() << "Mart@Error: failed to create the mutants directory\n";
+    return false;
+  }
+  bool withFdupes = inAllShards(shards, fdupesJsonFileName);
+  std::map<MutantIDType, JsonBox::Array> fdupes;
+  MutantIDType idShift = 0;
+  for (unsigned s = 0; s < shards.size(); ++s) {
+    auto mergedID = [idShift](std::string const &id) {
+      MutantIDType mid = std::stoul(id);
+      return (mid == 0 ? 0 : mid + idShift);
+    };
+    std::string shardMutantsDir = shards[s].dir + "/" + mutantsFolder;
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator it(shardMutantsDir, ec), ie;
+         it != ie && !ec; it.increment(ec)) {
+      std::string name = llvm::sys::path::filename(it->path()).str();
+      // The original program is the same in all the shards
+      if (name == "0" && s > 0)
+        continue;
+      if (!copyDirectory(it->path(), outputDir + "/" + mutantsFolder + "/" +
+                                         std::to_string(mergedID(name))))
+        return false;
+    }
+    if (ec) {
+      llvm::errs() << "Mart@Error: failed to read the directory '"
+                   << shardMutantsDir << "'\n";
+      return false;
+    }
+    if (withFdupes) {
+      JsonBox::Value value_in;
+      value_in.loadFromFile(shards[s].dir + "/" + fdupesJsonFileName);
+      for (auto &dP : value_in.getObject()) {
+        auto &dups = fdupes[mergedID(dP.first)];
+        for (auto &dup : dP.second.getArray())
+          dups.push_back(
+              JsonBox::Value(std::to_string(mergedID(dup.getString()))));
+      }
+    }
+    idShift += shards[s].postTCEMutants;
+  }
+  if (withFdupes) {
+    JsonBox::Object fdupesJ;
+    for (auto &dP : fdupes)
+      fdupesJ[std::to_string(dP.first)] = dP.second;
+    JsonBox::Value(fdupesJ).writeToFile(outputDir + "/" + fdupesJsonFileName,
+                                        true, false);
+  }
+  return true;
+}
+#endif //#if (LLVM_VERSION_MAJOR >= 4)
+
+int main(int argc, char **argv) {
+// Remove the option we don't want to display in help
+#if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
+  llvm::StringMap<llvm::cl::Option *> optMap;
+  llvm::cl::getRegisteredOptions(optMap);
+#else
+  llvm::StringMap<llvm::cl::Option *> &optMap =
+      llvm::cl::getRegisteredOptions();
+#endif
+  for (auto &option : optMap) {
+    auto optstr = option.getKey();
+    if (!(optstr.startswith("help") || optstr.equals("version")))
+      optMap[optstr]->setHiddenFlag(llvm::cl::Hidden);
+  }
+
+  llvm::cl::list<std::string> shardDirs(
+      llvm::cl::Positional, llvm::cl::OneOrMore,
+      llvm::cl::desc("<output directories of all the shards>"));
+  llvm::cl::opt<std::string> mergedOutputDir(
+      "o",
+      llvm::cl::desc("(Optional) Inexistant merged output directory. Default "
+                     "is the next 'mart-out-<n>'"),
+      llvm::cl::value_desc("directory"), llvm::cl::init(""));
+
+  llvm::cl::opt<std::string> traceFile(
+      "trace-file",
+      llvm::cl::desc("(Optional) Write the duration of the phases into the "
+                     "given file, in the Chrome trace-event format "
+                     "(chrome://tracing, Perfetto)"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> progressFile(
+      "progress-file",
+      llvm::cl::desc("(Optional) Write the start and end of the phases as "
+                     "JSON lines into the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+  llvm::cl::SetVersionPrinter(printVersion);
+
+  llvm::cl::ParseCommandLineOptions(argc, argv, "Mart Shards Merge");
+
+  if (!startTelemetry(traceFile, progressFile))
+    return 1;
+
+#if (LLVM_VERSION_MAJOR <= 3)
+  llvm::errs() << "Mart@Error: merging the shards requires LLVM 4 or later\n";
+  return 1;
+#else
+  time_t totalRunTime = time(NULL);
+
+  /// Load and check the shards infos
+  std::vector<ShardOutput> shards(shardDirs.size());
+  for (unsigned s = 0; s < shardDirs.size(); ++s)
+    if (!loadShardOutput(shardDirs[s], shards[s]))
+      return 1;
+  std::sort(shards.begin(), shards.end(),
+            [](ShardOutput const &a, ShardOutput const &b) {
+              return a.index < b.index;
+            });
+  for (unsigned s = 0; s < shards.size(); ++s) {
+    if (shards[s].count != shards.size() || shards[s].index != s) {
+      llvm::errs() << "Mart@Error: expected the outputs of the "
+                   << shards[0].count << " shards, each once (got shard "
+                   << shards[s].index << " of " << shards[s].count << " from '"
+                   << shards[s].dir << "')\n";
+      return 1;
+    }
+    if (shards[s].outputName != shards[0].outputName ||
+        shards[s].names.selectorGlobal != shards[0].names.selectorGlobal ||
+        shards[s].names.selectorFunc != shards[0].names.selectorFunc ||
+        shards[s].names.postMutationPointFunc !=
+            shards[0].names.postMutationPointFunc) {
+      llvm::errs() << "Mart@Error: the shard '" << shards[s].dir
+                   << "' is not from the same input module as '"
+                   << shards[0].dir << "'\n";
+      return 1;
+    }
+  }
+
+  /// Create the output directory
+  struct stat st;
+  if (mergedOutputDir.empty()) {
+    int dcount = 0;
+    while (stat((outputDir + std::to_string(dcount)).c_str(), &st) != -1)
+      dcount++;
+    outputDir += std::to_string(dcount);
+  } else {
+    outputDir = mergedOutputDir;
+    if (stat(outputDir.c_str(), &st) != -1) {
+      llvm::errs() << "Mart@Error: the output directory '" << outputDir
+                   << "' already exists\n";
+      return 1;
+    }
+  }
+  if (mkdir(outputDir.c_str(), 0777) != 0) {
+    llvm::errs() << "Mart@Error: failed to create the output directory '"
+                 << outputDir << "'\n";
+    return 1;
+  }
+
+  /// The preprocessed input module is the same for all the shards, only the
+  /// names of its global values are needed
+  std::string outFile = shards[0].outputName;
+  std::string originalFile = shards[0].dir + "/" + outFile + commonIRSuffix;
+  std::unique_ptr<llvm::Module> originalModule;
+  if (!ReadWriteIRObj::readIR(originalFile, originalModule, true /*lazy*/) ||
+      !copyFile(originalFile, outputDir + "/" + outFile + commonIRSuffix))
+    return 1;
+
+  /// Merge the modules
+  std::unique_ptr<llvm::Module> mergedModule;
+  if (!mergeShardModules(shards, *originalModule, preTCEMetaIRFileSuffix,
+                         true /*preTCE*/, mergedModule))
+    return 1;
+  for (const char *suffix : {wmOutIRFileSuffix, covOutIRFileSuffix}) {
+    mergedModule.reset(nullptr);
+    if (!mergeShardModules(shards, *originalModule, suffix, false,
+                           mergedModule))
+      return 1;
+  }
+  mergedModule.reset(nullptr);
+  if (!mergeShardModules(shards, *originalModule, metaMuIRFileSuffix, false,
+                         mergedModule))
+    return 1;
+  if (inAllShards(shards, outFile + optimizedMetaMuIRFileSuffix)) {
+    if (!mergedModule) {
+      llvm::errs() << "Mart@Warning: the optimized meta-mutant module is "
+                      "computed from the meta-mutant module, which the "
+                      "shards did not write\n";
+    } else {
+      llvm::outs() << "Mart@Progress: optimizing the merged meta-mutant...\n";
+      TelemetrySpan optimizeSpan("optimize", "phase");
+      if (!writeOptimizedMetaModule(
+              mergedModule.get(), shards[0].names,
+              getUsefulAbsPath(argv[0]) + "metamutant_selector.bc",
+              outputDir + "/" + outFile + optimizedMetaMuIRFileSuffix))
+        return 1;
+    }
+  }
+  mergedModule.reset(nullptr);
+
+  /// Merge the mutants infos and the mutants
+  mergeMutantsInfos(shards);
+  mergeMutatorsMatchStats(shards);
+  if (!mergeMutantsFolders(shards))
+    return 1;
+
+  /// Write the infos
+  MutantIDType numPreTCE = 0, numPostTCE = 0;
+  for (auto &shard : shards) {
+    numPreTCE += shard.preTCEMutants;
+    numPostTCE += shard.postTCEMutants;
+  }
+  std::ofstream infoStream(outputDir + "/" + generalInfo);
+  if (!infoStream.is_open()) {
+    llvm::errs() << "Unable to create info file:"
+                 << outputDir + "/" + generalInfo << "\n\n";
+    return 1;
+  }
+  infoStream << "# Merged from " << shards.size() << " shards\n";
+  infoStream << "\n# Number of Mutants:   PreTCE: " << numPreTCE
+             << ", PostTCE: " << numPostTCE << "\n";
+  MutantIDType idShift = 0;
+  for (auto &shard : shards) {
+    infoStream << "\n## Shard " << shard.index << " (" << shard.dir
+               << "): mutants " << idShift + 1 << ".."
+               << idShift + shard.postTCEMutants << "\n";
+    idShift += shard.postTCEMutants;
+    std::ifstream shardInfo(shard.dir + "/" + generalInfo);
+    if (shardInfo.is_open())
+      infoStream << shardInfo.rdbuf();
+  }
+  infoStream.close();
+
+  std::ofstream readme(outputDir + "/" + readmefile);
+  if (readme.is_open()) {
+    readme << "## Informations obout the output directory.\n";
+    readme << "```\nThis directory merges the outputs of " << shards.size()
+           << " shards of a mutant generation (mart -shard). The mutants of "
+           << "the shards are renumbered in the order of the shards, which "
+           << "follows the functions order of the module. The files are those "
+           << "of the output of Mart (see the README of a shard), the "
+           << "bitcode files are not compiled.\n```\n";
+    readme.close();
+  }
+
+  llvm::outs() << "\nMart@Progress:  TOTAL RUNTIME: "
+               << (difftime(time(NULL), totalRunTime) / 60) << " min.\n";
+  llvm::outs() << "Mart@Progress: merged " << numPostTCE << " mutants into '"
+               << outputDir << "'\n";
+  return 0;
+#endif //#if (LLVM_VERSION_MAJOR <= 3)
+}
@@ -199,10 +199,25 @@ int main(int argc, char **argv) {
       "do-random-selection",
       llvm::cl::desc("(optional) enable random selection"));
 
+  llvm::cl::opt<std::string> traceFile(
+      "trace-file",
+      llvm::cl::desc("(Optional) Write the duration of the phases into the "
+                     "given file, in the Chrome trace-event format "
+                     "(chrome://tracing, Perfetto)"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> progressFile(
+      "progress-file",
+      llvm::cl::desc("(Optional) Write the start and end of the phases as "
+                     "JSON lines into the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
   llvm::cl::SetVersionPrinter(printVersion);
 
   llvm::cl::ParseCommandLineOptions(argc, argv, "Mart Mutant Selection");
 
+  if (!startTelemetry(traceFile, progressFile))
+    return 1;
+
   time_t totalRunTime = time(NULL);
   clock_t curClockTime;
 
@@ -272,6 +287,7 @@ int main(int argc, char **argv) {
   llvm::Module *moduleM;
   std::unique_ptr<llvm::Module> _M;
 
+  TelemetrySpan readSpan("read", "phase");
   // Read IR into moduleM
   /// llvm::LLVMContext context;
   if (!ReadWriteIRObj::readIR(inputIRfile, _M))
@@ -281,6 +297,7 @@ int main(int argc, char **argv) {
 
   MutantInfoList mutantInfo;
   mutantInfo.loadFromJsonFile(mutantInfoJsonfile, true /*fix_missing_srclocs*/);
+  readSpan.end();
 
   std::string outDir(martOutTopDir);
   outDir = outDir + "/" + selectionFolder;
@@ -309,8 +326,10 @@ int main(int argc, char **argv) {
 
   llvm::outs() << "Computing mutant dependencies...\n";
   curClockTime = clock();
+  TelemetrySpan dependenciesSpan("dependencies", "phase");
   MutantSelection selection(*moduleM, mutantInfo, mutDepCacheName, rundg,
                             false /*is flow-sensitive?*/, disable_selection);
+  dependenciesSpan.end();
   llvm::outs() << "Mart@Progress: dependencies construction took: "
                << (float)(clock() - curClockTime) / CLOCKS_PER_SEC
                << " Seconds.\n";
@@ -409,6 +428,7 @@ int main(int argc, char **argv) {
     if (doSmart) {
       llvm::outs() << "Doing Smart Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("Smart Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -433,6 +453,7 @@ int main(int argc, char **argv) {
     if (doMLOnly) {
       llvm::outs() << "Doing ML Only Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("ML Only Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -464,6 +485,7 @@ int main(int argc, char **argv) {
     if (doEquivalentMutants) {
       llvm::outs() << "Doing Equivalent mutants detection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("Equivalent mutants detection", "phase");
       cachedPrediction.clear();
 
       selectedMutants1.clear();
@@ -486,6 +508,7 @@ int main(int argc, char **argv) {
     if (doSubsumingMutants) {
       llvm::outs() << "Doing Subsuming mutants detection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("Subsuming mutants detection", "phase");
       cachedPrediction.clear();
 
       selectedMutants1.clear();
@@ -508,6 +531,7 @@ int main(int argc, char **argv) {
     if (doHardtokillMutants) {
       llvm::outs() << "Doing Hardtokill mutants detection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("Hardtokill mutants detection", "phase");
       cachedPrediction.clear();
 
       selectedMutants1.clear();
@@ -530,6 +554,7 @@ int main(int argc, char **argv) {
     if (doMCLOnly) {
       llvm::outs() << "Doing MCL Only Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("MCL Only Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -553,6 +578,7 @@ int main(int argc, char **argv) {
     if (doISSTA2017) {
       llvm::outs() << "Doing ISSTA2017 Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("ISSTA2017 Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -576,6 +602,7 @@ int main(int argc, char **argv) {
     if (doMutTypeOnly) {
       llvm::outs() << "Doing MutTypeOnly Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("MutTypeOnly Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -599,6 +626,7 @@ int main(int argc, char **argv) {
     if (doDefectPrediction) {
       llvm::outs() << "Doing defectPrediction Selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("defectPrediction Selection", "phase");
       selectedMutants1.clear();
       selectedMutants1.resize(numberOfRandomSelections);
       // std::vector<double> selectedScores;
@@ -622,6 +650,8 @@ int main(int argc, char **argv) {
     if (doRandom) {
       llvm::outs() << "Doing dummy and spread random selection...\n";
       curClockTime = clock();
+      TelemetrySpan selectionSpan("dummy and spread random selection",
+                                  "phase");
       selectedMutants1.clear();
       selectedMutants2.clear();
       selectedMutants1.resize(numberOfRandomSelections);
@@ -360,11 +360,26 @@ int main(int argc, char **argv) {
       llvm::cl::desc(
           "(Required) Specify the filepath of the file containing the mutants to use for training. each row has: <projectID> <list of mutants>"));
 
+  llvm::cl::opt<std::string> traceFile(
+      "trace-file",
+      llvm::cl::desc("(Optional) Write the duration of the phases into the "
+                     "given file, in the Chrome trace-event format "
+                     "(chrome://tracing, Perfetto)"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> progressFile(
+      "progress-file",
+      llvm::cl::desc("(Optional) Write the start and end of the phases as "
+                     "JSON lines into the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
   llvm::cl::SetVersionPrinter(printVersion);
 
   llvm::cl::ParseCommandLineOptions(argc, argv,
                                     "Mart Mutant Selection Training");
 
+  if (!startTelemetry(traceFile, progressFile))
+    return 1;
+
   std::vector<std::tuple<std::string, std::string, std::string>> programTrainSets;
 
   // Make sure that only one of equivalent, subsuming and hard to kill is used
@@ -461,8 +476,11 @@ int main(int argc, char **argv) {
 
   std::vector<std::string> selectedProjectIDs;
   std::vector<std::string> projectIDPerRow;
+  TelemetrySpan loadSpan("load", "phase");
+  unsigned long numLoaded = 0;
   // for (auto &pair: programTrainSets) {
   for (auto posindex : selectedPrograms) {
+    Telemetry::get().progress("load", numLoaded++, selectedPrograms.size());
     auto &triple = programTrainSets.at(posindex);
     tmpXmapmatrix.clear();
     tmpYvector.clear();
@@ -491,6 +509,8 @@ int main(int argc, char **argv) {
     }
   }
 
+  Telemetry::get().progress("load", numLoaded, selectedPrograms.size());
+  loadSpan.end();
   project2consideredMuts.clear();
 
   llvm::outs() << "# CSVs Loaded. Preparing training data ...\n";
@@ -656,8 +676,10 @@ int main(int argc, char **argv) {
 
   llvm::outs() << "# X Matrix and Y Vector ready. Training ...\n";
 
+  TelemetrySpan trainSpan("train", "phase");
   PredictionModule predmod(outputModelFilename);
   std::map<unsigned long, double> featuresScores = predmod.train(Xmatrix, featuresnames, Yvector, Weightsvector, treesNumber, treesDepth);
+  trainSpan.end();
 
   // Get features relevance weights
   std::string modelInfosFilename(outputModelFilename+".infos.json");
@@ -665,9 +687,11 @@ int main(int argc, char **argv) {
   
 
   // Check prediction score
+  TelemetrySpan checkSpan("check", "phase");
   std::vector<float> scores;
   predmod.predict(Xmatrix, featuresnames, scores);
   checkPredictionScore (Yvector, scores);
+  checkSpan.end();
   
   std::cout << "\n# Training completed, model written to file "
             << outputModelFilename << "\n\n";
@@ -72,21 +72,38 @@ int main(int argc, char **argv) {
   llvm::cl::opt<bool> verbose(
       "verbose", llvm::cl::desc("(Optional) Enable verbose execution (printing info)"));
 
+  llvm::cl::opt<std::string> traceFile(
+      "trace-file",
+      llvm::cl::desc("(Optional) Write the duration of the phases into the "
+                     "given file, in the Chrome trace-event format "
+                     "(chrome://tracing, Perfetto)"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> progressFile(
+      "progress-file",
+      llvm::cl::desc("(Optional) Write the start and end of the phases as "
+                     "JSON lines into the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
   llvm::cl::SetVersionPrinter(printVersion);
 
   llvm::cl::ParseCommandLineOptions(argc, argv, "Mart Mutantion");
 
+  if (!startTelemetry(traceFile, progressFile))
+    return 1;
+
   time_t totalRunTime = time(NULL);
 
   /// Load both BC modules
   llvm::Module *moduleOrig, *moduleMeta;
   std::unique_ptr<llvm::Module> _MOrig, _MMeta;
+  TelemetrySpan readSpan("read", "phase");
   if (!ReadWriteIRObj::readIR(inputOriginalBc, _MOrig))
     return 1;
   moduleOrig = _MOrig.get();
   if (!ReadWriteIRObj::readIR(inputMetaMuBc, _MMeta))
     return 1;
   moduleMeta = _MMeta.get();
+  readSpan.end();
   
   /// Create Mutation object
   std::string useful_conf_dir = getUsefulAbsPath(argv[0]);
@@ -150,8 +167,11 @@ int main(int argc, char **argv) {
       !outFile.substr(outFile.length() - 3, 3).compare(".bc"))
     outFile.replace(outFile.length() - 3, 3, "");
 
+  TelemetrySpan writeSpan("write", "phase");
   MutantIDType ind = 1;
+  unsigned long numWritten = 0;
   for (auto mid: cand_mut_ids) {
+    Telemetry::get().progress("write", numWritten++, cand_mut_ids.size());
     if (verbose) {
       llvm::outs() << "# Writing Mutant " << mid 
 	      		<< ". (" << ind << "/" << cand_mut_ids.size() << ").\n";
@@ -184,6 +204,8 @@ int main(int argc, char **argv) {
       return 1;
     }
   }
+  Telemetry::get().progress("write", numWritten, cand_mut_ids.size());
+  writeSpan.end();
 
   llvm::outs() << "\nMart-Utils@Progress:  TOTAL RUNTIME: "
                << (difftime(time(NULL), totalRunTime) / 60) << " min.\n";
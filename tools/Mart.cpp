@@ -10,17 +10,23 @@
  * possibly selection.
  */
 
+#include <cerrno>
+#include <chrono>
 #include <ctime>
 #include <fstream>
 #include <libgen.h> //basename
+#include <map>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>  //mkdir, stat
 #include <sys/types.h> //mkdir, stat
 #include <sys/wait.h>  //wait
+#include <tuple>       //std::tie
 #include <unistd.h>    // fork, execl
 
+#include "../lib/memoryusage.h"
 #include "../lib/mutation.h"
+#include "../lib/tce.h"
 #include "ReadWriteIRObj.h"
 
 #include "llvm/Support/FileSystem.h"       //for llvm::sys::fs::create_link
@@ -30,6 +36,16 @@
 
 #include "llvm/Support/CommandLine.h" //llvm::cl
 
+#ifdef MART_UTILITY_PREDICTION
+#include <mutex>
+
+#include "../lib/mutantsSelection/MutantSelection.h"
+#include "../lib/mutantutilityfilter.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#endif //#ifdef MART_UTILITY_PREDICTION
+
 using namespace mart;
 
 #define TOOLNAME "Mart"
@@ -43,6 +59,48 @@ static std::stringstream loginfo;
 static std::string outFile;
 static const std::string tmpFuncModuleFolder("tmp-func-module-dir.tmp");
 
+#ifdef MART_UTILITY_PREDICTION
+/**
+ * \brief Utility predictor using a model trained with mart-training
+ */
+class TrainedModelUtilityPredictor : public MutantUtilityPredictor {
+  selection::PredictionModule predictionModule;
+  std::string modelFile;
+  std::string modelId;
+  // The classifier is not thread safe
+  std::mutex predictMutex;
+
+public:
+  TrainedModelUtilityPredictor(std::string const &filename)
+      : predictionModule(filename), modelFile(filename) {}
+
+  bool load() {
+    auto bufOrErr = llvm::MemoryBuffer::getFile(modelFile);
+    if (!bufOrErr || !predictionModule.loadModel()) {
+      llvm::errs() << "Mart@Error: failed to load the utility model '"
+                   << modelFile << "'\n";
+      return false;
+    }
+    // The model is identified by its content
+    llvm::MD5 hash;
+    hash.update(bufOrErr.get()->getBuffer());
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    modelId = str.str().str();
+    return true;
+  }
+
+  float predict(std::unordered_map<std::string, float> const &features) override {
+    std::lock_guard<std::mutex> lock(predictMutex);
+    return predictionModule.predictOne(features);
+  }
+
+  std::string getModelId() const override { return modelId; }
+}; // class TrainedModelUtilityPredictor
+#endif //#ifdef MART_UTILITY_PREDICTION
+
 //void insertMutSelectGetenv(llvm::Module *mod) {
   // insert getenv and atol
 //}
@@ -271,6 +329,284 @@ bool dumpMutantsCallback(Mutation *mutEng,
   return true;
 }
 
+/**
+ * \brief enumerate the mutants of the module of @param mut with
+ * MutantEnumerator (without building the meta-mutant module) and write their
+ * infos into the JSON file @param filename, as the mutants infos of doMutate
+ * before TCE.
+ */
+static bool enumerateMutants(Mutation &mut, std::string const &filename) {
+  MutantEnumerator enumerator(mut);
+  if (!enumerator.initialize())
+    return false;
+  MutantInfoList infos;
+  while (auto const *stmt = enumerator.nextStatement())
+    for (unsigned i = 0, ie = stmt->getNumMutants(); i < ie; ++i)
+      infos.add(stmt->getMutantInfo(i));
+  infos.printToJsonFile(filename);
+  llvm::outs() << "Mart@Progress: enumerated " << infos.getMutantsNumber()
+               << " mutants into " << filename << "\n";
+  return true;
+}
+
+/// \brief result of the mutation of a module in batch mode
+struct BatchModuleResult {
+  std::string outputDir;
+  unsigned preTCEMutants = 0;
+  unsigned postTCEMutants = 0;
+};
+
+/// \brief module of the batch mode manifest (-batch), and its mutation
+struct BatchModule {
+  std::string inputIRfile;
+  std::string mutantScopeJsonfile;
+  // Empty for the next 'mart-out-<n>'
+  std::string outputDir;
+
+  bool mutated = false;
+  std::string status;
+  double seconds = 0;
+  BatchModuleResult result;
+
+  // In the process of the module: the pipe of its result to the batch
+  // process, and its telemetry span
+  int resultFd = -1;
+  std::unique_ptr<TelemetrySpan> span;
+};
+
+static bool loadBatchManifest(std::string const &filename,
+                              std::vector<BatchModule> &modules) {
+  if (!llvm::sys::fs::exists(filename)) {
+    llvm::errs() << "Mart@Error: the batch manifest '" << filename
+                 << "' does not exist\n";
+    return false;
+  }
+  JsonBox::Value value_in;
+  value_in.loadFromFile(filename);
+  if (!value_in.isArray() || value_in.getArray().empty()) {
+    llvm::errs() << "Mart@Error: the batch manifest '" << filename
+                 << "' must be a non empty list of modules\n";
+    return false;
+  }
+  std::map<std::string, unsigned> posByOutputDir;
+  for (auto &entry : value_in.getArray()) {
+    JsonBox::Object obj;
+    if (entry.isObject())
+      obj = entry.getObject();
+    if (!obj["Input"].isString() ||
+        (obj.count("MutantScope") > 0 && !obj["MutantScope"].isString()) ||
+        (obj.count("OutputDir") > 0 && !obj["OutputDir"].isString())) {
+      llvm::errs() << "Mart@Error: invalid module " << modules.size()
+                   << " in the batch manifest (expected the string 'Input', "
+                      "and optionally 'MutantScope' and 'OutputDir')\n";
+      return false;
+    }
+    modules.emplace_back();
+    BatchModule &batchModule = modules.back();
+    batchModule.inputIRfile = obj["Input"].getString();
+    if (obj.count("MutantScope") > 0)
+      batchModule.mutantScopeJsonfile = obj["MutantScope"].getString();
+    if (obj.count("OutputDir") > 0) {
+      batchModule.outputDir = obj["OutputDir"].getString();
+      if (!posByOutputDir.emplace(batchModule.outputDir, modules.size() - 1)
+               .second) {
+        llvm::errs() << "Mart@Error: several modules of the batch manifest "
+                        "have the output directory '"
+                     << batchModule.outputDir << "'\n";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// \brief print the consolidated report of the batch and, if
+/// @param reportFile is not empty, write it as JSON
+static void reportBatch(std::vector<BatchModule> const &modules,
+                        double setupSeconds, double totalSeconds,
+                        std::string const &reportFile) {
+  unsigned numMutated = 0;
+  unsigned long numPreTCE = 0, numPostTCE = 0;
+  JsonBox::Array modulesJ;
+  llvm::outs() << "\nMart@Progress: batch report:\n";
+  for (auto &batchModule : modules) {
+    if (batchModule.mutated) {
+      ++numMutated;
+      numPreTCE += batchModule.result.preTCEMutants;
+      numPostTCE += batchModule.result.postTCEMutants;
+    }
+    llvm::outs() << "  " << batchModule.inputIRfile << ": "
+                 << batchModule.status << ", " << batchModule.seconds
+                 << " Seconds";
+    if (batchModule.mutated)
+      llvm::outs() << ", mutants PreTCE: " << batchModule.result.preTCEMutants
+                   << ", PostTCE: " << batchModule.result.postTCEMutants
+                   << ", in '" << batchModule.result.outputDir << "'";
+    llvm::outs() << "\n";
+
+    JsonBox::Object moduleJ;
+    moduleJ["Input"] = JsonBox::Value(batchModule.inputIRfile);
+    moduleJ["OutputDir"] = JsonBox::Value(batchModule.result.outputDir);
+    moduleJ["Status"] = JsonBox::Value(batchModule.status);
+    moduleJ["Seconds"] = JsonBox::Value(batchModule.seconds);
+    moduleJ["PreTCEMutants"] =
+        JsonBox::Value((int)batchModule.result.preTCEMutants);
+    moduleJ["PostTCEMutants"] =
+        JsonBox::Value((int)batchModule.result.postTCEMutants);
+    modulesJ.push_back(moduleJ);
+  }
+  llvm::outs() << "Mart@Progress: batch: " << numMutated << " of "
+               << modules.size() << " modules mutated (mutants PreTCE: "
+               << numPreTCE << ", PostTCE: " << numPostTCE << "), setup took "
+               << setupSeconds << " Seconds, TOTAL RUNTIME: "
+               << (totalSeconds / 60) << " min.\n";
+
+  if (!reportFile.empty()) {
+    JsonBox::Object reportJ;
+    reportJ["Modules"] = modulesJ;
+    reportJ["MutatedModules"] = JsonBox::Value((int)numMutated);
+    reportJ["FailedModules"] =
+        JsonBox::Value((int)(modules.size() - numMutated));
+    reportJ["PreTCEMutants"] = JsonBox::Value((int)numPreTCE);
+    reportJ["PostTCEMutants"] = JsonBox::Value((int)numPostTCE);
+    reportJ["SetupSeconds"] = JsonBox::Value(setupSeconds);
+    reportJ["TotalSeconds"] = JsonBox::Value(totalSeconds);
+    JsonBox::Value(reportJ).writeToFile(reportFile, true, false);
+  }
+}
+
+/**
+ * \brief mutate each module of @param modules in a process forked from this
+ * one, which did the setup, with at most @param numJobs processes at once.
+ * The processes send their result through a pipe (sendBatchResult).
+ * @return in the process of each module, that module, whose mutation goes on
+ * in the caller. In this process, nullptr once all the modules are mutated
+ * and reported (into @param reportFile if not empty), with the number of
+ * those that failed as @param exitCode.
+ */
+static BatchModule *
+runBatch(std::vector<BatchModule> &modules, unsigned numJobs,
+         std::chrono::steady_clock::time_point setupStartTime,
+         std::string const &reportFile, int &exitCode) {
+  typedef std::chrono::steady_clock::time_point TimePoint;
+  struct Job {
+    unsigned modulePos;
+    int resultFd;
+    TimePoint startTime;
+  };
+  std::map<pid_t, Job> running;
+  unsigned nextPos = 0, numFailed = 0, numDone = 0;
+  numJobs = std::max(1u, numJobs);
+  double setupSeconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - setupStartTime)
+                            .count();
+
+  while (nextPos < modules.size() || !running.empty()) {
+    if (nextPos < modules.size() && running.size() < numJobs) {
+      llvm::outs() << "Mart@Progress: batch: mutating '"
+                   << modules[nextPos].inputIRfile << "' (" << (nextPos + 1)
+                   << "/" << modules.size() << ")...\n";
+      // Do not let the child process print the buffered output again
+      llvm::outs().flush();
+      int fds[2];
+      if (pipe(fds) != 0) {
+        perror("pipe failure");
+        exit(1);
+      }
+      pid_t pid = fork();
+      if (pid < 0) {
+        perror("fork failure");
+        exit(1);
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        BatchModule &batchModule = modules[nextPos];
+        batchModule.resultFd = fds[1];
+        batchModule.span.reset(new TelemetrySpan(
+            "module", "batch",
+            "{\"file\":" + Telemetry::quote(batchModule.inputIRfile) + "}"));
+        return &batchModule;
+      }
+      close(fds[1]);
+      running[pid] = {nextPos, fds[0], std::chrono::steady_clock::now()};
+      ++nextPos;
+      continue;
+    }
+
+    int childStatus;
+    pid_t pid = waitpid(-1, &childStatus, 0);
+    if (pid < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("wait failure");
+      exit(1);
+    }
+    auto jobIt = running.find(pid);
+    if (jobIt == running.end())
+      continue;
+    Job const &job = jobIt->second;
+    BatchModule &batchModule = modules[job.modulePos];
+    batchModule.seconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - job.startTime)
+                              .count();
+    std::string resultStr;
+    char buf[512];
+    ssize_t nRead;
+    while ((nRead = read(job.resultFd, buf, sizeof(buf))) > 0)
+      resultStr.append(buf, nRead);
+    close(job.resultFd);
+    std::istringstream resultStream(resultStr);
+    resultStream >> batchModule.result.preTCEMutants >>
+        batchModule.result.postTCEMutants;
+    std::getline(resultStream >> std::ws, batchModule.result.outputDir);
+
+    if (WIFEXITED(childStatus)) {
+      batchModule.mutated = (WEXITSTATUS(childStatus) == 0);
+      batchModule.status =
+          batchModule.mutated
+              ? "OK"
+              : "FAILED (exit code " +
+                    std::to_string(WEXITSTATUS(childStatus)) + ")";
+    } else {
+      batchModule.mutated = false;
+      batchModule.status =
+          WIFSIGNALED(childStatus)
+              ? "FAILED (signal " + std::to_string(WTERMSIG(childStatus)) + ")"
+              : "FAILED";
+    }
+    if (!batchModule.mutated)
+      ++numFailed;
+    llvm::outs() << "Mart@Progress: batch: '" << batchModule.inputIRfile
+                 << "' " << batchModule.status << " in "
+                 << batchModule.seconds << " Seconds.\n";
+    Telemetry::get().progress("batch", ++numDone, modules.size());
+    running.erase(jobIt);
+  }
+  double totalSeconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - setupStartTime)
+                            .count();
+  reportBatch(modules, setupSeconds, totalSeconds, reportFile);
+  exitCode = (numFailed == 0 ? 0 : 1);
+  return nullptr;
+}
+
+/// \brief in the process of @param batchModule, send the result of its
+/// mutation into @param outputDir, with @param preTCEMutants and
+/// @param postTCEMutants mutants, to the batch process
+static bool sendBatchResult(BatchModule &batchModule,
+                            std::string const &outputDir,
+                            unsigned preTCEMutants, unsigned postTCEMutants) {
+  batchModule.span.reset();
+  std::string resultStr = std::to_string(preTCEMutants) + " " +
+                          std::to_string(postTCEMutants) + " " + outputDir +
+                          "\n";
+  bool sent =
+      write(batchModule.resultFd, resultStr.c_str(), resultStr.size()) >= 0;
+  close(batchModule.resultFd);
+  return sent;
+}
+
+
 int main(int argc, char **argv) {
 // Remove the option we don't want to display in help
 #if (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 5)
@@ -287,7 +623,7 @@ int main(int argc, char **argv) {
   }
 
   llvm::cl::opt<std::string> inputIRfile(llvm::cl::Positional,
-                                         llvm::cl::Required,
+                                         llvm::cl::Optional,
                                          llvm::cl::desc("<input IR file>"));
 
   llvm::cl::opt<std::string> mutantConfigfile(
@@ -300,6 +636,11 @@ int main(int argc, char **argv) {
       llvm::cl::desc(
           "(Optional) Specify the mutation scope: Functions, source files."),
       llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<bool> noLazyRead(
+      "no-lazy-read",
+      llvm::cl::desc("(Optional) With a mutation scope, read all the "
+                     "functions of the input IR file at once, instead of "
+                     "reading those out of scope only when they are needed"));
 
 llvm::cl::opt<std::string> extraLinkingFlags(
       "linking-flags",
@@ -309,7 +650,8 @@ llvm::cl::opt<std::string> extraLinkingFlags(
 
   llvm::cl::opt<bool> dumpPreTCEMeta(
       "print-preTCE-Meta",
-      llvm::cl::desc("Enable dumping Meta module before applying TCE"));
+      llvm::cl::desc("Enable dumping Meta module and mutants infos before "
+                     "applying TCE"));
   llvm::cl::opt<bool> disableDumpMetaIRbc(
       "no-Meta",
       llvm::cl::desc("Disable dumping Meta Module after applying TCE"));
@@ -334,19 +676,250 @@ llvm::cl::opt<std::string> extraLinkingFlags(
       llvm::cl::desc("Keep the different LLVM IR module of all mutants (only "
                      "active when enabled write-mutants)"));
 
+  llvm::cl::opt<unsigned> generationThreads(
+      "gen-threads",
+      llvm::cl::desc("(Optional) Number of threads used to generate the "
+                     "mutants. Default is 1 (no parallelism)"),
+      llvm::cl::value_desc("number of threads"), llvm::cl::init(1));
+
+  llvm::cl::opt<unsigned> tceThreads(
+      "tce-threads",
+      llvm::cl::desc("(Optional) Number of threads of the function-mode TCE, "
+                     "each processing the mutants of a function at a time. "
+                     "Default is 1 (no parallelism)"),
+      llvm::cl::value_desc("number of threads"), llvm::cl::init(1));
+  llvm::cl::opt<bool> tceNoHashBuckets(
+      "tce-no-hash-buckets",
+      llvm::cl::desc("(Optional) Diff each mutant with all the previous "
+                     "non-duplicate mutants of its function in the TCE, "
+                     "instead of only those with the same structural hash "
+                     "(slower, for checking the verdicts)"));
+
+  llvm::cl::opt<std::string> mutationCacheDir(
+      "mutation-cache",
+      llvm::cl::desc("(Optional) Directory of the persistent cache of the "
+                     "mutants of each function. The functions unchanged since "
+                     "a previous run reuse their cached mutants and TCE "
+                     "results"),
+      llvm::cl::value_desc("directory"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> tceCacheDir(
+      "tce-cache",
+      llvm::cl::desc("(Optional) Directory of the persistent cache of the "
+                     "TCE verdicts of the mutants, which can be shared by "
+                     "concurrent runs. The mutants already processed by a "
+                     "previous run are not optimized again (function mode "
+                     "TCE only)"),
+      llvm::cl::value_desc("directory"), llvm::cl::init(""));
+  llvm::cl::opt<bool> dumpMatchingStats(
+      "dump-matching-stats",
+      llvm::cl::desc("(Optional) Write, for each mutation operator, the "
+                     "number of statements offered to it for matching and "
+                     "the number of those it mutated"));
+  llvm::cl::opt<std::string> sampleBudget(
+      "sample",
+      llvm::cl::desc("(Optional) Only generate a deterministic stratified "
+                     "sample of the mutants: either a percentage of the "
+                     "mutants of each function and mutant type (e.g. '10%'), "
+                     "or a number of mutants per sampling unit (e.g. '50', "
+                     "see -sample-per)"),
+      llvm::cl::value_desc("percentage or number"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> samplePer(
+      "sample-per",
+      llvm::cl::desc("(Optional) Unit of a number of mutants given with "
+                     "-sample: 'function' (default), 'type' (mutant type) or "
+                     "'file' (source file)"),
+      llvm::cl::value_desc("unit"), llvm::cl::init("function"));
+  llvm::cl::opt<unsigned> sampleSeed(
+      "sample-seed",
+      llvm::cl::desc("(Optional) Seed of the mutants sampling (-sample). "
+                     "Default is 0"),
+      llvm::cl::value_desc("seed"), llvm::cl::init(0));
+  llvm::cl::opt<bool> sufficientSet(
+      "sufficient-set",
+      llvm::cl::desc("(Optional) Only generate the mutants that are not "
+                     "implied by other mutants of the same operator (e.g. "
+                     "'<' only mutated into '<=', '!=' and 'false'). The "
+                     "implied mutants are listed in the mutants infos"));
+  llvm::cl::opt<bool> noTrivialPruning(
+      "no-trivial-pruning",
+      llvm::cl::desc("(Optional) Disable the removal, at generation, of the "
+                     "mutants that are trivially equivalent to the original "
+                     "statement or duplicate of another mutant of the same "
+                     "statement"));
+  llvm::cl::opt<std::string> dryRunReport(
+      "dry-run",
+      llvm::cl::desc("(Optional) Only estimate the cost of the mutation: "
+                     "count the mutants of each function and mutant type "
+                     "without adding them into the module, estimate the size "
+                     "of the meta-mutant module and the cost of TCE, write "
+                     "the estimate into the given JSON file and exit"),
+      llvm::cl::value_desc("JSON file"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> enumeratedMutantsFile(
+      "enumerate-mutants",
+      llvm::cl::desc("(Optional) Only enumerate the mutants, one statement at "
+                     "a time without building the meta-mutant module, write "
+                     "their infos (as the mutants infos before TCE) into the "
+                     "given JSON file and exit"),
+      llvm::cl::value_desc("JSON file"), llvm::cl::init(""));
+  llvm::cl::list<std::string> entryFunctions(
+      "entry-functions",
+      llvm::cl::desc("(Optional) Comma separated list of the entry functions "
+                     "of the program or test harness (e.g. 'main'). The "
+                     "functions not reachable from them in the call graph "
+                     "are not mutated"),
+      llvm::cl::value_desc("function names"), llvm::cl::CommaSeparated);
+  llvm::cl::opt<std::string> utilityModel(
+      "utility-model",
+      llvm::cl::desc("(Optional) Model trained with mart-training, used to "
+                     "predict the utility of each mutant at generation. The "
+                     "mutants with a low predicted utility are not added "
+                     "into the meta-mutant module (see -min-utility and "
+                     "-utility-budget). Needs Mart built with the mutant "
+                     "selection"),
+      llvm::cl::value_desc("model file"), llvm::cl::init(""));
+  llvm::cl::opt<float> minUtility(
+      "min-utility",
+      llvm::cl::desc("(Optional) Only keep the mutants whose predicted "
+                     "utility (-utility-model) is at least the given value. "
+                     "Default is 0"),
+      llvm::cl::value_desc("utility"), llvm::cl::init(0.0));
+  llvm::cl::opt<unsigned long> utilityBudget(
+      "utility-budget",
+      llvm::cl::desc("(Optional) Only keep the given number of mutants with "
+                     "the highest predicted utility (-utility-model) in the "
+                     "module (plus those tied with the last one). Default is "
+                     "0 (no budget)"),
+      llvm::cl::value_desc("number"), llvm::cl::init(0));
+  llvm::cl::opt<std::string> shardSpec(
+      "shard",
+      llvm::cl::desc("(Optional) Only mutate the shard <i> (from 0) of <N> "
+                     "of the functions to mutate, split by size in the "
+                     "module's order (e.g. '0/4'). The outputs of the <N> "
+                     "shards are merged with mart-merge"),
+      llvm::cl::value_desc("i/N"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> batchManifest(
+      "batch",
+      llvm::cl::desc("(Optional) Mutate, instead of the input IR file, the "
+                     "modules listed in the given JSON manifest: a list of "
+                     "objects with the keys 'Input' (IR file), 'MutantScope' "
+                     "and 'OutputDir' (optional). The configuration and the "
+                     "helper modules are only read once"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<unsigned> batchJobs(
+      "batch-jobs",
+      llvm::cl::desc("(Optional) Number of modules of the batch (-batch) "
+                     "mutated concurrently, each in its own process. Default "
+                     "is 1"),
+      llvm::cl::value_desc("number of jobs"), llvm::cl::init(1));
+  llvm::cl::opt<std::string> batchReport(
+      "batch-report",
+      llvm::cl::desc("(Optional) Write the report of the batch (-batch) into "
+                     "the given JSON file: the status, time and numbers of "
+                     "mutants of each module"),
+      llvm::cl::value_desc("JSON file"), llvm::cl::init(""));
+
+  llvm::cl::opt<std::string> tceMode(
+      "tce-mode",
+      llvm::cl::desc("(Optional) Mode of the TCE: 'function' (default: a "
+                     "copy of the mutated function for every mutant), "
+                     "'module' (a copy of the module for every mutant) or "
+                     "'auto': module mode when its estimated memory fits in "
+                     "the memory budget (-memory-budget), else function mode"),
+      llvm::cl::value_desc("mode"), llvm::cl::init("function"));
+  llvm::cl::opt<std::string> tcePassManager(
+      "tce-pass-manager",
+      llvm::cl::desc("(Optional) Pass manager of the optimization of the "
+                     "mutants' functions by the TCE: 'new' (default from "
+                     "LLVM 12), 'legacy' (default before LLVM 12) or 'check' "
+                     "(the new one, reporting the functions for which its "
+                     "output differs from the legacy one's)"),
+      llvm::cl::value_desc("pass manager"), llvm::cl::init(""));
+  llvm::cl::opt<bool> tceCheckMaterialization(
+      "tce-check-materialization",
+      llvm::cl::desc("(Optional) In function-mode TCE, compare the function "
+                     "built for each mutant with the one cleaned out of the "
+                     "meta-mutant function, as written for -write-mutants, "
+                     "and report the mutants for which they differ"));
+  llvm::cl::opt<unsigned long> memoryBudget(
+      "memory-budget",
+      llvm::cl::desc("(Optional) Memory budget of a mutation, in MB. Default "
+                     "is the physical memory of the machine. When the TCE "
+                     "would exceed the given budget even in function mode, "
+                     "Mart stops before the TCE and writes the pre-TCE "
+                     "meta-mutant module (only a warning with the default "
+                     "budget)"),
+      llvm::cl::value_desc("MB"), llvm::cl::init(0));
+
+  llvm::cl::opt<std::string> traceFile(
+      "trace-file",
+      llvm::cl::desc("(Optional) Write the duration of the phases, of the "
+                     "TCE of each function and of the writing of each file "
+                     "into the given file, in the Chrome trace-event format "
+                     "(chrome://tracing, Perfetto)"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  llvm::cl::opt<std::string> progressFile(
+      "progress-file",
+      llvm::cl::desc("(Optional) Write the start and end of the phases and "
+                     "the progress of the TCE, with its estimated remaining "
+                     "time, as JSON lines into the given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
   llvm::cl::SetVersionPrinter(printVersion);
 
   llvm::cl::ParseCommandLineOptions(argc, argv, "Mart Mutantion");
 
-  time_t totalRunTime = time(NULL);
-  clock_t curClockTime;
+  if (!startTelemetry(traceFile, progressFile))
+    return 1;
+
+  if (inputIRfile.empty() == batchManifest.empty()) {
+    llvm::errs() << "Mart@Error: specify either the input IR file or a batch "
+                    "manifest (-batch)\n";
+    return 1;
+  }
+  if (!batchManifest.empty() && !dryRunReport.empty()) {
+    llvm::errs() << "Mart@Error: the dry run (-dry-run) is not supported in "
+                    "batch mode (-batch)\n";
+    return 1;
+  }
+  if (!batchManifest.empty() && !enumeratedMutantsFile.empty()) {
+    llvm::errs() << "Mart@Error: the mutants enumeration (-enumerate-mutants) "
+                    "is not supported in batch mode (-batch)\n";
+    return 1;
+  }
+
+  if (tceNoHashBuckets)
+    mart::TCE::setHashBuckets(false);
+
+  if (tceMode != "auto" && tceMode != "function" && tceMode != "module") {
+    llvm::errs() << "Mart@Error: invalid TCE mode '" << tceMode
+                 << "' (expected 'auto', 'function' or 'module')\n";
+    return 1;
+  }
+
+  if (!tcePassManager.empty()) {
+    mart::TCE::PassManagerKind pmKind = mart::TCE::NewPM;
+    if (tcePassManager == "legacy") {
+      pmKind = mart::TCE::LegacyPM;
+    } else if (tcePassManager == "check") {
+      pmKind = mart::TCE::CheckPM;
+    } else if (tcePassManager != "new") {
+      llvm::errs() << "Mart@Error: invalid TCE pass manager '"
+                   << tcePassManager
+                   << "' (expected 'new', 'legacy' or 'check')\n";
+      return 1;
+    }
+    if (!mart::TCE::setPassManager(pmKind)) {
+      llvm::errs() << "Mart@Error: the new pass manager of the TCE "
+                      "(-tce-pass-manager) needs LLVM 12 or later\n";
+      return 1;
+    }
+  }
+
+  auto setupStartTime = std::chrono::steady_clock::now();
 
   const char *wmLogFuncinputIRfileName = "wmlog-driver.bc";
   const char *metamutant_selector_inputIRfileName = "metamutant_selector.bc";
 
-  /// \brief set this to false if the module is small enough, that all mutants
-  /// will fit in memory
-  bool isTCEFunctionMode = true;
 
 #ifdef MART_GENMU_OBJECTFILE
   bool dumpMetaObj = false;
@@ -359,49 +932,126 @@ llvm::cl::opt<std::string> extraLinkingFlags(
   if (mutantConfigfile.empty())
     mutantConfigfile.assign(useful_conf_dir + defaultMconfFile);
 
+  /// The modules linked with the generated modules are read once, and parsed
+  /// into the context of each mutated module
+  // the module containing the metamutant selector, to be linked with meta
+  // module
+  std::string metamutant_selector_inputIRfile(useful_conf_dir +
+                                    metamutant_selector_inputIRfileName);
+  ReadWriteIRObj metamutantSelectorBuf;
+  if (!metamutantSelectorBuf.setToFile(metamutant_selector_inputIRfile)) {
+    llvm::errs() << "Failed reading '" << metamutant_selector_inputIRfile
+                 << "' file\n";
+    return 1;
+  }
+  // the module containing the function to log WM and COV info, to be linked
+  // with WMModule and CovModule
+  std::string wmLogFuncinputIRfile(useful_conf_dir + wmLogFuncinputIRfileName);
+  ReadWriteIRObj wmLogFuncBuf;
+  if ((!disabledWeakMutation || !disabledMutantCoverage) &&
+      !wmLogFuncBuf.setToFile(wmLogFuncinputIRfile)) {
+    llvm::errs() << "Failed reading '" << wmLogFuncinputIRfile << "' file\n";
+    return 1;
+  }
+
+#ifdef MART_UTILITY_PREDICTION
+  std::shared_ptr<TrainedModelUtilityPredictor> utilityPredictor;
+#endif //#ifdef MART_UTILITY_PREDICTION
+  if (!utilityModel.empty()) {
+#ifdef MART_UTILITY_PREDICTION
+    utilityPredictor =
+        std::make_shared<TrainedModelUtilityPredictor>(utilityModel);
+    if (!utilityPredictor->load())
+      return 1;
+#else
+    llvm::errs() << "Mart@Error: -utility-model needs Mart built with the "
+                    "mutant selection (MART_MUTANT_SELECTION)\n";
+    return 1;
+#endif //#ifdef MART_UTILITY_PREDICTION
+  }
+
+  unsigned shardIndex = 0, shardCount = 1;
+  if (!shardSpec.empty()) {
+    llvm::StringRef indexStr, countStr;
+    std::tie(indexStr, countStr) = llvm::StringRef(shardSpec).split('/');
+    if (indexStr.trim().getAsInteger(10, shardIndex) ||
+        countStr.trim().getAsInteger(10, shardCount) || shardCount == 0 ||
+        shardIndex >= shardCount) {
+      llvm::errs() << "\nInvalid shard '" << shardSpec
+                   << "' (expected <i>/<N>)!\n\n";
+      return 1;
+    }
+  }
+
+  /// Batch mode: the modules of the manifest are mutated each in a process
+  /// forked from this one, which goes on below with its module
+  std::vector<BatchModule> batchModules;
+  std::unique_ptr<Mutation> configSource;
+  BatchModule *batchModule = nullptr;
+  if (!batchManifest.empty()) {
+    if (!loadBatchManifest(batchManifest, batchModules))
+      return 1;
+    // The mutation configuration is parsed, and the operators' matchers
+    // (UserMaps) built, once for all the modules
+    configSource.reset(new Mutation(mutantConfigfile));
+    if (sufficientSet)
+      configSource->setSufficientSetMode();
+    int batchExitCode;
+    batchModule = runBatch(batchModules, batchJobs, setupStartTime,
+                           batchReport, batchExitCode);
+    if (!batchModule)
+      return batchExitCode;
+    inputIRfile = batchModule->inputIRfile;
+    mutantScopeJsonfile = batchModule->mutantScopeJsonfile;
+  }
+
+  time_t totalRunTime = time(NULL);
+  clock_t curClockTime;
+  MemoryUsageTracker memoryTracker;
+
   assert(!inputIRfile.empty() && "Error: No input llvm IR file passed!");
 
+  memoryTracker.startPhase("read");
+
   llvm::Module *moduleM;
   std::unique_ptr<llvm::Module> metamutant_sel(nullptr), modWMLog(nullptr), 
                                 modCovLog(nullptr), optMetaMu(nullptr), _M;
 
-  // Read IR into moduleM
+  // Read IR into moduleM. With a mutation scope, the functions bodies are
+  // read lazily, only those in scope are read before the mutation
   /// llvm::LLVMContext context;
-  if (!ReadWriteIRObj::readIR(inputIRfile, _M))
+  if (!ReadWriteIRObj::readIR(inputIRfile, _M,
+                              !mutantScopeJsonfile.empty() && !noLazyRead))
     return 1;
   moduleM = _M.get();
   // ~
 
   /// MetaMutantSelector
-  std::string metamutant_selector_inputIRfile(useful_conf_dir +
-                                    metamutant_selector_inputIRfileName);
-  // get the module containing the metamutant selector. 
-  // to be linked with meta module
-  if (!ReadWriteIRObj::readIR(metamutant_selector_inputIRfile, metamutant_sel))
+  metamutant_sel.reset(metamutantSelectorBuf.readIR(moduleM->getContext()));
+  if (!metamutant_sel) {
+    llvm::errs() << "Failed parsing '" << metamutant_selector_inputIRfile
+                 << "' file\n";
     return 1;
+  }
 
   /// Weak mutation
   if (!disabledWeakMutation) {
-    std::string wmLogFuncinputIRfile(useful_conf_dir +
-                                     wmLogFuncinputIRfileName);
-    // get the module containing the function to log WM info. to be linked with
-    // WMModule
-    if (!ReadWriteIRObj::readIR(wmLogFuncinputIRfile, modWMLog))
+    modWMLog.reset(wmLogFuncBuf.readIR(moduleM->getContext()));
+    if (!modWMLog) {
+      llvm::errs() << "Failed parsing '" << wmLogFuncinputIRfile
+                   << "' file\n";
       return 1;
-  } else {
-    modWMLog = nullptr;
+    }
   }
 
   /// Mutant Coverage
   if (!disabledMutantCoverage) {
-    std::string covLogFuncinputIRfile(useful_conf_dir +
-                                     wmLogFuncinputIRfileName);
-    // get the module containing the function to log COV info. to be linked with
-    // CovModule
-    if (!ReadWriteIRObj::readIR(covLogFuncinputIRfile, modCovLog))
+    modCovLog.reset(wmLogFuncBuf.readIR(moduleM->getContext()));
+    if (!modCovLog) {
+      llvm::errs() << "Failed parsing '" << wmLogFuncinputIRfile
+                   << "' file\n";
       return 1;
-  } else {
-    modCovLog = nullptr;
+    }
   }
 
   /**********************  To BE REMOVED (used to extrac line num from bc whith
@@ -436,21 +1086,61 @@ llvm::cl::opt<std::string> extraLinkingFlags(
   // std::string mutconffile;
 
   // @Mutation
-  Mutation mut(*moduleM, mutantConfigfile, dumpMutantsCallback,
-               mutantScopeJsonfile);
-
-// Keep Phi2Mem-preprocessed module
-#if (LLVM_VERSION_MAJOR >= 8) // && (LLVM_VERSION_MINOR < 5)
-  std::unique_ptr<llvm::Module> preProPhi2MemModule =
-      llvm::CloneModule(*moduleM);
-#elif (LLVM_VERSION_MAJOR <= 3) && (LLVM_VERSION_MINOR < 8)
-  std::unique_ptr<llvm::Module> preProPhi2MemModule(llvm::CloneModule(moduleM));
-#else
-  std::unique_ptr<llvm::Module> preProPhi2MemModule =
-      llvm::CloneModule(moduleM);
-#endif
+  memoryTracker.startPhase("preprocess");
+  std::unique_ptr<Mutation> mutPtr(
+      configSource ? new Mutation(*moduleM, *configSource, dumpMutantsCallback,
+                                  mutantScopeJsonfile)
+                   : new Mutation(*moduleM, mutantConfigfile,
+                                  dumpMutantsCallback, mutantScopeJsonfile));
+  Mutation &mut = *mutPtr;
+
+  // Keep Phi2Mem-preprocessed module. The functions out of scope are only
+  // read, and copied into it, when the meta-module is written (not for a
+  // dry run or an enumeration)
+  std::unique_ptr<llvm::Module> preProPhi2MemModule;
+  llvm::ValueToValueMapTy preProPhi2MemVMap;
+  if (dryRunReport.empty() && enumeratedMutantsFile.empty())
+    preProPhi2MemModule.reset(ReadWriteIRObj::cloneMaterializedAndRelease(
+        moduleM, preProPhi2MemVMap));
+
+  mut.setGenerationThreads(generationThreads);
+  mut.setTCEThreads(tceThreads);
+  mut.setTrivialEquivalencePruning(!noTrivialPruning);
+  if (tceCheckMaterialization)
+    mut.setMutantMaterializationCheck();
+  // The configuration source was already reduced
+  if (sufficientSet && !configSource)
+    mut.setSufficientSetMode();
+  if (!entryFunctions.empty())
+    mut.setReachabilityEntries(
+        std::vector<std::string>(entryFunctions.begin(), entryFunctions.end()));
+  if (!sampleBudget.empty() &&
+      !mut.setMutantSampling(sampleBudget, samplePer, sampleSeed)) {
+    llvm::errs() << "\nInvalid mutants sampling!\n\n";
+    return 1;
+  }
+#ifdef MART_UTILITY_PREDICTION
+  if (utilityPredictor)
+    mut.setUtilityFilter(utilityPredictor, minUtility, utilityBudget);
+#endif //#ifdef MART_UTILITY_PREDICTION
+  if (!shardSpec.empty()) {
+    if (!mut.setShard(shardIndex, shardCount))
+      return 1;
+    // The shards may run in the same directory
+    outputDir += "shard" + std::to_string(shardIndex) + "of" +
+                 std::to_string(shardCount) + "-";
+  }
+  if (!mutationCacheDir.empty())
+    mut.setMutationCache(mutationCacheDir);
+  if (!tceCacheDir.empty())
+    mut.setTCEVerdictCache(tceCacheDir);
+  if (!dryRunReport.empty())
+    mut.setDryRun();
+  if (!enumeratedMutantsFile.empty())
+    return (enumerateMutants(mut, enumeratedMutantsFile) ? 0 : 1);
 
   // do mutation
+  memoryTracker.startPhase("mutate");
   llvm::outs() << "Mart@Progress: Mutating...\n";
   curClockTime = clock();
   if (!mut.doMutate()) {
@@ -463,16 +1153,28 @@ llvm::cl::opt<std::string> extraLinkingFlags(
   loginfo << "Mart@Progress: Mutation took: "
           << (float)(clock() - curClockTime) / CLOCKS_PER_SEC << " Seconds.\n";
 
-  // @Output setup
-  struct stat st; // = {0};
-  int dcount = 0;
-  while (stat((outputDir + std::to_string(dcount)).c_str(), &st) != -1)
-    dcount++;
+  if (!dryRunReport.empty())
+    return (mut.dumpDryRunEstimate(dryRunReport) ? 0 : 1);
 
-  outputDir += std::to_string(dcount);
-
-  if (mkdir(outputDir.c_str(), 0777) != 0)
-    assert(false && "Failed to create output directory");
+  // @Output setup
+  if (batchModule && !batchModule->outputDir.empty()) {
+    outputDir = batchModule->outputDir;
+    if (mkdir(outputDir.c_str(), 0777) != 0) {
+      llvm::errs() << "Mart@Error: failed to create the output directory '"
+                   << outputDir << "' (it must not exist)\n";
+      return 1;
+    }
+  } else {
+    // The first free 'mart-out-<n>' is taken by creating it, since batch
+    // jobs may be looking for one concurrently
+    int dcount = 0;
+    while (mkdir((outputDir + std::to_string(dcount)).c_str(), 0777) != 0) {
+      if (errno != EEXIST)
+        assert(false && "Failed to create output directory");
+      dcount++;
+    }
+    outputDir += std::to_string(dcount);
+  }
 
   //@ Output file name root
 
@@ -494,25 +1196,97 @@ llvm::cl::opt<std::string> extraLinkingFlags(
                                            "clashes with temporary Function "
                                            "Module Folder folder");
 
-  //@ Store Phi2Mem-preprocessed module with the same name of the input file
-  if (!ReadWriteIRObj::writeIR(preProPhi2MemModule.get(),
-                               outputDir + "/" + outFile + commonIRSuffix))
-    assert(false && "Failed to output Phi-preprocessed IR file");
-
   //@ Print pre-TCE meta-mutant
   if (dumpPreTCEMeta) {
+    if (!ReadWriteIRObj::materializeAll(*moduleM))
+      return 1;
     if (!ReadWriteIRObj::writeIR(moduleM, outputDir + "/" + outFile +
                                               preTCEMetaIRFileSuffix))
       assert(false && "Failed to output pre-TCE meta-mutatant IR file");
-    // mut.dumpMutantInfos (outputDir+"//"+outFile+"mutantLocs-preTCE.json");
+    if (!disableDumpMutantInfos)
+      mut.dumpMutantInfos(outputDir + "/" + preTCEMutantsInfosFileName);
+  }
+
+  unsigned numPreTCEMutants = mut.getHighestMutantID();
+
+  //@ TCE mode: module mode is faster, but only when all the mutants' copies
+  // of the module fit in memory
+  bool isTCEFunctionMode = (tceMode != "module");
+  unsigned long budgetKB = memoryBudget * 1024;
+  if (budgetKB == 0)
+    budgetKB = MemoryUsageTracker::getPhysicalMemoryKB();
+  // The estimate of module mode needs the functions out of scope, which
+  // are otherwise only read when needed (see -mutant-scope)
+  if (tceMode == "module" && !ReadWriteIRObj::materializeAll(*moduleM))
+    return 1;
+  if (budgetKB > 0) {
+    unsigned long usedKB = MemoryUsageTracker::getCurrentRSSKB();
+    unsigned long funcModeKB = mut.estimateTCEMemoryKB(true);
+    unsigned long moduleModeKB = mut.estimateTCEMemoryKB(false);
+    // The mutation and TCE verdict caches store the TCE verdicts of
+    // function mode, which does not read the functions out of scope
+    if (tceMode == "auto")
+      isTCEFunctionMode = !mutationCacheDir.empty() ||
+                          !tceCacheDir.empty() ||
+                          !ReadWriteIRObj::isMaterialized(*moduleM) ||
+                          usedKB + moduleModeKB > budgetKB;
+    if (!isTCEFunctionMode && usedKB + moduleModeKB > budgetKB) {
+      llvm::errs() << "Mart@Warning: module mode TCE would exceed the "
+                      "memory budget, using function mode\n";
+      isTCEFunctionMode = true;
+    }
+    std::string estimateStr =
+        "Mart@Progress: TCE in " +
+        std::string(isTCEFunctionMode ? "function" : "module") +
+        " mode (estimated memory: " + std::to_string(funcModeKB / 1024) +
+        " MB in function mode, " + std::to_string(moduleModeKB / 1024) +
+        " MB in module mode, " + std::to_string(usedKB / 1024) +
+        " MB used, budget " + std::to_string(budgetKB / 1024) + " MB)\n";
+    llvm::outs() << estimateStr;
+    loginfo << estimateStr;
+    // The default budget is only a guide for the rough estimate
+    if (isTCEFunctionMode && usedKB + funcModeKB > budgetKB &&
+        memoryBudget == 0) {
+      llvm::errs() << "Mart@Warning: the TCE of the " << numPreTCEMutants
+                   << " mutants may exceed the physical memory. Reduce the "
+                      "mutants (e.g. with -shard, -sample or "
+                      "-mutant-scope), or set -memory-budget to stop "
+                      "before the TCE instead.\n";
+    } else if (isTCEFunctionMode && usedKB + funcModeKB > budgetKB) {
+      std::string preTCEFile =
+          outputDir + "/" + outFile + preTCEMetaIRFileSuffix;
+      if (!dumpPreTCEMeta &&
+          (!ReadWriteIRObj::materializeAll(*moduleM) ||
+           !ReadWriteIRObj::writeIR(moduleM, preTCEFile)))
+        assert(false && "Failed to output pre-TCE meta-mutatant IR file");
+      llvm::errs() << "Mart@Error: the TCE of the " << numPreTCEMutants
+                   << " mutants would exceed the memory budget (-memory-"
+                      "budget). The pre-TCE meta-mutant module was written "
+                      "into '"
+                   << preTCEFile
+                   << "'. Reduce the mutants (e.g. with -shard, -sample or "
+                      "-mutant-scope) or increase the budget.\n";
+      return 1;
+    }
   }
 
   //@ Remove equivalent mutants and //@ print mutants in case on
+  memoryTracker.startPhase("TCE");
+  mut.setMemoryTracker(&memoryTracker);
   llvm::outs() << "Mart@Progress: Removing TCE Duplicates & WM & writing "
                   "mutants IRs (with initially "
                << mut.getHighestMutantID() << " mutants)...\n";
   curClockTime = clock();
   mut.doTCE(optMetaMu, modWMLog, modCovLog, dumpMutants, isTCEFunctionMode);
+
+  //@ Store Phi2Mem-preprocessed module with the same name of the input file.
+  // The functions out of scope were read by the TCE, and are unchanged
+  if (!ReadWriteIRObj::cloneRemainingBodies(*moduleM, preProPhi2MemVMap) ||
+      !ReadWriteIRObj::writeIR(preProPhi2MemModule.get(),
+                               outputDir + "/" + outFile + commonIRSuffix))
+    assert(false && "Failed to output Phi-preprocessed IR file");
+  preProPhi2MemModule.reset(nullptr);
+  memoryTracker.startPhase("write");
   llvm::outs() << "Mart@Progress: Removing TCE Duplicates  & WM & writing "
                   "mutants IRs took: "
                << (float)(clock() - curClockTime) / CLOCKS_PER_SEC
@@ -520,11 +1294,38 @@ llvm::cl::opt<std::string> extraLinkingFlags(
   loginfo << "Mart@Progress: Removing TCE Duplicates  & WM & writing mutants "
              "IRs took: "
           << (float)(clock() - curClockTime) / CLOCKS_PER_SEC << " Seconds.\n";
+  if (tcePassManager == "check") {
+    auto pmCheckStats = mart::TCE::getPassManagerCheckStats();
+    std::string pmCheckStr =
+        "Mart@Progress: the new pass manager's optimization differs from "
+        "the legacy one's for " +
+        std::to_string(pmCheckStats.second) + " of the " +
+        std::to_string(pmCheckStats.first) + " optimized functions.\n";
+    llvm::outs() << pmCheckStr;
+    loginfo << pmCheckStr;
+  }
+
+  if (tceCheckMaterialization) {
+    auto matCheckStats = mut.getMutantMaterializationCheckStats();
+    std::string matCheckStr =
+        "Mart@Progress: the function built for the mutant differs from the "
+        "one cleaned out of the meta-mutant function for " +
+        std::to_string(matCheckStats.second) + " of the " +
+        std::to_string(matCheckStats.first) + " checked mutants.\n";
+    llvm::outs() << matCheckStr;
+    loginfo << matCheckStr;
+  }
 
   /// Mutants Infos into json
   if (!disableDumpMutantInfos)
     mut.dumpMutantInfos(outputDir + "//" + mutantsInfosFileName, outputDir + "//" + equivalentduplicate_mutantsInfosFileName);
 
+  if (dumpMatchingStats)
+    mut.dumpMutatorsMatchStats(outputDir + "//" + mutatorsMatchStatsFileName);
+
+  if (!shardSpec.empty())
+    mut.dumpShardInfos(outputDir + "//" + shardInfosFileName, outFile);
+
   //@ Print post-TCE meta-mutant
   if (!disableDumpMetaIRbc) {
     if (!ReadWriteIRObj::writeIR(moduleM, outputDir + "/" + outFile +
@@ -589,6 +1390,9 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
   // llvm::errs() << "@After Mutation->TCE\n"; moduleM->dump(); llvm::errs() <<
   // "\n";
 
+  memoryTracker.endPhase();
+  mut.setMemoryTracker(nullptr);
+
   llvm::outs() << "Mart@Progress: Compiling Mutants ...\n";
   // curClockTime = clock();
   time_t timer = time(NULL); // clock_t do not measure time when calling a
@@ -618,6 +1422,8 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
   // We use vfork here instead of pure fork to avoid error due to low memory
   // as fork will copy memory to the child process, and mutation use much memory
   // XXX Be careful about multithreading and vfork.
+  // The compilation is a single script job, with a single span
+  TelemetrySpan compileSpan("compile", "phase");
   if ((my_pid = vfork()) < 0) {
     perror("fork failure");
     exit(1);
@@ -650,6 +1456,7 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
       assert(false);
     }
   }
+  compileSpan.end();
   /********/
   // llvm::outs() << "Mart@Progress:  Compiling Mutants took: "<<
   // (float)(clock() - curClockTime)/CLOCKS_PER_SEC <<" Seconds.\n";
@@ -658,6 +1465,8 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
                << difftime(time(NULL), timer) << " Seconds.\n";
   loginfo << "Mart@Progress:  Compiling Mutants took: "
           << difftime(time(NULL), timer) << " Seconds.\n";
+  memoryTracker.addPhase("compile",
+                         MemoryUsageTracker::getChildrenPeakRSSKB());
 
   llvm::outs() << "\nMart@Progress:  TOTAL RUNTIME: "
                << (difftime(time(NULL), totalRunTime) / 60) << " min.\n";
@@ -665,6 +1474,7 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
           << (difftime(time(NULL), totalRunTime) / 60) << " min.\n";
 
   loginfo << mut.getMutationStats();
+  loginfo << memoryTracker.getStats();
 
   std::ofstream xxx(outputDir + "/" + generalInfo);
   if (xxx.is_open()) {
@@ -691,6 +1501,11 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
     xxx << ind++ << ". `" << (outFile + commonIRSuffix) << "` file: "
         << "Is the bitcode file that is mutated. it is the input IR file "
         << "after preprocessing to ease mutation (e.g. removing phi nodes).\n";
+    if (!shardSpec.empty())
+      xxx << ind++ << ". `" << shardInfosFileName << "` file: describes "
+          << "the shard of this output (its functions and numbers of "
+          << "mutants), used by mart-merge to merge the outputs of the "
+          << "shards.\n";
     if (!disableDumpMutantInfos)
       xxx << ind++ << ". `" << mutantsInfosFileName << "` file: contains "
           << "the description "
@@ -712,6 +1527,10 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
           << "the environment variable 'MART_WM_LOG_OUTPUT' to it. By default, "
           << "The lof file used is 'mart.defaultFileName.WM.covlabels', "
           << "located in the directory from where the program is called.\n";
+    if (dumpPreTCEMeta && !disableDumpMutantInfos)
+      xxx << ind++ << ". `" << preTCEMutantsInfosFileName << "` file: "
+          << "contains the description of all the mutants, before the "
+          << "in-memory TCE redundant mutants removal.\n";
     if (!dumpPreTCEMeta)
       xxx << ind++ << ". `" << (outFile + preTCEMetaIRFileSuffix)
           << "` file: is the raw meta-mutants program before in-memory TCE's "
@@ -750,5 +1569,10 @@ mutantsDir+"//"+std::to_string(mid)+"//"+outFile+".bc"))
     assert(false);
   }
 
+
+  if (batchModule &&
+      !sendBatchResult(*batchModule, outputDir, numPreTCEMutants,
+                       mut.getHighestMutantID()))
+    return 1;
   return 0;
 }
@@ -10,11 +10,16 @@
 #include "llvm/Support/Path.h"
 #include <llvm/Support/raw_ostream.h>
 
+#include "Telemetry.h"
+
 #define STRINGIFY2(X) #X
 #define STRINGIFY(X) STRINGIFY2(X)
 
 const std::string mutantsInfosFileName("mutantsInfos.json");
 const std::string equivalentduplicate_mutantsInfosFileName("equidup-mutantsInfos.json");
+const std::string preTCEMutantsInfosFileName("preTCE-mutantsInfos.json");
+const std::string mutatorsMatchStatsFileName("mutatorsMatchStats.json");
+const std::string shardInfosFileName("shardInfos.json");
 const char *wmOutIRFileSuffix = ".WM.bc";
 const char *covOutIRFileSuffix = ".COV.bc";
 const char *preTCEMetaIRFileSuffix = ".preTCE.MetaMu.bc";
@@ -43,6 +48,24 @@ void printVersion(llvm::raw_ostream &OS) {
   OS << "\n";
 }
 
+/// \brief open the outputs of the performance telemetry (options
+/// -trace-file and -progress-file). Empty file names disable the output.
+/// @return false if an output could not be opened
+bool startTelemetry(std::string const &traceFile,
+                    std::string const &progressFile) {
+  if (!traceFile.empty() && !Telemetry::get().openTrace(traceFile)) {
+    llvm::errs() << "Mart@Error: failed to open the trace file '" << traceFile
+                 << "'.\n";
+    return false;
+  }
+  if (!progressFile.empty() && !Telemetry::get().openProgress(progressFile)) {
+    llvm::errs() << "Mart@Error: failed to open the progress file '"
+                 << progressFile << "'.\n";
+    return false;
+  }
+  return true;
+}
+
 std::string getUsefulAbsPath(char *argv0) {
   std::string useful_conf_dir;
 